@@ -90,6 +90,10 @@
 #include <pcl/Mutex.h>
 #endif
 
+#ifndef __PCL_ThreadPool_h
+#include <pcl/ThreadPool.h>
+#endif
+
 #ifdef __PCL_BUILDING_PIXINSIGHT_APPLICATION
 namespace pi
 {
@@ -1040,19 +1044,18 @@ public:
     *                   of the three conditions above is false, the thread(s)
     *                   will be run without forcing their processor affinities.
     *
-    * This static member function launches the threads in sequence and waits
-    * until all threads have finished execution. While the threads are running,
+    * This static member function executes the Run() member functions of all
+    * threads as ThreadPool tasks, and waits until all of them have finished
+    * execution. The threads are not started: persistent pool worker threads
+    * are used instead, which avoids the overhead of creating and destroying
+    * execution threads for each parallel task. While the threads are running,
     * the \c status member of ThreadData is incremented to perform the process
     * monitoring task. This also ensures that the graphical interface remains
     * responsive during the whole process.
     *
-    * For normal thread execution with maximum performance, the \a useAffinity
-    * parameter should be true, in order to minimize cache invalidations due to
-    * processor reassignments of running threads. However, there are cases
-    * where forcing processor affinities can be counterproductive. An example
-    * is real-time previewing of intensive processes requiring continuous GUI
-    * updates. In these cases, disabling processor affinity can help to keep
-    * the GUI responsive with the required granularity.
+    * The \a useAffinity parameter is ignored in current PCL versions, since
+    * processor affinities cannot be assigned to thread pool tasks. It is kept
+    * for source code compatibility.
     *
     * The threads can be aborted asynchronously with the standard
     * Thread::Abort() mechanism, or through StatusMonitor/StatusCallback. If
@@ -1073,29 +1076,26 @@ public:
       if ( threads.IsEmpty() )
          return;
 
-      if ( useAffinity )
-         if ( threads.Length() == 1 || !Thread::IsRootThread() )
-            useAffinity = false;
+      (void)useAffinity;
 
+      Array<ThreadPool::ThreadTask> tasks;
       for ( typename ReferenceArray<thread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-         i->Start( ThreadPriority::DefaultMax, useAffinity ? Distance( threads.Begin(), i ) : -1 );
+         tasks.Add( ThreadPool::ThreadTask( *i ) );
+
+      ThreadPool::TaskGroup group;
+      for ( Array<ThreadPool::ThreadTask>::iterator i = tasks.Begin(); i != tasks.End(); ++i )
+         group.Run( *i );
 
       uint32 waitTime = StatusMonitor::RefreshRate() >> 1;
       waitTime += waitTime >> 2; // waitTime = 0.625 * StatusMonitor::RefreshRate()
 
       for ( size_type lastCount = 0; ; )
       {
-         for ( typename ReferenceArray<thread>::iterator i = threads.Begin(); ; )
+         if ( group.Wait( waitTime ) )
          {
-            if ( !i->Wait( waitTime ) )
-               break;
-
-            if ( ++i == threads.End() )
-            {
-               if ( data.total > 0 )
-                  data.status += data.total - lastCount;
-               return;
-            }
+            if ( data.total > 0 )
+               data.status += data.total - lastCount;
+            return;
          }
 
          if ( data.mutex.TryLock() )
@@ -1117,8 +1117,7 @@ public:
                data.mutex.Unlock();
                for ( typename ReferenceArray<thread>::iterator i = threads.Begin(); i != threads.End(); ++i )
                   i->Abort();
-               for ( typename ReferenceArray<thread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-                  i->Wait();
+               group.Wait();
                threads.Destroy();
                throw ProcessAborted();
             }
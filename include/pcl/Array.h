@@ -1039,6 +1039,30 @@ public:
          }
    }
 
+   /*!
+    * Destroys and removes a trailing sequence of contiguous objects, from the
+    * specified location \a i to the end of this array.
+    *
+    * Unlike Remove() and Clear(), this function never deallocates the array
+    * storage: the capacity of this array is preserved, so it can be filled
+    * again without reallocation. This is useful to reuse an array as a result
+    * list in repeated search operations.
+    *
+    * If \a i is located at or after the end of this array, this function does
+    * nothing. Otherwise \a i is constrained to stay in the range
+    * [Begin(),End()) of existing array elements.
+    */
+   void Truncate( iterator i )
+   {
+      if ( i < m_data->end )
+      {
+         i = pcl::Max( m_data->begin, i );
+         UniquifyIterator( i );
+         m_data->Destroy( i, m_data->end );
+         m_data->end = i;
+      }
+   }
+
    /*!
     * Destroys and removes all existing objects equal to the specified value
     * \a v in this array.
@@ -0,0 +1,363 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/BatchPipeline.h - Released 2016/02/21 20:22:12 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#ifndef __PCL_BatchPipeline_h
+#define __PCL_BatchPipeline_h
+
+/// \file pcl/BatchPipeline.h
+
+#ifndef __PCL_Defs_h
+#include <pcl/Defs.h>
+#endif
+
+#ifndef __PCL_IndirectArray_h
+#include <pcl/IndirectArray.h>
+#endif
+
+#ifndef __PCL_String_h
+#include <pcl/String.h>
+#endif
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \namespace pcl::BatchStage
+ * \brief     Processing stages of a batch pipeline.
+ *
+ * <table border="1" cellpadding="4" cellspacing="0">
+ * <tr><td>BatchStage::Load</td>    <td>Load stage: reads input data and generates processing tasks.</td></tr>
+ * <tr><td>BatchStage::Process</td> <td>Compute stage: processes tasks.</td></tr>
+ * <tr><td>BatchStage::Write</td>   <td>Output stage: writes processed tasks.</td></tr>
+ * </table>
+ */
+namespace BatchStage
+{
+   enum value_type
+   {
+      Load,
+      Process,
+      Write,
+      NumberOfStages
+   };
+}
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \class BatchPipeline
+ * \brief Three-stage parallel pipeline for batch processing of files.
+ *
+ * %BatchPipeline processes a sequence of batch items (typically, input file
+ * paths) in three stages, each of them executed by its own set of worker
+ * threads:
+ *
+ * \li Load stage. For each batch item, the reimplemented Load() member
+ * function reads input data and generates a list of processing tasks (for
+ * example, one task for each image stored in an input file).
+ *
+ * \li Compute stage. Tasks are processed in parallel by calling their
+ * Task::Process() member functions.
+ *
+ * \li Output stage. Processed tasks are finished by calling their
+ * Task::Write() member functions, then destroyed.
+ *
+ * Stages are joined by bounded task queues. Loader threads stop reading new
+ * items while the queue of loaded tasks is full, and compute threads wait
+ * while the queue of processed tasks is full, which limits the amount of
+ * memory used by the pipeline. With a queue capacity of C tasks, L loader
+ * threads, W compute threads and R output threads, and assuming that each
+ * batch item generates a single task, at most 2*C + L + W + R tasks can
+ * exist simultaneously: C in each queue, plus one being loaded, processed or
+ * written by each thread. Since a compute thread keeps its processed task
+ * while waiting for room in the output queue, this bound is not exceeded
+ * when the output stage is the bottleneck. Idle worker threads sleep on condition
+ * variables and are woken up as soon as new tasks are available, so disk
+ * reads and writes overlap with computations without polling.
+ *
+ * Worker threads cannot perform GUI operations. Console output generated by
+ * each stage function is captured and returned, along with the completion
+ * status of the stage, as an Event object. The thread that runs the pipeline
+ * (usually the root thread) retrieves events by calling WaitForEvent(), which
+ * returns as soon as an event is available:
+ *
+ * \code
+ * pipeline.Start( numberOfItems );
+ * try
+ * {
+ *    do
+ *    {
+ *       Module->ProcessEvents();
+ *       if ( console.AbortRequested() )
+ *          throw ProcessAborted();
+ *       BatchPipeline::Event event;
+ *       if ( pipeline.WaitForEvent( event, 250 ) )
+ *       {
+ *          console.Write( event.consoleText );
+ *          // ... handle event
+ *       }
+ *    }
+ *    while ( !pipeline.IsComplete() );
+ * }
+ * catch ( ... )
+ * {
+ *    pipeline.Abort();
+ *    throw;
+ * }
+ * \endcode
+ *
+ * Stage functions report errors by throwing exceptions. Exceptions are caught
+ * by the pipeline and shown as console output in the corresponding event.
+ * When a task fails, it is destroyed and does not enter subsequent stages.
+ *
+ * \note Stage functions executed by the same stage are serialized if the
+ * stage has a single worker thread. This is the recommended configuration
+ * for load and output stages when these functions modify shared data.
+ */
+class PCL_CLASS BatchPipeline
+{
+public:
+
+   /*!
+    * \class pcl::BatchPipeline::Task
+    * \brief Abstract base class of batch pipeline tasks.
+    */
+   class PCL_CLASS Task
+   {
+   public:
+
+      /*!
+       * Default constructor.
+       */
+      Task() : m_pipeline( nullptr ), m_item( 0 )
+      {
+      }
+
+      /*!
+       * Virtual destructor.
+       */
+      virtual ~Task()
+      {
+      }
+
+      /*!
+       * Processes this task. Invoked from a compute stage thread.
+       */
+      virtual void Process() = 0;
+
+      /*!
+       * Writes this task, once it has been processed. Invoked from an output
+       * stage thread.
+       */
+      virtual void Write() = 0;
+
+      /*!
+       * Returns the index of the batch item that generated this task.
+       */
+      size_type Item() const
+      {
+         return m_item;
+      }
+
+      /*!
+       * Returns true iff the pipeline executing this task has been aborted.
+       * Long-running tasks should call this function periodically, and
+       * return as soon as possible when it returns true.
+       */
+      bool IsAborted() const;
+
+   private:
+
+      const BatchPipeline* m_pipeline;
+      size_type            m_item;
+
+      friend class BatchPipeline;
+      friend class PipelineWorker;
+   };
+
+   /*!
+    * A list of pipeline tasks.
+    */
+   typedef IndirectArray<Task>   task_list;
+
+   /*!
+    * \struct pcl::BatchPipeline::Event
+    * \brief Completion of a pipeline stage.
+    */
+   struct Event
+   {
+      BatchStage::value_type stage;         //!< The stage that has been completed.
+      size_type              item;          //!< Index of the batch item.
+      int                    numberOfTasks; //!< For load events, the number of tasks generated.
+      bool                   success;       //!< Whether the stage has completed successfully.
+      String                 consoleText;   //!< Console output generated by the stage.
+
+      Event() : stage( BatchStage::Load ), item( 0 ), numberOfTasks( 0 ), success( false )
+      {
+      }
+   };
+
+   /*!
+    * Constructs a batch pipeline.
+    *
+    * \param numberOfLoaders  Number of load stage threads.
+    *
+    * \param numberOfWorkers  Number of compute stage threads.
+    *
+    * \param numberOfWriters  Number of output stage threads.
+    *
+    * \param queueCapacity    Maximum number of tasks waiting in each
+    *                         inter-stage queue. If zero or a negative value
+    *                         is specified, a single task slot will be used
+    *                         for each queue. Larger capacities can absorb
+    *                         irregular stage timings at the cost of two
+    *                         additional tasks in memory per queue slot.
+    *
+    * With the default queue capacity, the peak number of tasks held in
+    * memory by the pipeline is \a numberOfLoaders + \a numberOfWorkers +
+    * \a numberOfWriters + 2, when each batch item generates a single task.
+    */
+   BatchPipeline( int numberOfLoaders, int numberOfWorkers, int numberOfWriters, int queueCapacity = 0 );
+
+   /*!
+    * Destroys a batch pipeline. If the pipeline is running, it is aborted.
+    *
+    * \note Since worker threads invoke the Load() virtual member function,
+    * derived classes must make sure that the pipeline has completed, or call
+    * Abort(), before destruction.
+    */
+   virtual ~BatchPipeline();
+
+   /*!
+    * Starts processing the batch items [0,\a numberOfItems). This function
+    * returns immediately. A pipeline can only be started once.
+    */
+   void Start( size_type numberOfItems );
+
+   /*!
+    * Waits for the next pipeline event, during at most \a ms milliseconds.
+    * If an event is available, it is stored in \a event and this function
+    * returns true. Otherwise returns false.
+    */
+   bool WaitForEvent( Event& event, unsigned ms );
+
+   /*!
+    * Returns true iff all batch items have been processed and all pipeline
+    * events have been retrieved.
+    */
+   bool IsComplete() const;
+
+   /*!
+    * Aborts the pipeline. Idle worker threads are terminated immediately,
+    * and running tasks are notified through Task::IsAborted(). This function
+    * waits until all worker threads have terminated, then destroys all
+    * pending tasks.
+    */
+   void Abort();
+
+   /*!
+    * Returns true iff this pipeline has been aborted.
+    */
+   bool IsAborted() const;
+
+   /*!
+    * Returns the total time in seconds spent by all threads of the specified
+    * \a stage executing stage functions.
+    */
+   double StageTime( BatchStage::value_type stage ) const;
+
+   /*!
+    * Returns the number of stage functions executed by the specified
+    * \a stage.
+    */
+   size_type StageCount( BatchStage::value_type stage ) const;
+
+   /*!
+    * Returns the time in seconds elapsed since the pipeline was started,
+    * until completion if the pipeline has completed.
+    */
+   double ElapsedTime() const;
+
+   /*!
+    * Returns a human-readable report of execution times by stage, suitable
+    * for console output.
+    */
+   String TimingReport() const;
+
+protected:
+
+   /*!
+    * Load stage function. Reads the batch \a item and appends the
+    * corresponding processing tasks to the \a tasks list. Generating no
+    * tasks is valid. Invoked from a load stage thread.
+    */
+   virtual void Load( task_list& tasks, size_type item ) = 0;
+
+private:
+
+   void* m_data;
+
+   BatchPipeline( const BatchPipeline& ) = delete;
+   BatchPipeline& operator =( const BatchPipeline& ) = delete;
+
+   friend class PipelineWorker;
+};
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+#endif   // __PCL_BatchPipeline_h
+
+// ----------------------------------------------------------------------------
+// EOF pcl/BatchPipeline.h - Released 2016/02/21 20:22:12 UTC
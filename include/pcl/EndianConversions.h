@@ -90,6 +90,18 @@ inline uint32 BigToLittleEndian( uint32 x )
                       ((x & 0x00FF0000ul) >> 8) | (x >> 24);
 }
 
+/*!
+ * Converts a 64-bit unsigned integer from big endian to little endian byte
+ * storage order.
+ *
+ * \ingroup endian_conversion_functions
+ */
+inline uint64 BigToLittleEndian( uint64 x )
+{
+   return (uint64( BigToLittleEndian( uint32( x ) ) ) << 32) |
+                   BigToLittleEndian( uint32( x >> 32 ) );
+}
+
 /*!
  * A convenience function for little-to-big endian conversion. It is
  * equivalent to: BigToLittleEndian( x )
@@ -126,6 +126,12 @@ protected:
    static void* CreateInv( int, float* );
    static void* CreateInv( int, double* );
 
+   static void* CreateDCT( int, float* );
+   static void* CreateDCT( int, double* );
+
+   static void* CreateInvDCT( int, float* );
+   static void* CreateInvDCT( int, double* );
+
    static void  Destroy( void* );
 
    static void  Transform( void*, fcomplex*, const fcomplex* );
@@ -134,6 +140,9 @@ protected:
    static void  Transform( void*, dcomplex*, const double* );
    static void  Transform( void*, float*,    const fcomplex* );
    static void  Transform( void*, double*,   const dcomplex* );
+
+   static void  TransformDCT( void*, float*,  const float* );
+   static void  TransformDCT( void*, double*, const double* );
 };
 
 // ----------------------------------------------------------------------------
@@ -769,6 +778,151 @@ public:
 
 // ----------------------------------------------------------------------------
 
+/*!
+ * \class GenericDCT
+ * \brief Generic discrete cosine transform of real data
+ *
+ * The %GenericDCT template class performs forward and inverse, out-of-place or
+ * in-place discrete cosine transforms of real-valued data.
+ *
+ * The forward transform is a DCT-II:
+ *
+ * <tt>y[k] = 2 * Sum_{j=0}^{n-1} x[j]*cos( pi*(2*j + 1)*k/(2*n) )</tt>
+ *
+ * and the inverse transform is a DCT-III:
+ *
+ * <tt>y[k] = x[0] + 2 * Sum_{j=1}^{n-1} x[j]*cos( pi*j*(2*k + 1)/(2*n) )</tt>
+ *
+ * Transforms are not normalized: a forward transform followed by an inverse
+ * transform multiplies the original data by 2*n.
+ *
+ * Discrete cosine transforms are computed as fast Fourier transforms of real
+ * data of the same length. For best performance, the transform length should
+ * be an optimized length for real FFTs, as returned by OptimizedLength().
+ *
+ * \sa GenericRealFFT
+ */
+template <typename T>
+class PCL_CLASS GenericDCT : public FFT1DBase
+{
+public:
+
+   /*!
+    * Represents a scalar in the context of this %DCT class.
+    */
+   typedef T                        scalar;
+
+   /*!
+    * Represents a vector of real numbers.
+    */
+   typedef GenericVector<scalar>    vector;
+
+   /*!
+    * Constructs a %GenericDCT object of the specified length \a n.
+    */
+   GenericDCT( int n ) :
+      m_length( n ), m_handle( nullptr ), m_handleInv( nullptr )
+   {
+   }
+
+   /*!
+    * Destroys a %GenericDCT object.
+    */
+   virtual ~GenericDCT()
+   {
+      Release();
+   }
+
+   /*!
+    * Returns the transform length of this %GenericDCT object.
+    */
+   int Length() const
+   {
+      return m_length;
+   }
+
+   /*!
+    * Performs the forward (DCT-II) or inverse (DCT-III) discrete cosine
+    * transform of an input vector of real values, and stores the result in
+    * a caller-supplied output vector.
+    *
+    * \param[out] y  Output vector. Must be the starting address of a
+    *                contiguous sequence of at least Length() real numbers.
+    *
+    * \param[in] x   Input vector. Must be the starting address of a
+    *                contiguous sequence of at least Length() real numbers.
+    *                The input and output vectors can be the same.
+    *
+    * \param dir     Indicates the direction of the transform:
+    *                PCL_FFT_FORWARD for a DCT-II, PCL_FFT_BACKWARD for a
+    *                DCT-III. The default value is PCL_FFT_FORWARD.
+    *
+    * Returns a reference to this object.
+    */
+   GenericDCT& operator()( scalar* y, const scalar* x, int dir = PCL_FFT_FORWARD ) const
+   {
+      if ( dir == PCL_FFT_BACKWARD )
+      {
+         if ( m_handleInv == nullptr )
+            m_handleInv = this->CreateInvDCT( m_length, (scalar*)0 );
+         this->TransformDCT( m_handleInv, y, x );
+      }
+      else
+      {
+         if ( m_handle == nullptr )
+            m_handle = this->CreateDCT( m_length, (scalar*)0 );
+         this->TransformDCT( m_handle, y, x );
+      }
+      return const_cast<GenericDCT&>( *this );
+   }
+
+   /*!
+    * Returns the forward (DCT-II) or inverse (DCT-III) discrete cosine
+    * transform of the specified vector \a x, which must have at least
+    * Length() elements.
+    */
+   vector operator()( const vector& x, int dir = PCL_FFT_FORWARD ) const
+   {
+      if ( x.Length() < m_length )
+         throw Error( "Invalid DCT input vector length." );
+      vector y( m_length );
+      operator()( *y, *x, dir );
+      return y;
+   }
+
+   /*!
+    * Destroys all internal control structures in this %GenericDCT object.
+    */
+   void Release()
+   {
+      if ( m_handle != nullptr )
+         this->Destroy( m_handle ), m_handle = nullptr;
+      if ( m_handleInv != nullptr )
+         this->Destroy( m_handleInv ), m_handleInv = nullptr;
+   }
+
+   /*!
+    * Returns the <em>optimized %DCT length</em> larger than or equal to a
+    * given length \a n. The returned length will be optimal to perform a
+    * discrete cosine transform with the current PCL implementation.
+    */
+   static int OptimizedLength( int n )
+   {
+      return FFT1DBase::OptimizedLength( n, (scalar*)0 );
+   }
+
+private:
+
+           int   m_length;
+   mutable void* m_handle;      // Opaque pointers to internal control structures
+   mutable void* m_handleInv;
+
+   GenericDCT( const GenericDCT& ) = delete;
+   GenericDCT& operator =( const GenericDCT& ) = delete;
+};
+
+// ----------------------------------------------------------------------------
+
 #ifndef __PCL_NO_FFT1D_INSTANTIATE
 
 /*!
@@ -831,6 +985,24 @@ typedef FFFT                        FFT;
  */
 typedef FRealFFT                    RealFFT;
 
+/*!
+ * \class pcl::FDCT
+ * \ingroup fft_types_1d
+ * \brief Discrete cosine transform of 32-bit floating point real data.
+ *
+ * %FDCT is a template instantiation of GenericDCT for the \c float type.
+ */
+typedef GenericDCT<float>           FDCT;
+
+/*!
+ * \class pcl::DDCT
+ * \ingroup fft_types_1d
+ * \brief Discrete cosine transform of 64-bit floating point real data.
+ *
+ * %DDCT is a template instantiation of GenericDCT for the \c double type.
+ */
+typedef GenericDCT<double>          DDCT;
+
 #endif // __PCL_NO_FFT1D_INSTANTIATE
 
 // ----------------------------------------------------------------------------
@@ -121,6 +121,9 @@ protected:
    static void Transform( int, int, dcomplex*, const double*, StatusMonitor*, bool, int );
    static void Transform( int, int, float*, const fcomplex*, StatusMonitor*, bool, int );
    static void Transform( int, int, double*, const dcomplex*, StatusMonitor*, bool, int );
+
+   static void DCT( int, int, float*, const float*, int, StatusMonitor*, bool, int );
+   static void DCT( int, int, double*, const double*, int, StatusMonitor*, bool, int );
 };
 
 // ----------------------------------------------------------------------------
@@ -861,6 +864,123 @@ public:
 
 // ----------------------------------------------------------------------------
 
+/*!
+ * \class GenericDCT2D
+ * \brief Generic two-dimensional discrete cosine transform of real data
+ *
+ * The %GenericDCT2D template class performs two-dimensional forward (DCT-II)
+ * and inverse (DCT-III) discrete cosine transforms of real-valued data. Both
+ * transforms are computed separably, as one-dimensional transforms of matrix
+ * rows followed by transforms of matrix columns, with the normalization
+ * conventions described for the GenericDCT class. A forward transform
+ * followed by an inverse transform multiplies the original data by
+ * 4*Rows()*Cols().
+ *
+ * Two-dimensional discrete cosine transforms are useful to solve Poisson
+ * equations with Neumann boundary conditions on rectangular domains.
+ *
+ * \sa GenericDCT, GenericRealFFT2D
+ */
+template <typename T>
+class PCL_CLASS GenericDCT2D : public AbstractFFT2D<T>
+{
+public:
+
+   /*!
+    * Identifies the base class of this %DCT class.
+    */
+   typedef AbstractFFT2D<T>               base;
+
+   /*!
+    * Represents a scalar in the context of this %DCT class.
+    */
+   typedef typename base::scalar          scalar;
+
+   /*!
+    * Represents a real matrix.
+    */
+   typedef typename base::matrix          matrix;
+
+   /*!
+    * Constructs a %GenericDCT2D object of the specified dimensions \a rows
+    * and \a cols.
+    */
+   GenericDCT2D( int rows, int cols ) : base( rows, cols )
+   {
+   }
+
+   /*!
+    * Constructs a %GenericDCT2D object of the specified dimensions \a rows
+    * and \a cols, using the specified status monitoring object \a status.
+    *
+    * On each transform performed with this object, the status monitor will be
+    * incremented by the sum of transform dimensions: \a rows + \a cols.
+    */
+   GenericDCT2D( int rows, int cols, StatusMonitor& status ) : base( rows, cols, status )
+   {
+   }
+
+   /*!
+    * Virtual destructor.
+    */
+   virtual ~GenericDCT2D()
+   {
+   }
+
+   /*!
+    * Performs the forward (DCT-II) or inverse (DCT-III) two-dimensional
+    * discrete cosine transform of an input matrix of real numbers, and stores
+    * the result in an output matrix of real numbers.
+    *
+    * \param[out] y  Output matrix. Must be the starting address of a
+    *                contiguous sequence of at least NumberOfElements() real
+    *                numbers, stored in row order.
+    *
+    * \param[in] x   Input matrix. Must be the starting address of a
+    *                contiguous sequence of at least NumberOfElements() real
+    *                numbers, stored in row order. The input and output
+    *                matrices can be the same.
+    *
+    * \param dir     Indicates the direction of the transform:
+    *                PCL_FFT_FORWARD for a DCT-II, PCL_FFT_BACKWARD for a
+    *                DCT-III. The default value is PCL_FFT_FORWARD.
+    *
+    * Returns a reference to this object.
+    */
+   GenericDCT2D& operator()( scalar* y, const scalar* x, int dir = PCL_FFT_FORWARD ) const
+   {
+      this->DCT( m_rows, m_cols, y, x, dir, m_monitor, m_parallel, m_maxProcessors );
+      return const_cast<GenericDCT2D&>( *this );
+   }
+
+   /*!
+    * Returns the forward (DCT-II) or inverse (DCT-III) two-dimensional
+    * discrete cosine transform of the specified matrix \a x, which must have
+    * Rows() and Cols() dimensions. Otherwise an Error exception will be
+    * thrown.
+    */
+   matrix operator()( const matrix& x, int dir = PCL_FFT_FORWARD ) const
+   {
+      if ( x.Rows() != m_rows || x.Cols() != m_cols )
+         throw Error( "Invalid DCT input matrix dimensions." );
+      matrix y( m_rows, m_cols );
+      operator()( *y, *x, dir );
+      return y;
+   }
+
+   /*!
+    * Returns the <em>optimized %DCT length</em> larger than or equal to a
+    * given length \a n. The optimized length can be used as the \a rows or
+    * \a cols argument to the constructor of %GenericDCT2D.
+    */
+   static int OptimizedLength( int n )
+   {
+      return GenericDCT<T>::OptimizedLength( n );
+   }
+};
+
+// ----------------------------------------------------------------------------
+
 #undef m_dft
 #undef m_rows
 #undef m_cols
@@ -932,6 +1052,24 @@ typedef FFFT2D                      FFT2D;
  */
 typedef FRealFFT2D                  RealFFT2D;
 
+/*!
+ * \class pcl::FDCT2D
+ * \ingroup fft_2d
+ * \brief Discrete cosine transform of 32-bit floating point real data.
+ *
+ * %FDCT2D is a template instantiation of GenericDCT2D for the \c float type.
+ */
+typedef GenericDCT2D<float>         FDCT2D;
+
+/*!
+ * \class pcl::DDCT2D
+ * \ingroup fft_2d
+ * \brief Discrete cosine transform of 64-bit floating point real data.
+ *
+ * %DDCT2D is a template instantiation of GenericDCT2D for the \c double type.
+ */
+typedef GenericDCT2D<double>        DDCT2D;
+
 #endif // __PCL_NO_FFT2D_INSTANTIATE
 
 // ----------------------------------------------------------------------------
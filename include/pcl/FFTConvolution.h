@@ -115,6 +115,19 @@ namespace pcl
  */
 #define PCL_FFT_CONVOLUTION_IS_FASTER_THAN_NONSEPARABLE_FILTER_SIZE  12
 
+/*!
+ * \def PCL_FFT_CONVOLUTION_DEFAULT_MEMORY_LIMIT
+ * \brief Default maximum size in bytes of the working complex matrices used
+ * by an FFT-based convolution.
+ *
+ * When the padded FFT matrices required to convolve a whole image would
+ * exceed this limit, FFTConvolution switches automatically to a tiled
+ * overlap-save algorithm. See FFTConvolution::SetMemoryLimit().
+ *
+ * \ingroup fft_convolution_limits_macros
+ */
+#define PCL_FFT_CONVOLUTION_DEFAULT_MEMORY_LIMIT   (size_type( 1 ) << 30)
+
 /*!
  * \class FFTConvolution
  * \brief Fourier-based two-dimensional convolution
@@ -123,7 +136,15 @@ namespace pcl
  * convolution algorithm via fast Fourier transforms. It performs automatic
  * fixing of border artifacts by applying Neumann boundary conditions
  * (mirroring), and is able to convolve images and response functions of
- * arbitrary sizes, only limited by the available memory.
+ * arbitrary sizes.
+ *
+ * When the complex matrices required to transform the whole target image
+ * would exceed a prescribed memory limit, %FFTConvolution uses a tiled
+ * overlap-save algorithm: the image is divided into tiles whose transforms
+ * fit within the memory limit, the DFT of the response function is computed
+ * just once for the tile dimensions, and tiles are convolved in parallel. The
+ * tiled and untiled algorithms yield the same results within the numerical
+ * accuracy of single precision FFTs, including border fixing.
  *
  * \sa Convolution, SeparableConvolution, ATrousWaveletTransform, ImageTransformation
 */
@@ -140,7 +161,8 @@ public:
     */
    FFTConvolution() :
       ImageTransformation(),
-      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS )
+      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS ),
+      m_memoryLimit( PCL_FFT_CONVOLUTION_DEFAULT_MEMORY_LIMIT )
    {
    }
 
@@ -156,7 +178,8 @@ public:
    FFTConvolution( const KernelFilter& filter ) :
       ImageTransformation(),
       m_filter( filter.Clone() ),
-      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS )
+      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS ),
+      m_memoryLimit( PCL_FFT_CONVOLUTION_DEFAULT_MEMORY_LIMIT )
    {
       PCL_CHECK( bool( m_filter ) )
    }
@@ -177,7 +200,8 @@ public:
    FFTConvolution( const ImageVariant& f ) :
       ImageTransformation(),
       m_image( f ),
-      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS )
+      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS ),
+      m_memoryLimit( PCL_FFT_CONVOLUTION_DEFAULT_MEMORY_LIMIT )
    {
       PCL_CHECK( bool( m_image ) )
    }
@@ -188,7 +212,8 @@ public:
    FFTConvolution( const FFTConvolution& x ) :
       ImageTransformation( x ),
       m_image( x.m_image ),
-      m_parallel( x.m_parallel ), m_maxProcessors( x.m_maxProcessors )
+      m_parallel( x.m_parallel ), m_maxProcessors( x.m_maxProcessors ),
+      m_memoryLimit( x.m_memoryLimit )
    {
       if ( x.m_filter )
          m_filter = x.m_filter->Clone();
@@ -201,6 +226,7 @@ public:
       ImageTransformation( x ),
       m_filter( x.m_filter ), m_image( std::move( x.m_image ) ),
       m_parallel( x.m_parallel ), m_maxProcessors( x.m_maxProcessors ),
+      m_memoryLimit( x.m_memoryLimit ),
       m_h( x.m_h )
    {
       //x.m_filter = nullptr; // already done by AutoPointer
@@ -229,6 +255,7 @@ public:
             m_image = x.m_image;
          m_parallel = x.m_parallel;
          m_maxProcessors = x.m_maxProcessors;
+         m_memoryLimit = x.m_memoryLimit;
       }
       return *this;
    }
@@ -245,6 +272,7 @@ public:
          m_image = std::move( x.m_image );
          m_parallel = x.m_parallel;
          m_maxProcessors = x.m_maxProcessors;
+         m_memoryLimit = x.m_memoryLimit;
          m_h = x.m_h;
          //x.m_filter = nullptr; // already done by AutoPointer
          //x.m_h = nullptr;
@@ -334,6 +362,9 @@ public:
     * otherwise it is re-created on the fly, as necessary. It is destroyed when
     * a new filter is associated with this object.
     *
+    * When the tiled convolution algorithm is being used (see
+    * SetMemoryLimit()), the returned DFT has the dimensions of a single tile.
+    *
     * This function returns a pointer to a complex image that stores the DFT
     * of the original filter after transforming it to <em>wrap around
     * order</em>. This means that the original filter data has been splitted,
@@ -419,6 +450,35 @@ public:
       m_maxProcessors = unsigned( Range( maxProcessors, 1, PCL_MAX_PROCESSORS ) );
    }
 
+   /*!
+    * Returns the maximum size in bytes of the working complex matrices used by
+    * this %FFTConvolution object. The default value is given by the
+    * PCL_FFT_CONVOLUTION_DEFAULT_MEMORY_LIMIT macro.
+    */
+   size_type MemoryLimit() const
+   {
+      return m_memoryLimit;
+   }
+
+   /*!
+    * Sets the maximum size in bytes of the working complex matrices used by
+    * this %FFTConvolution object.
+    *
+    * If the padded matrices required to convolve the whole target image (the
+    * DFT of the response function plus one working matrix) would exceed this
+    * limit, the convolution is performed by the tiled overlap-save algorithm.
+    * Tile dimensions are then chosen so that the DFT of the response function
+    * plus one working matrix per concurrent tile fit within the limit,
+    * although tiles will never be smaller than twice the dimensions of the
+    * response function, irrespective of this limit.
+    *
+    * Specifying zero disables tiled convolution.
+    */
+   void SetMemoryLimit( size_type bytes )
+   {
+      m_memoryLimit = bytes;
+   }
+
 protected:
 
    /*
@@ -430,6 +490,7 @@ protected:
    ImageVariant              m_image;
    bool                      m_parallel      : 1;
    unsigned                  m_maxProcessors : PCL_MAX_PROCESSORS_BITCOUNT;
+   size_type                 m_memoryLimit;
 
    /*
     * Internal DFT of the response function. Initially zero. This matrix is
@@ -0,0 +1,220 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/HeadlessAPI.h - Released 2016/02/21 20:22:12 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+
+#ifndef __PCL_HeadlessAPI_h
+#define __PCL_HeadlessAPI_h
+
+/// \file pcl/HeadlessAPI.h
+
+#ifndef __PCL_Defs_h
+#include <pcl/Defs.h>
+#endif
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \namespace HeadlessConsoleOutput
+ * \brief     Destinations of console output text in headless applications
+ *
+ * <table border="1" cellpadding="4" cellspacing="0">
+ * <tr><td>HeadlessConsoleOutput::Discard</td>        <td>Console output text is discarded.</td></tr>
+ * <tr><td>HeadlessConsoleOutput::StandardOutput</td> <td>Console output text is written to the standard output stream.</td></tr>
+ * <tr><td>HeadlessConsoleOutput::StandardError</td>  <td>Console output text is written to the standard error stream.</td></tr>
+ * </table>
+ */
+namespace HeadlessConsoleOutput
+{
+   enum value_type
+   {
+      Discard,
+      StandardOutput,
+      StandardError
+   };
+}
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \class HeadlessAPI
+ * \brief Native implementation of the PixInsight core API for headless
+ *        applications.
+ *
+ * PCL classes reach the PixInsight core application through the function
+ * tables of the global API object, which the core resolves when a module is
+ * loaded. %HeadlessAPI provides a native, in-process implementation of the
+ * subset of the API required by image processing code, which allows PCL to be
+ * used by command line tools, test drivers and benchmarks running without the
+ * core application:
+ *
+ * <ul>
+ * <li>Threads are implemented with POSIX threads. Thread, ThreadPool and all
+ * parallel algorithms based on AbstractImage::RunThreads() work as usual,
+ * including thread status, abort requests and thread console output.</li>
+ * <li>ReadWriteMutex is implemented with POSIX read/write locks.</li>
+ * <li>Zlib compression is implemented with the zlib library bundled with
+ * PCL. The LZ4, LZ4HC and BloscLZ codecs are not available.</li>
+ * <li>The MD5, SHA-1, SHA-224, SHA-256, SHA-384 and SHA-512 cryptographic
+ * hashes are implemented natively.</li>
+ * <li>Shared memory allocation uses the local heap, and the pixel traits
+ * lookup tables are generated in-process.</li>
+ * <li>Global settings are stored in memory. The parallel processing settings
+ * are initialized to use all logical processors available.</li>
+ * <li>Console output text is written to the standard output or error streams,
+ * with console tags removed and character entities decoded.</li>
+ * </ul>
+ *
+ * Any other API function, including all graphical interface, view and
+ * process functions, resolves to a stub that does nothing, returns zero, and
+ * sets an API error code. PCL wrappers of these functions throw an
+ * APIFunctionError exception, as they do when the core application rejects a
+ * call.
+ *
+ * A headless application must call Initialize() before using any PCL class
+ * that depends on the API, typically at the beginning of its main() function.
+ * Module code that calls MetaModule::ProcessEvents() or other MetaModule
+ * members also requires an instance of a MetaModule derived class, which the
+ * application can define as usual.
+ *
+ * \note %HeadlessAPI is available on POSIX platforms (FreeBSD, Linux and Mac
+ * OS X). It must never be initialized in a module loaded by the PixInsight
+ * core application.
+ */
+class PCL_CLASS HeadlessAPI
+{
+public:
+
+   /*!
+    * Default constructor. This constructor is disabled because %HeadlessAPI
+    * is not an instantiable class.
+    */
+   HeadlessAPI() = delete;
+
+   /*!
+    * Copy constructor. This constructor is disabled because %HeadlessAPI is
+    * not an instantiable class.
+    */
+   HeadlessAPI( const HeadlessAPI& ) = delete;
+
+   /*!
+    * Destructor. This destructor is disabled because %HeadlessAPI is not an
+    * instantiable class.
+    */
+   ~HeadlessAPI() = delete;
+
+   /*!
+    * Installs the native API implementation as the global API object.
+    *
+    * \param maxProcessors    Maximum number of processors allowed for
+    *                         parallel processing. If zero or negative, all
+    *                         logical processors available will be used. If
+    *                         one, parallel processing will be disabled.
+    *
+    * Throws an Error exception if the global API object has already been
+    * initialized, either by a previous call to this function or by the core
+    * application.
+    */
+   static void Initialize( int maxProcessors = 0 );
+
+   /*!
+    * Destroys the global API object created by Initialize(). The worker
+    * threads of the ThreadPool are shut down by this function; any other
+    * threads created through the API must have been terminated before calling
+    * it. Does nothing if the headless API has not been initialized.
+    */
+   static void Terminate();
+
+   /*!
+    * Returns true iff the global API object has been created by Initialize().
+    */
+   static bool IsInitialized();
+
+   /*!
+    * Returns the destination of console output text. The default destination
+    * is HeadlessConsoleOutput::StandardOutput.
+    */
+   static HeadlessConsoleOutput::value_type ConsoleOutput();
+
+   /*!
+    * Sets the destination of console output text.
+    */
+   static void SetConsoleOutput( HeadlessConsoleOutput::value_type output );
+
+   /*!
+    * Native API function resolver. Returns the address of the native
+    * implementation of the API function with the specified \a name, which has
+    * the form "Context/Function", or the address of a stub function if the
+    * requested function is not implemented natively.
+    *
+    * This is the resolver used by Initialize() to construct the global API
+    * object. It can also be used to determine whether a function is available
+    * in headless applications; see IsNativeFunction().
+    */
+   static void* FunctionAddress( const char* name );
+
+   /*!
+    * Returns true iff the API function with the specified \a name, which has
+    * the form "Context/Function", is implemented natively.
+    */
+   static bool IsNativeFunction( const char* name );
+};
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+#endif   // __PCL_HeadlessAPI_h
+
+// ----------------------------------------------------------------------------
+// EOF pcl/HeadlessAPI.h - Released 2016/02/21 20:22:12 UTC
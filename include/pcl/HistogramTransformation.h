@@ -111,7 +111,9 @@ public:
                             double lr = 0, double hr = 1 ) :
       ImageTransformation(),
       m_parallel( true ),
-      m_maxProcessors( PCL_MAX_PROCESSORS )
+      m_exact( false ),
+      m_maxProcessors( PCL_MAX_PROCESSORS ),
+      m_tolerance( 1.0e-06 )
    {
       PCL_PRECONDITION( mb >= 0 && mb <= 1 )
       PCL_PRECONDITION( sc >= 0 && sc <= 1 )
@@ -527,6 +529,175 @@ public:
       m_maxProcessors = unsigned( Range( maxProcessors, 1, PCL_MAX_PROCESSORS ) );
    }
 
+   /*!
+    * Returns true iff this object always evaluates the transformation chain
+    * exactly for 32-bit floating point data.
+    *
+    * By default, transformations of 32-bit floating point images and arrays
+    * are computed with a piecewise cubic approximation of the whole
+    * transformation chain, whose accuracy is given by EvaluationTolerance().
+    * See the HistogramTransformation::Evaluator class for details. When exact
+    * evaluation is enabled, each transformation in the chain is evaluated
+    * with double precision arithmetic for each sample. 64-bit floating point
+    * and 32-bit integer data are always transformed exactly.
+    */
+   bool IsExactEvaluationEnabled() const
+   {
+      return m_exact;
+   }
+
+   /*!
+    * Enables exact evaluation of the transformation chain for 32-bit floating
+    * point data.
+    */
+   void EnableExactEvaluation( bool enable = true )
+   {
+      m_exact = enable;
+   }
+
+   /*!
+    * Disables exact evaluation of the transformation chain for 32-bit floating
+    * point data.
+    *
+    * This is a convenience function, equivalent to:
+    * EnableExactEvaluation( !disable )
+    */
+   void DisableExactEvaluation( bool disable = true )
+   {
+      EnableExactEvaluation( !disable );
+   }
+
+   /*!
+    * Returns the maximum absolute error allowed for approximate evaluation of
+    * the transformation chain, in the normalized [0,1] range. The default
+    * tolerance is 1e-6.
+    */
+   double EvaluationTolerance() const
+   {
+      return m_tolerance;
+   }
+
+   /*!
+    * Sets the maximum absolute error allowed for approximate evaluation of the
+    * transformation chain. The specified \a tolerance is constrained to the
+    * [1e-8,1e-2] range.
+    *
+    * If the required accuracy cannot be achieved for a transformation chain,
+    * the chain is evaluated exactly.
+    */
+   void SetEvaluationTolerance( double tolerance )
+   {
+      m_tolerance = pcl::Range( tolerance, 1.0e-08, 1.0e-02 );
+   }
+
+   /*!
+    * \class pcl::HistogramTransformation::Evaluator
+    * \brief Fast approximate evaluation of a histogram transformation chain.
+    *
+    * %Evaluator composes all transformations in a histogram transformation
+    * chain into a single function, and approximates it with a table of cubic
+    * polynomials for fast evaluation of 32-bit floating point samples.
+    *
+    * A histogram transformation chain is constant below and above two
+    * breakpoints defined by its clipping points, and smooth between them.
+    * %Evaluator finds both breakpoints and subdivides the range between them
+    * into uniform intervals, where the chain is interpolated by cubic
+    * polynomials at four equally spaced points. The number of intervals is
+    * doubled until the maximum interpolation error, measured against exact
+    * evaluation of the chain at three points on each interval, does not
+    * exceed the specified tolerance, or until a maximum of 2^18 intervals is
+    * reached. The resulting error estimate is available by calling Error().
+    */
+   class PCL_CLASS Evaluator
+   {
+   public:
+
+      /*!
+       * Constructs an evaluator for the specified transformation chain \a H,
+       * with the specified maximum absolute error \a tolerance.
+       */
+      Evaluator( const HistogramTransformation& H, double tolerance = 1.0e-06 );
+
+      /*!
+       * Returns the estimated maximum absolute error of this evaluator in the
+       * normalized [0,1] range.
+       */
+      double Error() const
+      {
+         return m_error;
+      }
+
+      /*!
+       * Returns the maximum absolute error requested for this evaluator.
+       */
+      double Tolerance() const
+      {
+         return m_tolerance;
+      }
+
+      /*!
+       * Returns true iff the estimated error of this evaluator does not exceed
+       * the requested tolerance.
+       */
+      bool IsValid() const
+      {
+         return m_error <= m_tolerance;
+      }
+
+      /*!
+       * Returns the number of cubic interpolation intervals.
+       */
+      int NumberOfIntervals() const
+      {
+         return m_intervals;
+      }
+
+      /*!
+       * Returns the approximate value of the transformation chain for the
+       * specified value \a x. Values outside the [0,1] range are clipped.
+       */
+      float operator()( float x ) const
+      {
+         float u = (x - m_x0)*m_scale;
+         if ( !(u > 0) )
+            u = 0;
+         else if ( u > m_intervals )
+            u = float( m_intervals );
+         int k = TruncInt( pcl::Min( u, m_maxIndex ) );
+         float t = u - k;
+         const float* c = m_table.Begin() + 4*k;
+         return c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+      }
+
+      /*!
+       * Transforms a contiguous sequence of \a n samples in place.
+       */
+      void Apply( float* a, size_type n ) const
+      {
+         Apply( a, n, 0, 1 );
+      }
+
+      /*!
+       * Transforms a contiguous sequence of \a n samples in place. Samples
+       * are rescaled from the [x0,x1] range to [0,1] before evaluation, and
+       * transformed values are rescaled back to [x0,x1].
+       */
+      void Apply( float* a, size_type n, float x0, float x1 ) const;
+
+   private:
+
+      Array<float> m_table;      // four polynomial coefficients per interval
+      int          m_intervals;  // number of intervals
+      float        m_x0;         // lower breakpoint
+      float        m_scale;      // intervals per unit
+      float        m_maxIndex;   // m_intervals - 1
+      double       m_tolerance;
+      double       m_error;
+
+      void Build( const HistogramTransformation& H, double a, double b, int n );
+      double Measure( const HistogramTransformation& H, double a, double b ) const;
+   };
+
 private:
 
    /*!
@@ -552,7 +723,9 @@ private:
    double              m_expandHigh;        // highlights dynamic range expansion
    Flags               m_flags;             // transformation flags
    bool                m_parallel      : 1; // use multiple execution threads
+   bool                m_exact         : 1; // always evaluate the transformation chain exactly
    unsigned            m_maxProcessors : PCL_MAX_PROCESSORS_BITCOUNT; // Maximum number of processors allowed
+   double              m_tolerance;         // maximum error of the fast evaluator
    transformation_list m_transformChain;    // more transformations
 
    void UpdateFlags();
@@ -268,6 +268,7 @@ namespace ImageOp
 class PCL_CLASS ImageVariant;
 class PCL_CLASS ImageTransformation;
 class PCL_CLASS BidirectionalImageTransformation;
+template <class E> class PCL_CLASS ImageExpr;
 
 // ----------------------------------------------------------------------------
 
@@ -7226,14 +7227,20 @@ public:
 
       if ( r == image.Bounds() )
          for ( int c = 0; firstChannel <= lastChannel; ++c, ++firstChannel )
-            P::Copy( m_pixelData[c], image[firstChannel], NumberOfPixels() );
+            ParallelCopy( m_pixelData[c], image[firstChannel], NumberOfPixels() );
       else
          for ( int c = 0; firstChannel <= lastChannel; ++c, ++firstChannel )
          {
             sample* f = m_pixelData[c];
             const typename P1::sample* g = image.PixelAddress( r.LeftTop(), firstChannel );
-            for ( int y = 0; y < m_height; ++y, f += m_width, g += image.Width() )
-               P::Copy( f, g, m_width );
+            int w = m_width;
+            int sw = image.Width();
+            ThreadPool::ParallelFor( m_height, pcl::Max( 1, 65536/w ),
+               [=]( int startRow, int endRow )
+               {
+                  for ( int y = startRow; y < endRow; ++y )
+                     P::Copy( f + size_type( y )*w, g + size_type( y )*sw, w );
+               } );
          }
 
       return *this;
@@ -7396,6 +7403,23 @@ public:
       return Fill( scalar );
    }
 
+   /*!
+    * Evaluates an image expression and assigns the result to this image.
+    * Returns a reference to this image.
+    *
+    * The expression is evaluated for all pixel samples in a single pass. If
+    * necessary, this image is reallocated to match the geometry of the
+    * expression. See the ImageExpr class for more information.
+    *
+    * \note Increments the status monitoring object by the number of evaluated
+    * pixel samples.
+    */
+   template <class E>
+   GenericImage& operator =( const ImageExpr<E>& expr )
+   {
+      return expr.EvaluateTo( *this );
+   }
+
    /*!
     * Exchanges two images \a x1 and \a x2 of the same template instantiation.
     */
@@ -11633,6 +11657,11 @@ public:
     * high and low medians is statistically irrelevant (modulo special cases
     * that are irrelevant for practical matters).
     *
+    * The median is computed with a parallel multi-pass radix selection
+    * algorithm that does not copy pixel samples. For 8-bit and 16-bit integer
+    * images the median is found in a single pass over the selected samples;
+    * wider sample types require two to four passes.
+    *
     * \note Increments the status monitoring object by the number of selected
     * pixel samples.
     */
@@ -11647,49 +11676,21 @@ public:
       if ( m_status.IsInitializationEnabled() )
          m_status.Initialize( "Computing median sample value", N );
 
-      int numberOfThreads = this->NumberOfThreadsForRows( r.Height(), r.Width(), maxProcessors );
-      int rowsPerThread = r.Height()/numberOfThreads;
-      bool useAffinity = m_parallel && Thread::IsRootThread();
+      RadixSelectionData s( SampleKeyBits() );
+      Array<size_type> H = RadixHistogram( s, r, firstChannel, lastChannel, maxProcessors );
+      size_type n = 0;
+      for ( Array<size_type>::const_iterator i = H.Begin(); i != H.End(); ++i )
+         n += *i;
 
-      ReferenceArray<SmpThread> threads;
-      for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
-         threads.Add( new SmpThread( *this, r, firstChannel, lastChannel,
-                                     i*rowsPerThread,
-                                     (j < numberOfThreads) ? j*rowsPerThread : r.Height() ) );
-      if ( numberOfThreads > 1 )
+      double m = 0;
+      if ( n > 1 )
       {
-         for ( typename ReferenceArray<SmpThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-            i->Start( ThreadPriority::DefaultMax, useAffinity ? Distance( threads.Begin(), i ) : -1 );
-         for ( typename ReferenceArray<SmpThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-            i->Wait();
+         size_type n2 = n >> 1;
+         m = SampleKeyValue( RadixSelect( s, H, n2, r, firstChannel, lastChannel, maxProcessors ) );
+         if ( n < 0x10000 )
+            if ( (n & 1) == 0 )
+               m = (m + SampleKeyValue( RadixSelect( s, H, n2-1, r, firstChannel, lastChannel, maxProcessors ) ))/2;
       }
-      else
-         threads[0].Run();
-
-      Array<sample> samples;
-      for ( typename ReferenceArray<SmpThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-         if ( !i->samples.IsEmpty() )
-         {
-            samples.Add( i->samples.Begin(), i->samples.At( i->n ) );
-            i->samples.Clear();
-         }
-
-      threads.Destroy();
-
-      size_type n = samples.Length();
-      if ( n < 2 )
-         return 0;
-
-      size_type n2 = n >> 1;
-      double m;
-      P::FromSample( m, *pcl::Select( samples.Begin(), samples.End(), n2 ) );
-      if ( n < 0x10000 )
-         if ( (n & 1) == 0 )
-         {
-            double m1;
-            P::FromSample( m1, *pcl::Select( samples.Begin(), samples.End(), n2-1 ) );
-            m = (m + m1)/2;
-         }
 
       m_status += N;
 
@@ -11968,6 +11969,11 @@ public:
     * \note To make the MAD estimator consistent with the standard deviation of
     * a normal distribution, it must be multiplied by the constant 1.4826.
     *
+    * Absolute deviations are selected with the same radix selection
+    * algorithm used by Median(), without copying pixel samples. For 8-bit and
+    * 16-bit integer images, a single pass over the selected samples is
+    * required.
+    *
     * \note Increments the status monitoring object by the number of selected
     * pixel samples.
     */
@@ -11982,46 +11988,56 @@ public:
       if ( m_status.IsInitializationEnabled() )
          m_status.Initialize( "Computing median absolute deviation", N );
 
-      int numberOfThreads = this->NumberOfThreadsForRows( r.Height(), r.Width(), maxProcessors );
-      int rowsPerThread = r.Height()/numberOfThreads;
-      bool useAffinity = m_parallel && Thread::IsRootThread();
+      double mad = 0;
+
+      if ( P::BitsPerSample() <= 16 && !P::IsFloatSample() && !P::IsComplexSample() )
+      {
+         /*
+          * For 8-bit and 16-bit integer images, a single pass yields the exact
+          * distribution of sample values. Order statistics of absolute
+          * deviations are then computed from the sorted distinct deviations.
+          */
+         RadixSelectionData s( SampleKeyBits() );
+         Array<size_type> H = RadixHistogram( s, r, firstChannel, lastChannel, maxProcessors );
+         Array<AbsDevBin> D;
+         size_type n = 0;
+         for ( size_type i = 0; i < H.Length(); ++i )
+            if ( H[i] > 0 )
+            {
+               double v; P::FromSample( v, sample( i ) );
+               D.Add( AbsDevBin( pcl::Abs( v - center ), H[i] ) );
+               n += H[i];
+            }
 
-      ReferenceArray<SmpAbsDevThread> threads;
-      for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
-         threads.Add( new SmpAbsDevThread( *this, center, r, firstChannel, lastChannel,
-                                           i*rowsPerThread,
-                                           (j < numberOfThreads) ? j*rowsPerThread : r.Height() ) );
-      if ( numberOfThreads > 1 )
-      {
-         for ( typename ReferenceArray<SmpAbsDevThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-            i->Start( ThreadPriority::DefaultMax, useAffinity ? Distance( threads.Begin(), i ) : -1 );
-         for ( typename ReferenceArray<SmpAbsDevThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-            i->Wait();
+         if ( n > 1 )
+         {
+            pcl::Sort( D.Begin(), D.End() );
+            size_type n2 = n >> 1;
+            mad = AbsDevBinValue( D, n2 );
+            if ( (n & 1) == 0 && n <= 0xffff )
+               mad = (mad + AbsDevBinValue( D, n2-1 ))/2;
+         }
       }
       else
-         threads[0].Run();
+      {
+         RadixSelectionData s( 64, true, center );
+         Array<size_type> H = RadixHistogram( s, r, firstChannel, lastChannel, maxProcessors );
+         size_type n = 0;
+         for ( Array<size_type>::const_iterator i = H.Begin(); i != H.End(); ++i )
+            n += *i;
 
-      Array<double> devs;
-      for ( typename ReferenceArray<SmpAbsDevThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
-         if ( !i->devs.IsEmpty() )
+         if ( n > 1 )
          {
-            devs.Add( i->devs.Begin(), i->devs.At( i->n ) );
-            i->devs.Clear();
+            size_type n2 = n >> 1;
+            mad = DoubleFromSelectionKey( RadixSelect( s, H, n2, r, firstChannel, lastChannel, maxProcessors ) );
+            if ( (n & 1) == 0 && n <= 0xffff )
+               mad = (mad + DoubleFromSelectionKey( RadixSelect( s, H, n2-1, r, firstChannel, lastChannel, maxProcessors ) ))/2;
          }
-
-      threads.Destroy();
+      }
 
       m_status += N;
 
-      size_type n = devs.Length();
-      if ( n < 2 )
-         return 0;
-
-      size_type n2 = n >> 1;
-      if ( n & 1 || n > 0xffff )
-         return *pcl::Select( devs.Begin(), devs.End(), n2 );
-      return (*pcl::Select( devs.Begin(), devs.End(), n2 )
-            + *pcl::Select( devs.Begin(), devs.End(), n2-1 ))/2;
+      return mad;
    }
 
    /*!
@@ -14688,6 +14704,31 @@ private:
          delete m_data;
    }
 
+   /*!
+    * \internal
+    * Copies and converts a contiguous block of \a n samples, in parallel for
+    * large blocks. Used by converting assignments between different template
+    * instantiations, where data type conversions dominate execution time.
+    */
+   template <typename T>
+   static void ParallelCopy( sample* f, const T* g, size_type n )
+   {
+      const size_type blockSize = 65536;
+      size_type blocks = (n + blockSize - 1)/blockSize;
+      if ( blocks < 4 || blocks > size_type( int_max ) )
+      {
+         P::Copy( f, g, n );
+         return;
+      }
+      ThreadPool::ParallelFor( int( blocks ), 0,
+         [=]( int startBlock, int endBlock )
+         {
+            size_type i = size_type( startBlock )*blockSize;
+            size_type j = pcl::Min( n, size_type( endBlock )*blockSize );
+            P::Copy( f+i, g+i, j-i );
+         } );
+   }
+
    // -------------------------------------------------------------------------
 
    class RectThreadBase : public Thread
@@ -15086,32 +15127,6 @@ private:
 
    // -------------------------------------------------------------------------
 
-   class SmpThread : public RectThreadBase
-   {
-   public:
-
-      Array<sample> samples;
-      size_type n;
-
-      SmpThread( const GenericImage& image, const Rect& rect, int ch1, int ch2, int firstRow, int endRow ) :
-         RectThreadBase( image, rect, ch1, ch2, firstRow, endRow ), samples(), n( 0 )
-      {
-         size_type N = size_type(  this->m_rect.Width() )
-                     * size_type( this->m_endRow - this->m_firstRow )
-                     * (1 + this->m_ch2 - this->m_ch1);
-         samples = Array<sample>( N );
-      }
-
-   private:
-
-      virtual void Perform( const sample* f )
-      {
-         samples[n++] = *f;
-      }
-   };
-
-   // -------------------------------------------------------------------------
-
    class VarThread : public RectThreadBase
    {
    public:
@@ -15139,35 +15154,6 @@ private:
 
    // -------------------------------------------------------------------------
 
-   class SmpAbsDevThread : public RectThreadBase
-   {
-   public:
-
-      Array<double> devs;
-      size_type n;
-
-      SmpAbsDevThread( const GenericImage& image, double center, const Rect& rect, int ch1, int ch2, int firstRow, int endRow ) :
-         RectThreadBase( image, rect, ch1, ch2, firstRow, endRow ), devs(), n( 0 ), m_center( center )
-      {
-         size_type N = size_type(  this->m_rect.Width() )
-                     * size_type( this->m_endRow - this->m_firstRow )
-                     * (1 + this->m_ch2 - this->m_ch1);
-         devs = Array<double>( N );
-      }
-
-   private:
-
-      double m_center;
-
-      virtual void Perform( const sample* f )
-      {
-         double v; P::FromSample( v, *f );
-         devs[n++] = pcl::Abs( v - m_center );
-      }
-   };
-
-   // -------------------------------------------------------------------------
-
    class SumAbsDevThread : public SumThread
    {
    public:
@@ -15252,6 +15238,275 @@ private:
 
    // -------------------------------------------------------------------------
 
+   /*
+    * Order statistics by parallel multi-pass radix selection.
+    *
+    * Sample values, or absolute deviations from a center value, are mapped
+    * to unsigned integer keys with the same ordering: unsigned integer samples
+    * are their own keys, and IEEE 754 floating point values are mapped by
+    * inverting all bits of negative values and the sign bit of positive
+    * values. Complex samples are ordered by their magnitudes. Each pass
+    * builds per-thread histograms of the next 16 key bits (or less) for
+    * samples whose already resolved high-order key bits match, so 8-bit and
+    * 16-bit samples are resolved exactly in a single pass. For wider keys,
+    * as soon as the selected bin is small enough its keys are gathered and
+    * the order statistic is found by quick selection. Pixel samples are
+    * never copied.
+    */
+
+   struct RadixSelectionData
+   {
+      int    keyBits;      // total number of key bits
+      int    resolvedBits; // number of already resolved high-order key bits
+      int    digitBits;    // number of key bits classified in the current pass
+      uint64 prefix;       // resolved high-order key bits
+      bool   absDev;       // select absolute deviations from center
+      double center;       // center value for absolute deviations
+      bool   gather;       // gather matching keys instead of classifying them
+
+      RadixSelectionData( int bits, bool absoluteDeviations = false, double centerValue = 0 ) :
+         keyBits( bits ), resolvedBits( 0 ), digitBits( pcl::Min( 16, bits ) ), prefix( 0 ),
+         absDev( absoluteDeviations ), center( centerValue ), gather( false )
+      {
+      }
+   };
+
+   static uint64 SelectionKey( uint8 x )
+   {
+      return x;
+   }
+
+   static uint64 SelectionKey( uint16 x )
+   {
+      return x;
+   }
+
+   static uint64 SelectionKey( uint32 x )
+   {
+      return x;
+   }
+
+   static uint64 SelectionKey( float x )
+   {
+      union { float f; uint32 u; } v;
+      v.f = x;
+      return (v.u & 0x80000000u) ? ~v.u : (v.u | 0x80000000u);
+   }
+
+   static uint64 SelectionKey( double x )
+   {
+      union { double f; uint64 u; } v;
+      v.f = x;
+      return (v.u & 0x8000000000000000ull) ? ~v.u : (v.u | 0x8000000000000000ull);
+   }
+
+   template <typename T>
+   static uint64 SelectionKey( const Complex<T>& x )
+   {
+      return SelectionKey( x.Mag() );
+   }
+
+   static float FloatFromSelectionKey( uint64 k )
+   {
+      union { float f; uint32 u; } v;
+      v.u = (k & 0x80000000u) ? uint32( k & 0x7FFFFFFFu ) : ~uint32( k );
+      return v.f;
+   }
+
+   static double DoubleFromSelectionKey( uint64 k )
+   {
+      union { double f; uint64 u; } v;
+      v.u = (k & 0x8000000000000000ull) ? (k & 0x7FFFFFFFFFFFFFFFull) : ~k;
+      return v.f;
+   }
+
+   static constexpr int SampleKeyBits()
+   {
+      return P::BitsPerSample(); // for complex samples, the size of a component
+   }
+
+   /*
+    * The normalized value of a sample, or of the magnitude of a complex
+    * sample, from its selection key.
+    */
+   static double SampleKeyValue( uint64 k )
+   {
+      if ( P::IsFloatSample() || P::IsComplexSample() )
+         return (SampleKeyBits() == 32) ? double( FloatFromSelectionKey( k ) ) : DoubleFromSelectionKey( k );
+      double v; P::FromSample( v, sample( k ) );
+      return v;
+   }
+
+   class RadixSelectionThread : public RectThreadBase
+   {
+   public:
+
+      Array<size_type> histogram;
+      Array<uint64>    keys;
+
+      RadixSelectionThread( const GenericImage& image, const RadixSelectionData& data,
+                            const Rect& rect, int ch1, int ch2, int firstRow, int endRow ) :
+         RectThreadBase( image, rect, ch1, ch2, firstRow, endRow ),
+         histogram(), keys(), m_data( data ),
+         m_prefixShift( data.keyBits - data.resolvedBits ),
+         m_digitShift( data.keyBits - data.resolvedBits - data.digitBits ),
+         m_digitMask( (uint64( 1 ) << data.digitBits) - 1 )
+      {
+         if ( !m_data.gather )
+            histogram = Array<size_type>( size_type( 1 ) << data.digitBits, size_type( 0 ) );
+      }
+
+   private:
+
+      const RadixSelectionData& m_data;
+            int                 m_prefixShift;
+            int                 m_digitShift;
+            uint64              m_digitMask;
+
+      virtual void Perform( const sample* f )
+      {
+         uint64 k;
+         if ( m_data.absDev )
+         {
+            double v; P::FromSample( v, *f );
+            k = SelectionKey( pcl::Abs( v - m_data.center ) );
+         }
+         else
+            k = SelectionKey( *f );
+
+         if ( m_data.resolvedBits > 0 )
+            if ( (k >> m_prefixShift) != m_data.prefix )
+               return;
+
+         if ( m_data.gather )
+            keys.Add( k );
+         else
+            ++histogram[(k >> m_digitShift) & m_digitMask];
+      }
+   };
+
+   /*
+    * Performs a radix selection pass. Generates the merged histogram H of the
+    * current key digit, or the merged array of matching keys if the gather
+    * member of the specified selection data is true.
+    */
+   void RadixPass( Array<size_type>& H, Array<uint64>& keys, const RadixSelectionData& data,
+                   const Rect& r, int firstChannel, int lastChannel, int maxProcessors ) const
+   {
+      int numberOfThreads = this->NumberOfThreadsForRows( r.Height(), r.Width(), maxProcessors );
+      int rowsPerThread = r.Height()/numberOfThreads;
+      bool useAffinity = m_parallel && Thread::IsRootThread();
+
+      ReferenceArray<RadixSelectionThread> threads;
+      for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+         threads.Add( new RadixSelectionThread( *this, data, r, firstChannel, lastChannel,
+                                                i*rowsPerThread,
+                                                (j < numberOfThreads) ? j*rowsPerThread : r.Height() ) );
+      if ( numberOfThreads > 1 )
+      {
+         for ( typename ReferenceArray<RadixSelectionThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
+            i->Start( ThreadPriority::DefaultMax, useAffinity ? Distance( threads.Begin(), i ) : -1 );
+         for ( typename ReferenceArray<RadixSelectionThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
+            i->Wait();
+      }
+      else
+         threads[0].Run();
+
+      if ( data.gather )
+      {
+         keys.Clear();
+         for ( typename ReferenceArray<RadixSelectionThread>::iterator i = threads.Begin(); i != threads.End(); ++i )
+            keys.Add( i->keys );
+      }
+      else
+      {
+         H = threads[0].histogram;
+         for ( typename ReferenceArray<RadixSelectionThread>::iterator i = threads.Begin(); ++i != threads.End(); )
+            for ( size_type j = 0; j < H.Length(); ++j )
+               H[j] += i->histogram[j];
+      }
+
+      threads.Destroy();
+   }
+
+   Array<size_type> RadixHistogram( const RadixSelectionData& data,
+                                    const Rect& r, int firstChannel, int lastChannel, int maxProcessors ) const
+   {
+      Array<size_type> H;
+      Array<uint64> keys;
+      RadixPass( H, keys, data, r, firstChannel, lastChannel, maxProcessors );
+      return H;
+   }
+
+   /*
+    * Returns the key of the order statistic of rank k, starting from the
+    * histogram H of the first key digit.
+    */
+   uint64 RadixSelect( RadixSelectionData data, const Array<size_type>& H0, size_type k,
+                       const Rect& r, int firstChannel, int lastChannel, int maxProcessors ) const
+   {
+      Array<size_type> H = H0;
+      for ( ;; )
+      {
+         size_type b = 0;
+         for ( ; b < H.Length()-1; ++b )
+         {
+            if ( k < H[b] )
+               break;
+            k -= H[b];
+         }
+
+         data.prefix = (data.prefix << data.digitBits) | b;
+         data.resolvedBits += data.digitBits;
+         if ( data.resolvedBits == data.keyBits )
+            return data.prefix;
+
+         if ( H[b] <= 0x40000 )
+         {
+            data.gather = true;
+            Array<uint64> keys;
+            RadixPass( H, keys, data, r, firstChannel, lastChannel, maxProcessors );
+            return *pcl::Select( keys.Begin(), keys.End(), distance_type( k ) );
+         }
+
+         data.digitBits = pcl::Min( 16, data.keyBits - data.resolvedBits );
+         H = RadixHistogram( data, r, firstChannel, lastChannel, maxProcessors );
+      }
+   }
+
+   struct AbsDevBin
+   {
+      double    d;
+      size_type n;
+
+      AbsDevBin( double dev = 0, size_type count = 0 ) : d( dev ), n( count )
+      {
+      }
+
+      bool operator ==( const AbsDevBin& x ) const
+      {
+         return d == x.d;
+      }
+
+      bool operator <( const AbsDevBin& x ) const
+      {
+         return d < x.d;
+      }
+   };
+
+   static double AbsDevBinValue( const Array<AbsDevBin>& D, size_type k )
+   {
+      for ( typename Array<AbsDevBin>::const_iterator i = D.Begin(); i != D.End(); ++i )
+      {
+         if ( k < i->n )
+            return i->d;
+         k -= i->n;
+      }
+      return D.IsEmpty() ? 0.0 : D[D.Length()-1].d;
+   }
+
+   // -------------------------------------------------------------------------
+
    class ColorSpaceConversionThread : public Thread
    {
    public:
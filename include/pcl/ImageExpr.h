@@ -0,0 +1,782 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/ImageExpr.h - Released 2016/02/21 20:22:12 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#ifndef __PCL_ImageExpr_h
+#define __PCL_ImageExpr_h
+
+/// \file pcl/ImageExpr.h
+
+#ifndef __PCL_Defs_h
+#include <pcl/Defs.h>
+#endif
+
+#ifndef __PCL_Image_h
+#include <pcl/Image.h>
+#endif
+
+#ifndef __PCL_ThreadPool_h
+#include <pcl/ThreadPool.h>
+#endif
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \namespace pcl::ImageExprOp
+ * \brief Element-wise operators of image expressions.
+ *
+ * Each operator implements the same arithmetic as the homonymous ImageOp
+ * operator for floating point pixel samples (see the PixelTraits classes),
+ * applied to normalized real sample values.
+ */
+namespace ImageExprOp
+{
+   struct Add
+   {
+      template <typename T> static void Apply( T& a, T b ) { a += b; }
+      static void CheckScalar( double ) {}
+   };
+
+   struct Sub
+   {
+      template <typename T> static void Apply( T& a, T b ) { a -= b; }
+      static void CheckScalar( double ) {}
+   };
+
+   struct Mul
+   {
+      template <typename T> static void Apply( T& a, T b ) { a *= b; }
+      static void CheckScalar( double ) {}
+   };
+
+   struct Div
+   {
+      template <typename T> static void Apply( T& a, T b ) { a /= b; }
+      static void CheckScalar( double x )
+      {
+         if ( 1 + x == 1 )
+            throw Error( "Division by zero or insignificant scalar" );
+      }
+   };
+
+   struct Pow
+   {
+      template <typename T> static void Apply( T& a, T b ) { a = pcl::Pow( a, b ); }
+      static void CheckScalar( double ) {}
+   };
+
+   struct Dif
+   {
+      template <typename T> static void Apply( T& a, T b ) { a = pcl::Abs( a - b ); }
+      static void CheckScalar( double ) {}
+   };
+
+   struct Min
+   {
+      template <typename T> static void Apply( T& a, T b ) { a = pcl::Min( a, b ); }
+      static void CheckScalar( double ) {}
+   };
+
+   struct Max
+   {
+      template <typename T> static void Apply( T& a, T b ) { a = pcl::Max( a, b ); }
+      static void CheckScalar( double ) {}
+   };
+
+   struct Abs
+   {
+      template <typename T> static void Apply( T& a ) { a = pcl::Abs( a ); }
+   };
+}
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Real type used to evaluate expressions for a given target image type.
+ * 32-bit floating point is enough for all pixel sample types, except 64-bit
+ * floating point and 32-bit unsigned integer images.
+ */
+template <class P>
+struct PCL_CLASS ImageExprWorkingType
+{
+   typedef float type;
+};
+
+template <>
+struct PCL_CLASS ImageExprWorkingType<DoublePixelTraits>
+{
+   typedef double type;
+};
+
+template <>
+struct PCL_CLASS ImageExprWorkingType<DComplexPixelTraits>
+{
+   typedef double type;
+};
+
+template <>
+struct PCL_CLASS ImageExprWorkingType<UInt32PixelTraits>
+{
+   typedef double type;
+};
+
+/*
+ * Conversion of evaluated values to target pixel samples. Integer samples are
+ * saturated, as happens with the ImageOp operators for integer images.
+ */
+template <class P>
+struct PCL_CLASS ImageExprStore
+{
+   template <typename T>
+   static void Store( typename P::sample& a, T x )
+   {
+      a = P::ToSample( x );
+   }
+};
+
+template <>
+struct PCL_CLASS ImageExprStore<UInt8PixelTraits>
+{
+   template <typename T>
+   static void Store( UInt8PixelTraits::sample& a, T x )
+   {
+      a = UInt8PixelTraits::ToSampleConstrained( x );
+   }
+};
+
+template <>
+struct PCL_CLASS ImageExprStore<UInt16PixelTraits>
+{
+   template <typename T>
+   static void Store( UInt16PixelTraits::sample& a, T x )
+   {
+      a = UInt16PixelTraits::ToSampleConstrained( x );
+   }
+};
+
+template <>
+struct PCL_CLASS ImageExprStore<UInt32PixelTraits>
+{
+   template <typename T>
+   static void Store( UInt32PixelTraits::sample& a, T x )
+   {
+      a = UInt32PixelTraits::ToSampleConstrained( x );
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Expression tree nodes.
+ *
+ * Every node evaluates a contiguous block of \a count samples of a channel,
+ * starting at the specified \a offset sample index, and writes the result to
+ * the \a out array. The References() member function returns true if the
+ * specified image is an operand of the node or of any of its subnodes. Nodes with two operands use a block of \a scratch space
+ * to evaluate their right-hand operands. The ScratchBlocks() static member
+ * function returns the number of scratch blocks required by a node.
+ *
+ * All image operands must have the same dimensions. An operand with a single
+ * channel is applied to all channels of the expression.
+ */
+
+template <class P>
+class PCL_CLASS ImageExprImage
+{
+public:
+
+   typedef GenericImage<P>          image_type;
+   typedef typename P::sample       sample;
+
+   ImageExprImage( const image_type& image ) : m_image( &image )
+   {
+   }
+
+   static int ScratchBlocks()
+   {
+      return 0;
+   }
+
+   void GetGeometry( int& width, int& height, int& numberOfChannels ) const
+   {
+      if ( m_image->IsEmpty() )
+         throw Error( "Empty image in image expression." );
+
+      if ( width == 0 )
+      {
+         width = m_image->Width();
+         height = m_image->Height();
+      }
+      else if ( m_image->Width() != width || m_image->Height() != height )
+         throw Error( "Incompatible image geometry in image expression." );
+
+      int n = m_image->NumberOfChannels();
+      if ( n != numberOfChannels )
+      {
+         if ( numberOfChannels <= 1 )
+            numberOfChannels = n;
+         else if ( n != 1 )
+            throw Error( "Incompatible number of channels in image expression." );
+      }
+   }
+
+   bool References( const void* image ) const
+   {
+      return image == m_image;
+   }
+
+   template <typename T>
+   void Evaluate( T* out, T* /*scratch*/, int channel, size_type offset, int count ) const
+   {
+      const sample* s = (*m_image)[(channel < m_image->NumberOfChannels()) ? channel : 0] + offset;
+      for ( int i = 0; i < count; ++i )
+         P::FromSample( out[i], s[i] );
+   }
+
+private:
+
+   const image_type* m_image;
+};
+
+template <class Op, class L, class R>
+class PCL_CLASS ImageExprBinary
+{
+public:
+
+   ImageExprBinary( const L& left, const R& right ) : m_left( left ), m_right( right )
+   {
+   }
+
+   static int ScratchBlocks()
+   {
+      return pcl::Max( L::ScratchBlocks(), 1 + R::ScratchBlocks() );
+   }
+
+   void GetGeometry( int& width, int& height, int& numberOfChannels ) const
+   {
+      m_left.GetGeometry( width, height, numberOfChannels );
+      m_right.GetGeometry( width, height, numberOfChannels );
+   }
+
+   bool References( const void* image ) const
+   {
+      return m_left.References( image ) || m_right.References( image );
+   }
+
+   template <typename T>
+   void Evaluate( T* out, T* scratch, int channel, size_type offset, int count ) const
+   {
+      m_left.Evaluate( out, scratch, channel, offset, count );
+      m_right.Evaluate( scratch, scratch+count, channel, offset, count );
+      for ( int i = 0; i < count; ++i )
+         Op::Apply( out[i], scratch[i] );
+   }
+
+private:
+
+   L m_left;
+   R m_right;
+};
+
+template <class Op, class L>
+class PCL_CLASS ImageExprScalarRight
+{
+public:
+
+   ImageExprScalarRight( const L& left, double scalar ) : m_left( left ), m_scalar( scalar )
+   {
+      Op::CheckScalar( scalar );
+   }
+
+   static int ScratchBlocks()
+   {
+      return L::ScratchBlocks();
+   }
+
+   void GetGeometry( int& width, int& height, int& numberOfChannels ) const
+   {
+      m_left.GetGeometry( width, height, numberOfChannels );
+   }
+
+   bool References( const void* image ) const
+   {
+      return m_left.References( image );
+   }
+
+   template <typename T>
+   void Evaluate( T* out, T* scratch, int channel, size_type offset, int count ) const
+   {
+      m_left.Evaluate( out, scratch, channel, offset, count );
+      T k = T( m_scalar );
+      for ( int i = 0; i < count; ++i )
+         Op::Apply( out[i], k );
+   }
+
+private:
+
+   L      m_left;
+   double m_scalar;
+};
+
+template <class Op, class R>
+class PCL_CLASS ImageExprScalarLeft
+{
+public:
+
+   ImageExprScalarLeft( double scalar, const R& right ) : m_scalar( scalar ), m_right( right )
+   {
+   }
+
+   static int ScratchBlocks()
+   {
+      return R::ScratchBlocks();
+   }
+
+   void GetGeometry( int& width, int& height, int& numberOfChannels ) const
+   {
+      m_right.GetGeometry( width, height, numberOfChannels );
+   }
+
+   bool References( const void* image ) const
+   {
+      return m_right.References( image );
+   }
+
+   template <typename T>
+   void Evaluate( T* out, T* scratch, int channel, size_type offset, int count ) const
+   {
+      m_right.Evaluate( out, scratch, channel, offset, count );
+      T k = T( m_scalar );
+      for ( int i = 0; i < count; ++i )
+      {
+         T a = k;
+         Op::Apply( a, out[i] );
+         out[i] = a;
+      }
+   }
+
+private:
+
+   double m_scalar;
+   R      m_right;
+};
+
+template <class Op, class A>
+class PCL_CLASS ImageExprUnary
+{
+public:
+
+   ImageExprUnary( const A& arg ) : m_arg( arg )
+   {
+   }
+
+   static int ScratchBlocks()
+   {
+      return A::ScratchBlocks();
+   }
+
+   void GetGeometry( int& width, int& height, int& numberOfChannels ) const
+   {
+      m_arg.GetGeometry( width, height, numberOfChannels );
+   }
+
+   bool References( const void* image ) const
+   {
+      return m_arg.References( image );
+   }
+
+   template <typename T>
+   void Evaluate( T* out, T* scratch, int channel, size_type offset, int count ) const
+   {
+      m_arg.Evaluate( out, scratch, channel, offset, count );
+      for ( int i = 0; i < count; ++i )
+         Op::Apply( out[i] );
+   }
+
+private:
+
+   A m_arg;
+};
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \class ImageExpr
+ * \brief Lazy evaluation of pixel-wise image expressions
+ *
+ * %ImageExpr represents an arithmetic expression whose operands are images
+ * and scalars. Image expressions are built with the Expr() function and the
+ * arithmetic operators and functions defined for %ImageExpr objects. Building
+ * an expression performs no calculations; the expression is evaluated when
+ * it is assigned to an image:
+ *
+ * \code
+ * Image target, dark, flat;
+ * double k, scale, pedestal;
+ * ...
+ * target = (Expr( target ) - Expr( dark )*k)/flat*scale + pedestal;
+ * \endcode
+ *
+ * The whole expression is evaluated for each pixel sample in a single pass.
+ * Samples are processed in small blocks that fit in the processor's data
+ * cache, with tight loops that are vectorized by the compiler, and blocks are
+ * distributed among the threads of the ThreadPool. Compared with the
+ * equivalent sequence of GenericImage::Apply() calls, each pixel sample is
+ * read from and written to main memory just once.
+ *
+ * Pixel samples of image operands are converted to normalized real values
+ * according to the PixelTraits conversion rules of each operand. The
+ * expression is evaluated with 32-bit floating point arithmetic, or 64-bit
+ * floating point for 64-bit floating point and 32-bit integer target images,
+ * and the result is converted to the target pixel sample type. Integer target
+ * samples are saturated to the native range, as happens with ImageOp
+ * operators. Unlike a sequence of ImageOp operations, intermediate results
+ * are neither rounded nor saturated for integer images.
+ *
+ * All image operands must have the same dimensions, and either the same
+ * number of channels or a single channel. A single-channel operand is applied
+ * to all channels of the expression. The target image is reallocated if its
+ * geometry differs from the geometry of the expression. The target image can
+ * also be an operand of the expression; if it has to be reallocated in that
+ * case, the expression is evaluated into a new image, which is then
+ * transferred to the target. Expressions are always evaluated for
+ * the entire images; the current selections of operand images are ignored.
+ *
+ * \note Image operands are referenced, not copied, by expression objects.
+ * Image operands must remain valid until the expression has been evaluated.
+ *
+ * \sa ImageOp, GenericImage::Apply()
+ */
+template <class E>
+class PCL_CLASS ImageExpr
+{
+public:
+
+   /*!
+    * Represents the root node of this expression.
+    */
+   typedef E   node_type;
+
+   /*!
+    * Number of pixel samples evaluated as a unit.
+    */
+   enum { BlockSize = 1024 };
+
+   /*!
+    * Constructs an expression with the specified root \a node.
+    */
+   explicit ImageExpr( const node_type& node ) : m_node( node )
+   {
+   }
+
+   /*!
+    * Returns a reference to the root node of this expression.
+    */
+   const node_type& Node() const
+   {
+      return m_node;
+   }
+
+   /*!
+    * Evaluates this expression and stores the result in the specified
+    * \a target image. Returns a reference to the target image.
+    *
+    * \note Increments the status monitoring object of the target image by the
+    * number of evaluated pixel samples.
+    */
+   template <class P>
+   GenericImage<P>& EvaluateTo( GenericImage<P>& target ) const
+   {
+      int width = 0, height = 0, numberOfChannels = 0;
+      m_node.GetGeometry( width, height, numberOfChannels );
+
+      if ( target.Width() != width || target.Height() != height || target.NumberOfChannels() != numberOfChannels )
+      {
+         typename GenericImage<P>::color_space colorSpace = (numberOfChannels < 3) ? ColorSpace::Gray : ColorSpace::RGB;
+
+         if ( m_node.References( &target ) )
+         {
+            /*
+             * The target image is an operand of this expression. Reallocating
+             * it would destroy pixel data before the expression reads them,
+             * so we evaluate into a new image and transfer it to the target.
+             */
+            GenericImage<P> result;
+            result.AllocateData( width, height, numberOfChannels, colorSpace );
+            result.SetRGBWorkingSpace( target.RGBWorkingSpace() );
+            result.EnableParallelProcessing( target.IsParallelProcessingEnabled(), target.MaxProcessors() );
+            result.Status() = target.Status();
+            Evaluate( result );
+            return target.Transfer( result );
+         }
+
+         target.AllocateData( width, height, numberOfChannels, colorSpace );
+      }
+      else
+         target.EnsureUnique();
+
+      Evaluate( target );
+      return target;
+   }
+
+   /*
+    * Functions of two expressions of the same type. These are necessary to
+    * resolve ambiguities with the homonymous template functions of PCL.
+    */
+   friend ImageExpr<ImageExprBinary<ImageExprOp::Min, E, E> > Min( const ImageExpr& a, const ImageExpr& b )
+   {
+      return ImageExpr<ImageExprBinary<ImageExprOp::Min, E, E> >( ImageExprBinary<ImageExprOp::Min, E, E>( a.m_node, b.m_node ) );
+   }
+
+   friend ImageExpr<ImageExprBinary<ImageExprOp::Max, E, E> > Max( const ImageExpr& a, const ImageExpr& b )
+   {
+      return ImageExpr<ImageExprBinary<ImageExprOp::Max, E, E> >( ImageExprBinary<ImageExprOp::Max, E, E>( a.m_node, b.m_node ) );
+   }
+
+   friend ImageExpr<ImageExprBinary<ImageExprOp::Pow, E, E> > Pow( const ImageExpr& a, const ImageExpr& b )
+   {
+      return ImageExpr<ImageExprBinary<ImageExprOp::Pow, E, E> >( ImageExprBinary<ImageExprOp::Pow, E, E>( a.m_node, b.m_node ) );
+   }
+
+private:
+
+   node_type m_node;
+
+   /*
+    * Evaluates this expression for all pixel samples of the specified image,
+    * which must have the geometry of the expression.
+    */
+   template <class P>
+   void Evaluate( GenericImage<P>& image ) const
+   {
+      typedef typename ImageExprWorkingType<P>::type  real;
+
+      int numberOfChannels = image.NumberOfChannels();
+      size_type N = image.NumberOfPixels();
+      if ( image.Status().IsInitializationEnabled() )
+         image.Status().Initialize( "Evaluating image expression", N*numberOfChannels );
+
+      int blocksPerChannel = int( (N + BlockSize - 1)/BlockSize );
+      int scratchLength = (1 + node_type::ScratchBlocks())*BlockSize;
+
+      ThreadPool::ParallelFor( blocksPerChannel*numberOfChannels, 0,
+         [&]( int begin, int end )
+         {
+            GenericVector<real> buffer( scratchLength );
+            real* out = buffer.Begin();
+            for ( int b = begin; b < end; ++b )
+            {
+               int c = b/blocksPerChannel;
+               size_type offset = size_type( b%blocksPerChannel )*BlockSize;
+               int count = int( pcl::Min( size_type( BlockSize ), N - offset ) );
+               m_node.Evaluate( out, out+count, c, offset, count );
+               typename P::sample* f = image[c] + offset;
+               for ( int i = 0; i < count; ++i )
+                  ImageExprStore<P>::Store( f[i], out[i] );
+            }
+         } );
+
+      image.Status() += N*numberOfChannels;
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \defgroup image_expressions Image Expressions
+ */
+
+/*!
+ * Returns an image expression consisting of a single image operand.
+ * \ingroup image_expressions
+ */
+template <class P> inline
+ImageExpr<ImageExprImage<P> > Expr( const GenericImage<P>& image )
+{
+   return ImageExpr<ImageExprImage<P> >( ImageExprImage<P>( image ) );
+}
+
+/*
+ * Binary operators and functions with expression, image and scalar operands.
+ */
+#define __PCL_IMAGE_EXPR_BINARY( Function, Op )                                                       \
+template <class E1, class E2> inline                                                                  \
+ImageExpr<ImageExprBinary<ImageExprOp::Op, E1, E2> >                                                  \
+Function( const ImageExpr<E1>& a, const ImageExpr<E2>& b )                                            \
+{                                                                                                     \
+   return ImageExpr<ImageExprBinary<ImageExprOp::Op, E1, E2> >(                                       \
+                        ImageExprBinary<ImageExprOp::Op, E1, E2>( a.Node(), b.Node() ) );             \
+}                                                                                                     \
+template <class E, class P> inline                                                                    \
+ImageExpr<ImageExprBinary<ImageExprOp::Op, E, ImageExprImage<P> > >                                   \
+Function( const ImageExpr<E>& a, const GenericImage<P>& b )                                           \
+{                                                                                                     \
+   return ImageExpr<ImageExprBinary<ImageExprOp::Op, E, ImageExprImage<P> > >(                        \
+                        ImageExprBinary<ImageExprOp::Op, E, ImageExprImage<P> >( a.Node(), b ) );     \
+}                                                                                                     \
+template <class P, class E> inline                                                                    \
+ImageExpr<ImageExprBinary<ImageExprOp::Op, ImageExprImage<P>, E> >                                    \
+Function( const GenericImage<P>& a, const ImageExpr<E>& b )                                           \
+{                                                                                                     \
+   return ImageExpr<ImageExprBinary<ImageExprOp::Op, ImageExprImage<P>, E> >(                         \
+                        ImageExprBinary<ImageExprOp::Op, ImageExprImage<P>, E>( a, b.Node() ) );      \
+}                                                                                                     \
+template <class E> inline                                                                             \
+ImageExpr<ImageExprScalarRight<ImageExprOp::Op, E> >                                                  \
+Function( const ImageExpr<E>& a, double b )                                                           \
+{                                                                                                     \
+   return ImageExpr<ImageExprScalarRight<ImageExprOp::Op, E> >(                                       \
+                        ImageExprScalarRight<ImageExprOp::Op, E>( a.Node(), b ) );                    \
+}                                                                                                     \
+template <class E> inline                                                                             \
+ImageExpr<ImageExprScalarLeft<ImageExprOp::Op, E> >                                                   \
+Function( double a, const ImageExpr<E>& b )                                                           \
+{                                                                                                     \
+   return ImageExpr<ImageExprScalarLeft<ImageExprOp::Op, E> >(                                        \
+                        ImageExprScalarLeft<ImageExprOp::Op, E>( a, b.Node() ) );                     \
+}
+
+/*!
+ * \fn operator +( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Addition of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( operator +, Add )
+
+/*!
+ * \fn operator -( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Subtraction of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( operator -, Sub )
+
+/*!
+ * \fn operator *( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Multiplication of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( operator *, Mul )
+
+/*!
+ * \fn operator /( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Division of image expressions, images and scalars. Throws an Error
+ * exception if the divisor is a zero or insignificant scalar.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( operator /, Div )
+
+/*!
+ * \fn operator ^( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Exponentiation of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( operator ^, Pow )
+
+/*!
+ * \fn Pow( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Exponentiation of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( Pow, Pow )
+
+/*!
+ * \fn Dif( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Absolute difference of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( Dif, Dif )
+
+/*!
+ * \fn Min( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Minimum of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( Min, Min )
+
+/*!
+ * \fn Max( const ImageExpr<E1>& a, const ImageExpr<E2>& b )
+ * Maximum of image expressions, images and scalars.
+ * \ingroup image_expressions
+ */
+__PCL_IMAGE_EXPR_BINARY( Max, Max )
+
+#undef __PCL_IMAGE_EXPR_BINARY
+
+/*!
+ * Absolute value of an image expression.
+ * \ingroup image_expressions
+ */
+template <class E> inline
+ImageExpr<ImageExprUnary<ImageExprOp::Abs, E> > Abs( const ImageExpr<E>& a )
+{
+   return ImageExpr<ImageExprUnary<ImageExprOp::Abs, E> >( ImageExprUnary<ImageExprOp::Abs, E>( a.Node() ) );
+}
+
+/*!
+ * Unary minus operator for image expressions.
+ * \ingroup image_expressions
+ */
+template <class E> inline
+ImageExpr<ImageExprScalarLeft<ImageExprOp::Sub, E> > operator -( const ImageExpr<E>& a )
+{
+   return 0.0 - a;
+}
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+#endif   // __PCL_ImageExpr_h
+
+// ----------------------------------------------------------------------------
+// EOF pcl/ImageExpr.h - Released 2016/02/21 20:22:12 UTC
@@ -109,6 +109,12 @@ namespace pcl
  *
  * %ImageStatistics calculates statistical values for the currently selected
  * region and channel of its source image.
+ *
+ * When parallel processing is enabled, sample gathering, partial moments,
+ * extremes and the order statistics required by robust estimators are
+ * computed with multiple concurrent threads. Samples are stored as 32-bit
+ * floating point values, so robust estimators are computed to single
+ * precision. Order statistics are exact with respect to the stored samples.
  */
 class PCL_CLASS ImageStatistics
 {
@@ -0,0 +1,237 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/InstructionSet.h - Released 2016/02/21 20:22:12 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#ifndef __PCL_InstructionSet_h
+#define __PCL_InstructionSet_h
+
+/// \file pcl/InstructionSet.h
+
+#ifndef __PCL_Defs_h
+#include <pcl/Defs.h>
+#endif
+
+#include <utility>
+
+/*
+ * Function attributes for multi-versioned kernels. GCC and Clang can generate
+ * code for an instruction set extension on a per-function basis, irrespective
+ * of the compiler options used to build a module. With other compilers these
+ * attributes are empty, and all instances of a kernel generate the same code.
+ */
+#if ( defined( __x86_64__ ) || defined( _M_X64 ) || defined( __PCL_MACOSX ) ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#  define __PCL_HAVE_TARGET_ATTRIBUTES 1
+#  define PCL_TARGET_AVX2     __attribute__ ((target ("avx2,fma")))
+#  if defined( __clang__ ) || __GNUC__ >= 5
+#    define PCL_TARGET_AVX512 __attribute__ ((target ("avx2,fma,avx512f,avx512dq,avx512bw,avx512vl")))
+#  else
+#    define __PCL_NO_AVX512_TARGET 1
+#    define PCL_TARGET_AVX512 PCL_TARGET_AVX2
+#  endif
+#else
+#  define PCL_TARGET_AVX2
+#  define PCL_TARGET_AVX512
+#endif
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \defgroup instruction_set_dispatch Runtime Instruction Set Dispatch
+ */
+
+/*!
+ * \namespace InstructionSet
+ * \brief     Instruction set levels for multi-versioned kernels
+ *
+ * <table border="1" cellpadding="4" cellspacing="0">
+ * <tr><td>InstructionSet::Baseline</td> <td>The instruction set used to build the module (SSE3 on x86_64 platforms with the standard PCL makefiles).</td></tr>
+ * <tr><td>InstructionSet::AVX2</td>     <td>AVX2 and FMA3 instruction sets.</td></tr>
+ * <tr><td>InstructionSet::AVX512</td>   <td>AVX-512 Foundation, DQ, BW and VL instruction sets.</td></tr>
+ * </table>
+ *
+ * \ingroup instruction_set_dispatch
+ */
+namespace InstructionSet
+{
+   enum value_type
+   {
+      Baseline,
+      AVX2,
+      AVX512,
+
+      NumberOfLevels
+   };
+}
+
+/*!
+ * Returns the highest instruction set level supported by the running
+ * processor and operating system.
+ *
+ * The processor is identified with the CPUID instruction the first time this
+ * function is called, which happens during static initialization of the
+ * module. AVX2 requires FMA3, and AVX-512 requires saving of extended
+ * register states by the operating system.
+ *
+ * \ingroup instruction_set_dispatch
+ */
+InstructionSet::value_type PCL_FUNC SupportedInstructionSet();
+
+/*!
+ * Returns the instruction set level currently selected for multi-versioned
+ * kernels.
+ *
+ * By default, this is the level returned by SupportedInstructionSet(). The
+ * PCL_INSTRUCTION_SET environment variable can be defined as "baseline",
+ * "avx2" or "avx512" to select a lower level when the module is loaded.
+ *
+ * \ingroup instruction_set_dispatch
+ */
+InstructionSet::value_type PCL_FUNC ActiveInstructionSet();
+
+/*!
+ * Selects the instruction set level for multi-versioned kernels. Returns the
+ * level actually selected, which is the lower of \a level and the level
+ * returned by SupportedInstructionSet().
+ *
+ * This function is intended for testing and benchmarking: results computed
+ * with different instruction set levels may only differ by the rounding
+ * errors of floating point operations. It should not be called while
+ * dispatched kernels are running in other threads.
+ *
+ * \ingroup instruction_set_dispatch
+ */
+InstructionSet::value_type PCL_FUNC SetActiveInstructionSet( InstructionSet::value_type level );
+
+/*!
+ * Returns the name of an instruction set level: "baseline", "avx2" or
+ * "avx512".
+ *
+ * \ingroup instruction_set_dispatch
+ */
+const char* PCL_FUNC InstructionSetName( InstructionSet::value_type level );
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \internal
+ * Instances of a kernel for each instruction set level.
+ */
+template <class K, typename... A>
+void __PCL_RunKernelBaseline( A&&... args )
+{
+   K::Run( std::forward<A>( args )... );
+}
+
+template <class K, typename... A> PCL_TARGET_AVX2
+void __PCL_RunKernelAVX2( A&&... args )
+{
+   K::Run( std::forward<A>( args )... );
+}
+
+template <class K, typename... A> PCL_TARGET_AVX512
+void __PCL_RunKernelAVX512( A&&... args )
+{
+   K::Run( std::forward<A>( args )... );
+}
+
+/*!
+ * Runs a multi-versioned kernel for the active instruction set level.
+ *
+ * \param args    Arguments passed to the kernel.
+ *
+ * The template argument K is a class with a static Run() member function,
+ * which implements the kernel. Run() must be declared PCL_FORCE_INLINE, so
+ * that its code is generated independently for each instruction set level.
+ * Kernels are usually written as plain loops over contiguous arrays, which
+ * the compiler vectorizes for the instruction set of each instance.
+ *
+ * \code
+ * struct Scale
+ * {
+ *    static PCL_FORCE_INLINE void Run( float* f, float k, int n )
+ *    {
+ *       for ( int i = 0; i < n; ++i )
+ *          f[i] *= k;
+ *    }
+ * };
+ *
+ * DispatchKernel<Scale>( data, 0.5F, length );
+ * \endcode
+ *
+ * \ingroup instruction_set_dispatch
+ */
+template <class K, typename... A> inline
+void DispatchKernel( A&&... args )
+{
+   switch ( ActiveInstructionSet() )
+   {
+   case InstructionSet::AVX512:
+      __PCL_RunKernelAVX512<K>( std::forward<A>( args )... );
+      break;
+   case InstructionSet::AVX2:
+      __PCL_RunKernelAVX2<K>( std::forward<A>( args )... );
+      break;
+   default:
+      __PCL_RunKernelBaseline<K>( std::forward<A>( args )... );
+      break;
+   }
+}
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+#endif   // __PCL_InstructionSet_h
+
+// ----------------------------------------------------------------------------
+// EOF pcl/InstructionSet.h - Released 2016/02/21 20:22:12 UTC
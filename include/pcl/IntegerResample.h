@@ -116,7 +116,8 @@ public:
     */
    IntegerResample( int zoom = 0, downsample_mode mode = IntegerDownsampleMode::Average ) :
       GeometricTransformation(),
-      m_zoomFactor( zoom ), m_downsampleMode( mode )
+      m_zoomFactor( zoom ), m_downsampleMode( mode ),
+      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS )
    {
    }
 
@@ -125,7 +126,8 @@ public:
     */
    IntegerResample( const IntegerResample& x ) :
       GeometricTransformation( x ),
-      m_zoomFactor( x.m_zoomFactor ), m_downsampleMode( x.m_downsampleMode )
+      m_zoomFactor( x.m_zoomFactor ), m_downsampleMode( x.m_downsampleMode ),
+      m_parallel( x.m_parallel ), m_maxProcessors( x.m_maxProcessors )
    {
    }
 
@@ -189,6 +191,78 @@ public:
     */
    virtual void GetNewSizes( int& width, int& height ) const;
 
+   /*!
+    * Returns true iff this object is allowed to use multiple parallel execution
+    * threads (when multiple threads are permitted and available).
+    */
+   bool IsParallelProcessingEnabled() const
+   {
+      return m_parallel;
+   }
+
+   /*!
+    * Enables parallel processing for this instance of %IntegerResample.
+    *
+    * \param enable  Whether to enable or disable parallel processing. True by
+    *                default.
+    *
+    * \param maxProcessors    The maximum number of processors allowed for this
+    *                instance of %IntegerResample. If \a enable is false this
+    *                parameter is ignored. A value <= 0 is ignored. The default
+    *                value is zero.
+    */
+   void EnableParallelProcessing( bool enable = true, int maxProcessors = 0 )
+   {
+      m_parallel = enable;
+      if ( enable && maxProcessors > 0 )
+         SetMaxProcessors( maxProcessors );
+   }
+
+   /*!
+    * Disables parallel processing for this instance of %IntegerResample.
+    *
+    * This is a convenience function, equivalent to:
+    * EnableParallelProcessing( !disable )
+    */
+   void DisableParallelProcessing( bool disable = true )
+   {
+      EnableParallelProcessing( !disable );
+   }
+
+   /*!
+    * Returns the maximum number of processors allowed for this instance of
+    * %IntegerResample.
+    *
+    * Irrespective of the value returned by this function, a module should not
+    * use more processors than the maximum number of parallel threads allowed
+    * for external modules on the PixInsight platform. This number is given by
+    * the "Process/MaxProcessors" global variable (refer to the GlobalSettings
+    * class for information on global variables).
+    */
+   int MaxProcessors() const
+   {
+      return m_maxProcessors;
+   }
+
+   /*!
+    * Sets the maximum number of processors allowed for this instance of
+    * %IntegerResample.
+    *
+    * In the current version of PCL, a module can use a maximum of 1023
+    * processors. The term \e processor actually refers to the number of
+    * threads a module can execute concurrently.
+    *
+    * Irrespective of the value specified by this function, a module should not
+    * use more processors than the maximum number of parallel threads allowed
+    * for external modules on the PixInsight platform. This number is given by
+    * the "Process/MaxProcessors" global variable (refer to the GlobalSettings
+    * class for information on global variables).
+    */
+   void SetMaxProcessors( int maxProcessors )
+   {
+      m_maxProcessors = unsigned( Range( maxProcessors, 1, PCL_MAX_PROCESSORS ) );
+   }
+
 protected:
 
    /*
@@ -201,6 +275,9 @@ protected:
     */
    downsample_mode m_downsampleMode;
 
+   bool            m_parallel      : 1;
+   unsigned        m_maxProcessors : PCL_MAX_PROCESSORS_BITCOUNT;
+
    // Inherited from ImageTransformation.
    virtual void Apply( pcl::Image& ) const;
    virtual void Apply( pcl::DImage& ) const;
@@ -62,10 +62,16 @@
 #include <pcl/Array.h>
 #endif
 
+#ifndef __PCL_Selection_h
+#include <pcl/Selection.h>
+#endif
+
 #ifndef __PCL_Vector_h
 #include <pcl/Vector.h>
 #endif
 
+#include <float.h> // for DBL_MAX
+
 namespace pcl
 {
 
@@ -103,11 +109,19 @@ namespace pcl
  * stored in the K-d tree, such that 0 <= i < N, where N > 0 is the dimension
  * of the point space.
  *
+ * Besides rectangular range searches, this implementation supports radius
+ * searches and k-nearest neighbor queries. Search functions returning point
+ * lists have overloads that store the points found in an existing list,
+ * reusing its allocated storage.
+ *
+ * The tree is stored as a single contiguous array of points, which is
+ * partitioned in place by median selection during the build process, plus a
+ * vector of split values with implicit node indexing. No dynamic memory
+ * allocation is performed for individual tree nodes.
+ *
  * \note We use this implementation of K-d trees in some essential PixInsight
  * tools with success (e.g., StarAlignment), and hopefully it will be also
- * useful for you, but we don't claim it to be complete. This is a practical
- * and relatively simple implementation, where only the construction,
- * destruction and range search operations are available. In particular, this
+ * useful for you, but we don't claim it to be complete. In particular, this
  * implementation does not include point addition, deletion and iteration
  * operations. Future versions of PCL will include more complete
  * implementations of this fundamental data structure.
@@ -138,8 +152,7 @@ public:
    typedef typename point::component   component;
 
    /*!
-    * A vector of point components. Used internally for tree build and range
-    * search operations.
+    * A vector of point components.
     */
    typedef GenericVector<component>    component_vector;
 
@@ -148,11 +161,16 @@ public:
     */
    typedef Array<point>                point_list;
 
+   /*!
+    * A list of distances. Used for nearest neighbor search operations.
+    */
+   typedef Array<double>               distance_list;
+
    /*!
     * Constructs an empty K-d tree.
     */
    KDTree() :
-      m_root( nullptr ), m_dimension( 0 ), m_bucketCapacity( 0 ), m_length( 0 )
+      m_dimension( 0 ), m_bucketCapacity( 0 )
    {
    }
 
@@ -175,7 +193,7 @@ public:
     * Error exception is thrown.
     */
    KDTree( const point_list& points, int bucketCapacity = 16 ) :
-      m_root( nullptr ), m_dimension( 0 ), m_bucketCapacity( 0 ), m_length( 0 )
+      m_dimension( 0 ), m_bucketCapacity( 0 )
    {
       Build( points, bucketCapacity );
    }
@@ -200,34 +218,39 @@ public:
     * Error exception is thrown.
     */
    KDTree( const point_list& points, int dimension, int bucketCapacity ) :
-      m_root( nullptr ), m_dimension( 0 ), m_bucketCapacity( 0 ), m_length( 0 )
+      m_dimension( 0 ), m_bucketCapacity( 0 )
    {
       Build( points, dimension, bucketCapacity );
    }
 
+   /*!
+    * Copy constructor.
+    */
+   KDTree( const KDTree& ) = default;
+
    /*!
     * Move constructor.
     */
    KDTree( KDTree&& x ) :
-      m_root( x.m_root ), m_dimension( x.m_dimension ),
-      m_bucketCapacity( x.m_bucketCapacity ), m_length( x.m_length )
+      m_points( std::move( x.m_points ) ), m_split( std::move( x.m_split ) ),
+      m_dimension( x.m_dimension ), m_bucketCapacity( x.m_bucketCapacity )
    {
-      x.m_root = nullptr;
-      x.m_length = 0;
    }
 
+   /*!
+    * Copy assignment operator. Returns a reference to this object.
+    */
+   KDTree& operator =( const KDTree& ) = default;
+
    /*!
     * Move assignment operator. Returns a reference to this object.
     */
    KDTree& operator =( KDTree&& x )
    {
-      DestroyTree( m_root );
-      m_root = x.m_root;
+      m_points = std::move( x.m_points );
+      m_split = std::move( x.m_split );
       m_dimension = x.m_dimension;
       m_bucketCapacity = x.m_bucketCapacity;
-      m_length = x.m_length;
-      x.m_root = nullptr;
-      x.m_length = 0;
       return *this;
    }
 
@@ -236,7 +259,6 @@ public:
     */
    ~KDTree()
    {
-      Clear();
    }
 
    /*!
@@ -244,9 +266,8 @@ public:
     */
    void Clear()
    {
-      DestroyTree( m_root );
-      m_root = nullptr;
-      m_length = 0;
+      m_points.Clear();
+      m_split.Clear();
    }
 
    /*!
@@ -279,7 +300,7 @@ public:
          m_dimension = points[0].Length();
          if ( m_dimension < 1 )
             throw Error( "Invalid point space dimension in KDTree::Build()" );
-         m_root = BuildTree( points, 0 );
+         BuildTree( points );
       }
    }
 
@@ -311,7 +332,7 @@ public:
       m_bucketCapacity = Max( 1, bucketCapacity );
       if ( (m_dimension = dimension) < 1 )
          throw Error( "Invalid point space dimension in KDTree::Build()" );
-      m_root = BuildTree( points, 0 );
+      BuildTree( points );
    }
 
    /*!
@@ -337,18 +358,29 @@ public:
     */
    point_list Search( const point& pt, component epsilon ) const
    {
-      component_vector p0( m_dimension );
-      component_vector p1( m_dimension );
-      for ( int i = 0; i < m_dimension; ++i )
-      {
-         p0[i] = pt[i] - epsilon;
-         p1[i] = pt[i] + epsilon;
-      }
       point_list found;
-      SearchTree( found, p0, p1, m_root, 0 );
+      Search( found, pt, epsilon );
       return found;
    }
 
+   /*!
+    * Performs a range search in this K-d tree, storing the points found in an
+    * existing list.
+    *
+    * \param found   The list where the points found will be stored. Existing
+    *                list elements are removed, but the list's allocated
+    *                storage is reused, so repeated searches with the same
+    *                list don't require memory reallocations in most cases.
+    *
+    * See Search( const point&, component ) for information on the rest of
+    * parameters.
+    */
+   void Search( point_list& found, const point& pt, component epsilon ) const
+   {
+      found.Truncate( found.Begin() );
+      Search( pt, epsilon, []( const point& p, void* data ) { reinterpret_cast<point_list*>( data )->Add( p ); }, &found );
+   }
+
    /*!
     * Performs a range search in this K-d tree.
     *
@@ -382,14 +414,185 @@ public:
    template <class F>
    void Search( const point& pt, component epsilon, F callback, void* data ) const
    {
-      component_vector p0( m_dimension );
-      component_vector p1( m_dimension );
-      for ( int i = 0; i < m_dimension; ++i )
+      if ( !m_points.IsEmpty() )
+         SearchTree( pt, epsilon, callback, data, 0, 0, m_points.Length(), 0 );
+   }
+
+   /*!
+    * Performs a radius search in this K-d tree.
+    *
+    * \param pt      Reference to the point being searched for. The coordinates
+    *                of this point define the center of the hyperspherical
+    *                search range in the N-dimensional point space.
+    *
+    * \param radius  Radius of the search hypersphere.
+    *
+    * Returns a (possibly empty) list with all the points found in the tree at
+    * Euclidean distances less than or equal to \a radius from \a pt.
+    */
+   point_list SearchRadius( const point& pt, double radius ) const
+   {
+      point_list found;
+      SearchRadius( found, pt, radius );
+      return found;
+   }
+
+   /*!
+    * Performs a radius search in this K-d tree, storing the points found in
+    * an existing list.
+    *
+    * \param found   The list where the points found will be stored. Existing
+    *                list elements are removed, but the list's allocated
+    *                storage is reused, so repeated searches with the same
+    *                list don't require memory reallocations in most cases.
+    *
+    * See SearchRadius( const point&, double ) for information on the rest of
+    * parameters.
+    */
+   void SearchRadius( point_list& found, const point& pt, double radius ) const
+   {
+      found.Truncate( found.Begin() );
+      SearchRadius( pt, radius, []( const point& p, void* data ) { reinterpret_cast<point_list*>( data )->Add( p ); }, &found );
+   }
+
+   /*!
+    * Performs a radius search in this K-d tree.
+    *
+    * \param pt         Reference to the point being searched for. The
+    *                   coordinates of this point define the center of the
+    *                   hyperspherical search range in the N-dimensional point
+    *                   space.
+    *
+    * \param radius     Radius of the search hypersphere.
+    *
+    * \param callback   Callback functional.
+    *
+    * \param data       Callback data.
+    *
+    * The callback function prototype should be:
+    *
+    * \code void callback( const point& pt, void* data ) \endcode
+    *
+    * The callback function will be called once for each point found in the
+    * tree at a Euclidean distance less than or equal to \a radius from \a pt.
+    */
+   template <class F>
+   void SearchRadius( const point& pt, double radius, F callback, void* data ) const
+   {
+      if ( m_points.IsEmpty() || radius < 0 )
+         return;
+      SearchRadiusTree( pt, radius, radius*radius, callback, data, 0, 0, m_points.Length(), 0 );
+   }
+
+   /*!
+    * Finds the \a k nearest neighbors of a point in this K-d tree.
+    *
+    * \param pt   Reference to the point whose nearest neighbors are being
+    *             searched for.
+    *
+    * \param k    Number of nearest neighbors to find. Must be >= 1.
+    *
+    * Returns a list with the min( k, Length() ) points in the tree closest to
+    * \a pt in terms of Euclidean distance, sorted by increasing distance.
+    */
+   point_list NearestNeighbors( const point& pt, int k ) const
+   {
+      point_list found;
+      NearestNeighbors( found, pt, k );
+      return found;
+   }
+
+   /*!
+    * Finds the \a k nearest neighbors of a point in this K-d tree, storing
+    * them in an existing list.
+    *
+    * \param found      The list where the nearest neighbors will be stored,
+    *                   sorted by increasing distance to \a pt. Existing list
+    *                   elements are removed, but the list's allocated storage
+    *                   is reused, so repeated searches with the same list
+    *                   don't require memory reallocations in most cases.
+    *
+    * \param pt         Reference to the point whose nearest neighbors are
+    *                   being searched for.
+    *
+    * \param k          Number of nearest neighbors to find. Must be >= 1.
+    *
+    * \param distances  If nonzero, the address of a list where the Euclidean
+    *                   distances from \a pt to the points found will be
+    *                   stored. The allocated storage of this list is also
+    *                   reused.
+    *
+    * This function doesn't allocate working memory for k <= 32. It is
+    * thread-safe: concurrent searches can be performed on the same tree from
+    * multiple threads.
+    */
+   void NearestNeighbors( point_list& found, const point& pt, int k, distance_list* distances = nullptr ) const
+   {
+      found.Truncate( found.Begin() );
+      if ( distances != nullptr )
+         distances->Truncate( distances->Begin() );
+      if ( m_points.IsEmpty() || k < 1 )
+         return;
+
+      k = int( Min( size_type( k ), m_points.Length() ) );
+
+      double d2Buffer[ 32 ];
+      size_type iBuffer[ 32 ];
+      GenericVector<double> d2Storage;
+      GenericVector<size_type> iStorage;
+      Neighbors N;
+      if ( k <= 32 )
+      {
+         N.d2 = d2Buffer;
+         N.index = iBuffer;
+      }
+      else
       {
-         p0[i] = pt[i] - epsilon;
-         p1[i] = pt[i] + epsilon;
+         d2Storage = GenericVector<double>( k );
+         iStorage = GenericVector<size_type>( k );
+         N.d2 = d2Storage.Begin();
+         N.index = iStorage.Begin();
       }
-      SearchTree( p0, p1, callback, data, m_root, 0 );
+      N.k = k;
+      N.count = 0;
+
+      SearchNeighborsTree( N, pt, 0, 0, m_points.Length(), 0 );
+
+      for ( int i = 0; i < N.count; ++i )
+      {
+         found.Add( m_points[N.index[i]] );
+         if ( distances != nullptr )
+            distances->Add( Sqrt( N.d2[i] ) );
+      }
+   }
+
+   /*!
+    * Returns the nearest neighbor of a point in this K-d tree.
+    *
+    * \param pt         Reference to the point whose nearest neighbor is
+    *                   being searched for.
+    *
+    * \param distance   If nonzero, the address of a variable where the
+    *                   Euclidean distance from \a pt to the nearest neighbor
+    *                   will be stored.
+    *
+    * If this tree is empty, this function throws an Error exception.
+    */
+   const point& NearestNeighbor( const point& pt, double* distance = nullptr ) const
+   {
+      if ( m_points.IsEmpty() )
+         throw Error( "KDTree::NearestNeighbor(): Empty tree." );
+      double d2;
+      size_type index;
+      Neighbors N;
+      N.d2 = &d2;
+      N.index = &index;
+      N.k = 1;
+      N.count = 0;
+      SearchNeighborsTree( N, pt, 0, 0, m_points.Length(), 0 );
+      if ( distance != nullptr )
+         *distance = Sqrt( d2 );
+      return m_points[index];
    }
 
    /*!
@@ -406,15 +609,15 @@ public:
     */
    size_type Length() const
    {
-      return m_length;
+      return m_points.Length();
    }
 
    /*!
     * Returns true iff this K-d tree is empty.
     */
-   bool IsEmpty()
+   bool IsEmpty() const
    {
-      return m_root == nullptr;
+      return m_points.IsEmpty();
    }
 
    /*!
@@ -422,165 +625,190 @@ public:
     */
    friend void Swap( KDTree& x1, KDTree& x2 )
    {
-      pcl::Swap( x1.m_root,           x2.m_root );
+      pcl::Swap( x1.m_points,         x2.m_points );
+      pcl::Swap( x1.m_split,          x2.m_split );
       pcl::Swap( x1.m_dimension,      x2.m_dimension );
       pcl::Swap( x1.m_bucketCapacity, x2.m_bucketCapacity );
-      pcl::Swap( x1.m_length,         x2.m_length );
    }
 
 private:
 
-   struct Node
+   /*
+    * Tree structure
+    *
+    * Points are stored in a single contiguous array. Each tree node owns a
+    * range [begin,end) of this array. Nodes with more than m_bucketCapacity
+    * points are split at the median mid = begin + (end - begin)/2 along the
+    * (depth mod dimension) coordinate: the left child owns [begin,mid) with
+    * coordinates <= split, and the right child owns [mid,end) with
+    * coordinates >= split. Since node ranges can be computed on the fly, only
+    * split values have to be stored, with implicit node indexing: the
+    * children of node i are nodes 2*i + 1 and 2*i + 2.
+    */
+   point_list      m_points;
+   DVector         m_split;
+   int             m_dimension;
+   int             m_bucketCapacity;
+
+   /*
+    * Sorted list of nearest neighbor candidates.
+    */
+   struct Neighbors
    {
-      double split;  // position of this node's splitting hyperplane
-      Node*  left;   // child points at coordinates <= split
-      Node*  right;  // child points at coordinates > split
+      double*    d2;    // squared distances, ascending order
+      size_type* index; // point indices
+      int        k;
+      int        count;
 
-      Node( double s = 0 ) : split( s ), left( nullptr ), right( nullptr )
+      double Bound() const
       {
+         return (count < k) ? DBL_MAX : d2[count-1];
       }
 
-      bool IsLeaf() const
+      void Add( double d, size_type i )
       {
-         return left == nullptr && right == nullptr;
+         int j = (count < k) ? count++ : count-1;
+         for ( ; j > 0 && d2[j-1] > d; --j )
+         {
+            d2[j] = d2[j-1];
+            index[j] = index[j-1];
+         }
+         d2[j] = d;
+         index[j] = i;
       }
    };
 
-   struct LeafNode : public Node
+   void BuildTree( const point_list& points )
    {
-      point_list points;
-
-      LeafNode( const point_list& p ) : Node(), points( p )
-      {
-      }
-   };
+      int levels = 0;
+      for ( size_type n = points.Length(); n > size_type( m_bucketCapacity ); n -= n >> 1 )
+         ++levels;
+      m_split = DVector( (1 << levels) - 1 );
+
+      // The tree is built by in-place median partitioning of a single copy of
+      // the point list.
+      m_points = points;
+      m_points.EnsureUnique();
+      if ( levels > 0 )
+         PartitionTree( 0, 0, m_points.Length(), 0 );
+   }
 
-   Node*     m_root;
-   int       m_dimension;
-   int       m_bucketCapacity;
-   size_type m_length;
+   void PartitionTree( int node, size_type begin, size_type end, int depth )
+   {
+      if ( IsLeaf( begin, end ) )
+         return;
+      int coordinate = depth % m_dimension;
+      size_type mid = begin + ((end - begin) >> 1);
+      typename point_list::iterator i = m_points.Begin();
+      Select( i + begin, i + end, distance_type( mid - begin ),
+              [coordinate]( const point& a, const point& b ) { return a[coordinate] < b[coordinate]; } );
+      m_split[node] = m_points[mid][coordinate];
+      PartitionTree( 2*node + 1, begin, mid, depth+1 );
+      PartitionTree( 2*node + 2, mid, end, depth+1 );
+   }
 
-   Node* BuildTree( const point_list& points, int depth )
+   bool IsLeaf( size_type begin, size_type end ) const
    {
-      if ( points.IsEmpty() )
-         return nullptr;
+      return end - begin <= size_type( m_bucketCapacity );
+   }
 
-      if ( points.Length() <= size_type( m_bucketCapacity ) )
+   template <class F>
+   void SearchTree( const point& pt, component epsilon, F callback, void* data,
+                    int node, size_type begin, size_type end, int depth ) const
+   {
+      if ( IsLeaf( begin, end ) )
       {
-         m_length += points.Length();
-         return new LeafNode( points );
+         for ( typename point_list::const_iterator i = m_points.At( begin ), j = m_points.At( end ); i < j; ++i )
+            for ( int c = 0; ; )
+            {
+               component x = (*i)[c];
+               if ( x < component( pt[c] - epsilon ) || component( pt[c] + epsilon ) < x )
+                  break;
+               if ( ++c == m_dimension )
+               {
+                  callback( *i, data );
+                  break;
+               }
+            }
       }
-
-      int index = depth % m_dimension;
-
-      Node* node = new Node( SplitValue( points, index ) );
-
-      point_list left, right;
-      for ( typename point_list::const_iterator i = points.Begin(); i != points.End(); ++i )
-         if ( (*i)[index] <= node->split )
-            left.Add( *i );
-         else
-            right.Add( *i );
-
-      // If we are about to build a degenerate subtree, abort this branch of
-      // recursion right now.
-      if ( left.IsEmpty() || right.IsEmpty() )
+      else
       {
-         delete node;
-         return nullptr;
+         int coordinate = depth % m_dimension;
+         size_type mid = begin + ((end - begin) >> 1);
+         double split = m_split[node];
+         if ( component( pt[coordinate] - epsilon ) <= split )
+            SearchTree( pt, epsilon, callback, data, 2*node + 1, begin, mid, depth+1 );
+         if ( component( pt[coordinate] + epsilon ) >= split )
+            SearchTree( pt, epsilon, callback, data, 2*node + 2, mid, end, depth+1 );
       }
+   }
 
-      node->left  = BuildTree( left, depth+1 );
-      node->right = BuildTree( right, depth+1 );
-
-      // Don't propagate degeneracies.
-      if ( node->IsLeaf() )
+   double SquaredDistance( const point& p, const point& q ) const
+   {
+      double d2 = 0;
+      for ( int c = 0; c < m_dimension; ++c )
       {
-         delete node;
-         return nullptr;
+         double d = double( p[c] ) - double( q[c] );
+         d2 += d*d;
       }
-
-      return node;
+      return d2;
    }
 
-   void SearchTree( point_list& found, const component_vector& p0, const component_vector& p1, const Node* node, int depth ) const
+   template <class F>
+   void SearchRadiusTree( const point& pt, double radius, double r2, F callback, void* data,
+                          int node, size_type begin, size_type end, int depth ) const
    {
-      if ( node != nullptr )
-         if ( node->IsLeaf() )
-         {
-            const LeafNode* leaf = static_cast<const LeafNode*>( node );
-            for ( typename point_list::const_iterator i = leaf->points.Begin(); i != leaf->points.End(); ++i )
-               for ( int j = 0; ; )
-               {
-                  component x = (*i)[j];
-                  if ( x < p0[j] || p1[j] < x )
-                     break;
-                  if ( ++j == m_dimension )
-                  {
-                     found.Add( *i );
-                     break;
-                  }
-               }
-         }
-         else
-         {
-            int index = depth % m_dimension;
-            if ( p0[index] <= node->split )
-               SearchTree( found, p0, p1, node->left, depth+1 );
-            if ( p1[index] > node->split )
-               SearchTree( found, p0, p1, node->right, depth+1 );
-         }
+      if ( IsLeaf( begin, end ) )
+      {
+         for ( typename point_list::const_iterator i = m_points.At( begin ), j = m_points.At( end ); i < j; ++i )
+            if ( SquaredDistance( *i, pt ) <= r2 )
+               callback( *i, data );
+      }
+      else
+      {
+         int coordinate = depth % m_dimension;
+         size_type mid = begin + ((end - begin) >> 1);
+         double split = m_split[node];
+         double x = pt[coordinate];
+         if ( x - radius <= split )
+            SearchRadiusTree( pt, radius, r2, callback, data, 2*node + 1, begin, mid, depth+1 );
+         if ( x + radius >= split )
+            SearchRadiusTree( pt, radius, r2, callback, data, 2*node + 2, mid, end, depth+1 );
+      }
    }
 
-   template <class F>
-   void SearchTree( const component_vector& p0, const component_vector& p1, F callback, void* data, const Node* node, int depth ) const
+   void SearchNeighborsTree( Neighbors& N, const point& pt, int node, size_type begin, size_type end, int depth ) const
    {
-      if ( node != nullptr )
-         if ( node->IsLeaf() )
+      if ( IsLeaf( begin, end ) )
+      {
+         for ( size_type i = begin; i < end; ++i )
          {
-            const LeafNode* leaf = static_cast<const LeafNode*>( node );
-            for ( typename point_list::const_iterator i = leaf->points.Begin(); i != leaf->points.End(); ++i )
-               for ( int j = 0; ; )
-               {
-                  component x = (*i)[j];
-                  if ( x < p0[j] || p1[j] < x )
-                     break;
-                  if ( ++j == m_dimension )
-                  {
-                     callback( *i, data );
-                     break;
-                  }
-               }
+            double d2 = SquaredDistance( m_points[i], pt );
+            if ( d2 < N.Bound() )
+               N.Add( d2, i );
          }
-         else
+      }
+      else
+      {
+         int coordinate = depth % m_dimension;
+         size_type mid = begin + ((end - begin) >> 1);
+         double d = double( pt[coordinate] ) - m_split[node];
+
+         // Visit the subtree containing the search point first; then visit
+         // the other subtree only if it may contain closer points.
+         if ( d <= 0 )
          {
-            int index = depth % m_dimension;
-            if ( p0[index] <= node->split )
-               SearchTree( p0, p1, callback, data, node->left, depth+1 );
-            if ( p1[index] > node->split )
-               SearchTree( p0, p1, callback, data, node->right, depth+1 );
+            SearchNeighborsTree( N, pt, 2*node + 1, begin, mid, depth+1 );
+            if ( d*d < N.Bound() )
+               SearchNeighborsTree( N, pt, 2*node + 2, mid, end, depth+1 );
          }
-   }
-
-   void DestroyTree( Node* node )
-   {
-      if ( node != nullptr )
-         if ( node->IsLeaf() )
-            delete static_cast<LeafNode*>( node );
          else
          {
-            DestroyTree( node->left );
-            DestroyTree( node->right );
-            delete node;
+            SearchNeighborsTree( N, pt, 2*node + 2, mid, end, depth+1 );
+            if ( d*d < N.Bound() )
+               SearchNeighborsTree( N, pt, 2*node + 1, begin, mid, depth+1 );
          }
-   }
-
-   double SplitValue( const point_list& points, int index )
-   {
-      component_vector v( points.Length() );
-      for ( int i = 0; i < v.Length(); ++i )
-         v[i] = points[i][index];
-      return v.Median();
+      }
    }
 };
 
@@ -243,7 +243,7 @@ public:
          if ( m_fillBorder )
             FillRow( sp, sn, wp, wn, i - dy );
          else
-            InterpolateRow( sp, sn, wp, wn, m_data - 2*int64( y )*m_width, x0, i - dy );
+            InterpolateRow( sp, sn, wp, wn, m_data - int64( y )*m_width, x0, i - dy );
       }
 
       // Unclipped rows
@@ -553,7 +553,7 @@ public:
          if ( m_fillBorder )
             FillRow( sp, sn, wp, wn, m_Ly[k] );
          else
-            InterpolateRow( sp, sn, wp, wn, m_data - 2*int64( y )*m_width, x0, m_Ly[k] );
+            InterpolateRow( sp, sn, wp, wn, m_data - int64( y )*m_width, x0, m_Ly[k] );
       }
 
       // Unclipped rows
@@ -179,6 +179,49 @@ inline int MaxSSEInstructionSetSupported()
    return 0;
 }
 
+/*!
+ * Returns true iff the running processor supports the AVX2 instruction set,
+ * and the operating system supports saving extended AVX register states.
+ * This function is a portable wrapper to the CPUID and XGETBV x86
+ * instructions.
+ *
+ * \ingroup hw_identification_functions
+ */
+inline bool IsAVX2InstructionSetSupported()
+{
+   int32 maxLeaf = 0;
+   int32 ecxFlags1 = 0;
+   int32 ebxFlags7 = 0;
+   uint32 xcr0 = 0;
+
+#ifdef _MSC_VER
+   int cpuInfo[ 4 ];
+   __cpuid( cpuInfo, 0 );
+   maxLeaf = cpuInfo[0];
+   if ( maxLeaf < 7 )
+      return false;
+   __cpuid( cpuInfo, 1 );
+   ecxFlags1 = cpuInfo[2];
+   __cpuidex( cpuInfo, 7, 0 );
+   ebxFlags7 = cpuInfo[1];
+   if ( ecxFlags1 & (1u << 27) ) // OSXSAVE
+      xcr0 = uint32( _xgetbv( 0 ) );
+#else
+   int32 ebx, ecx, edx;
+   asm volatile( "cpuid" : "=a" (maxLeaf), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (0), "c" (0) );
+   if ( maxLeaf < 7 )
+      return false;
+   asm volatile( "cpuid" : "=a" (maxLeaf), "=b" (ebx), "=c" (ecxFlags1), "=d" (edx) : "a" (1), "c" (0) );
+   asm volatile( "cpuid" : "=a" (maxLeaf), "=b" (ebxFlags7), "=c" (ecx), "=d" (edx) : "a" (7), "c" (0) );
+   if ( ecxFlags1 & (1u << 27) ) // OSXSAVE
+      asm volatile( "xgetbv" : "=a" (xcr0), "=d" (edx) : "c" (0) );
+#endif
+
+   return (ecxFlags1 & (1u << 28))  // AVX
+       && (xcr0 & 6u) == 6u         // XMM and YMM states enabled by the OS
+       && (ebxFlags7 & (1u << 5));  // AVX2
+}
+
 // ----------------------------------------------------------------------------
 
 /*!
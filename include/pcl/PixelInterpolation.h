@@ -486,6 +486,16 @@ public:
       return String().Format( "Bicubic spline interpolation, c=%.2f", m_clamp );
    }
 
+   /*!
+    * Returns the linear clamping threshold of this pixel interpolation. See
+    * BicubicSplineInterpolation::SetClampingThreshold() for information on
+    * the linear clamping mechanism.
+    */
+   float ClampingThreshold() const
+   {
+      return m_clamp;
+   }
+
 private:
 
    float m_clamp;
@@ -767,6 +777,24 @@ public:
       return desc;
    }
 
+   /*!
+    * Returns the order of the Lanczos filter used by this pixel
+    * interpolation.
+    */
+   int FilterOrder() const
+   {
+      return m_n;
+   }
+
+   /*!
+    * Returns the clamping threshold of this pixel interpolation. A negative
+    * value means that clamping is disabled.
+    */
+   float ClampingThreshold() const
+   {
+      return m_clamp;
+   }
+
 private:
 
    int   m_n;     // filter order
@@ -851,6 +879,15 @@ public:
       return desc;
    }
 
+   /*!
+    * Returns the clamping threshold of this pixel interpolation. A negative
+    * value means that clamping is disabled.
+    */
+   float ClampingThreshold() const
+   {
+      return m_clamp;
+   }
+
 private:
 
    float m_clamp; // clamping threshold (enabled if >= 0)
@@ -934,6 +971,15 @@ public:
       return desc;
    }
 
+   /*!
+    * Returns the clamping threshold of this pixel interpolation. A negative
+    * value means that clamping is disabled.
+    */
+   float ClampingThreshold() const
+   {
+      return m_clamp;
+   }
+
 private:
 
    float m_clamp; // clamping threshold (enabled if >= 0)
@@ -1017,6 +1063,15 @@ public:
       return desc;
    }
 
+   /*!
+    * Returns the clamping threshold of this pixel interpolation. A negative
+    * value means that clamping is disabled.
+    */
+   float ClampingThreshold() const
+   {
+      return m_clamp;
+   }
+
 private:
 
    float m_clamp; // clamping threshold (enabled if >= 0)
@@ -226,6 +226,47 @@ public:
    }
 };
 
+/*!
+ * \class PixelTraitsConversion
+ * \brief Bulk conversion of pixel sample arrays.
+ *
+ * %PixelTraitsConversion implements the conversions between integer and
+ * floating point pixel sample types performed by the ToSample() member
+ * functions of pixel traits classes, optimized for large arrays of pixel
+ * samples. Conversions are implemented with SSE2 instructions, or with AVX2
+ * or AVX-512 instructions, depending on the instruction set level selected
+ * at runtime (see ActiveInstructionSet()). All implementations generate
+ * identical results.
+ *
+ * Integer to floating point conversions scale source samples to the
+ * normalized [0,1] range. Floating point to integer conversions clamp source
+ * samples to the [0,1] range, then scale and round them to the nearest
+ * integer, as the ToSampleConstrained() member functions of integer pixel
+ * traits classes.
+ *
+ * These functions are used by the Copy() member functions of pixel traits
+ * classes, so they are used transparently for all image conversions.
+ */
+class PCL_CLASS PixelTraitsConversion
+{
+public:
+
+   static void Convert( float* f, const uint8* g, size_type n );
+   static void Convert( float* f, const uint16* g, size_type n );
+   static void Convert( float* f, const uint32* g, size_type n );
+   static void Convert( double* f, const uint8* g, size_type n );
+   static void Convert( double* f, const uint16* g, size_type n );
+   static void Convert( double* f, const uint32* g, size_type n );
+   static void Convert( uint8* f, const float* g, size_type n );
+   static void Convert( uint8* f, const double* g, size_type n );
+   static void Convert( uint16* f, const float* g, size_type n );
+   static void Convert( uint16* f, const double* g, size_type n );
+   static void Convert( uint32* f, const float* g, size_type n );
+   static void Convert( uint32* f, const double* g, size_type n );
+};
+
+// ----------------------------------------------------------------------------
+
 #define IMPLEMENT_TRANSFER_OPERATIONS                             \
                                                                   \
    template <typename T>                                          \
@@ -915,6 +956,28 @@ public:
    // -------------------------------------------------------------------------
 
    IMPLEMENT_TRANSFER_OPERATIONS
+
+   /*
+    * Bulk conversions - see PixelTraitsConversion.
+    */
+
+   static void Copy( sample* f, const uint8* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
+
+   static void Copy( sample* f, const uint16* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
+
+   static void Copy( sample* f, const uint32* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
 };
 
 // ----------------------------------------------------------------------------
@@ -1480,6 +1543,28 @@ public:
    // -------------------------------------------------------------------------
 
    IMPLEMENT_TRANSFER_OPERATIONS
+
+   /*
+    * Bulk conversions - see PixelTraitsConversion.
+    */
+
+   static void Copy( sample* f, const uint8* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
+
+   static void Copy( sample* f, const uint16* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
+
+   static void Copy( sample* f, const uint32* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
 };
 
 // ----------------------------------------------------------------------------
@@ -3784,6 +3869,22 @@ public:
    // -------------------------------------------------------------------------
 
    IMPLEMENT_TRANSFER_OPERATIONS
+
+   /*
+    * Bulk conversions - see PixelTraitsConversion.
+    */
+
+   static void Copy( sample* f, const float* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
+
+   static void Copy( sample* f, const double* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
 };
 
 // ----------------------------------------------------------------------------
@@ -4621,6 +4722,22 @@ public:
    // -------------------------------------------------------------------------
 
    IMPLEMENT_TRANSFER_OPERATIONS
+
+   /*
+    * Bulk conversions - see PixelTraitsConversion.
+    */
+
+   static void Copy( sample* f, const float* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
+
+   static void Copy( sample* f, const double* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
 };
 
 // ----------------------------------------------------------------------------
@@ -5447,6 +5564,22 @@ public:
    // -------------------------------------------------------------------------
 
    IMPLEMENT_TRANSFER_OPERATIONS
+
+   /*
+    * Bulk conversions - see PixelTraitsConversion.
+    */
+
+   static void Copy( sample* f, const float* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
+
+   static void Copy( sample* f, const double* g, size_type n )
+   {
+      PCL_PRECONDITION( f != 0 && g != 0 )
+      PixelTraitsConversion::Convert( f, g, n );
+   }
 };
 
 // ----------------------------------------------------------------------------
@@ -396,6 +396,318 @@ private:
 
 // ----------------------------------------------------------------------------
 
+/*!
+ * \class Philox4x32
+ * \brief Implementation of the Philox4x32-10 counter-based pseudo-random
+ *        number generator.
+ *
+ * Philox4x32-10 is a counter-based generator: the n-th block of four 32-bit
+ * random words is a pure function of a 128-bit counter and a 64-bit key,
+ * computed by ten rounds of a bijective multiply/xor mixing function. This
+ * has two important consequences for parallel code:
+ *
+ * <ul>
+ * <li>Any position in a random sequence can be reached in constant time, so
+ * a generator can skip ahead an arbitrary number of values without generating
+ * them (see SetPosition() and SkipAhead()).</li>
+ * <li>Up to 2^64 independent streams can be generated with the same key by
+ * using the upper half of the counter as a stream identifier (see SetStream()).
+ * Different streams never overlap.</li>
+ * </ul>
+ *
+ * Parallel algorithms can thus assign a separate stream, or a separate range
+ * of positions, to each work unit (for example, each row of an image), and
+ * produce exactly the same results for a given seed regardless of the number
+ * of threads used and of how work units are distributed among them.
+ *
+ * In addition to the usual scalar functions, this class provides batch
+ * generation functions for uniform, normal and Poisson deviates. Batch
+ * functions generate random blocks in groups, which allows the compiler to
+ * vectorize the Philox rounds, and always yield exactly the same values as the
+ * equivalent sequence of scalar calls.
+ *
+ * Examples of use:
+ *
+ * \code
+ * Philox4x32 P( 12345 );  // fixed seed, stream #0
+ * double x = P();         // x = random uniform deviate in the range [0,1)
+ * double y = P.Normal();  // y = normal deviate with zero mean and unit sigma
+ *
+ * DVector v( 1000 );
+ * P.SetStream( 17 );            // stream #17, positioned at its beginning
+ * P.Uniform( v.Begin(), 1000 ); // v = 1000 uniform deviates in [0,1)
+ * \endcode
+ *
+ * <b>References</b>
+ *
+ * John K. Salmon, Mark A. Moraes, Ron O. Dror and David E. Shaw (2011),
+ * <em>Parallel Random Numbers: As Easy as 1, 2, 3</em>, Proceedings of the
+ * International Conference for High Performance Computing, Networking,
+ * Storage and Analysis (SC11).
+ *
+ * \ingroup random_numbers
+ */
+class PCL_CLASS Philox4x32
+{
+public:
+
+   /*!
+    * Constructs a %Philox4x32 random generator.
+    *
+    * \param seed    64-bit generator key. If this parameter is zero, a unique
+    *                random seed will be generated automatically. The default
+    *                value is zero.
+    *
+    * \param stream  Stream identifier. The default value is zero.
+    *
+    * The generator is positioned at the beginning of the specified stream.
+    */
+   Philox4x32( uint64 seed = 0, uint64 stream = 0 )
+   {
+      Initialize( seed, stream );
+   }
+
+   /*!
+    * Reinitializes this generator with a new \a seed and \a stream. If the
+    * specified \a seed is zero, a unique random seed will be generated
+    * automatically. The generator is positioned at the beginning of the
+    * specified stream.
+    */
+   void Initialize( uint64 seed, uint64 stream = 0 )
+   {
+      m_key = (seed != 0) ? seed : RandomSeed64();
+      m_lambda[0] = -1;
+      SetStream( stream );
+   }
+
+   /*!
+    * Returns the 64-bit key of this generator.
+    */
+   uint64 Seed() const
+   {
+      return m_key;
+   }
+
+   /*!
+    * Returns the current stream identifier.
+    */
+   uint64 Stream() const
+   {
+      return m_stream;
+   }
+
+   /*!
+    * Selects a new stream and positions this generator at its beginning.
+    */
+   void SetStream( uint64 stream )
+   {
+      m_stream = stream;
+      SetPosition( 0 );
+   }
+
+   /*!
+    * Returns the current position in the current stream, measured in 32-bit
+    * words generated since the beginning of the stream.
+    *
+    * UI32() and UIN() consume one word; UI64() and operator()() consume two
+    * words; a pair of normal deviates consumes four words. Poisson deviates
+    * consume a variable number of words.
+    */
+   uint64 Position() const
+   {
+      return m_position;
+   }
+
+   /*!
+    * Moves this generator to the specified \a position in the current stream,
+    * measured in 32-bit words. This is a constant time operation. The normal
+    * deviate cached by Normal(), if any, is discarded.
+    */
+   void SetPosition( uint64 position )
+   {
+      m_position = position;
+      m_valid = false;
+      m_normal = false;
+   }
+
+   /*!
+    * Advances this generator by \a n 32-bit words in the current stream. This
+    * is a constant time operation. The normal deviate cached by Normal(), if
+    * any, is discarded.
+    */
+   void SkipAhead( uint64 n )
+   {
+      SetPosition( m_position + n );
+   }
+
+   /*!
+    * Returns a double precision uniform random deviate in the [0,1) range,
+    * with 53 random bits.
+    */
+   double operator()()
+   {
+      return 1.1102230246251565404236e-16 * (UI64() >> 11); // 1.0/2^53
+   }
+
+   /*!
+    * Returns a double precision uniform random deviate in the [0,1) range.
+    *
+    * This is a convenience alias for operator()().
+    */
+   double Uniform()
+   {
+      return operator()();
+   }
+
+   /*!
+    * Returns a 32-bit unsigned integer uniform random deviate.
+    */
+   uint32 UI32()
+   {
+      uint64 block = m_position >> 2;
+      if ( !m_valid || block != m_block )
+      {
+         Block( m_words, block, m_stream, m_key );
+         m_block = block;
+         m_valid = true;
+      }
+      return m_words[m_position++ & 3];
+   }
+
+   /*!
+    * Returns a 64-bit unsigned integer uniform random deviate.
+    */
+   uint64 UI64()
+   {
+      uint64 lo = UI32();
+      return lo | (uint64( UI32() ) << 32);
+   }
+
+   /*!
+    * Returns an unsigned integer uniform random deviate in the range [0,n-1].
+    */
+   uint32 UIN( uint32 n )
+   {
+      return UI32() % n;
+   }
+
+   /*!
+    * Generates a floating point normal deviate with the specified \a mean and
+    * standard deviation \a sigma.
+    *
+    * Normal deviates are generated in pairs with the Box-Muller transform. The
+    * second deviate of each pair is cached and returned by the next call to
+    * this function.
+    */
+   double Normal( double mean = 0, double sigma = 1 )
+   {
+      if ( m_normal )
+      {
+         m_normal = false;
+         return mean + m_vs*sigma;
+      }
+      double z0;
+      NormalPair( z0, m_vs );
+      m_normal = true;
+      return mean + z0*sigma;
+   }
+
+   /*!
+    * Generates a floating point normal deviate with the specified \a mean and
+    * standard deviation \a sigma.
+    *
+    * This is a convenience alias for Normal( mean, sigma ).
+    */
+   double Gaussian( double mean = 0, double sigma = 1 )
+   {
+      return Normal( mean, sigma );
+   }
+
+   /*!
+    * Generates a discrete random deviate from a Poisson distribution with the
+    * specified expected value \a lambda.
+    *
+    * This function uses the same algorithms as RandomNumberGenerator::Poisson().
+    */
+   int Poisson( double lambda );
+
+   /*!
+    * Generates \a n uniform random deviates in the [0,1) range and stores them
+    * in the array \a x. The generated values are identical to those returned
+    * by \a n successive calls to operator()().
+    */
+   void Uniform( double* x, size_type n );
+
+   /*!
+    * Generates \a n normal random deviates with the specified \a mean and
+    * standard deviation \a sigma and stores them in the array \a x. The
+    * generated values are identical to those returned by \a n successive
+    * calls to Normal( mean, sigma ).
+    */
+   void Normal( double* x, size_type n, double mean = 0, double sigma = 1 );
+
+   /*!
+    * Generates \a n Poisson random deviates with the specified expected value
+    * \a lambda and stores them in the array \a k. The generated values are
+    * identical to those returned by \a n successive calls to Poisson( lambda ).
+    */
+   void Poisson( int* k, size_type n, double lambda );
+
+   /*!
+    * Generates \a n Poisson random deviates with the expected values in the
+    * array \a lambda and stores them in the array \a k. The generated values
+    * are identical to those returned by successive calls to
+    * Poisson( lambda[i] ) for i = 0, 1, ..., n-1.
+    */
+   void Poisson( int* k, const double* lambda, size_type n );
+
+   /*!
+    * Computes a block of four 32-bit random words, which is the Philox4x32-10
+    * bijection of the 128-bit counter formed by the specified 64-bit \a block
+    * index (low half) and \a stream identifier (high half), with the specified
+    * 64-bit \a key.
+    */
+   static void Block( uint32 out[ 4 ], uint64 block, uint64 stream, uint64 key )
+   {
+      uint32 c0 = uint32( block ), c1 = uint32( block >> 32 );
+      uint32 c2 = uint32( stream ), c3 = uint32( stream >> 32 );
+      uint32 k0 = uint32( key ), k1 = uint32( key >> 32 );
+      for ( int r = 0; ; )
+      {
+         uint64 p0 = uint64( 0xD2511F53u ) * c0;
+         uint64 p1 = uint64( 0xCD9E8D57u ) * c2;
+         c0 = uint32( p1 >> 32 ) ^ c1 ^ k0;
+         c1 = uint32( p1 );
+         c2 = uint32( p0 >> 32 ) ^ c3 ^ k1;
+         c3 = uint32( p0 );
+         if ( ++r == 10 )
+            break;
+         k0 += 0x9E3779B9u;
+         k1 += 0xBB67AE85u;
+      }
+      out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+   }
+
+private:
+
+   uint64 m_key;          // generator key (seed)
+   uint64 m_stream;       // stream identifier, high half of the counter
+   uint64 m_position;     // current position in 32-bit words
+   uint64 m_block;        // index of the block stored in m_words
+   uint32 m_words[ 4 ];   // current random block
+   bool   m_valid;        // true iff m_words stores block m_block
+   bool   m_normal;       // true iff m_vs stores a cached normal deviate
+   double m_vs;           // second result from Box-Muller transform
+   double m_lambda[ 5 ];  // precalculated for current Poisson lambda
+
+   /*
+    * Box-Muller transform, consuming four 32-bit words.
+    */
+   void NormalPair( double& z0, double& z1 );
+};
+
+// ----------------------------------------------------------------------------
+
 } // pcl
 
 #endif   // __PCL_Random_h
@@ -0,0 +1,339 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/RecursiveGaussianConvolution.h - Released 2016/02/21 20:22:12 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+
+#ifndef __PCL_RecursiveGaussianConvolution_h
+#define __PCL_RecursiveGaussianConvolution_h
+
+/// \file pcl/RecursiveGaussianConvolution.h
+
+#ifndef __PCL_Defs_h
+#include <pcl/Defs.h>
+#endif
+
+#ifndef __PCL_Diagnostics_h
+#include <pcl/Diagnostics.h>
+#endif
+
+#ifndef __PCL_ImageTransformation_h
+#include <pcl/ImageTransformation.h>
+#endif
+
+#ifndef __PCL_GaussianFilter_h
+#include <pcl/GaussianFilter.h>
+#endif
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \def PCL_RECURSIVE_GAUSSIAN_IS_FASTER_THAN_SEPARABLE_FILTER_SIGMA
+ * \brief Standard deviation of a Gaussian filter, in pixels, above which
+ * recursive Gaussian convolution is faster than separable convolution.
+ *
+ * The computational cost of a recursive Gaussian convolution does not depend
+ * on the standard deviation of the filter. For Gaussian filters with
+ * standard deviations larger than this value, RecursiveGaussianConvolution is
+ * faster than SeparableConvolution and FFTConvolution. This value has been
+ * determined experimentally; it is somewhat larger than the actual break-even
+ * point, since the recursive approximation is less accurate for small
+ * standard deviations.
+ *
+ * \ingroup fft_convolution_limits_macros
+ */
+#define PCL_RECURSIVE_GAUSSIAN_IS_FASTER_THAN_SEPARABLE_FILTER_SIGMA  4
+
+/*!
+ * \class RecursiveGaussianConvolution
+ * \brief Recursive two-dimensional Gaussian convolution
+ *
+ * %RecursiveGaussianConvolution implements the third-order recursive
+ * Gaussian filter of Young and van Vliet. Each row and each column of the
+ * target image is filtered with a causal recursion followed by an anticausal
+ * recursion, which requires a constant number of operations per pixel,
+ * irrespective of the standard deviation of the Gaussian function.
+ *
+ * Boundaries are handled by mirroring, as in SeparableConvolution. Each
+ * signal is extended with mirrored samples over a distance of eight standard
+ * deviations, and the anticausal recursion is initialized as described by
+ * Triggs and Sdika for a constant continuation of the extended signal. This
+ * prevents the border artifacts of the usual zero initialization. The
+ * impulse response of the recursive filter decays more slowly than a true
+ * Gaussian function, hence the relatively long boundary extension.
+ *
+ * A recursive Gaussian filter is an approximation to a Gaussian function of
+ * infinite extent. With respect to a separable convolution with a
+ * GaussianFilter object truncated at the default epsilon of 0.01, the
+ * maximum absolute error measured on normalized images is:
+ *
+ * <table border="1" cellpadding="4" cellspacing="0">
+ * <tr><td><b>Sigma</b></td> <td><b>Random noise</b></td> <td><b>Impulse</b></td> <td><b>Step edge</b></td></tr>
+ * <tr><td>1</td> <td>6.3e-02</td> <td>1.5e-01</td> <td>2.3e-02</td></tr>
+ * <tr><td>2</td> <td>1.6e-02</td> <td>1.1e-01</td> <td>1.6e-02</td></tr>
+ * <tr><td>4</td> <td>6.1e-03</td> <td>6.0e-02</td> <td>1.2e-02</td></tr>
+ * <tr><td>8</td> <td>2.1e-03</td> <td>3.7e-02</td> <td>9.2e-03</td></tr>
+ * <tr><td>16</td> <td>5.8e-04</td> <td>3.1e-02</td> <td>5.7e-03</td></tr>
+ * <tr><td>32</td> <td>2.3e-04</td> <td>3.0e-02</td> <td>4.7e-03</td></tr>
+ * <tr><td>64</td> <td>1.1e-04</td> <td>2.9e-02</td> <td>7.0e-03</td></tr>
+ * </table>
+ *
+ * where <em>random noise</em> is a uniform random image, <em>impulse</em> is
+ * the response to a unit impulse, and <em>step edge</em> is the response to
+ * a vertical step function of unit amplitude. Impulse responses have been
+ * normalized to unit peak values. These differences include the truncation
+ * of the FIR filter, which dominates the impulse response, and the error of
+ * the recursive approximation, which is largest for small standard
+ * deviations.
+ *
+ * <b>References</b>
+ *
+ * I. T. Young, L. J. van Vliet, <em>Recursive implementation of the Gaussian
+ * filter</em>, Signal Processing, vol. 44, pp. 139-151, 1995.
+ *
+ * L. J. van Vliet, I. T. Young, P. W. Verbeek, <em>Recursive Gaussian
+ * derivative filters</em>, Proceedings of the 14th International Conference
+ * on Pattern Recognition, vol. 1, pp. 509-514, 1998.
+ *
+ * B. Triggs, M. Sdika, <em>Boundary conditions for Young-van Vliet recursive
+ * filtering</em>, IEEE Transactions on Signal Processing, vol. 54, no. 6,
+ * pp. 2365-2367, 2006.
+ *
+ * \sa SeparableConvolution, FFTConvolution, GaussianFilter, ImageTransformation
+ */
+class PCL_CLASS RecursiveGaussianConvolution : public ImageTransformation
+{
+public:
+
+   /*!
+    * Constructs a %RecursiveGaussianConvolution instance with the specified
+    * standard deviation \a sigma > 0 in pixels.
+    */
+   RecursiveGaussianConvolution( float sigma = 2 ) :
+      ImageTransformation(),
+      m_sigma( Abs( sigma ) ),
+      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS )
+   {
+      PCL_PRECONDITION( sigma > 0 )
+   }
+
+   /*!
+    * Constructs a %RecursiveGaussianConvolution instance with the standard
+    * deviation of the specified Gaussian \a filter, which must be separable.
+    */
+   RecursiveGaussianConvolution( const GaussianFilter& filter ) :
+      ImageTransformation(),
+      m_sigma( filter.SigmaX() ),
+      m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS )
+   {
+      PCL_PRECONDITION( filter.IsSeparable() )
+   }
+
+   /*!
+    * Copy constructor.
+    */
+   RecursiveGaussianConvolution( const RecursiveGaussianConvolution& x ) :
+      ImageTransformation( x ),
+      m_sigma( x.m_sigma ),
+      m_parallel( x.m_parallel ), m_maxProcessors( x.m_maxProcessors )
+   {
+   }
+
+   /*!
+    * Destroys a %RecursiveGaussianConvolution object.
+    */
+   virtual ~RecursiveGaussianConvolution()
+   {
+   }
+
+   /*!
+    * Copy assignment operator. Returns a reference to this object.
+    */
+   RecursiveGaussianConvolution& operator =( const RecursiveGaussianConvolution& x )
+   {
+      if ( &x != this )
+      {
+         (void)ImageTransformation::operator =( x );
+         m_sigma = x.m_sigma;
+         m_parallel = x.m_parallel;
+         m_maxProcessors = x.m_maxProcessors;
+      }
+      return *this;
+   }
+
+   /*!
+    * Returns the standard deviation of the Gaussian function applied by this
+    * object, in pixels.
+    */
+   float Sigma() const
+   {
+      return m_sigma;
+   }
+
+   /*!
+    * Sets the standard deviation \a sigma > 0 of the Gaussian function
+    * applied by this object, in pixels.
+    */
+   void SetSigma( float sigma )
+   {
+      PCL_PRECONDITION( sigma > 0 )
+      m_sigma = Abs( sigma );
+   }
+
+   /*!
+    * Returns the number of mirrored boundary samples used to extend each row
+    * and each column of the target image. This is the distance, in pixels,
+    * where the result of this convolution depends on boundary conditions.
+    */
+   int BoundaryDistance() const
+   {
+      return 1 + TruncInt( 8*m_sigma );
+   }
+
+   /*!
+    * Returns true iff this object is allowed to use multiple parallel execution
+    * threads (when multiple threads are permitted and available).
+    */
+   bool IsParallelProcessingEnabled() const
+   {
+      return m_parallel;
+   }
+
+   /*!
+    * Enables parallel processing for this instance of
+    * %RecursiveGaussianConvolution.
+    *
+    * \param enable  Whether to enable or disable parallel processing. True by
+    *                default.
+    *
+    * \param maxProcessors    The maximum number of processors allowed for this
+    *                instance of %RecursiveGaussianConvolution. If \a enable is
+    *                false this parameter is ignored. A value <= 0 is ignored.
+    *                The default value is zero.
+    */
+   void EnableParallelProcessing( bool enable = true, int maxProcessors = 0 )
+   {
+      m_parallel = enable;
+      if ( enable && maxProcessors > 0 )
+         SetMaxProcessors( maxProcessors );
+   }
+
+   /*!
+    * Disables parallel processing for this instance of
+    * %RecursiveGaussianConvolution.
+    *
+    * This is a convenience function, equivalent to:
+    * EnableParallelProcessing( !disable )
+    */
+   void DisableParallelProcessing( bool disable = true )
+   {
+      EnableParallelProcessing( !disable );
+   }
+
+   /*!
+    * Returns the maximum number of processors allowed for this instance of
+    * %RecursiveGaussianConvolution.
+    *
+    * Irrespective of the value returned by this function, a module should not
+    * use more processors than the maximum number of parallel threads allowed
+    * for external modules on the PixInsight platform. This number is given by
+    * the "Process/MaxProcessors" global variable (refer to the GlobalSettings
+    * class for information on global variables).
+    */
+   int MaxProcessors() const
+   {
+      return m_maxProcessors;
+   }
+
+   /*!
+    * Sets the maximum number of processors allowed for this instance of
+    * %RecursiveGaussianConvolution.
+    *
+    * In the current version of PCL, a module can use a maximum of 1023
+    * processors. The term \e processor actually refers to the number of
+    * threads a module can execute concurrently.
+    *
+    * Irrespective of the value specified by this function, a module should not
+    * use more processors than the maximum number of parallel threads allowed
+    * for external modules on the PixInsight platform. This number is given by
+    * the "Process/MaxProcessors" global variable (refer to the GlobalSettings
+    * class for information on global variables).
+    */
+   void SetMaxProcessors( int maxProcessors )
+   {
+      m_maxProcessors = unsigned( Range( maxProcessors, 1, PCL_MAX_PROCESSORS ) );
+   }
+
+protected:
+
+   float    m_sigma;                     // standard deviation in pixels
+   bool     m_parallel      : 1;         // use multiple threads
+   unsigned m_maxProcessors : PCL_MAX_PROCESSORS_BITCOUNT; // Maximum number of processors allowed
+
+   /*
+    * In-place 2-D recursive Gaussian convolution algorithm.
+    */
+   virtual void Apply( pcl::Image& ) const;
+   virtual void Apply( pcl::DImage& ) const;
+   virtual void Apply( pcl::UInt8Image& ) const;
+   virtual void Apply( pcl::UInt16Image& ) const;
+   virtual void Apply( pcl::UInt32Image& ) const;
+};
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+#endif   // __PCL_RecursiveGaussianConvolution_h
+
+// ----------------------------------------------------------------------------
+// EOF pcl/RecursiveGaussianConvolution.h - Released 2016/02/21 20:22:12 UTC
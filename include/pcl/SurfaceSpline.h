@@ -66,6 +66,26 @@
 #include <pcl/Vector.h>
 #endif
 
+#ifndef __PCL_Matrix_h
+#include <pcl/Matrix.h>
+#endif
+
+#ifndef __PCL_Image_h
+#include <pcl/Image.h>
+#endif
+
+#ifndef __PCL_BicubicInterpolation_h
+#include <pcl/BicubicInterpolation.h>
+#endif
+
+#ifndef __PCL_Thread_h
+#include <pcl/Thread.h>
+#endif
+
+#ifndef __PCL_ThreadPool_h
+#include <pcl/ThreadPool.h>
+#endif
+
 namespace pcl
 {
 
@@ -92,14 +112,16 @@ protected:
    }
 
    static void Generate( float*, float*, const float*, int,
-                         int, float, const float*, float*, double&, double&, double& );
+                         int, float, const float*, float*, double&, double&, double&, bool, int );
 
    static void Generate( double*, double*, const double*, int,
-                         int, float, const float*, double*, double&, double&, double& );
+                         int, float, const float*, double*, double&, double&, double&, bool, int );
 
-   static float Interpolate( const float*, const float*, int, const float*, int, double, double );
+   static void Interpolate( double*, const double*, const double*, int,
+                            const float*, const float*, int, const float*, int, double, double, double );
 
-   static double Interpolate( const double*, const double*, int, const double*, int, double, double );
+   static void Interpolate( double*, const double*, const double*, int,
+                            const double*, const double*, int, const double*, int, double, double, double );
 };
 
 /*!
@@ -109,6 +131,13 @@ protected:
  * %SurfaceSpline implements interpolating or smoothing surface splines (also
  * known as <em>thin plates</em>) for arbitrarily distributed input nodes in
  * two dimensions.
+ *
+ * Evaluating a surface spline at a single point requires O(n) operations,
+ * where n is the number of nodes. To evaluate a spline at a large number of
+ * points efficiently, use the bulk evaluation member functions Evaluate() and
+ * EvaluateGrid(). These functions run in parallel, and can approximate the
+ * spline by bicubic interpolation from a coarse grid of exact function values,
+ * with a maximum error controlled by a user-defined tolerance.
  */
 template <typename T>
 class PCL_CLASS SurfaceSpline : private SurfaceSplineBase
@@ -125,7 +154,7 @@ public:
     * spline of second order.
     */
    SurfaceSpline() :
-      SurfaceSplineBase(), m_order( 2 ), m_smoothing( 0 )
+      SurfaceSplineBase(), m_order( 2 ), m_smoothing( 0 ), m_parallel( true ), m_maxProcessors( PCL_MAX_PROCESSORS )
    {
    }
 
@@ -254,6 +283,19 @@ public:
     * The input nodes can be arbitrarily distributed, and they don't need to
     * follow any specific order. However, all nodes must be distinct with
     * respect to the machine epsilon for the floating point type T.
+    *
+    * The spline is generated by solving a dense linear system of n+m(m+1)/2
+    * equations, where m is the derivative order, using multiple threads if
+    * parallel processing is enabled for this object.
+    *
+    * \note Generation requires O(n^2) memory and O(n^3) time, since the
+    * system matrix is stored and solved by Gaussian elimination in dense
+    * form. For example, 2000 nodes require about 32 MiB and 5000 nodes about
+    * 200 MiB for the system matrix, and elimination time grows eightfold each
+    * time the number of nodes is doubled. For this reason, surface splines
+    * should not be generated with more than a few thousand nodes; larger
+    * node sets should be reduced (for example, by averaging nodes in
+    * regular cells) before calling this function.
     */
    void Initialize( const T* x, const T* y, const T* z, int n, const float* weights = 0 )
    {
@@ -275,7 +317,8 @@ public:
 
          m_spline = vector_type( T( 0 ), n + ((m_order*(m_order + 1)) >> 1) );
 
-         Generate( m_x.Begin(), m_y.Begin(), z, n, m_order, m_smoothing, m_weights.Begin(), m_spline.Begin(), m_r0, m_x0, m_y0 );
+         Generate( m_x.Begin(), m_y.Begin(), z, n, m_order, m_smoothing, m_weights.Begin(), m_spline.Begin(), m_r0, m_x0, m_y0,
+                   m_parallel, m_maxProcessors );
       }
       catch ( ... )
       {
@@ -293,7 +336,195 @@ public:
       PCL_PRECONDITION( !m_x.IsEmpty() && !m_y.IsEmpty() )
       PCL_PRECONDITION( m_order >= 1 )
       PCL_PRECONDITION( !m_spline.IsEmpty() )
-      return Interpolate( m_x.Begin(), m_y.Begin(), m_x.Length(), m_spline.Begin(), m_order, m_r0*(x - m_x0), m_r0*(y - m_y0) );
+      double z;
+      Interpolate( &z, &x, &y, 1, m_x.Begin(), m_y.Begin(), m_x.Length(), m_spline.Begin(), m_order, m_r0, m_x0, m_y0 );
+      return T( z );
+   }
+
+   /*!
+    * Evaluates this surface spline at a set of points.
+    *
+    * \param[out] z  Address of the first element of an array where the \a n
+    *                interpolated values will be stored.
+    *
+    * \param x,y     Addresses of the first elements of the arrays of X and Y
+    *                coordinates of the interpolation points.
+    *
+    * \param n       Number of interpolation points.
+    *
+    * This function computes exact function values. If parallel processing is
+    * enabled for this object, the points are distributed among multiple
+    * threads.
+    */
+   void Evaluate( T* z, const double* x, const double* y, int n ) const
+   {
+      PCL_PRECONDITION( IsValid() )
+      EvaluatePoints( z, x, y, n, NumberOfThreads( n ) );
+   }
+
+   /*!
+    * Evaluates this surface spline at the pixels of a rectangular region of an
+    * image.
+    *
+    * \param[out] image   The image where the spline values will be written.
+    *
+    * \param rect    The rectangular region of the image to evaluate. If this
+    *                rectangle is empty, the current rectangular selection of
+    *                the image will be used. The default value is an empty
+    *                rectangle.
+    *
+    * \param channel Zero-based index of the channel where the spline values
+    *                will be written. If a negative index is specified, the
+    *                currently selected channel of the image will be used. The
+    *                default value is -1.
+    *
+    * \param tolerance  Maximum error allowed for grid approximation, in the
+    *                units of node values. If this parameter is zero or
+    *                negative, the spline is evaluated exactly at each pixel.
+    *                The default value is zero. See EvaluateGrid() for
+    *                information on grid approximation.
+    *
+    * The spline is evaluated at the integer image coordinates of each pixel,
+    * that is, the pixel at column x and row y receives the spline value at
+    * {x,y}. For integer pixel sample types, spline values are interpreted in
+    * the normalized [0,1] range and are constrained to it.
+    */
+   template <class P>
+   void Evaluate( GenericImage<P>& image, const Rect& rect = Rect( 0 ), int channel = -1, double tolerance = 0 ) const
+   {
+      PCL_PRECONDITION( IsValid() )
+      Rect r = rect;
+      if ( !image.ParseSelection( r, channel ) )
+         return;
+      image.EnsureUnique();
+      typename P::sample* f0 = image.PixelAddress( r.LeftTop(), channel );
+      int width = image.Width();
+      EvaluateRect( r, tolerance,
+         [=]( int i, const double* z )
+         {
+            typename P::sample* f = f0 + size_type( i )*width;
+            for ( int j = 0, w = r.Width(); j < w; ++j )
+               f[j] = P::ToSample( P::IsFloatSample() ? z[j] : pcl::Range( z[j], 0.0, 1.0 ) );
+         } );
+   }
+
+   /*!
+    * Evaluates this surface spline at the integer coordinates of a
+    * rectangular region. Returns a matrix with \a rect.Height() rows and
+    * \a rect.Width() columns, where the element at row i and column j is the
+    * spline value at {\a rect.x0 + j, \a rect.y0 + i}.
+    *
+    * \param rect    The rectangular region to evaluate.
+    *
+    * \param tolerance  Maximum error allowed for grid approximation, in the
+    *                units of node values. If this parameter is zero or
+    *                negative, the spline is evaluated exactly at each point.
+    *                The default value is zero.
+    *
+    * When a positive tolerance is specified, the spline is evaluated exactly
+    * on a coarse grid covering the rectangular region, and the values at the
+    * rest of points are approximated by bicubic spline interpolation from the
+    * grid. Starting from a grid distance of 64 units, the grid distance is
+    * halved until the approximation error, measured at the centers of all
+    * grid cells, is not larger than \a tolerance. If the grid cannot be
+    * cheaper than exact evaluation, the spline is evaluated exactly at all
+    * points.
+    *
+    * Grid approximation is typically orders of magnitude faster than exact
+    * evaluation for splines with a large number of nodes, since the cost per
+    * point does not depend on the number of nodes. If parallel processing is
+    * enabled for this object, both grid initialization and interpolation are
+    * performed using multiple threads.
+    */
+   GenericMatrix<T> EvaluateGrid( const Rect& rect, double tolerance = 0 ) const
+   {
+      PCL_PRECONDITION( IsValid() )
+      Rect r = rect.Ordered();
+      GenericMatrix<T> M( r.Height(), r.Width() );
+      T* m0 = M.Begin();
+      EvaluateRect( r, tolerance,
+         [=]( int i, const double* z )
+         {
+            T* m = m0 + size_type( i )*r.Width();
+            for ( int j = 0, w = r.Width(); j < w; ++j )
+               m[j] = T( z[j] );
+         } );
+      return M;
+   }
+
+   /*!
+    * Returns true iff this object is allowed to use multiple parallel
+    * execution threads (when multiple threads are permitted and available).
+    */
+   bool IsParallelProcessingEnabled() const
+   {
+      return m_parallel;
+   }
+
+   /*!
+    * Enables parallel processing for this instance of %SurfaceSpline.
+    *
+    * \param enable  Whether to enable or disable parallel processing. True by
+    *                default.
+    *
+    * \param maxProcessors    The maximum number of processors allowed for this
+    *                instance of %SurfaceSpline. If \a enable is false this
+    *                parameter is ignored. A value <= 0 is ignored. The default
+    *                value is zero.
+    *
+    * Parallel processing is applied to spline generation (see Initialize())
+    * and to bulk evaluation (see Evaluate() and EvaluateGrid()).
+    */
+   void EnableParallelProcessing( bool enable = true, int maxProcessors = 0 )
+   {
+      m_parallel = enable;
+      if ( enable && maxProcessors > 0 )
+         SetMaxProcessors( maxProcessors );
+   }
+
+   /*!
+    * Disables parallel processing for this instance of %SurfaceSpline.
+    *
+    * This is a convenience function, equivalent to:
+    * EnableParallelProcessing( !disable )
+    */
+   void DisableParallelProcessing( bool disable = true )
+   {
+      EnableParallelProcessing( !disable );
+   }
+
+   /*!
+    * Returns the maximum number of processors allowed for this instance of
+    * %SurfaceSpline.
+    *
+    * Irrespective of the value returned by this function, a module should not
+    * use more processors than the maximum number of parallel threads allowed
+    * for external modules on the PixInsight platform. This number is given by
+    * the "Process/MaxProcessors" global variable (refer to the GlobalSettings
+    * class for information on global variables).
+    */
+   int MaxProcessors() const
+   {
+      return m_maxProcessors;
+   }
+
+   /*!
+    * Sets the maximum number of processors allowed for this instance of
+    * %SurfaceSpline.
+    *
+    * In the current version of PCL, a module can use a maximum of 1023
+    * processors. The term \e processor actually refers to the number of
+    * threads a module can execute concurrently.
+    *
+    * Irrespective of the value specified by this function, a module should not
+    * use more processors than the maximum number of parallel threads allowed
+    * for external modules on the PixInsight platform. This number is given by
+    * the "Process/MaxProcessors" global variable (refer to the GlobalSettings
+    * class for information on global variables).
+    */
+   void SetMaxProcessors( int maxProcessors )
+   {
+      m_maxProcessors = unsigned( Range( maxProcessors, 1, PCL_MAX_PROCESSORS ) );
    }
 
    /*!
@@ -319,6 +550,151 @@ protected:
    float       m_smoothing; // smoothing factor, or interpolating 2-D spline if m_smoothing == 0
    FVector     m_weights;   // vector of node weights if m_smoothing != 0, otherwise ignored (empty)
    vector_type m_spline;    // coefficients of the 2-D surface spline
+   bool        m_parallel      : 1;
+   unsigned    m_maxProcessors : PCL_MAX_PROCESSORS_BITCOUNT;
+
+private:
+
+   /*
+    * Number of points evaluated per thread pool task in bulk evaluation.
+    */
+   enum { block_size = 256 };
+
+   int NumberOfThreads( int count ) const
+   {
+      return m_parallel ? pcl::Min( int( m_maxProcessors ), Thread::NumberOfThreads( count, 1 ) ) : 1;
+   }
+
+   /*
+    * Processes the range [0,count) with at most numberOfThreads concurrent
+    * thread pool tasks.
+    */
+   template <class F>
+   static void Run( int count, int numberOfThreads, F f )
+   {
+      if ( numberOfThreads > 1 )
+         ThreadPool::ParallelFor( count, (count + numberOfThreads - 1)/numberOfThreads, f );
+      else
+         f( 0, count );
+   }
+
+   template <typename Tz>
+   void EvaluatePoints( Tz* z, const double* x, const double* y, int n, int numberOfThreads ) const
+   {
+      Run( (n + block_size - 1)/block_size, numberOfThreads,
+         [=]( int begin, int end )
+         {
+            double zb[ block_size ];
+            for ( int b = begin; b < end; ++b )
+            {
+               int i0 = b*block_size;
+               int nb = pcl::Min( int( block_size ), n - i0 );
+               Interpolate( zb, x + i0, y + i0, nb,
+                            m_x.Begin(), m_y.Begin(), m_x.Length(), m_spline.Begin(), m_order, m_r0, m_x0, m_y0 );
+               for ( int i = 0; i < nb; ++i )
+                  z[i0 + i] = Tz( zb[i] );
+            }
+         } );
+   }
+
+   /*
+    * Evaluates this spline at the integer coordinates of the specified
+    * rectangle, calling store( i, z ) with the vector z of values for each row
+    * i, relative to the rectangle. Different rows can be stored concurrently.
+    */
+   template <class F>
+   void EvaluateRect( const Rect& rect, double tolerance, F store ) const
+   {
+      int w = rect.Width();
+      int h = rect.Height();
+      if ( w <= 0 || h <= 0 )
+         return;
+
+      if ( tolerance > 0 )
+         for ( int delta = 64; delta > 1; delta >>= 1 )
+         {
+            /*
+             * Grid nodes cover the rectangle plus one additional node on each
+             * side, so that interpolation at border cells is not affected by
+             * boundary conditions.
+             */
+            int rows = h/delta + ((h%delta) ? 1 : 0);
+            int cols = w/delta + ((w%delta) ? 1 : 0);
+            int gw = cols + 3;
+            int gh = rows + 3;
+            if ( 2.0*gw*gh >= double( w )*h )
+               break;
+
+            int N = gw*gh;
+            DVector X( N ), Y( N );
+            for ( int i = 0, k = 0; i < gh; ++i )
+               for ( int j = 0; j < gw; ++j, ++k )
+               {
+                  X[k] = rect.x0 + (j - 1)*delta;
+                  Y[k] = rect.y0 + (i - 1)*delta;
+               }
+            DVector G( N );
+            EvaluatePoints( G.Begin(), X.Begin(), Y.Begin(), N, NumberOfThreads( N ) );
+
+            BicubicSplineInterpolation<double> I;
+            I.Initialize( G.Begin(), gw, gh );
+
+            /*
+             * Measure the approximation error at the centers of all grid cells
+             * within the rectangle.
+             */
+            int Nc = rows*cols;
+            X = DVector( Nc );
+            Y = DVector( Nc );
+            for ( int i = 0, k = 0; i < rows; ++i )
+               for ( int j = 0; j < cols; ++j, ++k )
+               {
+                  X[k] = pcl::Min( rect.x0 + (j + 0.5)*delta, rect.x1 - 0.5 );
+                  Y[k] = pcl::Min( rect.y0 + (i + 0.5)*delta, rect.y1 - 0.5 );
+               }
+            DVector Z( Nc );
+            EvaluatePoints( Z.Begin(), X.Begin(), Y.Begin(), Nc, NumberOfThreads( Nc ) );
+
+            double maxError = 0;
+            for ( int k = 0; k < Nc; ++k )
+            {
+               double e = Abs( I( (X[k] - rect.x0)/delta + 1, (Y[k] - rect.y0)/delta + 1 ) - Z[k] );
+               if ( e > maxError )
+                  maxError = e;
+            }
+
+            if ( maxError <= tolerance )
+            {
+               Run( h, NumberOfThreads( h ),
+                  [&]( int begin, int end )
+                  {
+                     DVector z( w );
+                     for ( int i = begin; i < end; ++i )
+                     {
+                        double fy = double( i )/delta + 1;
+                        for ( int j = 0; j < w; ++j )
+                           z[j] = I( double( j )/delta + 1, fy );
+                        store( i, z.Begin() );
+                     }
+                  } );
+               return;
+            }
+         }
+
+      Run( h, NumberOfThreads( h ),
+         [&]( int begin, int end )
+         {
+            DVector x( w ), y( w ), z( w );
+            for ( int j = 0; j < w; ++j )
+               x[j] = rect.x0 + j;
+            for ( int i = begin; i < end; ++i )
+            {
+               y = double( rect.y0 + i );
+               EvaluatePoints( z.Begin(), x.Begin(), y.Begin(), w, 1 );
+               store( i, z.Begin() );
+            }
+         } );
+   }
 };
 
 // ----------------------------------------------------------------------------
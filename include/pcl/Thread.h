@@ -66,6 +66,10 @@
 #include <pcl/String.h>
 #endif
 
+#ifndef __PCL_Atomic_h
+#include <pcl/Atomic.h>
+#endif
+
 namespace pcl
 {
 
@@ -468,11 +472,17 @@ public:
     * Module->ProcessEvents(), as described above, and should stop its
     * execution after catching a ProcessAborted exception.
     *
+    * The abort request is also recorded in this object, so IsAborted() and
+    * TryIsAborted() return true after calling this function even if the
+    * thread's Run() member function is being executed without starting the
+    * thread, as happens with ThreadPool tasks.
+    *
     * \note This member function is thread-safe. It can be safely called for a
     * running thread, even from other running threads.
     */
    void Abort()
    {
+      m_abortRequested.Store( 1 );
       SetStatus( 0x80000000 );
    }
 
@@ -490,7 +500,7 @@ public:
     */
    bool IsAborted() const
    {
-      return (Status() & 0x80000000) != 0;
+      return m_abortRequested != 0 || (Status() & 0x80000000) != 0;
    }
 
    /*!
@@ -506,6 +516,8 @@ public:
     */
    bool TryIsAborted() const
    {
+      if ( m_abortRequested != 0 )
+         return true;
       uint32 status;
       return TryGetStatus( status ) && (status & 0x80000000) != 0;
    }
@@ -624,8 +636,9 @@ private:
    Thread( void* );
    virtual void* CloneHandle() const;
 
-   int    m_processorIndex;
-   String m_consoleOutputText;
+   int       m_processorIndex;
+   String    m_consoleOutputText;
+   AtomicInt m_abortRequested;
 
    friend class ThreadDispatcher;
 };
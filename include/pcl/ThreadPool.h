@@ -0,0 +1,400 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/ThreadPool.h - Released 2016/02/21 20:22:12 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#ifndef __PCL_ThreadPool_h
+#define __PCL_ThreadPool_h
+
+/// \file pcl/ThreadPool.h
+
+#ifndef __PCL_Defs_h
+#include <pcl/Defs.h>
+#endif
+
+#ifndef __PCL_Array_h
+#include <pcl/Array.h>
+#endif
+
+#ifndef __PCL_Atomic_h
+#include <pcl/Atomic.h>
+#endif
+
+#ifndef __PCL_Thread_h
+#include <pcl/Thread.h>
+#endif
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*!
+ * \class ThreadPool
+ * \brief Pool of persistent worker threads with work stealing.
+ *
+ * %ThreadPool manages a set of persistent worker threads shared by all
+ * parallel algorithms of a module. Worker threads are created the first time
+ * the pool is used, and remain idle, without consuming processor time, while
+ * there are no tasks to execute.
+ *
+ * Each worker owns a double-ended task queue. Tasks submitted from a worker
+ * thread are pushed to the worker's own queue, while tasks submitted from any
+ * other thread are distributed among all worker queues. A worker executes the
+ * most recently queued task of its own queue; when its queue is empty, it
+ * steals the oldest task from the queue of another worker. In this way the
+ * pool balances irregular workloads dynamically, without the overhead of
+ * creating and destroying threads for each parallel task.
+ *
+ * Tasks are submitted and waited for as members of a ThreadPool::TaskGroup
+ * object. The ParallelFor() member function provides a convenient interface to
+ * process a range of items (typically pixel rows) in parallel with dynamic
+ * load balancing:
+ *
+ * \code
+ * ThreadPool::ParallelFor( image.Height(), 16,
+ *    [&]( int startRow, int endRow )
+ *    {
+ *       for ( int y = startRow; y < endRow; ++y )
+ *          ProcessRow( image, y );
+ *    } );
+ * \endcode
+ *
+ * AbstractImage::RunThreads() executes its threads as pool tasks, so all
+ * parallel image processing algorithms based on that function benefit
+ * automatically from persistent worker threads.
+ *
+ * \note Since PCL is linked statically with each module, a thread pool is
+ * shared by all algorithms of a module, but not among different modules.
+ * Worker threads are terminated automatically when the module is unloaded.
+ *
+ * \ingroup thread_support
+ */
+class PCL_CLASS ThreadPool
+{
+public:
+
+   /*!
+    * \class pcl::ThreadPool::Task
+    * \brief Abstract base class of thread pool tasks.
+    */
+   class PCL_CLASS Task
+   {
+   public:
+
+      /*!
+       * Virtual destructor.
+       */
+      virtual ~Task()
+      {
+      }
+
+      /*!
+       * Performs the task. This function is invoked from a worker thread, or
+       * from a thread waiting for completion of a task group.
+       */
+      virtual void Execute() = 0;
+   };
+
+   /*!
+    * \class pcl::ThreadPool::ThreadTask
+    * \brief A task that executes the Run() member function of a Thread object.
+    *
+    * The thread object is not started: its Run() function is invoked directly
+    * from a pool worker thread. If the thread has been aborted before the task
+    * is executed, Run() is not called. As happens with running threads,
+    * exceptions thrown by Thread::Run() are not propagated.
+    */
+   class PCL_CLASS ThreadTask : public Task
+   {
+   public:
+
+      /*!
+       * Constructs a task to execute the specified \a thread.
+       */
+      ThreadTask( Thread& thread ) : m_thread( &thread )
+      {
+      }
+
+      /*!
+       * Constructs a null task.
+       */
+      ThreadTask() : m_thread( nullptr )
+      {
+      }
+
+      /*!
+       */
+      virtual void Execute();
+
+   private:
+
+      Thread* m_thread;
+   };
+
+   /*!
+    * \class pcl::ThreadPool::TaskGroup
+    * \brief A set of thread pool tasks that can be waited for as a unit.
+    *
+    * Task objects are not owned by a task group. Submitted tasks must remain
+    * valid until the group has completed execution.
+    *
+    * If a task throws an exception, the first exception thrown is rethrown
+    * by the Wait() member functions, once all tasks in the group have been
+    * completed.
+    */
+   class PCL_CLASS TaskGroup
+   {
+   public:
+
+      /*!
+       * Constructs an empty task group.
+       */
+      TaskGroup();
+
+      /*!
+       * Destroys a task group. If there are pending tasks, waits until all of
+       * them have been completed.
+       */
+      ~TaskGroup();
+
+      /*!
+       * Submits a \a task for execution by the thread pool.
+       */
+      void Run( Task& task );
+
+      /*!
+       * Waits until all tasks in this group have been completed. While there
+       * are pending tasks, the calling thread contributes to execute queued
+       * pool tasks.
+       */
+      void Wait();
+
+      /*!
+       * Waits until all tasks in this group have been completed, or until the
+       * specified time \a ms in milliseconds has elapsed. Returns true iff all
+       * tasks have been completed.
+       *
+       * If the calling thread is a pool worker, it contributes to execute
+       * queued tasks while waiting. Otherwise the calling thread is suspended,
+       * which allows it to perform periodic tasks such as status monitoring.
+       */
+      bool Wait( unsigned ms );
+
+      /*!
+       * Returns true iff all tasks submitted to this group have been
+       * completed.
+       */
+      bool IsComplete() const;
+
+   private:
+
+      void* m_data;
+
+      TaskGroup( const TaskGroup& ) = delete;
+      TaskGroup& operator =( const TaskGroup& ) = delete;
+   };
+
+   /*!
+    * Returns the number of worker threads in the thread pool. If necessary,
+    * the pool is initialized by calling this function.
+    */
+   static int NumberOfWorkers();
+
+   /*!
+    * Terminates all worker threads. The pool will be initialized again with
+    * new worker threads if it is used after calling this function.
+    *
+    * This function is called automatically when the module is unloaded. It
+    * must not be called while there are pending pool tasks.
+    */
+   static void Shutdown();
+
+   /*!
+    * Processes the range [0,\a count) of items in parallel.
+    *
+    * \param count   Number of items to process.
+    *
+    * \param grain   Minimum number of items processed by a single task. If
+    *                zero or a negative value is specified, a grain size will
+    *                be chosen to generate about four tasks per worker thread.
+    *
+    * \param f       Function or function object invoked as f( begin, end ) to
+    *                process the range [begin,end) of items.
+    *
+    * \param maxThreads   Maximum number of item ranges processed
+    *                concurrently. If zero or a negative value is specified,
+    *                the number of concurrent tasks is only limited by the
+    *                number of pool worker threads.
+    *
+    * The range is divided into tasks of \a grain items, which are executed by
+    * pool worker threads with dynamic load balancing. The calling thread also
+    * executes tasks until the whole range has been processed. If a task
+    * throws an exception, it is rethrown by this function.
+    */
+   template <class F>
+   static void ParallelFor( int count, int grain, F f, int maxThreads = 0 )
+   {
+      if ( count <= 0 )
+         return;
+
+      int workers = NumberOfWorkers();
+      if ( maxThreads > 0 )
+         workers = pcl::Min( workers, maxThreads );
+      if ( grain <= 0 )
+         grain = pcl::Max( 1, count/(4*pcl::Max( 1, workers )) );
+
+      int n = (count + grain - 1)/grain;
+      if ( n < 2 || workers < 2 )
+      {
+         f( 0, count );
+         return;
+      }
+
+      TaskGroup group;
+      if ( maxThreads <= 0 || n <= workers )
+      {
+         Array<RangeTask<F> > tasks( n );
+         for ( int i = 0, begin = 0; i < n; ++i, begin += grain )
+         {
+            tasks[i].Initialize( f, begin, pcl::Min( count, begin+grain ) );
+            group.Run( tasks[i] );
+         }
+         group.Wait();
+      }
+      else
+      {
+         /*
+          * Limited concurrency: a fixed set of tasks fetch ranges of items
+          * from a shared counter.
+          */
+         AtomicInt next;
+         Array<SharedRangeTask<F> > tasks( workers );
+         for ( int i = 0; i < workers; ++i )
+         {
+            tasks[i].Initialize( f, next, count, grain );
+            group.Run( tasks[i] );
+         }
+         group.Wait();
+      }
+   }
+
+private:
+
+   template <class F>
+   class RangeTask : public Task
+   {
+   public:
+
+      RangeTask() : m_f( nullptr ), m_begin( 0 ), m_end( 0 )
+      {
+      }
+
+      void Initialize( const F& f, int begin, int end )
+      {
+         m_f = &f;
+         m_begin = begin;
+         m_end = end;
+      }
+
+      virtual void Execute()
+      {
+         (*m_f)( m_begin, m_end );
+      }
+
+   private:
+
+      const F* m_f;
+      int      m_begin, m_end;
+   };
+
+   template <class F>
+   class SharedRangeTask : public Task
+   {
+   public:
+
+      SharedRangeTask() : m_f( nullptr ), m_next( nullptr ), m_count( 0 ), m_grain( 0 )
+      {
+      }
+
+      void Initialize( const F& f, AtomicInt& next, int count, int grain )
+      {
+         m_f = &f;
+         m_next = &next;
+         m_count = count;
+         m_grain = grain;
+      }
+
+      virtual void Execute()
+      {
+         for ( ;; )
+         {
+            int begin = m_next->FetchAndAdd( m_grain );
+            if ( begin >= m_count )
+               break;
+            (*m_f)( begin, pcl::Min( m_count, begin+m_grain ) );
+         }
+      }
+
+   private:
+
+      const F*   m_f;
+      AtomicInt* m_next;
+      int        m_count, m_grain;
+   };
+};
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+#endif   // __PCL_ThreadPool_h
+
+// ----------------------------------------------------------------------------
+// EOF pcl/ThreadPool.h - Released 2016/02/21 20:22:12 UTC
@@ -0,0 +1,1379 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// PCLBench Benchmark Suite Version 01.00.00.0001
+// ----------------------------------------------------------------------------
+// PCLBench.cpp - Released 2016/02/21 20:22:34 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PCLBench benchmark suite.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+
+#if !defined( __PCL_FREEBSD ) && !defined( __PCL_LINUX ) && !defined( __PCL_MACOSX )
+#error This source file can only be compiled on FreeBSD, Linux and OS X platforms.
+#endif
+
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+
+#include <pcl/Arguments.h>
+#include <pcl/Console.h>
+#include <pcl/Convolution.h>
+#include <pcl/ElapsedTime.h>
+#include <pcl/Exception.h>
+#include <pcl/File.h>
+#include <pcl/GaussianFilter.h>
+#include <pcl/HeadlessAPI.h>
+#include <pcl/ImageStatistics.h>
+#include <pcl/KDTree.h>
+#include <pcl/MetaModule.h>
+#include <pcl/MorphologicalTransformation.h>
+#include <pcl/PixelInterpolation.h>
+#include <pcl/Random.h>
+#include <pcl/RecursiveGaussianConvolution.h>
+#include <pcl/Resample.h>
+#include <pcl/SeparableConvolution.h>
+#include <pcl/Sort.h>
+#include <pcl/StructuringElement.h>
+#include <pcl/Thread.h>
+#include <pcl/ThreadPool.h>
+#include <pcl/Version.h>
+
+#include "../../modules/file-formats/XISF/XISF.h"
+#include "../../modules/processes/ImageIntegration/RejectionKernels.h"
+
+/*
+ * Standard exit codes.
+ */
+#define EXIT_OK      0
+#define EXIT_ERROR   1
+
+using namespace pcl;
+
+// ----------------------------------------------------------------------------
+
+/*
+ * XISFReader and XISFWriter call MetaModule::ProcessEvents() and
+ * MetaModule::ReadableVersion(), so we need a module object, even if there is
+ * no core application to load it.
+ */
+class PCLBenchModule : public MetaModule
+{
+public:
+
+   virtual const char* Version() const
+   {
+      return PCL_MODULE_VERSION( 01, 00, 00, 0001, eng );
+   }
+
+   virtual IsoString Name() const
+   {
+      return "PCLBench";
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Benchmark parameters and shared input data.
+ */
+struct BenchmarkContext
+{
+   int    width      = 2048;
+   int    height     = 2048;
+   int    channels   = 1;
+   int    frames     = 16;
+   uint32 seed       = 1234567u;
+   String tmpDir;
+   Image  signal;    // noiseless synthetic image
+   Image  source;    // synthetic image with additive Gaussian noise
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Synthetic test images: A smooth background with linear gradients, a
+ * population of Gaussian star profiles, and optional additive Gaussian noise
+ * and hot pixels. Random numbers are generated with one generator per row, so
+ * the generated images don't depend on the number of threads used.
+ */
+static void GenerateSignal( Image& signal, int width, int height, int channels, uint32 seed )
+{
+   signal.AllocateData( width, height, channels, (channels < 3) ? ColorSpace::Gray : ColorSpace::RGB );
+
+   ThreadPool::ParallelFor( height, 16,
+      [&]( int startRow, int endRow )
+      {
+         for ( int c = 0; c < channels; ++c )
+            for ( int y = startRow; y < endRow; ++y )
+            {
+               Image::sample* f = signal.ScanLine( y, c );
+               double by = 0.1 + 0.01*c + 0.03*double( y )/height;
+               for ( int x = 0; x < width; ++x )
+                  f[x] = Image::sample( by + 0.05*double( x )/width );
+            }
+      } );
+
+   RandomNumberGenerator R( 1.0, seed );
+   int count = pcl::Max( 1, int( double( width )*height/20000 ) );
+   for ( int i = 0; i < count; ++i )
+   {
+      double x0 = R()*width;
+      double y0 = R()*height;
+      double sigma = 1 + 2*R();
+      double amplitude = 0.02 + 0.8*R()*R();
+      double k = 1/(2*sigma*sigma);
+      int r = int( 4*sigma ) + 1;
+      int xa = pcl::Max( 0, int( x0 ) - r ), xb = pcl::Min( width-1, int( x0 ) + r );
+      int ya = pcl::Max( 0, int( y0 ) - r ), yb = pcl::Min( height-1, int( y0 ) + r );
+      for ( int c = 0; c < channels; ++c )
+      {
+         double a = amplitude*(1 - 0.1*c);
+         for ( int y = ya; y <= yb; ++y )
+         {
+            Image::sample* f = signal.ScanLine( y, c );
+            double dy2 = (y - y0)*(y - y0);
+            for ( int x = xa; x <= xb; ++x )
+               f[x] += Image::sample( a*Exp( -((x - x0)*(x - x0) + dy2)*k ) );
+         }
+      }
+   }
+
+   signal.Truncate();
+}
+
+static void GenerateFrame( Image& image, const Image& signal, double sigma, double hotPixelFraction, uint32 seed )
+{
+   image.Assign( signal );
+
+   ThreadPool::ParallelFor( image.Height(), 16,
+      [&]( int startRow, int endRow )
+      {
+         for ( int y = startRow; y < endRow; ++y )
+         {
+            uint32 rowSeed = seed + 2654435761u*uint32( y+1 );
+            RandomNumberGenerator R( 1.0, rowSeed ? rowSeed : 1u );
+            for ( int c = 0; c < image.NumberOfChannels(); ++c )
+            {
+               Image::sample* f = image.ScanLine( y, c );
+               for ( int x = 0; x < image.Width(); ++x )
+               {
+                  f[x] += Image::sample( R.Normal( 0, sigma ) );
+                  if ( hotPixelFraction > 0 )
+                     if ( R() < hotPixelFraction )
+                        f[x] = 1;
+               }
+            }
+         }
+      } );
+}
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Abstract benchmark. Initialize() and Finalize() are called once, before and
+ * after all iterations, respectively. Prepare() is called before each
+ * iteration. Only the execution time of Execute() is measured.
+ */
+class Benchmark
+{
+public:
+
+   Benchmark( const IsoString& id, const String& description ) :
+      m_id( id ), m_description( description )
+   {
+   }
+
+   virtual ~Benchmark()
+   {
+   }
+
+   const IsoString& Id() const
+   {
+      return m_id;
+   }
+
+   const String& Description() const
+   {
+      return m_description;
+   }
+
+   virtual void Initialize( BenchmarkContext& )
+   {
+   }
+
+   virtual void Prepare()
+   {
+   }
+
+   virtual void Execute() = 0;
+
+   virtual void Finalize()
+   {
+   }
+
+   /*
+    * Number of input pixels processed by each iteration, in megapixels.
+    */
+   virtual double Megapixels( const BenchmarkContext& context ) const
+   {
+      return double( context.width )*context.height*context.channels/1.0e+06;
+   }
+
+private:
+
+   IsoString m_id;
+   String    m_description;
+};
+
+typedef IndirectArray<Benchmark> benchmark_list;
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Applies an image transformation in place to a working copy of the source
+ * image.
+ */
+class TransformationBenchmark : public Benchmark
+{
+public:
+
+   TransformationBenchmark( const IsoString& id, const String& description, ImageTransformation* transformation ) :
+      Benchmark( id, description ), m_transformation( transformation ), m_source( nullptr )
+   {
+   }
+
+   virtual ~TransformationBenchmark()
+   {
+      delete m_transformation;
+   }
+
+   virtual void Initialize( BenchmarkContext& context )
+   {
+      m_source = &context.source;
+   }
+
+   virtual void Prepare()
+   {
+      m_work.Assign( *m_source );
+   }
+
+   virtual void Execute()
+   {
+      *m_transformation >> m_work;
+   }
+
+   virtual void Finalize()
+   {
+      m_work.FreeData();
+   }
+
+private:
+
+         ImageTransformation* m_transformation;
+   const Image*               m_source;
+         Image                m_work;
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Resampling benchmarks own their pixel interpolation objects, which must
+ * survive the Resample transformation that references them.
+ */
+class ResampleBenchmark : public TransformationBenchmark
+{
+public:
+
+   ResampleBenchmark( const IsoString& id, const String& description, PixelInterpolation* interpolation, double scale ) :
+      TransformationBenchmark( id, description, new Resample( *interpolation, scale ) ),
+      m_interpolation( interpolation )
+   {
+   }
+
+   virtual ~ResampleBenchmark()
+   {
+      delete m_interpolation;
+   }
+
+private:
+
+   PixelInterpolation* m_interpolation;
+};
+
+// ----------------------------------------------------------------------------
+
+class StatisticsBenchmark : public Benchmark
+{
+public:
+
+   StatisticsBenchmark() :
+      Benchmark( "statistics", "ImageStatistics: mean, median, average deviation, MAD and biweight midvariance" )
+   {
+      m_statistics.EnableMedian();
+      m_statistics.EnableAvgDev();
+      m_statistics.EnableMAD();
+      m_statistics.EnableBWMV();
+   }
+
+   virtual void Initialize( BenchmarkContext& context )
+   {
+      m_image.Assign( context.source );
+   }
+
+   virtual void Execute()
+   {
+      for ( int c = 0; c < m_image.NumberOfChannels(); ++c )
+      {
+         m_image.SelectChannel( c );
+         m_statistics << m_image;
+      }
+      m_image.ResetSelections();
+   }
+
+   virtual void Finalize()
+   {
+      m_image.FreeData();
+   }
+
+private:
+
+   ImageStatistics m_statistics;
+   Image           m_image;
+};
+
+// ----------------------------------------------------------------------------
+
+static XISFOptions BenchmarkXISFOptions( bool compressed )
+{
+   XISFOptions options;
+   options.verbosity = 0;
+   options.noWarnings = true;
+   if ( compressed )
+   {
+      options.compressionMethod = XISF_COMPRESSION_ZLIB_SH;
+      options.checksumMethod = XISF_CHECKSUM_SHA1;
+   }
+   return options;
+}
+
+static void WriteXISFFile( const String& filePath, const Image& image, bool compressed )
+{
+   XISFWriter writer;
+   writer.SetOptions( BenchmarkXISFOptions( compressed ) );
+   writer.Create( filePath, 1 );
+   writer.WriteImage( image );
+   writer.Close();
+}
+
+class XISFWriteBenchmark : public Benchmark
+{
+public:
+
+   XISFWriteBenchmark( bool compressed ) :
+      Benchmark( compressed ? "xisf-write-zlib" : "xisf-write",
+                 compressed ? "XISF output, zlib + byte shuffling compression, SHA-1 checksums" : "XISF output, uncompressed" ),
+      m_compressed( compressed ), m_source( nullptr )
+   {
+   }
+
+   virtual void Initialize( BenchmarkContext& context )
+   {
+      m_source = &context.source;
+      m_filePath = File::UniqueFileName( context.tmpDir, 12, "PCLBench_", ".xisf" );
+   }
+
+   virtual void Execute()
+   {
+      WriteXISFFile( m_filePath, *m_source, m_compressed );
+   }
+
+   virtual void Finalize()
+   {
+      if ( File::Exists( m_filePath ) )
+         File::Remove( m_filePath );
+   }
+
+private:
+
+         bool   m_compressed;
+   const Image* m_source;
+         String m_filePath;
+};
+
+class XISFReadBenchmark : public Benchmark
+{
+public:
+
+   XISFReadBenchmark( bool compressed ) :
+      Benchmark( compressed ? "xisf-read-zlib" : "xisf-read",
+                 compressed ? "XISF input, zlib + byte shuffling compression, SHA-1 checksums" : "XISF input, uncompressed" ),
+      m_compressed( compressed )
+   {
+   }
+
+   virtual void Initialize( BenchmarkContext& context )
+   {
+      m_filePath = File::UniqueFileName( context.tmpDir, 12, "PCLBench_", ".xisf" );
+      WriteXISFFile( m_filePath, context.source, m_compressed );
+   }
+
+   virtual void Execute()
+   {
+      XISFReader reader;
+      reader.SetOptions( BenchmarkXISFOptions( m_compressed ) );
+      reader.Open( m_filePath );
+      reader.ReadImage( m_image );
+      reader.Close();
+   }
+
+   virtual void Finalize()
+   {
+      m_image.FreeData();
+      if ( File::Exists( m_filePath ) )
+         File::Remove( m_filePath );
+   }
+
+private:
+
+   bool   m_compressed;
+   String m_filePath;
+   Image  m_image;
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Pixel rejection kernels of the ImageIntegration process: Iterative sigma
+ * clipping rejection and average combination, applied to a stack of
+ * registered frames with independent noise and hot pixels. Pixel stacks are
+ * sorted and clipped with the same routines used by the ImageIntegration
+ * rejection engine.
+ */
+class IntegrationBenchmark : public Benchmark
+{
+public:
+
+   IntegrationBenchmark() :
+      Benchmark( "integration", "ImageIntegration kernels: sigma clipping rejection, average combination" )
+   {
+   }
+
+   virtual void Initialize( BenchmarkContext& context )
+   {
+      m_frames.Clear();
+      m_frames.Add( Image(), context.frames );
+      for ( int i = 0; i < context.frames; ++i )
+         GenerateFrame( m_frames[i], context.signal, 0.01, 0.0005, context.seed + 7919u*uint32( i+1 ) );
+      m_result.AllocateData( context.width, context.height, context.channels, context.signal.ColorSpace() );
+   }
+
+   virtual void Execute()
+   {
+      int width = m_result.Width();
+      int n = int( m_frames.Length() );
+
+      ThreadPool::ParallelFor( m_result.Height(), 4,
+         [&]( int startRow, int endRow )
+         {
+            Array<float> v( n );
+            Array<int> ix( n );
+            Array<uint8> f( n );
+            RejectionKernels::stack_buffer buffer( n );
+            for ( int c = 0; c < m_result.NumberOfChannels(); ++c )
+               for ( int y = startRow; y < endRow; ++y )
+               {
+                  Image::sample* r = m_result.ScanLine( y, c );
+                  for ( int x = 0; x < width; ++x )
+                  {
+                     for ( int i = 0; i < n; ++i )
+                     {
+                        v[i] = m_frames[i].ScanLine( y, c )[x];
+                        ix[i] = i;
+                        f[i] = 0;
+                     }
+                     RejectionKernels::SortStack( v.Begin(), ix.Begin(), n, buffer.Begin() );
+                     int lo, hi;
+                     RejectionKernels::SigmaClip( lo, hi, v.Begin(), ix.Begin(), f.Begin(), n,
+                                                  4.0, 3.0, true/*clipLow*/, true/*clipHigh*/ );
+                     int m = RejectionKernels::CloseWindow( v.Begin(), ix.Begin(), lo, hi );
+                     double s = 0;
+                     for ( int i = 0; i < m; ++i )
+                        s += v[i];
+                     r[x] = Image::sample( (m > 0) ? s/m : 0.0 );
+                  }
+               }
+         } );
+   }
+
+   virtual void Finalize()
+   {
+      m_frames.Clear();
+      m_result.FreeData();
+   }
+
+   virtual double Megapixels( const BenchmarkContext& context ) const
+   {
+      return Benchmark::Megapixels( context )*context.frames;
+   }
+
+private:
+
+   Array<Image> m_frames;
+   Image        m_result;
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Two-dimensional point stored in K-d tree benchmarks.
+ */
+struct BenchmarkPoint
+{
+   typedef double component;
+
+   double x, y;
+
+   BenchmarkPoint( double a_x = 0, double a_y = 0 ) : x( a_x ), y( a_y )
+   {
+   }
+
+   int Length() const
+   {
+      return 2;
+   }
+
+   double operator []( int i ) const
+   {
+      return i ? y : x;
+   }
+};
+
+typedef Array<BenchmarkPoint> benchmark_point_list;
+
+/*
+ * Uniformly distributed points over the image area, with a density of one
+ * point per 16 pixels.
+ */
+static size_type NumberOfPoints( const BenchmarkContext& context )
+{
+   return Max( size_type( 1 ), (size_type( context.width )*size_type( context.height )) >> 4 );
+}
+
+static void GeneratePoints( benchmark_point_list& points, const BenchmarkContext& context, uint32 seed )
+{
+   RandomNumberGenerator R( 1.0, seed );
+   size_type n = NumberOfPoints( context );
+   points.Clear();
+   points.Reserve( n );
+   for ( size_type i = 0; i < n; ++i )
+      points.Add( BenchmarkPoint( context.width*R(), context.height*R() ) );
+}
+
+/*
+ * The pointer-based bucket K-d tree implementation of PCL 2.1.1, used as a
+ * reference for the KDTree benchmarks. Each node is allocated separately and
+ * each leaf stores its own list of points.
+ */
+class PointerKDTree
+{
+public:
+
+   typedef BenchmarkPoint::component component;
+
+   PointerKDTree() : m_root( nullptr ), m_bucketCapacity( 16 )
+   {
+   }
+
+   ~PointerKDTree()
+   {
+      Clear();
+   }
+
+   void Clear()
+   {
+      DestroyTree( m_root );
+      m_root = nullptr;
+   }
+
+   void Build( const benchmark_point_list& points, int bucketCapacity = 16 )
+   {
+      Clear();
+      m_bucketCapacity = Max( 1, bucketCapacity );
+      m_root = BuildTree( points, 0 );
+   }
+
+   template <class F>
+   void Search( const BenchmarkPoint& pt, component epsilon, F callback, void* data ) const
+   {
+      component p0[ 2 ] = { pt.x - epsilon, pt.y - epsilon };
+      component p1[ 2 ] = { pt.x + epsilon, pt.y + epsilon };
+      SearchTree( p0, p1, callback, data, m_root, 0 );
+   }
+
+private:
+
+   struct Node
+   {
+      double split;
+      Node*  left;
+      Node*  right;
+
+      Node( double s = 0 ) : split( s ), left( nullptr ), right( nullptr )
+      {
+      }
+
+      bool IsLeaf() const
+      {
+         return left == nullptr && right == nullptr;
+      }
+   };
+
+   struct LeafNode : public Node
+   {
+      benchmark_point_list points;
+
+      LeafNode( const benchmark_point_list& p ) : Node(), points( p )
+      {
+      }
+   };
+
+   Node* m_root;
+   int   m_bucketCapacity;
+
+   Node* BuildTree( const benchmark_point_list& points, int depth )
+   {
+      if ( points.IsEmpty() )
+         return nullptr;
+
+      if ( points.Length() <= size_type( m_bucketCapacity ) )
+         return new LeafNode( points );
+
+      int index = depth & 1;
+
+      DVector v( int( points.Length() ) );
+      for ( int i = 0; i < v.Length(); ++i )
+         v[i] = points[i][index];
+      Node* node = new Node( v.Median() );
+
+      benchmark_point_list left, right;
+      for ( benchmark_point_list::const_iterator i = points.Begin(); i != points.End(); ++i )
+         if ( (*i)[index] <= node->split )
+            left.Add( *i );
+         else
+            right.Add( *i );
+
+      if ( left.IsEmpty() || right.IsEmpty() )
+      {
+         delete node;
+         return nullptr;
+      }
+
+      node->left  = BuildTree( left, depth+1 );
+      node->right = BuildTree( right, depth+1 );
+
+      if ( node->IsLeaf() )
+      {
+         delete node;
+         return nullptr;
+      }
+
+      return node;
+   }
+
+   template <class F>
+   void SearchTree( const component* p0, const component* p1, F callback, void* data, const Node* node, int depth ) const
+   {
+      if ( node != nullptr )
+         if ( node->IsLeaf() )
+         {
+            const LeafNode* leaf = static_cast<const LeafNode*>( node );
+            for ( benchmark_point_list::const_iterator i = leaf->points.Begin(); i != leaf->points.End(); ++i )
+               if ( i->x >= p0[0] && i->x <= p1[0] && i->y >= p0[1] && i->y <= p1[1] )
+                  callback( *i, data );
+         }
+         else
+         {
+            int index = depth & 1;
+            if ( p0[index] <= node->split )
+               SearchTree( p0, p1, callback, data, node->left, depth+1 );
+            if ( p1[index] > node->split )
+               SearchTree( p0, p1, callback, data, node->right, depth+1 );
+         }
+   }
+
+   static void DestroyTree( Node* node )
+   {
+      if ( node != nullptr )
+         if ( node->IsLeaf() )
+            delete static_cast<LeafNode*>( node );
+         else
+         {
+            DestroyTree( node->left );
+            DestroyTree( node->right );
+            delete node;
+         }
+   }
+};
+
+/*
+ * K-d tree construction for a set of uniformly distributed 2-D points, with
+ * the default bucket capacity of 16 points. With pointerTree = true, the
+ * previous pointer-based implementation is benchmarked instead of KDTree.
+ * Throughput is expressed in millions of points per second.
+ */
+class KDTreeBuildBenchmark : public Benchmark
+{
+public:
+
+   KDTreeBuildBenchmark( bool pointerTree ) :
+      Benchmark( pointerTree ? "kdtree-build-pointer" : "kdtree-build",
+                 pointerTree ? "K-d tree construction, pointer-based reference implementation" :
+                               "KDTree construction, 2-D points, bucket capacity = 16" ),
+      m_pointerTree( pointerTree )
+   {
+   }
+
+   virtual void Initialize( BenchmarkContext& context )
+   {
+      GeneratePoints( m_points, context, context.seed );
+   }
+
+   virtual void Execute()
+   {
+      if ( m_pointerTree )
+      {
+         PointerKDTree T;
+         T.Build( m_points );
+      }
+      else
+      {
+         KDTree<BenchmarkPoint> T( m_points );
+      }
+   }
+
+   virtual void Finalize()
+   {
+      m_points.Clear();
+   }
+
+   virtual double Megapixels( const BenchmarkContext& context ) const
+   {
+      return NumberOfPoints( context )/1.0e+06;
+   }
+
+private:
+
+   bool                 m_pointerTree;
+   benchmark_point_list m_points;
+};
+
+/*
+ * Rectangular range searches in a K-d tree of uniformly distributed 2-D
+ * points. One query is centered at each point of an independent point set,
+ * with a half-side of 4 pixels (about four points found per query). Queries
+ * run in parallel. With pointerTree = true, the previous pointer-based
+ * implementation is benchmarked instead of KDTree. Throughput is expressed in
+ * millions of queries per second.
+ */
+class KDTreeSearchBenchmark : public Benchmark
+{
+public:
+
+   KDTreeSearchBenchmark( bool pointerTree ) :
+      Benchmark( pointerTree ? "kdtree-search-pointer" : "kdtree-search",
+                 pointerTree ? "K-d tree range search, pointer-based reference implementation" :
+                               "KDTree range search, 2-D points, half-side = 4" ),
+      m_pointerTree( pointerTree ), m_found( 0 )
+   {
+   }
+
+   virtual void Initialize( BenchmarkContext& context )
+   {
+      benchmark_point_list points;
+      GeneratePoints( points, context, context.seed );
+      if ( m_pointerTree )
+         m_pointerKDTree.Build( points );
+      else
+         m_tree.Build( points );
+      GeneratePoints( m_queries, context, context.seed + 7919u );
+   }
+
+   virtual void Execute()
+   {
+      m_found = 0;
+      ThreadPool::ParallelFor( int( m_queries.Length() ), 1024,
+         [this]( int begin, int end )
+         {
+            size_type found = 0;
+            for ( int i = begin; i < end; ++i )
+               if ( m_pointerTree )
+                  m_pointerKDTree.Search( m_queries[i], 4.0, CountPoint, &found );
+               else
+                  m_tree.Search( m_queries[i], 4.0, CountPoint, &found );
+            m_found += found;
+         } );
+   }
+
+   virtual void Finalize()
+   {
+      m_tree.Clear();
+      m_pointerKDTree.Clear();
+      m_queries.Clear();
+   }
+
+   virtual double Megapixels( const BenchmarkContext& context ) const
+   {
+      return NumberOfPoints( context )/1.0e+06;
+   }
+
+private:
+
+   bool                   m_pointerTree;
+   KDTree<BenchmarkPoint> m_tree;
+   PointerKDTree          m_pointerKDTree;
+   benchmark_point_list   m_queries;
+   std::atomic<size_type> m_found;
+
+   static void CountPoint( const BenchmarkPoint&, void* data )
+   {
+      ++*reinterpret_cast<size_type*>( data );
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+static void CreateBenchmarks( benchmark_list& benchmarks )
+{
+   GaussianFilter G4( 4.0F );
+   benchmarks.Add( new TransformationBenchmark( "convolution-separable",
+                                                "SeparableConvolution, Gaussian filter, sigma = 4",
+                                                new SeparableConvolution( G4.AsSeparableFilter() ) ) );
+   benchmarks.Add( new TransformationBenchmark( "convolution-kernel",
+                                                "Convolution, nonseparable Gaussian filter, sigma = 1.5, rho = 0.5",
+                                                new Convolution( GaussianFilter( 1.5F, 0.01F, 0.5F, 0.6F ) ) ) );
+   benchmarks.Add( new TransformationBenchmark( "convolution-recursive",
+                                                "RecursiveGaussianConvolution, sigma = 16",
+                                                new RecursiveGaussianConvolution( 16.0F ) ) );
+   benchmarks.Add( new TransformationBenchmark( "median-3x3",
+                                                "MorphologicalTransformation, median filter, 3x3 box structure",
+                                                new MorphologicalTransformation( MedianFilter(), BoxStructure( 3 ) ) ) );
+   benchmarks.Add( new TransformationBenchmark( "median-7x7",
+                                                "MorphologicalTransformation, median filter, 7x7 box structure",
+                                                new MorphologicalTransformation( MedianFilter(), BoxStructure( 7 ) ) ) );
+   benchmarks.Add( new StatisticsBenchmark );
+   benchmarks.Add( new ResampleBenchmark( "resample-bicubic",
+                                          "Resample, bicubic spline interpolation, scale = 1.5",
+                                          new BicubicSplinePixelInterpolation, 1.5 ) );
+   benchmarks.Add( new ResampleBenchmark( "resample-lanczos",
+                                          "Resample, Lanczos-3 LUT interpolation, scale = 0.5",
+                                          new Lanczos3LUTPixelInterpolation, 0.5 ) );
+   benchmarks.Add( new XISFWriteBenchmark( false ) );
+   benchmarks.Add( new XISFReadBenchmark( false ) );
+   benchmarks.Add( new XISFWriteBenchmark( true ) );
+   benchmarks.Add( new XISFReadBenchmark( true ) );
+   benchmarks.Add( new IntegrationBenchmark );
+   benchmarks.Add( new KDTreeBuildBenchmark( false ) );
+   benchmarks.Add( new KDTreeBuildBenchmark( true ) );
+   benchmarks.Add( new KDTreeSearchBenchmark( false ) );
+   benchmarks.Add( new KDTreeSearchBenchmark( true ) );
+}
+
+// ----------------------------------------------------------------------------
+
+struct BenchmarkResult
+{
+   IsoString     id;
+   String        description;
+   double        megapixels = 0;
+   Array<double> times;
+   String        error;
+
+   double Min() const
+   {
+      return times.IsEmpty() ? 0.0 : *pcl::MinItem( times.Begin(), times.End() );
+   }
+
+   double Max() const
+   {
+      return times.IsEmpty() ? 0.0 : *pcl::MaxItem( times.Begin(), times.End() );
+   }
+
+   double Mean() const
+   {
+      return times.IsEmpty() ? 0.0 : pcl::Sum( times.Begin(), times.End() )/times.Length();
+   }
+
+   double Median() const
+   {
+      if ( times.IsEmpty() )
+         return 0;
+      Array<double> t( times );
+      pcl::Sort( t.Begin(), t.End() );
+      size_type n = t.Length();
+      return (n & 1) ? t[n >> 1] : (t[(n >> 1)-1] + t[n >> 1])/2;
+   }
+
+   double StdDev() const
+   {
+      return (times.Length() < 2) ? 0.0 : pcl::StdDev( times.Begin(), times.End() );
+   }
+};
+
+typedef Array<BenchmarkResult> result_list;
+
+// ----------------------------------------------------------------------------
+
+static IsoString JSONString( const String& s )
+{
+   IsoString u = s.ToUTF8();
+   IsoString j = '\"';
+   for ( IsoString::const_iterator i = u.Begin(); i != u.End(); ++i )
+      switch ( *i )
+      {
+      case '\"': j << "\\\""; break;
+      case '\\': j << "\\\\"; break;
+      case '\n': j << "\\n"; break;
+      case '\r': j << "\\r"; break;
+      case '\t': j << "\\t"; break;
+      default:
+         if ( uint8( *i ) < 0x20 )
+            j.AppendFormat( "\\u%04x", unsigned( *i ) );
+         else
+            j << *i;
+         break;
+      }
+   return j << '\"';
+}
+
+static IsoString CSVString( const String& s )
+{
+   IsoString u = s.ToUTF8();
+   if ( u.Contains( ',' ) || u.Contains( '\"' ) || u.Contains( '\n' ) )
+   {
+      u.ReplaceString( "\"", "\"\"" );
+      return '\"' + u + '\"';
+   }
+   return u;
+}
+
+static IsoString FormatJSON( const result_list& results, const BenchmarkContext& context, int iterations, int warmup )
+{
+   IsoString text = "{\n";
+   text << "   \"suite\": \"PCLBench\",\n";
+   text << "   \"pcl_version\": " << JSONString( pcl::Version::AsString() ) << ",\n";
+   text.AppendFormat( "   \"threads\": %d,\n", Thread::NumberOfThreads( PCL_MAX_PROCESSORS, 1 ) );
+   text.AppendFormat( "   \"width\": %d,\n", context.width );
+   text.AppendFormat( "   \"height\": %d,\n", context.height );
+   text.AppendFormat( "   \"channels\": %d,\n", context.channels );
+   text.AppendFormat( "   \"frames\": %d,\n", context.frames );
+   text.AppendFormat( "   \"iterations\": %d,\n", iterations );
+   text.AppendFormat( "   \"warmup\": %d,\n", warmup );
+   text << "   \"results\": [";
+   for ( result_list::const_iterator r = results.Begin(); r != results.End(); ++r )
+   {
+      if ( r != results.Begin() )
+         text << ',';
+      text << "\n      {\n";
+      text << "         \"id\": " << JSONString( String( r->id ) ) << ",\n";
+      text << "         \"description\": " << JSONString( r->description ) << ",\n";
+      if ( r->error.IsEmpty() )
+      {
+         double median = r->Median();
+         text.AppendFormat( "         \"megapixels\": %.6f,\n", r->megapixels );
+         text << "         \"times\": [";
+         for ( size_type i = 0; i < r->times.Length(); ++i )
+            text.AppendFormat( (i > 0) ? ", %.6f" : "%.6f", r->times[i] );
+         text << "],\n";
+         text.AppendFormat( "         \"min\": %.6f,\n", r->Min() );
+         text.AppendFormat( "         \"median\": %.6f,\n", median );
+         text.AppendFormat( "         \"mean\": %.6f,\n", r->Mean() );
+         text.AppendFormat( "         \"max\": %.6f,\n", r->Max() );
+         text.AppendFormat( "         \"stddev\": %.6f,\n", r->StdDev() );
+         text.AppendFormat( "         \"mpixels_per_second\": %.3f\n", (median > 0) ? r->megapixels/median : 0.0 );
+      }
+      else
+         text << "         \"error\": " << JSONString( r->error ) << '\n';
+      text << "      }";
+   }
+   text << "\n   ]\n}\n";
+   return text;
+}
+
+static IsoString FormatCSV( const result_list& results, const BenchmarkContext& context, int iterations )
+{
+   IsoString text = "id,threads,width,height,channels,iterations,megapixels,min,median,mean,max,stddev,mpixels_per_second,error\n";
+   int threads = Thread::NumberOfThreads( PCL_MAX_PROCESSORS, 1 );
+   for ( result_list::const_iterator r = results.Begin(); r != results.End(); ++r )
+   {
+      double median = r->Median();
+      text << r->id;
+      text.AppendFormat( ",%d,%d,%d,%d,%d", threads, context.width, context.height, context.channels, iterations );
+      if ( r->error.IsEmpty() )
+         text.AppendFormat( ",%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.3f,\n",
+                            r->megapixels, r->Min(), median, r->Mean(), r->Max(), r->StdDev(),
+                            (median > 0) ? r->megapixels/median : 0.0 );
+      else
+         text << ",,,,,,,," << CSVString( r->error ) << '\n';
+   }
+   return text;
+}
+
+// ----------------------------------------------------------------------------
+
+static void ShowHelp()
+{
+   std::cout <<
+"\nUsage: PCLBench [<arg_list>]"
+"\n"
+"\n--width=<n> | -w=<n>"
+"\n"
+"\n      Width in pixels of the synthetic test images. The default is 2048."
+"\n"
+"\n--height=<n> | -h=<n>"
+"\n"
+"\n      Height in pixels of the synthetic test images. The default is 2048."
+"\n"
+"\n--channels=<n> | -c=<n>"
+"\n"
+"\n      Number of channels: 1 for grayscale, 3 for RGB color images. The"
+"\n      default is 1."
+"\n"
+"\n--frames=<n>"
+"\n"
+"\n      Number of frames integrated by the integration benchmark. The default"
+"\n      is 16."
+"\n"
+"\n--iterations=<n> | -n=<n>"
+"\n"
+"\n      Number of timed iterations of each benchmark. The default is 5."
+"\n"
+"\n--warmup=<n>"
+"\n"
+"\n      Number of untimed iterations executed before the timed ones. The"
+"\n      default is 1."
+"\n"
+"\n--threads=<n> | -t=<n>"
+"\n"
+"\n      Maximum number of threads. Zero uses all logical processors available"
+"\n      (the default). One disables parallel processing."
+"\n"
+"\n--benchmarks=<id_list> | -b=<id_list>"
+"\n"
+"\n      Comma-separated list of benchmarks to run. A benchmark is selected if"
+"\n      its identifier begins with any list item; for example, -b=xisf,median"
+"\n      selects all XISF and median filter benchmarks. All benchmarks are run"
+"\n      by default. See --list."
+"\n"
+"\n--format=json|csv | -f=json|csv"
+"\n"
+"\n      Output format of benchmark results. The default is json."
+"\n"
+"\n--output=<file> | -o=<file>"
+"\n"
+"\n      Write benchmark results to the specified file. By default results are"
+"\n      written to the standard output stream."
+"\n"
+"\n--tmp-dir=<dir>"
+"\n"
+"\n      Directory where temporary XISF files will be created. The default is"
+"\n      the system temporary directory."
+"\n"
+"\n--seed=<n>"
+"\n"
+"\n      Seed of the random number generators used to generate test images."
+"\n"
+"\n--list | -l"
+"\n"
+"\n      List the available benchmarks and exit."
+"\n"
+"\n--quiet | -q"
+"\n"
+"\n      Do not write progress information on the standard error stream."
+"\n"
+"\n--help"
+"\n"
+"\n      Show this help text and exit."
+"\n\n";
+}
+
+// ----------------------------------------------------------------------------
+
+static int ParseInteger( const Argument& arg, int minValue )
+{
+   double value = arg.NumericValue();
+   if ( value < minValue || value != Round( value ) || value > int_max )
+      throw Error( "Invalid argument value: " + arg.Token() );
+   return int( value );
+}
+
+static bool IsSelected( const IsoString& id, const StringList& selection )
+{
+   if ( selection.IsEmpty() )
+      return true;
+   for ( StringList::const_iterator i = selection.Begin(); i != selection.End(); ++i )
+      if ( id.StartsWith( IsoString( *i ) ) )
+         return true;
+   return false;
+}
+
+static int PCLBench( int argc, const char** argv )
+{
+   BenchmarkContext context;
+   int iterations = 5;
+   int warmup = 1;
+   int maxThreads = 0;
+   bool csv = false;
+   bool list = false;
+   bool quiet = false;
+   StringList selection;
+   String outputPath;
+
+   StringList inputArgs;
+   for ( int i = 1; i < argc; ++i )
+      inputArgs.Add( IsoString( argv[i] ).UTF8ToUTF16() );
+
+   ArgumentList arguments = ExtractArguments( inputArgs, ArgumentItemMode::NoItems );
+
+   for ( ArgumentList::const_iterator i = arguments.Begin(); i != arguments.End(); ++i )
+   {
+      if ( i->IsNumeric() )
+      {
+         if ( i->Id() == "-width" || i->Id() == "w" )
+            context.width = ParseInteger( *i, 16 );
+         else if ( i->Id() == "-height" || i->Id() == "h" )
+            context.height = ParseInteger( *i, 16 );
+         else if ( i->Id() == "-channels" || i->Id() == "c" )
+            context.channels = ParseInteger( *i, 1 );
+         else if ( i->Id() == "-frames" )
+            context.frames = ParseInteger( *i, 3 );
+         else if ( i->Id() == "-iterations" || i->Id() == "n" )
+            iterations = ParseInteger( *i, 1 );
+         else if ( i->Id() == "-warmup" )
+            warmup = ParseInteger( *i, 0 );
+         else if ( i->Id() == "-threads" || i->Id() == "t" )
+            maxThreads = ParseInteger( *i, 0 );
+         else if ( i->Id() == "-seed" )
+            context.seed = uint32( ParseInteger( *i, 1 ) );
+         else
+            throw Error( "Unknown numeric argument: " + i->Token() );
+      }
+      else if ( i->IsString() )
+      {
+         if ( i->Id() == "-benchmarks" || i->Id() == "b" )
+            i->StringValue().Break( selection, ',', true/*trim*/ );
+         else if ( i->Id() == "-format" || i->Id() == "f" )
+         {
+            String format = i->StringValue().CaseFolded();
+            if ( format == "csv" )
+               csv = true;
+            else if ( format == "json" )
+               csv = false;
+            else
+               throw Error( "Unknown output format: " + i->StringValue() );
+         }
+         else if ( i->Id() == "-output" || i->Id() == "o" )
+            outputPath = i->StringValue();
+         else if ( i->Id() == "-tmp-dir" )
+            context.tmpDir = i->StringValue();
+         else
+            throw Error( "Unknown string argument: " + i->Token() );
+      }
+      else if ( i->IsLiteral() )
+      {
+         if ( i->Id() == "-list" || i->Id() == "l" )
+            list = true;
+         else if ( i->Id() == "-quiet" || i->Id() == "q" )
+            quiet = true;
+         else if ( i->Id() == "-help" )
+         {
+            ShowHelp();
+            return EXIT_OK;
+         }
+         else
+            throw Error( "Unknown argument: " + i->Token() );
+      }
+      else
+         throw Error( "Invalid argument: " + i->Token() );
+   }
+
+   if ( context.channels != 1 && context.channels != 3 )
+      throw Error( "Invalid number of channels: must be 1 or 3." );
+
+   selection.Remove( String() );
+
+   HeadlessAPI::Initialize( maxThreads );
+   HeadlessAPI::SetConsoleOutput( quiet ? HeadlessConsoleOutput::Discard : HeadlessConsoleOutput::StandardError );
+
+   PCLBenchModule module;
+
+   benchmark_list benchmarks;
+   CreateBenchmarks( benchmarks );
+
+   if ( list )
+   {
+      for ( benchmark_list::const_iterator i = benchmarks.Begin(); i != benchmarks.End(); ++i )
+         std::cout << IsoString().Format( "%-24s", (*i)->Id().c_str() ) << (*i)->Description().ToUTF8() << '\n';
+      benchmarks.Destroy();
+      HeadlessAPI::Terminate();
+      return EXIT_OK;
+   }
+
+   if ( context.tmpDir.IsEmpty() )
+      context.tmpDir = File::SystemTempDirectory();
+
+   Console console;
+   console.WriteLn( String().Format( "<end><cbr>PCLBench: %dx%dx%d pixels, %d threads",
+                                     context.width, context.height, context.channels,
+                                     Thread::NumberOfThreads( PCL_MAX_PROCESSORS, 1 ) ) );
+
+   GenerateSignal( context.signal, context.width, context.height, context.channels, context.seed );
+   GenerateFrame( context.source, context.signal, 0.01, 0, context.seed );
+
+   result_list results;
+   for ( benchmark_list::iterator i = benchmarks.Begin(); i != benchmarks.End(); ++i )
+   {
+      Benchmark* B = *i;
+      if ( !IsSelected( B->Id(), selection ) )
+         continue;
+
+      BenchmarkResult result;
+      result.id = B->Id();
+      result.description = B->Description();
+      result.megapixels = B->Megapixels( context );
+
+      console.Write( "<end><cbr>" + String( B->Id() ) + ": " );
+      console.Flush();
+
+      try
+      {
+         B->Initialize( context );
+         for ( int k = 0; k < warmup; ++k )
+         {
+            B->Prepare();
+            B->Execute();
+         }
+         for ( int k = 0; k < iterations; ++k )
+         {
+            B->Prepare();
+            ElapsedTime T;
+            B->Execute();
+            result.times << T();
+         }
+         B->Finalize();
+         console.WriteLn( String().Format( "%.3f s", result.Median() ) );
+      }
+      catch ( Exception& x )
+      {
+         B->Finalize();
+         result.times.Clear();
+         result.error = x.Message();
+         console.WriteLn( "*** Error: " + result.error );
+      }
+
+      results << result;
+   }
+
+   benchmarks.Destroy();
+
+   IsoString text = csv ? FormatCSV( results, context, iterations ) : FormatJSON( results, context, iterations, warmup );
+   if ( outputPath.IsEmpty() )
+   {
+      fwrite( text.c_str(), 1, text.Length(), stdout );
+      fflush( stdout );
+   }
+   else
+      File::WriteTextFile( outputPath, text );
+
+   console.Flush();
+   HeadlessAPI::Terminate();
+
+   for ( result_list::const_iterator r = results.Begin(); r != results.End(); ++r )
+      if ( !r->error.IsEmpty() )
+         return EXIT_ERROR;
+   return EXIT_OK;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char** argv )
+{
+   Exception::DisableGUIOutput();
+   Exception::EnableConsoleOutput();
+
+   try
+   {
+      return PCLBench( argc, argv );
+   }
+   catch ( ... )
+   {
+      try
+      {
+         throw;
+      }
+      catch ( Exception& x )
+      {
+         std::cerr << "*** Error: " << x.Message() << "\n\n";
+      }
+      catch ( String& s )
+      {
+         std::cerr << "*** Error: " << s << "\n\n";
+      }
+      catch ( std::bad_alloc& )
+      {
+         std::cerr << "*** Error: Out of memory.\n\n";
+      }
+      catch ( ... )
+      {
+         std::cerr << "*** Error: Unknown exception.\n\n";
+      }
+   }
+   return EXIT_ERROR;
+}
+
+// ----------------------------------------------------------------------------
+// EOF PCLBench.cpp - Released 2016/02/21 20:22:34 UTC
@@ -53,11 +53,25 @@
 #include "FITS.h"
 
 #include <pcl/Console.h>
+#include <pcl/EndianConversions.h>
 #include <pcl/ErrorHandler.h>
 #include <pcl/ICCProfile.h>
 #include <pcl/MetaModule.h>
+#include <pcl/ThreadPool.h>
 #include <pcl/Version.h>
 
+#include <string.h>
+
+#ifdef __PCL_WINDOWS
+#  include <windows.h>
+#else
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
 // Tell fitsio.h that we do support 64-bit integers.
 #define HAVE_LONGLONG   1
 
@@ -96,16 +110,102 @@ String FITS::Error::Message() const
 
 struct FITSFileData
 {
-   void* fits = nullptr; // CFITSIO's ::fitsfile*
-   int   status = 0;     // CFITSIO's persistent error code
+   void*        fits = nullptr;      // CFITSIO's ::fitsfile*
+   int          status = 0;          // CFITSIO's persistent error code
+   const uint8* map = nullptr;       // read-only memory mapping of the whole file
+   fsize_type   mapSize = 0;         // length of the mapped file in bytes
+   bool         mapFailed = false;   // don't retry a failed mapping
+#ifdef __PCL_WINDOWS
+   HANDLE       mapHandle = 0;       // file mapping object
+#endif
 
    FITSFileData() = default;
 
    ~FITSFileData()
    {
+      Unmap();
       if ( fits != nullptr )
          ::fits_close_file( (::fitsfile*)fits, &status ), fits = nullptr;
    }
+
+   /*
+    * Maps the entire file in memory for direct access to image data units.
+    * Returns false if the file cannot be mapped, or if it is not a plain FITS
+    * file (e.g., a gzip-compressed file that CFITSIO decompresses on the
+    * fly), in which case all read operations must go through CFITSIO.
+    */
+   bool Map( const String& path )
+   {
+      if ( map != nullptr )
+         return true;
+      if ( mapFailed )
+         return false;
+      mapFailed = true;
+
+#ifdef __PCL_WINDOWS
+      HANDLE file = ::CreateFileW( (LPCWSTR)File::UnixPathToWindows( path ).c_str(),
+                                   GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+      if ( file == INVALID_HANDLE_VALUE )
+         return false;
+      LARGE_INTEGER size;
+      if ( ::GetFileSizeEx( file, &size ) && size.QuadPart > 0 && uint64( size.QuadPart ) <= uint64( ~size_t( 0 ) ) )
+      {
+         mapHandle = ::CreateFileMappingW( file, 0, PAGE_READONLY, 0, 0, 0 );
+         if ( mapHandle != 0 )
+         {
+            map = (const uint8*)::MapViewOfFile( mapHandle, FILE_MAP_READ, 0, 0, 0 );
+            if ( map != nullptr )
+               mapSize = size.QuadPart;
+            else
+               ::CloseHandle( mapHandle ), mapHandle = 0;
+         }
+      }
+      ::CloseHandle( file );
+#else
+      int fd = ::open( path.ToUTF8().c_str(), O_RDONLY );
+      if ( fd < 0 )
+         return false;
+      struct stat st;
+      if ( ::fstat( fd, &st ) == 0 && st.st_size > 0 && uint64( st.st_size ) <= uint64( ~size_t( 0 ) ) )
+      {
+         void* p = ::mmap( 0, size_t( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+         if ( p != MAP_FAILED )
+         {
+            map = (const uint8*)p;
+            mapSize = st.st_size;
+         }
+      }
+      ::close( fd );
+#endif
+
+      if ( map == nullptr )
+         return false;
+
+      // A plain FITS file always begins with the SIMPLE keyword.
+      if ( mapSize < 2880 || ::memcmp( map, "SIMPLE  =", 9 ) != 0 )
+      {
+         Unmap();
+         return false;
+      }
+
+      mapFailed = false;
+      return true;
+   }
+
+   void Unmap()
+   {
+      if ( map != nullptr )
+      {
+#ifdef __PCL_WINDOWS
+         ::UnmapViewOfFile( map );
+         ::CloseHandle( mapHandle ), mapHandle = 0;
+#else
+         ::munmap( (void*)map, size_t( mapSize ) );
+#endif
+         map = nullptr;
+         mapSize = 0;
+      }
+   }
 };
 
 // ----------------------------------------------------------------------------
@@ -125,6 +225,9 @@ struct FITSHDUData
    double    zeroOffset       = 0;           // BZERO
    double    scaleRange       = 1;           // BSCALE
    bool      signedIsPhysical = false;       // signed integer values store physical pixel data
+   double    rawZero          = 0;           // BZERO applied to raw samples (zero for floating point)
+   double    rawScale         = 1;           // BSCALE applied to raw samples (one for floating point)
+   fsize_type dataOffset      = -1;          // file position of the data unit, < 0 if unknown
    IsoString iccExtName;   // name of ICC profile extension
    IsoString thumbExtName; // name of thumbnail image extension
 
@@ -176,10 +279,186 @@ struct FITSReaderData
 
 // ----------------------------------------------------------------------------
 
+/*
+ * Native FITS sample types. FITS data are always stored in big endian byte
+ * order; PCL only runs on little endian machines.
+ */
+template <int bitpix> struct FITSNativeSample;
+
+template <> struct FITSNativeSample<BYTE_IMG>
+{
+   typedef uint8 raw;
+   enum { isInteger = true };
+   static double Value( uint8 x ) { return x; }
+};
+
+template <> struct FITSNativeSample<SHORT_IMG>
+{
+   typedef uint16 raw;
+   enum { isInteger = true };
+   static double Value( uint16 x ) { return int16( BigToLittleEndian( x ) ); }
+};
+
+template <> struct FITSNativeSample<LONG_IMG>
+{
+   typedef uint32 raw;
+   enum { isInteger = true };
+   static double Value( uint32 x ) { return int32( BigToLittleEndian( x ) ); }
+};
+
+template <> struct FITSNativeSample<FLOAT_IMG>
+{
+   typedef uint32 raw;
+   enum { isInteger = false };
+   static double Value( uint32 x ) { union { uint32 u; float f; } v; v.u = BigToLittleEndian( x ); return v.f; }
+};
+
+template <> struct FITSNativeSample<DOUBLE_IMG>
+{
+   typedef uint64 raw;
+   enum { isInteger = false };
+   static double Value( uint64 x ) { union { uint64 u; double d; } v; v.u = BigToLittleEndian( x ); return v.d; }
+};
+
+/*
+ * Transformation of native FITS samples to image samples: the same sequence
+ * of operations applied to the double buffers filled by CFITSIO.
+ */
+struct FITSNativeConversion
+{
+   double zero;      // BZERO
+   double scale;     // BSCALE
+   double offset;    // lower bound of the input range
+   double k;         // rescaling factor
+   double minValue;  // lower bound of the output range
+   bool   rescale;   // rescaling required
+   bool   truncate;  // truncate negative values
+};
+
+#define FITS_NATIVE_GRAIN_SIZE   65536 // minimum number of samples converted by a parallel task
+
+// ----------------------------------------------------------------------------
+
 class FITSReaderPrivate
 {
 public:
 
+   /*
+    * Returns the starting address of the data unit of the specified HDU in
+    * the memory-mapped FITS file, or nullptr if pixel data must be read by
+    * CFITSIO.
+    */
+   static const uint8* NativeData( const FITSHDUData& hdu, FITSReader& reader )
+   {
+      if ( hdu.dataOffset < 0 || hdu.rawScale == 0 || !IsFinite( hdu.rawScale ) || !IsFinite( hdu.rawZero ) )
+         return nullptr;
+
+      switch ( hdu.bitpix )
+      {
+      case BYTE_IMG:
+      case SHORT_IMG:
+      case LONG_IMG:
+      case FLOAT_IMG:
+      case DOUBLE_IMG:
+         break;
+      default:
+         return nullptr;
+      }
+
+      FITSFileData* fileData = reader.fileData;
+      if ( !fileData->Map( reader.path ) )
+         return nullptr;
+
+      fsize_type size = fsize_type( hdu.naxes[0] ) * hdu.naxes[1] * ((hdu.naxis == 2) ? 1 : hdu.naxes[2]) * (Abs( hdu.bitpix ) >> 3);
+      if ( hdu.dataOffset + size > fileData->mapSize )
+         return nullptr;
+
+      return fileData->map + hdu.dataOffset;
+   }
+
+   template <class P>
+   static FITSNativeConversion NativeConversion( const FITSHDUData& hdu, bool rescalingRequired, double k )
+   {
+      FITSNativeConversion c;
+      c.zero = hdu.rawZero;
+      c.scale = hdu.rawScale;
+      c.offset = hdu.zeroOffset;
+      c.k = k;
+      c.minValue = P::MinSampleValue();
+      c.rescale = rescalingRequired;
+      c.truncate = hdu.signedIsPhysical;
+      return c;
+   }
+
+   /*
+    * Converts a sequence of native FITS samples to image samples in a single
+    * pass: byte swapping, BZERO/BSCALE scaling, replacement of NaNs and
+    * infinities, optional truncation of negative values, and rescaling.
+    */
+   template <int bitpix, class P>
+   static void NativeToImage( typename P::sample* f, const uint8* data, int count, const FITSNativeConversion& c )
+   {
+      typedef FITSNativeSample<bitpix> S;
+      const typename S::raw* s = reinterpret_cast<const typename S::raw*>( data );
+      const double zero = c.zero, scale = c.scale, offset = c.offset, k = c.k, minValue = c.minValue;
+      const bool truncate = c.truncate;
+      if ( c.rescale )
+         for ( int j = 0; j < count; ++j )
+         {
+            double v = S::Value( s[j] )*scale + zero;
+            if ( !S::isInteger )
+               if ( !IsFinite( v ) )
+                  v = 0;
+            if ( truncate )
+               if ( v < 0 )
+                  v = 0;
+            f[j] = P::FloatToSample( k*(v - offset) + minValue );
+         }
+      else
+         for ( int j = 0; j < count; ++j )
+         {
+            double v = S::Value( s[j] )*scale + zero;
+            if ( !S::isInteger )
+               if ( !IsFinite( v ) )
+                  v = 0;
+            if ( truncate )
+               if ( v < 0 )
+                  v = 0;
+            f[j] = typename P::sample( v );
+         }
+   }
+
+   template <class P>
+   static void NativeToImage( typename P::sample* f, const uint8* data, int count, int bitpix, const FITSNativeConversion& c )
+   {
+      switch ( bitpix )
+      {
+      case BYTE_IMG:   NativeToImage<BYTE_IMG, P>( f, data, count, c ); break;
+      case SHORT_IMG:  NativeToImage<SHORT_IMG, P>( f, data, count, c ); break;
+      case LONG_IMG:   NativeToImage<LONG_IMG, P>( f, data, count, c ); break;
+      case FLOAT_IMG:  NativeToImage<FLOAT_IMG, P>( f, data, count, c ); break;
+      case DOUBLE_IMG: NativeToImage<DOUBLE_IMG, P>( f, data, count, c ); break;
+      }
+   }
+
+   /*
+    * Converts a set of consecutive native FITS rows to image rows in
+    * parallel. Row i is written at f[i] or, for bottom-up orientation, at
+    * f[rowCount-i-1].
+    */
+   template <class P, class F>
+   static void NativeRowsToImage( F rowAddress, const uint8* data, int width, int rowCount, bool bottomUp,
+                                  int bitpix, const FITSNativeConversion& c )
+   {
+      size_type rowSize = size_type( width )*(Abs( bitpix ) >> 3);
+      ThreadPool::ParallelFor( rowCount, Max( 1, FITS_NATIVE_GRAIN_SIZE/Max( 1, width ) ),
+         [&]( int begin, int end )
+         {
+            for ( int i = begin; i < end; ++i )
+               NativeToImage<P>( rowAddress( bottomUp ? rowCount-i-1 : i ), data + i*rowSize, width, bitpix, c );
+         } );
+   }
+
    template <class P> inline
    static void ReadImage( GenericImage<P>& image, FITSReader& reader )
    {
@@ -233,11 +512,6 @@ public:
                      image.NumberOfChannels(), image.Width(), image.Height() ),
                image.NumberOfSamples() );
 
-         // To support 32-bit integer samples and to provide for arbitrary integer
-         // format output, we'll ask FITSIO to store 64-bit floating point pixel
-         // values in a temporary row buffer.
-         buffer = new double[ image.Width() ];
-
          // A rescaling operation is required for integer sample values if the
          // source data type (as provided by FITSIO, i.e taking BZERO into account)
          // doesn't match the target image's sample type.
@@ -246,6 +520,25 @@ public:
          if ( rescalingRequired )
             k = (double( P::MaxSampleValue() ) - P::MinSampleValue())/(hdu.scaleRange - hdu.zeroOffset);
 
+         // Uncompressed data units are converted directly from the
+         // memory-mapped file, bypassing CFITSIO.
+         const uint8* native = NativeData( hdu, reader );
+         if ( native != nullptr )
+         {
+            FITSNativeConversion conversion = NativeConversion<P>( hdu, rescalingRequired, k );
+            size_type channelSize = size_type( image.NumberOfPixels() )*(Abs( hdu.bitpix ) >> 3);
+            for ( int c = 0; c < image.NumberOfChannels(); ++c, image.Status() += image.NumberOfPixels() )
+               NativeRowsToImage<P>( [&]( int i ) { return image.ScanLine( i, c ); },
+                                     native + c*channelSize, image.Width(), image.Height(),
+                                     reader.FITSOptions().bottomUp, hdu.bitpix, conversion );
+            return;
+         }
+
+         // To support 32-bit integer samples and to provide for arbitrary integer
+         // format output, we'll ask FITSIO to store 64-bit floating point pixel
+         // values in a temporary row buffer.
+         buffer = new double[ image.Width() ];
+
          // Coordinate selectors.
          // The primary image HDU is assumed to be FITSIO's current HDU.
          // N.B.: CFITSIO expects one-based indexes.
@@ -346,11 +639,6 @@ public:
          // Number of samples to read.
          long N = hdu.naxes[0]*rowCount;
 
-         // To support 32-bit integer samples and to provide for arbitrary integer
-         // format output, we'll ask FITSIO to store 64-bit floating point pixel
-         // values in a temporary row buffer.
-         buffer = new double[ N ];
-
          // A rescaling operation is required for integer sample values if the
          // source data type (as provided by FITSIO, i.e taking BZERO into account)
          // doesn't match the target image's sample type.
@@ -359,6 +647,24 @@ public:
          if ( rescalingRequired )
             k = (double( P::MaxSampleValue() ) - P::MinSampleValue())/(hdu.scaleRange - hdu.zeroOffset);
 
+         // Uncompressed data units are converted directly from the
+         // memory-mapped file, bypassing CFITSIO.
+         const uint8* native = NativeData( hdu, reader );
+         if ( native != nullptr )
+         {
+            int width = hdu.naxes[0];
+            size_type rowSize = size_type( width )*(Abs( hdu.bitpix ) >> 3);
+            NativeRowsToImage<P>( [=]( int i ) { return f + size_type( i )*width; },
+                                  native + (size_type( c )*hdu.naxes[1] + startRow)*rowSize, width, rowCount,
+                                  reader.FITSOptions().bottomUp, hdu.bitpix, NativeConversion<P>( hdu, rescalingRequired, k ) );
+            return;
+         }
+
+         // To support 32-bit integer samples and to provide for arbitrary integer
+         // format output, we'll ask FITSIO to store 64-bit floating point pixel
+         // values in a temporary row buffer.
+         buffer = new double[ N ];
+
          // Coordinate selectors.
          // N.B.: CFITSIO expects one-based indexes.
          long fpixel[ 3 ];
@@ -770,10 +1076,28 @@ void FITSReader::Open( const String& filePath )
          if ( nonImageExtension )
             continue;
 
-         // Increment the count of nonempty images
          if ( hdu.naxis > 0 )
+         {
+            // Increment the count of nonempty images
             ++numberOfReadableImages;
 
+            // Raw sample scaling applied by CFITSIO. Automatic data scaling
+            // has been disabled for floating point images.
+            if ( !image.options.ieeefpSampleFormat )
+            {
+               hdu.rawZero = fits.zeroOffset;
+               hdu.rawScale = fits.scaleRange;
+            }
+
+            // Location of the data unit, for direct access to uncompressed
+            // pixel data in the memory-mapped file.
+            LONGLONG headStart, dataStart, dataEnd;
+            ::fits_get_hduaddrll( fits_handle, &headStart, &dataStart, &dataEnd, &fitsStatus );
+            if ( fitsStatus != 0 )
+               throw FileReadError( path );
+            hdu.dataOffset = dataStart;
+         }
+
          image.info.colorSpace = hdu.colorSpace;
 
          hdus.Add( hdu );
@@ -1253,6 +1577,7 @@ void FITSReader::Read( UInt32Image::sample* f, int startRow, int rowCount, int c
 #undef hdus
 #undef keywords
 #undef fitsOptions
+#undef FITS_NATIVE_GRAIN_SIZE
 
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
@@ -65,6 +65,7 @@
 #include <pcl/Image.h>
 #include <pcl/MetaModule.h>
 #include <pcl/Random.h>
+#include <pcl/ThreadPool.h>
 #include <pcl/Version.h>
 
 // ----------------------------------------------------------------------------
@@ -740,17 +741,26 @@ struct XISFInputDataBlock
     *
     * For inline and embedded compressed blocks, the data member already has
     * the compressed data loaded.
+    *
+    * For chunked blocks, each compressed subblock has been compressed (and
+    * byte-shuffled) independently. Blocks with independent subblocks allow
+    * random access to uncompressed data without uncompressing the whole block.
     */
    fpos_type     position          = 0;   // absolute file position in bytes
    fsize_type    size              = 0;   // file block size in bytes
    int           compressionMethod = XISF_COMPRESSION_NONE; // compression algorithm
    int           itemSize          = 1;   // size in bytes of a data item, for byte shuffling
+   bool          chunked           = false; // true if subblocks are independently compressed chunks
    subblock_info subblockInfo;            // compressed subblock dimensions
    subblock_list subblocks;               // compressed data
    ByteArray     data;                    // uncompressed data
    ByteArray     checksum;                // cryptographic hash digest
    int           checksumMethod    = XISF_CHECKSUM_NONE; // hashing algorithm
    mutable bool  checksumVerified  = false;
+   Array<size_type> subblockOffsets;      // uncompressed subblock offsets, for random access
+   Array<fpos_type> subblockPositions;    // absolute file positions of compressed subblocks
+   size_type     cachedSubblockIndex = 0; // index of the cached uncompressed subblock
+   ByteArray     cachedSubblock;          // last uncompressed subblock, for random access
 
    XISFInputDataBlock() = default;
    XISFInputDataBlock( const XISFInputDataBlock& ) = default;
@@ -791,6 +801,18 @@ struct XISFInputDataBlock
       return size <= 0 && !HasData() && !HasCompressedData();
    }
 
+   /*
+    * Returns true iff the compressed subblocks of this block can be
+    * uncompressed independently. Without byte shuffling, this is always true
+    * for blocks with two or more subblocks. With byte shuffling, each subblock
+    * must have been shuffled independently (chunked block).
+    */
+   bool HasIndependentSubblocks() const
+   {
+      return IsCompressed() && subblockInfo.Length() > 1 &&
+            (chunked || itemSize < 2 || !XISFEngineBase::CompressionUsesByteShuffle( compressionMethod ));
+   }
+
    size_type DataSize() const
    {
       if ( IsEmpty() )
@@ -818,7 +840,13 @@ struct XISFInputDataBlock
       VerifyChecksum( file );
 
       if ( IsCompressed() )
-         Uncompress( file );
+         if ( !HasData() && HasIndependentSubblocks() )
+         {
+            GetSubblockData( file, dst, dstSize, offset );
+            return;
+         }
+         else
+            Uncompress( file );
 
       if ( HasData() )
       {
@@ -855,6 +883,7 @@ struct XISFInputDataBlock
       if ( IsCompressed() )
       {
          data.Clear();
+         cachedSubblock.Clear();
          if ( IsAttachment() )
             subblocks.Clear();
       }
@@ -917,12 +946,67 @@ struct XISFInputDataBlock
          throw Error( "Internal error: Invalid call to XISFInputDataBlock::Uncompress()" );
 
       if ( !HasData() )
-      {
-         AutoPointer<Compression> compressor( XISFEngineBase::NewCompression( compressionMethod, itemSize ) );
-         LoadCompressedData( file );
-         data = compressor->Uncompress( subblocks );
-         subblocks.Clear();
-      }
+         if ( chunked )
+         {
+            /*
+             * Independently shuffled subblocks cannot be uncompressed as a
+             * single data stream.
+             */
+            data = ByteArray( DataSize() );
+            Array<size_type> indices;
+            for ( size_type i = 0; i < subblockInfo.Length(); ++i )
+               indices << i;
+            UncompressSubblocks( file, indices, data.Begin(), 0 );
+            subblocks.Clear();
+            cachedSubblock.Clear();
+         }
+         else
+         {
+            AutoPointer<Compression> compressor( XISFEngineBase::NewCompression( compressionMethod, itemSize ) );
+            LoadCompressedData( file );
+            data = compressor->Uncompress( subblocks );
+            subblocks.Clear();
+         }
+   }
+
+   /*
+    * Random access to uncompressed data of a block with independent
+    * subblocks. Only the subblocks covering the requested range of
+    * uncompressed data are read and uncompressed, in parallel. The last
+    * uncompressed subblock is cached, since sequential reads of contiguous
+    * pixel rows often begin within the last subblock of a previous read.
+    */
+   void GetSubblockData( File& file, void* dst, size_type dstSize, size_type offset )
+   {
+      if ( dstSize == 0 )
+         return;
+
+      InitializeSubblockOffsets();
+
+      if ( offset + dstSize > subblockOffsets[subblockInfo.Length()] )
+         throw Error( "Internal error: Invalid dst size in block data access." );
+
+      size_type first = 0;
+      while ( subblockOffsets[first+1] <= offset )
+         ++first;
+      size_type last = first + 1;
+      while ( subblockOffsets[last] < offset + dstSize )
+         ++last;
+
+      ByteArray buffer( subblockOffsets[last] - subblockOffsets[first] );
+      Array<size_type> indices;
+      for ( size_type i = first; i < last; ++i )
+         if ( i == cachedSubblockIndex && !cachedSubblock.IsEmpty() )
+            ::memcpy( buffer.At( subblockOffsets[i] - subblockOffsets[first] ), cachedSubblock.Begin(), cachedSubblock.Length() );
+         else
+            indices << i;
+
+      UncompressSubblocks( file, indices, buffer.Begin(), subblockOffsets[first] );
+
+      ::memcpy( dst, buffer.At( offset - subblockOffsets[first] ), dstSize );
+
+      cachedSubblockIndex = last - 1;
+      cachedSubblock = ByteArray( buffer.At( subblockOffsets[last-1] - subblockOffsets[first] ), buffer.End() );
    }
 
    void VerifyChecksum( File& file ) const
@@ -979,6 +1063,68 @@ struct XISFInputDataBlock
                                ", got " + IsoString::ToHex( theChecksum ) );
          }
    }
+
+private:
+
+   void InitializeSubblockOffsets()
+   {
+      if ( subblockOffsets.IsEmpty() )
+      {
+         size_type offset = 0;
+         fpos_type subblockPosition = position;
+         for ( subblock_info::const_iterator i = subblockInfo.Begin(); i != subblockInfo.End(); ++i )
+         {
+            subblockOffsets << offset;
+            subblockPositions << subblockPosition;
+            offset += i->uncompressedSize;
+            subblockPosition += i->compressedSize;
+         }
+         subblockOffsets << offset;
+      }
+   }
+
+   /*
+    * Uncompress a set of independent subblocks. The uncompressed data of the
+    * i-th subblock is stored at dst + subblockOffsets[i] - dstOffset. File
+    * access is sequential, then subblocks are uncompressed in parallel.
+    */
+   void UncompressSubblocks( File& file, const Array<size_type>& indices, uint8* dst, size_type dstOffset )
+   {
+      if ( indices.IsEmpty() )
+         return;
+
+      InitializeSubblockOffsets();
+
+      subblock_list list;
+      if ( HasCompressedData() )
+      {
+         for ( Array<size_type>::const_iterator i = indices.Begin(); i != indices.End(); ++i )
+            list << subblocks[*i];
+      }
+      else
+      {
+         for ( Array<size_type>::const_iterator i = indices.Begin(); i != indices.End(); ++i )
+         {
+            Compression::Subblock subblock;
+            subblock.compressedData = ByteArray( size_type( subblockInfo[*i].compressedSize ) );
+            subblock.uncompressedSize = subblockInfo[*i].uncompressedSize;
+            file.SetPosition( subblockPositions[*i] );
+            file.Read( subblock.compressedData.Begin(), subblockInfo[*i].compressedSize );
+            list << subblock;
+         }
+      }
+
+      AutoPointer<Compression> compressor( XISFEngineBase::NewCompression( compressionMethod, itemSize ) );
+      compressor->DisableParallelProcessing();
+      const Compression& C = *compressor;
+      const subblock_list& L = list;
+      ThreadPool::ParallelFor( int( L.Length() ), 1,
+         [&]( int begin, int end )
+         {
+            for ( int i = begin; i < end; ++i )
+               C.Uncompress( dst + subblockOffsets[indices[i]] - dstOffset, L[i].uncompressedSize, subblock_list() << L[i] );
+         } );
+   }
 };
 
 /*
@@ -1952,7 +2098,8 @@ public:
          throw Error( "Internal error: invalid image block." );
 
       if ( block.IsCompressed() )
-         block.Uncompress( m_file );
+         if ( !block.HasIndependentSubblocks() )
+            block.Uncompress( m_file );
 
       const pcl::ImageOptions& options = m_images[m_currentImage].options;
       if ( options.complexSample )
@@ -2170,11 +2317,16 @@ private:
    {
       block.compressionMethod = XISF_COMPRESSION_NONE;
       block.itemSize = 1;
+      block.chunked = false;
       block.subblockInfo.Clear();
       block.subblocks.Clear();
+      block.subblockOffsets.Clear();
+      block.subblockPositions.Clear();
+      block.cachedSubblock.Clear();
 
       // compression="<codec>:<uncompressed-size>"
       // compression="<codec>:<uncompressed-size>:<item-size>"
+      // compression="<codec>+chunked:<uncompressed-size>:<item-size>"
       IsoString s = IsoString( xml.attributes().value( "compression" ).toString() ).Trimmed();
       if ( !s.IsEmpty() )
       {
@@ -2184,7 +2336,20 @@ private:
          if ( tokens.Length() < 2 || tokens.Length() > 3 ) // all supported codecs use one or two parameters
             throw Error( "Malformed block compression attribute: '" + s + "'" );
 
-         block.compressionMethod = CompressionMethodFromId( tokens[0] );
+         /*
+          * A +chunked suffix identifies byte-shuffled blocks whose subblocks
+          * have been shuffled independently. A distinct codec identifier
+          * ensures that readers unaware of chunked blocks reject them,
+          * instead of unshuffling the whole block as a single data stream.
+          */
+         IsoString codec = tokens[0].CaseFolded();
+         if ( codec.EndsWith( "+chunked" ) )
+         {
+            codec.DeleteRight( codec.Length() - 8 );
+            block.chunked = true;
+         }
+
+         block.compressionMethod = CompressionMethodFromId( codec );
          if ( block.compressionMethod == XISF_COMPRESSION_NONE )
             throw Error( "Missing data compression algorithm: " + s );
          if ( block.compressionMethod == XISF_COMPRESSION_UNKNOWN )
@@ -2266,7 +2431,8 @@ private:
 
    void GetBlockData( XISFInputDataBlock& block, void* dst, size_type dstSize, int channel = 0 )
    {
-      bool verbose = m_xisfOptions.verbosity > 0 && block.IsCompressed() && !block.HasData();
+      bool verbose = m_xisfOptions.verbosity > 0 && block.IsCompressed() && !block.HasData() &&
+                     (channel == 0 || !block.HasIndependentSubblocks());
       if ( verbose )
       {
          m_console.Write( "<end><cbr>Uncompressing block (" +
@@ -2279,8 +2445,9 @@ private:
 
       if ( verbose )
       {
-         m_console.WriteLn( File::SizeAsString( block.data.Length() ) +
-               String().Format( " (%.2f%%)", 100*double( block.data.Length() - block.size )/block.data.Length() ) );
+         size_type uncompressedSize = block.DataSize();
+         m_console.WriteLn( File::SizeAsString( uncompressedSize ) +
+               String().Format( " (%.2f%%)", 100*double( uncompressedSize - block.size )/uncompressedSize ) );
          Module->ProcessEvents();
       }
    }
@@ -3313,6 +3480,7 @@ struct XISFOutputBlock
    IsoString     attachmentPos;
    int           compressionMethod = XISF_COMPRESSION_NONE;
    int           itemSize          = 1;
+   bool          chunked           = false;
    subblock_list subblocks;
    ByteArray     data;
    int           checksumMethod    = XISF_CHECKSUM_NONE;
@@ -3392,16 +3560,31 @@ struct XISFOutputBlock
       return IsoString();
    }
 
+   /*
+    * Returns true iff this is a chunked block whose chunks have been
+    * byte-shuffled independently. These blocks cannot be uncompressed as a
+    * single data stream, so they are written with a distinct codec identifier.
+    * Unshuffled chunks are ordinary compressed subblocks.
+    */
+   bool IsChunkShuffled() const
+   {
+      return chunked && itemSize > 1 && XISFEngineBase::CompressionUsesByteShuffle( compressionMethod );
+   }
+
    IsoString CompressionAttributeValue() const
    {
       // compression="<codec>:<uncompressed-size>:<item-size>"
+      // compression="<codec>+chunked:<uncompressed-size>:<item-size>"
       IsoString value;
       if ( IsCompressed() )
       {
          size_type uncompressedSize = 0;
          for ( subblock_list::const_iterator i = subblocks.Begin(); i != subblocks.End(); ++i )
             uncompressedSize += i->uncompressedSize;
-         value = IsoString( XISFEngineBase::CompressionMethodId( compressionMethod ) ) + ':' + IsoString( uncompressedSize );
+         value = XISFEngineBase::CompressionMethodId( compressionMethod );
+         if ( IsChunkShuffled() )
+            value += "+chunked";
+         value += ':' + IsoString( uncompressedSize );
          if ( itemSize > 1 && XISFEngineBase::CompressionNeedsItemSize( compressionMethod ) )
             value += ':' + IsoString( itemSize );
       }
@@ -3423,7 +3606,14 @@ struct XISFOutputBlock
       return value;
    }
 
-   void CompressData( int method, int bytesPerItem, int level )
+   /*
+    * Compress the block data. If a nonzero chunkSize is specified, the data
+    * are divided into chunks of chunkSize bytes, which are compressed (and
+    * byte-shuffled) independently in parallel, each chunk being stored as a
+    * compressed subblock. If one or more chunks cannot be compressed, the
+    * whole block is compressed as a single data stream.
+    */
+   void CompressData( int method, int bytesPerItem, int level, size_type chunkSize = 0 )
    {
       if ( HasData() )
       {
@@ -3433,7 +3623,41 @@ struct XISFOutputBlock
          AutoPointer<Compression> compressor( XISFEngineBase::NewCompression( method, bytesPerItem ) );
          compressor->SetCompressionLevel( level );
 
-         subblocks = compressor->Compress( data );
+         subblocks.Clear();
+         chunked = false;
+         if ( chunkSize > 0 && chunkSize < data.Length() )
+         {
+            int numberOfChunks = int( (data.Length() + chunkSize - 1)/chunkSize );
+            Array<subblock_list> chunks( numberOfChunks );
+            compressor->DisableParallelProcessing();
+            const Compression& C = *compressor;
+            const ByteArray& D = data;
+            ThreadPool::ParallelFor( numberOfChunks, 1,
+               [&]( int begin, int end )
+               {
+                  for ( int i = begin; i < end; ++i )
+                  {
+                     size_type offset = i*chunkSize;
+                     chunks[i] = C.Compress( D.At( offset ), Min( chunkSize, D.Length() - offset ) );
+                  }
+               } );
+
+            for ( Array<subblock_list>::const_iterator i = chunks.Begin(); i != chunks.End(); ++i )
+            {
+               if ( i->Length() != 1 )
+               {
+                  subblocks.Clear();
+                  break;
+               }
+               subblocks << (*i)[0];
+            }
+
+            chunked = !subblocks.IsEmpty();
+            compressor->EnableParallelProcessing();
+         }
+
+         if ( !chunked )
+            subblocks = compressor->Compress( data );
          if ( subblocks.IsEmpty() )
          {
             compressionMethod = XISF_COMPRESSION_NONE;
@@ -4103,6 +4327,13 @@ private:
     *
     * and emit base64-encoded data.
     *
+    * If a nonzero chunkSize is specified, compressed data are stored as
+    * independently compressed chunks of chunkSize bytes, one chunk per
+    * compressed subblock. If the chunks are byte-shuffled, the codec
+    * identifier has a +chunked suffix:
+    *
+    *    compression="<codec>+chunked:<uncompressed-size>:<item-size>"
+    *
     * For attached data, write the attribute:
     *
     *    location="attachment:<pos>:<size>"
@@ -4110,12 +4341,12 @@ private:
     * and generate an offline block structure to be generated upon stream
     * completion.
     */
-   void NewBlock( const ByteArray& blockData, int itemSize = 1, bool canInline = true )
+   void NewBlock( const ByteArray& blockData, int itemSize = 1, bool canInline = true, size_type chunkSize = 0 )
    {
       XISFOutputBlock block( blockData );
 
       if ( m_xisfOptions.compressionMethod != XISF_COMPRESSION_NONE )
-         CompressBlock( block, itemSize );
+         CompressBlock( block, itemSize, chunkSize );
 
       if ( m_xisfOptions.checksumMethod != XISF_CHECKSUM_NONE )
          block.ComputeChecksum( m_xisfOptions.checksumMethod );
@@ -4196,7 +4427,9 @@ private:
          }
       }
 
-      NewBlock( blockData, P::BytesPerSample(), false/*canInline*/ );
+      NewBlock( blockData, P::BytesPerSample(), false/*canInline*/,
+                CompressionChunkSize( image.SelectedRectangle().Width(), image.NumberOfSelectedChannels(),
+                                      P::BytesPerSample(), true/*planar*/ ) );
    }
 
    /*
@@ -4219,17 +4452,35 @@ private:
 
          StartElement( "Image" );
          WriteImageAttributes();
-         NewBlock( m_randomData, m_options.bitsPerSample >> 3, false/*canInline*/ );
+         NewBlock( m_randomData, m_options.bitsPerSample >> 3, false/*canInline*/,
+                   CompressionChunkSize( m_info.width, m_info.numberOfChannels,
+                                         m_options.bitsPerSample >> 3, true/*planar*/ ) );
          WriteImageElements();
          EndElement(); // Image
          m_randomData.Clear();
       }
    }
 
+   /*
+    * Size in bytes of a compression chunk of compressionChunkRows pixel rows,
+    * or zero if chunked compression is disabled. With the planar pixel
+    * storage model each channel is a separate sequence of rows of width
+    * samples; with the normal storage model a row has width*numberOfChannels
+    * interleaved samples. Image blocks are currently written in planar
+    * format.
+    */
+   size_type CompressionChunkSize( int width, int numberOfChannels, int bytesPerSample, bool planar ) const
+   {
+      size_type samplesPerRow = size_type( width );
+      if ( !planar )
+         samplesPerRow *= numberOfChannels;
+      return size_type( m_xisfOptions.compressionChunkRows )*samplesPerRow*bytesPerSample;
+   }
+
    /*
     * Compress an output data block.
     */
-   void CompressBlock( XISFOutputBlock& block, int itemSize )
+   void CompressBlock( XISFOutputBlock& block, int itemSize, size_type chunkSize = 0 )
    {
       size_type uncompressedSize = block.data.Length();
       int compressionLevel = CompressionLevelForMethod( m_xisfOptions.compressionMethod, m_xisfOptions.compressionLevel );
@@ -4242,7 +4493,7 @@ private:
          Module->ProcessEvents();
       }
 
-      block.CompressData( m_xisfOptions.compressionMethod, itemSize, compressionLevel );
+      block.CompressData( m_xisfOptions.compressionMethod, itemSize, compressionLevel, chunkSize );
 
       if ( m_xisfOptions.verbosity > 0 )
       {
@@ -139,6 +139,12 @@ class PCL_CLASS CryptographicHash;
  */
 #define XISF_COMPRESSION_LEVEL_MAX     100
 
+/*
+ * Default number of pixel rows per independently compressed image chunk.
+ * Zero means that image blocks are compressed as single data streams.
+ */
+#define XISF_COMPRESSION_CHUNK_ROWS_DEFAULT 0
+
 /*
  * The default verbosity level (0=quiet, 1=normal, 2=quite, >2=very)
  */
@@ -212,6 +218,7 @@ public:
    uint8  verbosity           : 3;  // * 0 = quiet, > 0 = write console state messages
    uint16 blockAlignmentSize;       // block alignment size in bytes (0 = 1 = unaligned)
    uint16 maxInlineBlockSize;       // maximum size in bytes of an inline/embedded data block
+   uint16 compressionChunkRows;     // pixel rows per independently compressed image chunk (0 = no chunks)
    double outputLowerBound;         // * lower bound for output floating point samples (default=0)
    double outputUpperBound;         // * upper bound for output floating point samples (default=1)
 
@@ -240,6 +247,7 @@ public:
       verbosity          = XISF_VERBOSITY_DEFAULT;
       blockAlignmentSize = XISF_BLOCK_ALIGN_SIZE;
       maxInlineBlockSize = XISF_BLOCK_INLINE_MAX;
+      compressionChunkRows = XISF_COMPRESSION_CHUNK_ROWS_DEFAULT;
       outputLowerBound   = XISF_OUT_LOWER_BOUND_DEFAULT;
       outputUpperBound   = XISF_OUT_UPPER_BOUND_DEFAULT;
    }
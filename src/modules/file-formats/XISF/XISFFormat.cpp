@@ -275,6 +275,7 @@ bool XISFFormat::EditPreferences() const
       Settings::Write( "XISFChecksums",          options.checksumMethod );
       Settings::Write( "XISFBlockAlignmentSize", options.blockAlignmentSize );
       Settings::Write( "XISFMaxInlineBlockSize", options.maxInlineBlockSize );
+      Settings::Write( "XISFCompressionChunkRows", options.compressionChunkRows );
 
       return true;
    }
@@ -333,6 +334,10 @@ XISFOptions XISFFormat::DefaultOptions()
    Settings::ReadU( "XISFMaxInlineBlockSize", u16 );
    options.maxInlineBlockSize = u16;
 
+   u16 = options.compressionChunkRows;
+   Settings::ReadU( "XISFCompressionChunkRows", u16 );
+   options.compressionChunkRows = u16;
+
    return options;
 }
 
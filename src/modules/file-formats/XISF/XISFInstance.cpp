@@ -77,6 +77,8 @@ namespace pcl
  *    compress-data                  w
  *    no-compress-data               w
  *    compression-level <n>          w
+ *    compression-chunk-rows <n>     w
+ *    no-compression-chunks          w
  *    checksums <method>             w
  *    no-checksums                   w
  *    embedded-data                 rw
@@ -153,6 +155,7 @@ public:
    HintValue<int>       checksumMethod;
    HintValue<unsigned>  blockAlignmentSize;
    HintValue<unsigned>  maxInlineBlockSize;
+   HintValue<unsigned>  compressionChunkRows;
    HintValue<bool>      embeddedData;
    HintValue<IsoString> cfa;
    HintValue<bool>      normalize;
@@ -206,6 +209,17 @@ public:
                if ( n >= 0 ) // 0=default
                   compressionLevel = Range( n, XISF_COMPRESSION_LEVEL_DEFAULT, XISF_COMPRESSION_LEVEL_MAX );
          }
+         else if ( *i == "compression-chunk-rows" )
+         {
+            if ( ++i == theHints.End() )
+               break;
+            unsigned n;
+            if ( i->TryToUInt( n ) )
+               if ( n <= uint16_max )
+                  compressionChunkRows = uint16( n );
+         }
+         else if ( *i == "no-compression-chunks" )
+            compressionChunkRows = uint16( 0 );
          else if ( *i == "compress-data" ) // (deprecated) = compression-codec zlib
             compressionMethod = XISF_COMPRESSION_ZLIB;
          else if ( *i == "no-compression" ||
@@ -342,6 +356,11 @@ public:
       if ( compressionLevel.HasChanged() && compressionMethod.Value() != XISF_COMPRESSION_NONE )
          hints << "compression-level " + IsoString( compressionLevel.Value() );
 
+      if ( compressionChunkRows.HasChanged() )
+         hints << ((compressionChunkRows.Value() > 0) ?
+                   "compression-chunk-rows " + IsoString( compressionChunkRows.Value() ) :
+                   "no-compression-chunks");
+
       if ( checksumMethod.HasChanged() )
          hints << ((checksumMethod.Value() != XISF_CHECKSUM_NONE) ?
                    "checksums " + IsoString( XISFEngineBase::ChecksumMethodId( checksumMethod.Value() ) ) :
@@ -442,6 +461,8 @@ public:
          options.compressionMethod = compressionMethod;
       if ( compressionLevel.HasChanged() )
          options.compressionLevel = compressionLevel;
+      if ( compressionChunkRows.HasChanged() )
+         options.compressionChunkRows = compressionChunkRows;
       if ( checksumMethod.HasChanged() )
          options.checksumMethod = checksumMethod;
       if ( blockAlignmentSize.HasChanged() )
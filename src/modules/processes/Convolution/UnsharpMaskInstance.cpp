@@ -60,6 +60,7 @@
 #include <pcl/Console.h>
 #include <pcl/SeparableConvolution.h>
 #include <pcl/FFTConvolution.h>
+#include <pcl/RecursiveGaussianConvolution.h>
 #include <pcl/GaussianFilter.h>
 #include <pcl/MuteStatus.h>
 #include <pcl/Selection.h>
@@ -217,14 +218,17 @@ private:
       size_type pixelsPerThread = N/numberOfThreads;
 
       /*
-       * For USM filters of size <= 49px, we use separable convolutions in the
-       * spatial domain. For larger filters, FFT convolutions are faster. This
-       * limit has been determined empirically.
+       * For small USM filters, we use separable convolutions in the spatial
+       * domain. For large standard deviations, recursive Gaussian filters are
+       * faster, since their cost does not depend on the filter size. These
+       * limits have been determined empirically.
        */
 
       GaussianFilter G( instance.sigma, 0.05F );
       AutoPointer<ImageTransformation> T;
-      if ( G.Size() < PCL_FFT_CONVOLUTION_IS_FASTER_THAN_SEPARABLE_FILTER_SIZE )
+      if ( G.Sigma() >= PCL_RECURSIVE_GAUSSIAN_IS_FASTER_THAN_SEPARABLE_FILTER_SIGMA )
+         T = new RecursiveGaussianConvolution( G );
+      else if ( G.Size() < PCL_FFT_CONVOLUTION_IS_FASTER_THAN_SEPARABLE_FILTER_SIZE )
          T = new SeparableConvolution( G.AsSeparableFilter() );
       else
          T = new FFTConvolution( G );
@@ -64,6 +64,7 @@
 #include <pcl/MetaModule.h>
 #include <pcl/MuteStatus.h>
 #include <pcl/StdStatus.h>
+#include <pcl/ThreadPool.h>
 #include <pcl/Version.h>
 
 namespace pcl
@@ -333,6 +334,7 @@ static void SubtractDark( Image& target, const Image& dark, const FVector& dScal
 /*
  * One-channel dark subtraction with scaling
  */
+/* -- Currently this routine is not used
 static void SubtractOneChannelDark( Image& target, int tCh, const Image& dark, int dCh, float k )
 {
          float* t  = target.PixelData( tCh );
@@ -340,6 +342,7 @@ static void SubtractOneChannelDark( Image& target, int tCh, const Image& dark, i
    const float* d  = dark.PixelData( dCh );
    LOOP *t++ -= SCALED_DARK;
 }
+*/
 
 /*
  * Full calibration routine
@@ -453,22 +456,121 @@ static void Calibrate( Image& target,
  *    Support Publications of the Royal Astronomical Society of the Pacific,
  *    vol. 110, February 1998, pp. 193-199
  *
- * Returns a noise estimate for (target - k*dark).
+ * The first wavelet layer is a linear function of the image, hence
+ * w0(target - k*dark) = w0(target) - k*w0(dark). The first layers of the
+ * target and dark channels are computed once, and the noise estimate for
+ * each dark scaling factor k is evaluated directly on them.
  */
-static double TestDarkOptimization( float k, const Image& target, const Image& dark )
+class DarkOptimizationNoiseEvaluator
 {
-   Image t( target );
-   t.Status().DisableInitialization();
+public:
 
-   SubtractOneChannelDark( t, 0, dark, Min( target.SelectedChannel(), dark.NumberOfChannels()-1 ), k );
+   DarkOptimizationNoiseEvaluator( const Image& target, int tCh, const Image& dark, int dCh )
+   {
+      FirstWaveletLayer( m_target, target, tCh );
+      FirstWaveletLayer( m_dark, dark, dCh );
+   }
 
-   SeparableFilter H( __5x5B3Spline_hv, __5x5B3Spline_hv, 5 );
-   ATrousWaveletTransform W( H, 1 );
-   W.DisableParallelProcessing();
-   W.DisableLayer( 1 );
-   W << t;
-   return W.NoiseKSigma( 0 ) /*/__5x5B3Spline_kj[0]*/; // we can work with unscaled noise estimates here
-}
+   /*
+    * Returns a noise estimate for (target - k*dark). We can work with
+    * unscaled noise estimates here.
+    *
+    * The iterative k-sigma clipping scheme of
+    * ATrousWaveletTransform::NoiseKSigma( 0 ) is reproduced without storing
+    * intermediate sample sets: a sample belongs to the current set if its
+    * absolute value is less than all previous clipping limits, so each
+    * iteration is a single parallel pass accumulating sums and sums of
+    * squares of clipped samples.
+    */
+   double Noise( float k ) const
+   {
+      const float K = 3;
+      const float eps = 0.01F;
+      const int n = 10;
+
+      double limit = -1; // no clipping in the first iteration
+      double s0 = 0;
+      for ( int it = 0; ; )
+      {
+         double s1, s2;
+         size_type N;
+         Accumulate( s1, s2, N, k, limit );
+         if ( N < 2 )
+            return 0;
+
+         double s = Sqrt( Max( 0.0, (s2 - s1*s1/N)/(N - 1) ) );
+         if ( 1 + s == 1 )
+            return 0;
+         if ( ++it == n || it > 1 && (s0 - s)/s0 < eps )
+            return s;
+
+         s0 = s;
+         limit = (limit < 0) ? K*s : Min( limit, double( K*s ) );
+      }
+   }
+
+private:
+
+   Image m_target;
+   Image m_dark;
+
+   static void FirstWaveletLayer( Image& layer, const Image& image, int c )
+   {
+      Image t( image.Width(), image.Height() );
+      t.Status().DisableInitialization();
+      ::memcpy( t.PixelData(), image.PixelData( c ), image.NumberOfPixels()*sizeof( float ) );
+
+      SeparableFilter H( __5x5B3Spline_hv, __5x5B3Spline_hv, 5 );
+      ATrousWaveletTransform W( H, 1 );
+      W.DisableParallelProcessing();
+      W.DisableLayer( 1 );
+      W << t;
+      layer = W[0];
+   }
+
+   void Accumulate( double& s1, double& s2, size_type& N, float k, double limit ) const
+   {
+      const size_type blockSize = 65536;
+      size_type count = m_target.NumberOfPixels();
+      int numberOfBlocks = int( (count + blockSize - 1)/blockSize );
+
+      DVector S1( 0.0, numberOfBlocks ), S2( 0.0, numberOfBlocks );
+      Array<size_type> C( size_type( numberOfBlocks ), size_type( 0 ) );
+
+      ThreadPool::ParallelFor( numberOfBlocks, 1,
+         [&]( int begin, int end )
+         {
+            for ( int b = begin; b < end; ++b )
+            {
+               size_type i0 = b*blockSize;
+               size_type i1 = Min( i0 + blockSize, count );
+               const float* t = m_target.PixelData() + i0;
+               const float* d = m_dark.PixelData() + i0;
+               double a1 = 0, a2 = 0;
+               size_type n = 0;
+               for ( size_type i = i0; i < i1; ++i )
+               {
+                  double v = *t++ - k * *d++;
+                  if ( limit < 0 || Abs( v ) < limit )
+                  {
+                     a1 += v;
+                     a2 += v*v;
+                     ++n;
+                  }
+               }
+               S1[b] = a1;
+               S2[b] = a2;
+               C[b] = n;
+            }
+         } );
+
+      s1 = S1.Sum();
+      s2 = S2.Sum();
+      N = 0;
+      for ( int b = 0; b < numberOfBlocks; ++b )
+         N += C[b];
+   }
+};
 
 /*
  * Initial bracketing of the dark optimization factor.
@@ -483,10 +585,10 @@ inline T SameSign( const T& x, const T& sameAs )
    return (sameAs < 0) ? ((x < 0) ? x : -x) : ((x < 0) ? -x : x);
 }
 
-#define TEST_DARK( x )  TestDarkOptimization( x, target, dark )
+#define TEST_DARK( x )  E.Noise( x )
 
 static void BracketDarkOptimization( float& ax, float& bx, float& cx,
-                                     const Image& target, const Image& dark, bool useConsole )
+                                     const DarkOptimizationNoiseEvaluator& E, bool useConsole )
 {
    if ( useConsole )
    {
@@ -603,14 +705,13 @@ static float DarkOptimization( const Image& target, const Image& dark, int c, bo
    const float R = 0.61803399;
    const float C = 1 - R;
 
-   target.ResetSelections();
-   target.SelectChannel( c );
+   DarkOptimizationNoiseEvaluator E( target, c, dark, Min( c, dark.NumberOfChannels()-1 ) );
 
    /*
     * Find an initial triplet ax,bx,cx that brackets the minimum.
     */
    float ax, bx, cx;
-   BracketDarkOptimization( ax, bx, cx, target, dark, useConsole );
+   BracketDarkOptimization( ax, bx, cx, E, useConsole );
 
    if ( useConsole ) // if we are not running into a thread
    {
@@ -910,11 +1011,11 @@ static String UniqueFilePath( const String& filePath )
 
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
-// Calibration Thread
+// Calibration Task
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
 
-struct CalibrationThreadData
+struct CalibrationTaskData
 {
    ImageCalibrationInstance* instance; // the instance being executed
    ImageCalibrationInstance::overscan_table overscan; // overscan regions grouped by target regions
@@ -927,7 +1028,7 @@ struct CalibrationThreadData
    int     maxProcessors;  // maximum number of threads allowed (for noise estimation)
 };
 
-class CalibrationThread : public Thread
+class CalibrationTask : public BatchPipeline::Task
 {
 public:
 
@@ -943,18 +1044,17 @@ public:
    FVector    noiseFractions;
    StringList noiseAlgorithms;
 
-   CalibrationThread( Image* target, OutputFileData* outputData, const String& targetPath, int subimageIndex,
-                      const CalibrationThreadData& data ) :
+   CalibrationTask( Image* target, OutputFileData* outputData, const String& targetPath, int subimageIndex,
+                    const CalibrationTaskData& data ) :
       m_target( target ),
       m_outputData( outputData ),
       m_targetPath( targetPath ),
       m_subimageIndex( subimageIndex ),
-      m_success( false ),
       m_data( data )
    {
    }
 
-   virtual ~CalibrationThread()
+   virtual ~CalibrationTask()
    {
       if ( m_target != nullptr )
          delete m_target, m_target = nullptr;
@@ -962,67 +1062,63 @@ public:
          delete m_outputData, m_outputData = nullptr;
    }
 
-   virtual void Run()
+   /*
+    * Calibrates the target image. Errors are reported by throwing exceptions,
+    * which are managed by the pipeline.
+    */
+   virtual void Process()
    {
-      try
-      {
-         m_success = false;
+      m_target->Status().DisableInitialization();
 
-         m_target->Status().DisableInitialization();
+      /*
+       * Overscan correction.
+       */
+      if ( m_data.instance->overscan.enabled )
+         SubtractOverscan( *m_target, m_data.overscan, m_data.instance->overscan.imageRect );
 
-         /*
-          * Overscan correction.
-          */
-         if ( m_data.instance->overscan.enabled )
-            SubtractOverscan( *m_target, m_data.overscan, m_data.instance->overscan.imageRect );
+      /*
+       * Dark frame optimization.
+       */
+      if ( m_data.dark != nullptr && m_data.instance->optimizeDarks && m_data.optimizingDark != nullptr )
+         K = OptimizeDark( *m_target,
+                           *m_data.optimizingDark,
+                            m_data.isDarkCFA );
+      else
+         K = FVector( 1.0F, m_target->NumberOfChannels() );
 
-         /*
-          * Dark frame optimization.
-          */
-         if ( m_data.dark != nullptr && m_data.instance->optimizeDarks && m_data.optimizingDark != nullptr )
-            K = OptimizeDark( *m_target,
-                              *m_data.optimizingDark,
-                               m_data.isDarkCFA );
-         else
-            K = FVector( 1.0F, m_target->NumberOfChannels() );
+      /*
+       * Target frame calibration.
+       */
+      Calibrate( *m_target,
+                  m_data.bias,
+                  m_data.dark, K,
+                  m_data.flat, m_data.fScale,
+                  m_data.instance->outputPedestal/65535.0 );
 
-         /*
-          * Target frame calibration.
-          */
-         Calibrate( *m_target,
-                     m_data.bias,
-                     m_data.dark, K,
-                     m_data.flat, m_data.fScale,
-                     m_data.instance->outputPedestal/65535.0 );
+      /*
+       * Noise evaluation.
+       *
+       * ### TODO: Implement a different way to tell the noise evaluation
+       *           routine that we have CFA images (not tied to dark frame
+       *           optimization).
+       */
+      if ( m_data.instance->evaluateNoise )
+         EvaluateNoise( noiseEstimates, noiseFractions, noiseAlgorithms,
+                       *m_target,
+                        m_data.instance->noiseEvaluationAlgorithm,
+                        m_data.maxProcessors,
+                        m_data.instance->darkCFADetectionMode == ICDarkCFADetectionMode::ForceCFA || m_data.isDarkCFA );
+   }
 
-         /*
-          * Noise evaluation.
-          *
-          * ### TODO: Implement a different way to tell the noise evaluation
-          *           routine that we have CFA images (not tied to dark frame
-          *           optimization).
-          */
-         if ( m_data.instance->evaluateNoise )
-            EvaluateNoise( noiseEstimates, noiseFractions, noiseAlgorithms,
-                          *m_target,
-                           m_data.instance->noiseEvaluationAlgorithm,
-                           m_data.maxProcessors,
-                           m_data.instance->darkCFADetectionMode == ICDarkCFADetectionMode::ForceCFA || m_data.isDarkCFA );
-
-         m_success = true;
-      }
-      catch ( ... )
-      {
-         ClearConsoleOutputText();
-         try
-         {
-            throw;
-         }
-         ERROR_HANDLER
-      }
+   /*
+    * Writes the calibrated image.
+    */
+   virtual void Write()
+   {
+      m_data.instance->WriteCalibratedImage( this );
    }
 
-   const CalibrationThreadData& CalibrationData() const
+   const CalibrationTaskData& CalibrationData() const
    {
       return m_data;
    }
@@ -1047,20 +1143,63 @@ public:
       return m_subimageIndex;
    }
 
-   bool Success() const
-   {
-      return m_success;
-   }
-
 private:
 
-   Image*          m_target;        // The image being calibrated. It belongs to this thread.
-   OutputFileData* m_outputData;    // Target image parameters and embedded m_data. It belongs to this thread.
+   Image*          m_target;        // The image being calibrated. It belongs to this task.
+   OutputFileData* m_outputData;    // Target image parameters and embedded m_data. It belongs to this task.
    String          m_targetPath;    // File path of this m_target image
    int             m_subimageIndex; // >= 0 in case of a multiple image; = 0 otherwise
-   bool            m_success : 1;   // The thread completed execution successfully
 
-   const CalibrationThreadData& m_data;
+   const CalibrationTaskData& m_data;
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Batch calibration pipeline. Target frames are read by a single loader
+ * thread, calibrated by a set of compute threads, and written by a single
+ * writer thread. Since load and write stages have a single thread each,
+ * LoadTargetFrame() and WriteCalibratedImage() can modify instance data
+ * without additional synchronization.
+ */
+class CalibrationPipeline : public BatchPipeline
+{
+public:
+
+   CalibrationPipeline( ImageCalibrationInstance& instance, const CalibrationTaskData& data, int numberOfWorkers ) :
+      BatchPipeline( 1, numberOfWorkers, 1 ),
+      m_instance( instance ),
+      m_data( data )
+   {
+   }
+
+   virtual ~CalibrationPipeline()
+   {
+      Abort();
+   }
+
+protected:
+
+   virtual void Load( task_list& tasks, size_type item )
+   {
+      Console console;
+      console.WriteLn( String().Format( "<end><cbr><br>Calibrating target frame %u of %u",
+                                        item+1, m_instance.targetFrames.Length() ) );
+
+      const ImageCalibrationInstance::ImageItem& target = m_instance.targetFrames[item];
+      if ( !target.enabled )
+      {
+         console.NoteLn( "* Skipping disabled target" );
+         return;
+      }
+
+      m_instance.LoadTargetFrame( tasks, target.path, m_data );
+   }
+
+private:
+
+   ImageCalibrationInstance&  m_instance;
+   const CalibrationTaskData& m_data;
 };
 
 // ----------------------------------------------------------------------------
@@ -1277,12 +1416,12 @@ Image* ImageCalibrationInstance::LoadCalibrationFrame( const String& filePath, b
 }
 
 /*
- * Read a target frame file. Returns a list of calibration threads ready to
- * calibrate all subimages loaded from the file.
+ * Read a target frame file. Appends to the specified list a calibration task
+ * for each subimage loaded from the file.
  */
-thread_list
-ImageCalibrationInstance::LoadTargetFrame( const String& filePath,
-                                           const CalibrationThreadData& threadData )
+void ImageCalibrationInstance::LoadTargetFrame( BatchPipeline::task_list& tasks,
+                                                const String& filePath,
+                                                const CalibrationTaskData& taskData )
 {
    Console console;
 
@@ -1317,7 +1456,7 @@ ImageCalibrationInstance::LoadTargetFrame( const String& filePath,
     * images, usually consisting of a single image, but we must provide for a
     * set of subimages.
     */
-   thread_list threads;
+   BatchPipeline::task_list newTasks;
    try
    {
       for ( size_type j = 0; j < images.Length(); ++j )
@@ -1327,8 +1466,6 @@ ImageCalibrationInstance::LoadTargetFrame( const String& filePath,
 
          AutoPointer<Image> target( LoadImageFile( file, j ) );
 
-         Module->ProcessEvents();
-
          /*
           * NB: At this point, LoadImageFile() has already called
           * file.SelectImage().
@@ -1351,14 +1488,14 @@ ImageCalibrationInstance::LoadTargetFrame( const String& filePath,
          OutputFileData* outputData = new OutputFileData( file, images[j].options );
 
          /*
-          * Create a new calibration thread and add it to the thread list.
+          * Create a new calibration task and add it to the task list.
           */
-         threads.Add( new CalibrationThread( target,
-                                             outputData,
-                                             filePath,
-                                             (images.Length() > 1) ? j+1 : 0,
-                                             threadData ) );
-         // The thread owns the target image
+         newTasks.Add( new CalibrationTask( target,
+                                            outputData,
+                                            filePath,
+                                            (images.Length() > 1) ? j+1 : 0,
+                                            taskData ) );
+         // The task owns the target image
          target.Release();
       }
 
@@ -1367,16 +1504,16 @@ ImageCalibrationInstance::LoadTargetFrame( const String& filePath,
        */
       file.Close();
 
-      return threads;
+      tasks.Add( newTasks );
    }
    catch ( ... )
    {
-      threads.Destroy();
+      newTasks.Destroy();
       throw;
    }
 }
 
-void ImageCalibrationInstance::WriteCalibratedImage( const CalibrationThread* t )
+void ImageCalibrationInstance::WriteCalibratedImage( const CalibrationTask* t )
 {
    Console console;
 
@@ -2166,321 +2303,148 @@ bool ImageCalibrationInstance::ExecuteGlobal()
       int failed = 0;
       int skipped = 0;
 
-      /*
-       * Running threads list. Note that IndirectArray<> initializes all item
-       * pointers to zero.
-       */
       int numberOfThreads = Thread::NumberOfThreads( PCL_MAX_PROCESSORS, 1 );
-      thread_list runningThreads( Min( int( targetFrames.Length() ), numberOfThreads ) );
+      int numberOfWorkers = Max( 1, Min( int( targetFrames.Length() ), numberOfThreads ) );
 
       /*
-       * Waiting threads list. We use this list for temporary storage of
-       * calibration threads for multiple image files.
+       * Prepare calibration task data.
        */
-      thread_list waitingThreads;
+      CalibrationTaskData taskData;
+      taskData.instance = this;
+      taskData.overscan = O;
+      taskData.bias = bias;
+      taskData.dark = dark;
+      taskData.optimizingDark = optimizingDark;
+      taskData.isDarkCFA = isDarkCFA;
+      taskData.flat = flat;
+      taskData.fScale = s;
+      taskData.maxProcessors = 1 + (numberOfThreads - numberOfWorkers)/numberOfWorkers;
 
-      /*
-       * Flag to signal the beginning of the final waiting period, when there
-       * are no more pending images but there are still running threads.
-       */
-      bool waitingForFinished = false;
-
-      /*
-       * Prepare working thread data.
-       */
-      CalibrationThreadData threadData;
-      threadData.instance = this;
-      threadData.overscan = O;
-      threadData.bias = bias;
-      threadData.dark = dark;
-      threadData.optimizingDark = optimizingDark;
-      threadData.isDarkCFA = isDarkCFA;
-      threadData.flat = flat;
-      threadData.fScale = s;
-      threadData.maxProcessors = 1 + (numberOfThreads - runningThreads.Length())/runningThreads.Length();
+      console.WriteLn( String().Format( "<end><cbr><br>Calibration of %u target frames:", targetFrames.Length() ) );
+      console.WriteLn( String().Format( "* Using %d worker threads", numberOfWorkers ) );
 
       /*
-       * We'll work on a temporary duplicate of the target frames list. This
-       * allows us to modify the working list without altering the instance.
+       * Target frames are loaded, calibrated and written by a three-stage
+       * pipeline. We are woken up as soon as a pipeline stage completes, so
+       * that we can report its console output and apply the error policy.
+       * The wait timeout only serves to keep the GUI responsive.
        */
-      image_list targets( targetFrames );
-
-      console.WriteLn( String().Format( "<end><cbr><br>Calibration of %u target frames:", targetFrames.Length() ) );
-      console.WriteLn( String().Format( "* Using %u worker threads", runningThreads.Length() ) );
+      CalibrationPipeline pipeline( *this, taskData, numberOfWorkers );
+      pipeline.Start( targetFrames.Length() );
 
-      try
+      for ( ;; )
       {
-         for ( ;; )
+         try
          {
-            try
-            {
-               /*
-                * Thread watching loop.
-                */
-               thread_list::iterator i = 0;
-               size_type unused = 0;
-               for ( thread_list::iterator j = runningThreads.Begin(); j != runningThreads.End(); ++j )
-               {
-                  // Keep the GUI responsive
-                  Module->ProcessEvents();
-                  if ( console.AbortRequested() )
-                     throw ProcessAborted();
-
-                  if ( *j == 0 )
-                  {
-                     /*
-                      * This is a free thread slot. Ignore it if we don't have
-                      * more pending images to feed in.
-                      */
-                     if ( targets.IsEmpty() && waitingThreads.IsEmpty() )
-                     {
-                        ++unused;
-                        continue;
-                     }
-                  }
-                  else
-                  {
-                     /*
-                      * This is an existing thread. If this thread is still
-                      * alive, wait for 0.1 seconds and then continue watching.
-                      */
-                     if ( (*j)->IsActive() )
-                     {
-                        pcl::Sleep( 100 );
-                        continue;
-                     }
-                  }
+            // Keep the GUI responsive
+            Module->ProcessEvents();
+            if ( console.AbortRequested() )
+               throw ProcessAborted();
 
-                  /*
-                   * If we have a useful free thread slot, or a thread has just
-                   * finished, exit the watching loop and work it out.
-                   */
-                  i = j;
+            BatchPipeline::Event event;
+            if ( !pipeline.WaitForEvent( event, 250 ) )
+            {
+               if ( pipeline.IsComplete() )
                   break;
-               }
-
-               /*
-                * Keep watching while there is no useful free thread slots or a
-                * finished thread.
-                */
-               if ( i == 0 )
-                  if ( unused == runningThreads.Length() )
-                     break;
-                  else
-                     continue;
-
-               /*
-                * At this point we have found either a unused thread slot that
-                * we can reuse, or a thread that has just finished execution.
-                */
-               if ( *i != 0 )
-               {
-                  /*
-                   * This is a just-finished thread.
-                   */
-                  try
-                  {
-                     if ( !(*i)->Success() )
-                        throw Error( (*i)->ConsoleOutputText() );
-
-                     // Write the calibrated image.
-                     WriteCalibratedImage( *i );
-
-                     // Dispose this calibration thread, since we are done with
-                     // it. NB: IndirectArray<T>::Delete() sets to zero the
-                     // pointer pointed to by the iterator, but does not remove
-                     // the array element.
-                     runningThreads.Delete( i );
-                  }
-                  catch ( ... )
-                  {
-                     // Ensure the thread is also destroyed in the event of
-                     // error; we'd enter an infinite loop otherwise!
-                     runningThreads.Delete( i );
-                     throw;
-                  }
-
-                  ++succeeded;
-               }
-
-               // Keep the GUI responsive
-               Module->ProcessEvents();
-               if ( console.AbortRequested() )
-                  throw ProcessAborted();
-
-               if ( !waitingThreads.IsEmpty() )
-               {
-                  /*
-                   * If there are threads waiting, pop the first one from the
-                   * waiting threads list and put it in the free thread slot
-                   * for immediate firing.
-                   */
-                  *i = *waitingThreads;
-                  waitingThreads.Remove( waitingThreads.Begin() );
-               }
-               else
-               {
-                  /*
-                   * If there are no more target frames to calibrate, simply
-                   * wait until all running threads terminate execution.
-                   */
-                  if ( targets.IsEmpty() )
-                  {
-                     bool someRunning = false;
-                     for ( thread_list::iterator j = runningThreads.Begin(); j != runningThreads.End(); ++j )
-                        if ( *j != 0 )
-                        {
-                           someRunning = true;
-                           break;
-                        }
-
-                     /*
-                      * If there are still running threads, continue waiting.
-                      */
-                     if ( someRunning )
-                     {
-                        if ( !waitingForFinished )
-                        {
-                           console.WriteLn( "<end><cbr><br>* Waiting for running tasks to terminate ..." );
-                           waitingForFinished = true;
-                        }
-
-                        continue;
-                     }
+               continue;
+            }
 
-                     /*
-                      * If there are no running threads, no waiting threads,
-                      * and no pending target frames, then we are done.
-                      */
-                     break;
-                  }
+            if ( !event.consoleText.IsEmpty() )
+               console.Write( "<end><cbr>" + event.consoleText );
 
-                  /*
-                   * We still have pending work to do: Extract the next target
-                   * frame from the targets list, load and calibrate it.
-                   */
-                  ImageItem item = *targets;
-                  targets.Remove( targets.Begin() );
-
-                  console.WriteLn( String().Format( "<end><cbr><br>Calibrating target frame %u of %u",
-                                                      targetFrames.Length()-targets.Length(),
-                                                      targetFrames.Length() ) );
-                  if ( !item.enabled )
-                  {
-                     console.NoteLn( "* Skipping disabled target" );
-                     ++skipped;
-                     continue;
-                  }
+            if ( !event.success )
+               throw CatchedException(); // error already reported by the pipeline
 
-                  /*
-                   * Create a new thread for this target frame image, or if
-                   * this is a multiple-image file, a set of threads for all
-                   * subimages in this file.
-                   */
-                  thread_list threads = LoadTargetFrame( item.path, threadData );
-
-                  /*
-                   * Put the new thread --or the first thread if this is a
-                   * multiple-image file-- in the free slot.
-                   */
-                  *i = *threads;
-                  threads.Remove( threads.Begin() );
-
-                  /*
-                   * Add the rest of subimages in a multiple-image file to the
-                   * list of waiting threads.
-                   */
-                  if ( !threads.IsEmpty() )
-                     waitingThreads.Add( threads );
-               }
-
-               /*
-                * If we have produced a new thread, run it immediately. Note
-                * that we support thread CPU affinity, if it has been enabled
-                * on the platform via global preferences - hence the second
-                * argument to Thread::Start() below.
-                */
-               if ( *i != 0 )
-                  (*i)->Start( ThreadPriority::DefaultMax, i - runningThreads.Begin() );
-            } // try
-            catch ( ProcessAborted& )
+            switch ( event.stage )
             {
-               /*
-                * The user has requested to abort the process.
-                */
-               throw;
+            case BatchStage::Load:
+               if ( !targetFrames[event.item].enabled )
+                  ++skipped;
+               break;
+            case BatchStage::Write:
+               ++succeeded;
+               break;
+            default:
+               break;
             }
-            catch ( ... )
+         } // try
+         catch ( ProcessAborted& )
+         {
+            /*
+             * The user has requested to abort the process.
+             */
+            console.NoteLn( "<end><cbr><br>* Waiting for running tasks to terminate ..." );
+            pipeline.Abort();
+            throw;
+         }
+         catch ( ... )
+         {
+            /*
+             * The user has requested to abort the process.
+             */
+            if ( console.AbortRequested() )
             {
-               /*
-                * The user has requested to abort the process.
-                */
-               if ( console.AbortRequested() )
-                  throw ProcessAborted();
+               console.NoteLn( "<end><cbr><br>* Waiting for running tasks to terminate ..." );
+               pipeline.Abort();
+               throw ProcessAborted();
+            }
 
-               /*
-                * Other errors handled according to the selected error policy.
-                */
+            /*
+             * Other errors handled according to the selected error policy.
+             */
 
-               ++failed;
+            ++failed;
 
-               try
-               {
-                  throw;
-               }
-               ERROR_HANDLER
+            try
+            {
+               throw;
+            }
+            ERROR_HANDLER
 
-               console.ResetStatus();
-               console.EnableAbort();
+            console.ResetStatus();
+            console.EnableAbort();
 
-               console.Note( "<end><cbr><br>* Applying error policy: " );
+            console.Note( "<end><cbr><br>* Applying error policy: " );
 
-               switch ( onError )
+            switch ( onError )
+            {
+            default: // ?
+            case ICOnError::Continue:
+               console.NoteLn( "Continue on error." );
+               continue;
+
+            case ICOnError::Abort:
+               console.NoteLn( "Abort on error." );
+               console.NoteLn( "<end><cbr><br>* Waiting for running tasks to terminate ..." );
+               pipeline.Abort();
+               throw ProcessAborted();
+
+            case ICOnError::AskUser:
                {
-               default: // ?
-               case ICOnError::Continue:
-                  console.NoteLn( "Continue on error." );
-                  continue;
+                  console.NoteLn( "Ask on error..." );
 
-               case ICOnError::Abort:
-                  console.NoteLn( "Abort on error." );
-                  throw ProcessAborted();
+                  int r = MessageBox( "<p style=\"white-space:pre;\">"
+                     "An error occurred during ImageCalibration execution. What do you want to do?</p>",
+                     "ImageCalibration",
+                     StdIcon::Error,
+                     StdButton::Ignore, StdButton::Abort ).Execute();
 
-               case ICOnError::AskUser:
+                  if ( r == StdButton::Abort )
                   {
-                     console.NoteLn( "Ask on error..." );
-
-                     int r = MessageBox( "<p style=\"white-space:pre;\">"
-                        "An error occurred during ImageCalibration execution. What do you want to do?</p>",
-                        "ImageCalibration",
-                        StdIcon::Error,
-                        StdButton::Ignore, StdButton::Abort ).Execute();
-
-                     if ( r == StdButton::Abort )
-                     {
-                        console.NoteLn( "* Aborting as per user request." );
-                        throw ProcessAborted();
-                     }
-
-                     console.NoteLn( "* Ignoring error as per user request." );
-                     continue;
+                     console.NoteLn( "* Aborting as per user request." );
+                     console.NoteLn( "<end><cbr><br>* Waiting for running tasks to terminate ..." );
+                     pipeline.Abort();
+                     throw ProcessAborted();
                   }
+
+                  console.NoteLn( "* Ignoring error as per user request." );
+                  continue;
                }
             }
-         } // for ( ;; )
-      } // try
+         }
+      } // for ( ;; )
 
-      catch ( ... )
-      {
-         console.NoteLn( "<end><cbr><br>* Waiting for running tasks to terminate ..." );
-         for ( thread_list::iterator i = runningThreads.Begin(); i != runningThreads.End(); ++i )
-            if ( *i != 0 ) (*i)->Abort();
-         for ( thread_list::iterator i = runningThreads.Begin(); i != runningThreads.End(); ++i )
-            if ( *i != 0 ) (*i)->Wait();
-         runningThreads.Destroy();
-         waitingThreads.Destroy();
-         throw;
-      }
+      console.WriteLn( "<end><cbr><br>Pipeline timing:\n" + pipeline.TimingReport() );
 
       /*
        * Fail if no images have been calibrated.
@@ -53,6 +53,7 @@
 #ifndef __ImageCalibrationInstance_h
 #define __ImageCalibrationInstance_h
 
+#include <pcl/BatchPipeline.h>
 #include <pcl/ProcessImplementation.h>
 #include <pcl/Vector.h>
 #include <pcl/Matrix.h>
@@ -66,10 +67,8 @@ namespace pcl
 
 class FileFormatInstance;
 
-class CalibrationThread;
-struct CalibrationThreadData;
-
-typedef IndirectArray<CalibrationThread>  thread_list;
+class CalibrationTask;
+struct CalibrationTaskData;
 
 class ImageCalibrationInstance : public ProcessImplementation
 {
@@ -273,12 +272,13 @@ private:
    Image* LoadCalibrationFrame( const String& filePath, bool willCalibrate, bool* hasCFA = 0 );
 
    // Read a target frame file
-   thread_list LoadTargetFrame( const String& filePath, const CalibrationThreadData& );
+   void LoadTargetFrame( BatchPipeline::task_list&, const String& filePath, const CalibrationTaskData& );
 
    // Write a calibrated image file
-   void WriteCalibratedImage( const CalibrationThread* );
+   void WriteCalibratedImage( const CalibrationTask* );
 
-   friend class CalibrationThread;
+   friend class CalibrationTask;
+   friend class CalibrationPipeline;
    friend class ImageCalibrationInterface;
 };
 
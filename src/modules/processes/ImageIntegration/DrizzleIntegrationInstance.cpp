@@ -153,6 +153,7 @@ DrizzleIntegrationInstance::DrizzleIntegrationInstance( const MetaProcess* m ) :
    p_enableRejection( TheDZEnableRejectionParameter->DefaultValue() ),
    p_enableImageWeighting( TheDZEnableImageWeightingParameter->DefaultValue() ),
    p_enableSurfaceSplines( TheDZEnableSurfaceSplinesParameter->DefaultValue() ),
+   p_splineGridTolerance( TheDZSplineGridToleranceParameter->DefaultValue() ),
    p_useROI( TheDZUseROIParameter->DefaultValue() ),
    p_roi( 0 ),
    p_closePreviousImages( TheDZClosePreviousImagesParameter->DefaultValue() ),
@@ -181,6 +182,7 @@ void DrizzleIntegrationInstance::Assign( const ProcessImplementation& p )
       p_enableRejection      = x->p_enableRejection;
       p_enableImageWeighting = x->p_enableImageWeighting;
       p_enableSurfaceSplines = x->p_enableSurfaceSplines;
+      p_splineGridTolerance  = x->p_splineGridTolerance;
       p_useROI               = x->p_useROI;
       p_roi                  = x->p_roi;
       p_closePreviousImages  = x->p_closePreviousImages;
@@ -299,115 +301,96 @@ private:
          Image::pixel_iterator w( m_data.weight );
          w.MoveBy( 0, m_firstRow );
 
+         /*
+          * Source coordinates of the top (C0) and bottom (C1) corners of the
+          * current row of output pixels. Adjacent output pixels share their
+          * corners, and the bottom corners of a row are the top corners of the
+          * next one, so we evaluate the geometric transformation just once for
+          * each corner.
+          */
+         Array<DPoint> C0( m_data.engine.m_width+1 );
+         Array<DPoint> C1( m_data.engine.m_width+1 );
+         GetRowCorners( C0, m_firstRow );
+
          for ( int y = m_firstRow; y < m_endRow; ++y )
          {
-            DRect referenceRect;
-            referenceRect.y0 = (y + m_data.engine.m_origin.y) * m_data.engine.m_pixelSize;
-            referenceRect.y1 = referenceRect.y0 + m_data.engine.m_pixelSize;
+            GetRowCorners( C1, y+1 );
 
             Point referencePixel;
             if ( m_data.rejection )
             {
-               referencePixel.y = TruncInt( referenceRect.y0 + 0.5 );
+               referencePixel.y = TruncInt( (y + m_data.engine.m_origin.y) * m_data.engine.m_pixelSize + 0.5 );
                if ( referencePixel.y >= m_data.engine.m_referenceHeight )
                   referencePixel.y = m_data.engine.m_referenceHeight-1;
             }
 
             for ( int x = 0; x < m_data.engine.m_width; ++x, ++r, ++w )
             {
-               referenceRect.x0 = (x + m_data.engine.m_origin.x) * m_data.engine.m_pixelSize;
-
                if ( m_data.rejection )
                {
-                  referencePixel.x = TruncInt( referenceRect.x0 + 0.5 );
+                  referencePixel.x = TruncInt( (x + m_data.engine.m_origin.x) * m_data.engine.m_pixelSize + 0.5 );
                   if ( referencePixel.x >= m_data.engine.m_referenceWidth )
                      referencePixel.x = m_data.engine.m_referenceWidth-1;
                   if ( m_data.engine.Reject( referencePixel ) )
                      continue;
                }
 
-               referenceRect.x1 = referenceRect.x0 + m_data.engine.m_pixelSize;
-
-               DPoint sourceP0, sourceP1, sourceP2, sourceP3;
-               if ( m_data.splines )
-               {
-                  sourceP0 = m_data.G( referenceRect.x0, referenceRect.y1 );
-                  sourceP1 = m_data.G( referenceRect.x0, referenceRect.y0 );
-                  sourceP2 = m_data.G( referenceRect.x1, referenceRect.y0 );
-                  sourceP3 = m_data.G( referenceRect.x1, referenceRect.y1 );
-               }
-               else
-               {
-                  sourceP0 = m_data.H( referenceRect.x0, referenceRect.y1 );
-                  sourceP1 = m_data.H( referenceRect.x0, referenceRect.y0 );
-                  sourceP2 = m_data.H( referenceRect.x1, referenceRect.y0 );
-                  sourceP3 = m_data.H( referenceRect.x1, referenceRect.y1 );
-               }
-
-               sourceP0.MoveBy( 0.5 );
-               sourceP1.MoveBy( 0.5 );
-               sourceP2.MoveBy( 0.5 );
-               sourceP3.MoveBy( 0.5 );
-
-               sourceP0.Round( DRIZZLE_RESOLUTION );
-               sourceP1.Round( DRIZZLE_RESOLUTION );
-               sourceP2.Round( DRIZZLE_RESOLUTION );
-               sourceP3.Round( DRIZZLE_RESOLUTION );
+               const DPoint& sourceP0 = C1[x];
+               const DPoint& sourceP1 = C0[x];
+               const DPoint& sourceP2 = C0[x+1];
+               const DPoint& sourceP3 = C1[x+1];
 
                DRect sourceBounds( Min( Min( Min( sourceP0.x, sourceP1.x ), sourceP2.x ), sourceP3.x ) + 1.0e-5,
                                    Min( Min( Min( sourceP0.y, sourceP1.y ), sourceP2.y ), sourceP3.y ) + 1.0e-5,
                                    Max( Max( Max( sourceP0.x, sourceP1.x ), sourceP2.x ), sourceP3.x ) - 1.0e-5,
                                    Max( Max( Max( sourceP0.y, sourceP1.y ), sourceP2.y ), sourceP3.y ) - 1.0e-5 );
 
-               Array<Point> sourcePixels;
-               {
-                  Rect b = sourceBounds.TruncatedToInt();
-                  for ( int y = b.y0; y <= b.y1; ++y )
-                     if ( y >= 0 )
-                        if ( y < m_data.source.Height() )
-                           for ( int x = b.x0; x <= b.x1; ++x )
-                              if ( x >= 0 )
-                                 if ( x < m_data.source.Width() )
-                                    sourcePixels.Append( Point( x, y ) );
-               }
+               Rect b = sourceBounds.TruncatedToInt();
+               int sx0 = Max( 0, b.x0 );
+               int sy0 = Max( 0, b.y0 );
+               int sx1 = Min( m_data.source.Width()-1, b.x1 );
+               int sy1 = Min( m_data.source.Height()-1, b.y1 );
 
-               for ( Array<Point>::const_iterator p = sourcePixels.Begin(); p != sourcePixels.End(); ++p )
-               {
-                  DRect dropRect( p->x + m_data.dropDelta0,
-                                  p->y + m_data.dropDelta0,
-                                  p->x + m_data.dropDelta1,
-                                  p->y + m_data.dropDelta1 );
+               for ( int sy = sy0; sy <= sy1; ++sy )
+                  for ( int sx = sx0; sx <= sx1; ++sx )
+                  {
+                     DRect dropRect( sx + m_data.dropDelta0,
+                                     sy + m_data.dropDelta0,
+                                     sx + m_data.dropDelta1,
+                                     sy + m_data.dropDelta1 );
 
-                  dropRect.Round( DRIZZLE_RESOLUTION );
+                     dropRect.Round( DRIZZLE_RESOLUTION );
 
-                  if ( CanRectsIntersect( dropRect, sourceBounds ) )
-                  {
-                     double area;
-                     if ( GetAreaOfIntersectionOfQuadAndRect( area, dropRect, sourceP0, sourceP1, sourceP2, sourceP3 ) )
+                     if ( CanRectsIntersect( dropRect, sourceBounds ) )
                      {
-                        for ( int c = 0; c < m_data.engine.m_numberOfChannels; ++c )
+                        double area;
+                        if ( GetAreaOfIntersectionOfQuadAndRect( area, dropRect, sourceP0, sourceP1, sourceP2, sourceP3 ) )
                         {
-                           double value = m_data.source( *p, c );
-                           if ( 1 + value != 1 )
-                              if ( !m_data.perChannelRejection || !m_data.engine.Reject( referencePixel, c ) )
-                              {
-                                 double normalizedValue = (value - m_data.engine.Location( c ))
-                                                         * m_data.engine.Scale( c )
-                                                         + m_data.engine.ReferenceLocation( c );
-
-                                 double weightedArea = area * m_data.engine.Weight( c );
-
-                                 r[c] += weightedArea * normalizedValue;
-                                 w[c] += weightedArea;
-                              }
+                           for ( int c = 0; c < m_data.engine.m_numberOfChannels; ++c )
+                           {
+                              double value = m_data.source( sx, sy, c );
+                              if ( 1 + value != 1 )
+                                 if ( !m_data.perChannelRejection || !m_data.engine.Reject( referencePixel, c ) )
+                                 {
+                                    double normalizedValue = (value - m_data.engine.Location( c ))
+                                                            * m_data.engine.Scale( c )
+                                                            + m_data.engine.ReferenceLocation( c );
+
+                                    double weightedArea = area * m_data.engine.Weight( c );
+
+                                    r[c] += weightedArea * normalizedValue;
+                                    w[c] += weightedArea;
+                                 }
+                           }
+
+                           totalDropArea += area;
                         }
-
-                        totalDropArea += area;
                      }
                   }
-               }
             }
 
+            Swap( C0, C1 );
+
             UPDATE_THREAD_MONITOR( 1 )
          }
       }
@@ -416,6 +399,65 @@ private:
 
       const ThreadData& m_data;
             int         m_firstRow, m_endRow;
+
+      /*
+       * Computes source image coordinates for the top corners of all output
+       * pixels in the specified row.
+       */
+      void GetRowCorners( Array<DPoint>& C, int y ) const
+      {
+         double ry = (y + m_data.engine.m_origin.y) * m_data.engine.m_pixelSize;
+         for ( int x = 0; x <= m_data.engine.m_width; ++x )
+         {
+            double rx = (x + m_data.engine.m_origin.x) * m_data.engine.m_pixelSize;
+            DPoint p = m_data.splines ? m_data.G( rx, ry ) : m_data.H( rx, ry );
+            p.MoveBy( 0.5 );
+            p.Round( DRIZZLE_RESOLUTION );
+            C[x] = p;
+         }
+      }
+   };
+
+   /*
+    * The intersection of a convex quadrilateral and a rectangle, stored in a
+    * fixed-length array to avoid dynamic allocations in the drizzle loop. Each
+    * side of the quadrilateral can intersect the rectangle at two points at
+    * most, so no more than 4*2 + 4 + 4 points can be generated.
+    */
+   struct IntersectionPolygon
+   {
+      DPoint P[ 16 ];
+      int    n;
+
+      IntersectionPolygon() : n( 0 )
+      {
+      }
+
+      void Append( const DPoint& p )
+      {
+         PCL_PRECONDITION( n < 16 )
+         P[n++] = p;
+      }
+
+      int Length() const
+      {
+         return n;
+      }
+
+      DPoint* Begin()
+      {
+         return P;
+      }
+
+      DPoint* End()
+      {
+         return P + n;
+      }
+
+      const DPoint& operator []( int i ) const
+      {
+         return P[i];
+      }
    };
 
    /*
@@ -425,7 +467,7 @@ private:
    {
    public:
 
-      PointsClockwisePredicate( const Array<DPoint>& P ) : c( 0 )
+      PointsClockwisePredicate( const IntersectionPolygon& P ) : c( 0 )
       {
          /*
           * Compute the polygon's barycenter.
@@ -520,7 +562,7 @@ private:
                                            q0.x*q3.y - q3.x*q0.y >= 0;
    }
 
-   static void GetIntersectionOfSegmentAndHorizontalSegment( Array<DPoint>& P, const DPoint& a, const DPoint& b,
+   static void GetIntersectionOfSegmentAndHorizontalSegment( IntersectionPolygon& P, const DPoint& a, const DPoint& b,
                                                              double x0, double y, double x1 )
    {
       // Fail if the lines are parallel
@@ -550,7 +592,7 @@ private:
       }
    }
 
-   static void GetIntersectionOfSegmentAndVerticalSegment( Array<DPoint>& P, const DPoint& a, const DPoint& b,
+   static void GetIntersectionOfSegmentAndVerticalSegment( IntersectionPolygon& P, const DPoint& a, const DPoint& b,
                                                            double x, double y0, double y1 )
    {
       // Fail if the lines are parallel
@@ -580,7 +622,7 @@ private:
       }
    }
 
-   static void GetIntersectionsOfSegmentAndRect( Array<DPoint>& P, const DPoint& a, const DPoint& b, const DRect& r )
+   static void GetIntersectionsOfSegmentAndRect( IntersectionPolygon& P, const DPoint& a, const DPoint& b, const DRect& r )
    {
       GetIntersectionOfSegmentAndHorizontalSegment( P, a, b, r.x0, r.y0, r.x1 );
       GetIntersectionOfSegmentAndHorizontalSegment( P, a, b, r.x0, r.y1, r.x1 );
@@ -592,7 +634,7 @@ private:
     * Adapted from a public-domain function by Darel Rex Finley, 2006.
     * http://alienryderflex.com/polygon_area/
     */
-   static double AreaOfPolygon( const Array<DPoint>& P )
+   static double AreaOfPolygon( const IntersectionPolygon& P )
    {
       double s = 0;
       for ( int n = P.Length(), i = 0, j = n-1; i < n; ++i )
@@ -606,7 +648,7 @@ private:
    static bool GetAreaOfIntersectionOfQuadAndRect( double& f, const DRect& r,
                                                    const DPoint& p0, const DPoint& p1, const DPoint& p2, const DPoint& p3 )
    {
-      Array<DPoint> P;
+      IntersectionPolygon P;
       if ( CanSegmentAndRectIntersect( p0, p1, r ) )
          GetIntersectionsOfSegmentAndRect( P, p0, p1, r );
       if ( CanSegmentAndRectIntersect( p1, p2, r ) )
@@ -645,6 +687,57 @@ private:
       return true;
    }
 
+   /*
+    * Initializes a discretized interpolation of the registration surface
+    * splines. Starting from a coarse grid, the grid distance is halved until
+    * the interpolation error, sampled at the centers of a regular subset of
+    * grid cells, is within the user-defined tolerance.
+    */
+   void InitializeSplineGrid( PointGridInterpolation& G, const PointSurfaceSpline& S ) const
+   {
+      Console console;
+      console.WriteLn( "<end><cbr>Building 2D surface interpolation grid...<flush>" );
+
+      Rect rect( m_referenceWidth, m_referenceHeight );
+      double maxError;
+      int delta = 64;
+      for ( ;; )
+      {
+         G.Initialize( rect, delta, S, false/*verbose*/ );
+         maxError = SplineGridError( G, S, rect, delta );
+         if ( maxError <= m_instance.p_splineGridTolerance || delta == 1 )
+            break;
+         delta >>= 1;
+      }
+
+      console.WriteLn( String().Format( "Grid distance : %d px, max. error = %.4f px", delta, maxError ) );
+   }
+
+   static double SplineGridError( const PointGridInterpolation& G, const PointSurfaceSpline& S, const Rect& rect, int delta )
+   {
+      int w = rect.Width();
+      int h = rect.Height();
+      int rows = h/delta + ((h%delta) ? 1 : 0);
+      int cols = w/delta + ((w%delta) ? 1 : 0);
+      int rowStep = Max( 1, rows/32 );
+      int colStep = Max( 1, cols/32 );
+
+      double maxError = 0;
+      for ( int i = 0; i < rows; i = (i < rows-1) ? Min( rows-1, i+rowStep ) : rows )
+      {
+         double y = Min( rect.y0 + (i + 0.5)*delta, rect.y1 - 0.5 );
+         for ( int j = 0; j < cols; j = (j < cols-1) ? Min( cols-1, j+colStep ) : cols )
+         {
+            double x = Min( rect.x0 + (j + 0.5)*delta, rect.x1 - 0.5 );
+            DPoint d = G( x, y ) - S( x, y );
+            double e = Sqrt( d.x*d.x + d.y*d.y );
+            if ( e > maxError )
+               maxError = e;
+         }
+      }
+      return maxError;
+   }
+
    bool Reject( const Point& p ) const
    {
       // Assume m_decoder.HasRejectionData() == true
@@ -944,7 +1037,7 @@ void DrizzleIntegrationEngine::Perform()
             threadData.H = Homography( m_decoder.AlignmentMatrix() );
             if ( m_instance.p_enableSurfaceSplines )
                if ( m_decoder.HasSplines() )
-                  threadData.G.Initialize( Rect( m_referenceWidth, m_referenceHeight ), 8, m_decoder.AlignmentSplines() );
+                  InitializeSplineGrid( threadData.G, m_decoder.AlignmentSplines() );
             threadData.dropDelta0 = (1 - m_instance.p_dropShrink)/2;
             threadData.dropDelta1 = 1 - threadData.dropDelta0;
             threadData.splines = threadData.G.IsValid();
@@ -1096,6 +1189,9 @@ void DrizzleIntegrationEngine::Perform()
                                        "DrizzleIntegration.enableImageWeighting: " + IsoString( bool( m_instance.p_enableImageWeighting ) ) ) );
       keywords.Add( FITSHeaderKeyword( "HISTORY", IsoString(),
                                        "DrizzleIntegration.enableSurfaceSplines: " + IsoString( bool( m_instance.p_enableSurfaceSplines ) ) ) );
+      if ( m_instance.p_enableSurfaceSplines )
+         keywords.Add( FITSHeaderKeyword( "HISTORY", IsoString(),
+                                       IsoString().Format( "DrizzleIntegration.splineGridTolerance: %.3f", m_instance.p_splineGridTolerance ) ) );
       keywords.Add( FITSHeaderKeyword( "HISTORY", IsoString(),
                                        IsoString().Format( "DrizzleIntegration.referenceDimensions: width=%d, height=%d",
                                                          m_referenceWidth, m_referenceHeight ) ) );
@@ -1194,6 +1290,8 @@ void* DrizzleIntegrationInstance::LockParameter( const MetaParameter* p, size_ty
       return &p_enableImageWeighting;
    if ( p == TheDZEnableSurfaceSplinesParameter )
       return &p_enableSurfaceSplines;
+   if ( p == TheDZSplineGridToleranceParameter )
+      return &p_splineGridTolerance;
    if ( p == TheDZUseROIParameter )
       return &p_useROI;
    if ( p == TheDZROIX0Parameter )
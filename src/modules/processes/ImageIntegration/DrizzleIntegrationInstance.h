@@ -114,6 +114,7 @@ private:
    pcl_bool        p_enableRejection;      // enable pixel rejection
    pcl_bool        p_enableImageWeighting; // enable image weights
    pcl_bool        p_enableSurfaceSplines; // enable registration surface splines
+   float           p_splineGridTolerance;  // max. spline grid interpolation error in pixels
    pcl_bool        p_useROI;               // use a region of interest
    Rect            p_roi;                  // region of interest
    pcl_bool        p_closePreviousImages;  // close existing integration and weight images before running
@@ -256,6 +256,8 @@ void DrizzleIntegrationInterface::UpdateIntegrationControls()
    GUI->EnableRejection_CheckBox.SetChecked( m_instance.p_enableRejection );
    GUI->EnableImageWeighting_CheckBox.SetChecked( m_instance.p_enableImageWeighting );
    GUI->EnableSurfaceSplines_CheckBox.SetChecked( m_instance.p_enableSurfaceSplines );
+   GUI->SplineGridTolerance_NumericControl.SetValue( m_instance.p_splineGridTolerance );
+   GUI->SplineGridTolerance_NumericControl.Enable( m_instance.p_enableSurfaceSplines );
    GUI->ClosePreviousImages_CheckBox.SetChecked( m_instance.p_closePreviousImages );
 }
 
@@ -274,6 +276,8 @@ void DrizzleIntegrationInterface::__ValueUpdated( NumericEdit& sender, double va
 {
    if ( sender == GUI->DropShrink_NumericControl )
       m_instance.p_dropShrink = value;
+   else if ( sender == GUI->SplineGridTolerance_NumericControl )
+      m_instance.p_splineGridTolerance = value;
 }
 
 
@@ -403,6 +407,7 @@ void DrizzleIntegrationInterface::__Click( Button& sender, bool checked )
    else if ( sender == GUI->EnableSurfaceSplines_CheckBox )
    {
       m_instance.p_enableSurfaceSplines = checked;
+      UpdateIntegrationControls();
    }
    else if ( sender == GUI->ClosePreviousImages_CheckBox )
    {
@@ -684,6 +689,22 @@ DrizzleIntegrationInterface::GUIData::GUIData( DrizzleIntegrationInterface& w )
    EnableSurfaceSplines_Sizer.Add( EnableSurfaceSplines_CheckBox );
    EnableSurfaceSplines_Sizer.AddStretch();
 
+   SplineGridTolerance_NumericControl.label.SetText( "Grid tolerance:" );
+   SplineGridTolerance_NumericControl.label.SetFixedWidth( labelWidth1 );
+   SplineGridTolerance_NumericControl.slider.SetRange( 0, 250 );
+   SplineGridTolerance_NumericControl.slider.SetScaledMinWidth( 250 );
+   SplineGridTolerance_NumericControl.SetReal();
+   SplineGridTolerance_NumericControl.SetRange( TheDZSplineGridToleranceParameter->MinimumValue(), TheDZSplineGridToleranceParameter->MaximumValue() );
+   SplineGridTolerance_NumericControl.SetPrecision( TheDZSplineGridToleranceParameter->Precision() );
+   SplineGridTolerance_NumericControl.edit.SetFixedWidth( editWidth1 );
+   SplineGridTolerance_NumericControl.SetToolTip( "<p>Maximum error, in input pixels, of the interpolation grid used to "
+      "evaluate registration surface splines.</p>"
+      "<p>Evaluating a surface spline is expensive, since its cost is proportional to the number of spline nodes. To accelerate "
+      "the drizzle process, splines are evaluated on a coarse grid, which is then interpolated with bicubic splines. The grid "
+      "spacing is selected automatically for each input image as the largest one that approximates the surface splines within "
+      "the specified tolerance. The default tolerance is 0.005 pixels.</p>" );
+   SplineGridTolerance_NumericControl.OnValueUpdated( (NumericEdit::value_event_handler)&DrizzleIntegrationInterface::__ValueUpdated, w );
+
    ClosePreviousImages_CheckBox.SetText( "Close previous images" );
    ClosePreviousImages_CheckBox.SetToolTip( "<p>Select this option to close existing drizzle integration and weight images "
       "before running a new integration process. This is useful to avoid accumulation of multiple results on the workspace, "
@@ -700,6 +721,7 @@ DrizzleIntegrationInterface::GUIData::GUIData( DrizzleIntegrationInterface& w )
    Integration_Sizer.Add( EnableRejection_Sizer );
    Integration_Sizer.Add( EnableImageWeighting_Sizer );
    Integration_Sizer.Add( EnableSurfaceSplines_Sizer );
+   Integration_Sizer.Add( SplineGridTolerance_NumericControl );
    Integration_Sizer.Add( ClosePreviousImages_Sizer );
 
    Integration_Control.SetSizer( Integration_Sizer );
@@ -143,6 +143,7 @@ private:
             CheckBox          EnableImageWeighting_CheckBox;
          HorizontalSizer   EnableSurfaceSplines_Sizer;
             CheckBox          EnableSurfaceSplines_CheckBox;
+         NumericControl    SplineGridTolerance_NumericControl;
          HorizontalSizer   ClosePreviousImages_Sizer;
             CheckBox          ClosePreviousImages_CheckBox;
 
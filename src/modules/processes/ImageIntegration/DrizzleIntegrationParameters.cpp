@@ -67,6 +67,7 @@ DZDropShrink*               TheDZDropShrinkParameter = 0;
 DZEnableRejection*          TheDZEnableRejectionParameter = 0;
 DZEnableImageWeighting*     TheDZEnableImageWeightingParameter = 0;
 DZEnableSurfaceSplines*     TheDZEnableSurfaceSplinesParameter = 0;
+DZSplineGridTolerance*      TheDZSplineGridToleranceParameter = 0;
 DZUseROI*                   TheDZUseROIParameter = 0;
 DZROIX0*                    TheDZROIX0Parameter = 0;
 DZROIY0*                    TheDZROIY0Parameter = 0;
@@ -292,6 +293,38 @@ bool DZEnableSurfaceSplines::DefaultValue() const
 
 // ----------------------------------------------------------------------------
 
+DZSplineGridTolerance::DZSplineGridTolerance( MetaProcess* P ) : MetaFloat( P )
+{
+   TheDZSplineGridToleranceParameter = this;
+}
+
+IsoString DZSplineGridTolerance::Id() const
+{
+   return "splineGridTolerance";
+}
+
+int DZSplineGridTolerance::Precision() const
+{
+   return 3;
+}
+
+double DZSplineGridTolerance::DefaultValue() const
+{
+   return 0.005;
+}
+
+double DZSplineGridTolerance::MinimumValue() const
+{
+   return 0.001;
+}
+
+double DZSplineGridTolerance::MaximumValue() const
+{
+   return 0.5;
+}
+
+// ----------------------------------------------------------------------------
+
 DZUseROI::DZUseROI( MetaProcess* P ) : MetaBoolean( P )
 {
    TheDZUseROIParameter = this;
@@ -204,6 +204,23 @@ extern DZEnableSurfaceSplines* TheDZEnableSurfaceSplinesParameter;
 
 // ----------------------------------------------------------------------------
 
+class DZSplineGridTolerance : public MetaFloat
+{
+public:
+
+   DZSplineGridTolerance( MetaProcess* );
+
+   virtual IsoString Id() const;
+   virtual int Precision() const;
+   virtual double DefaultValue() const;
+   virtual double MinimumValue() const;
+   virtual double MaximumValue() const;
+};
+
+extern DZSplineGridTolerance* TheDZSplineGridToleranceParameter;
+
+// ----------------------------------------------------------------------------
+
 class DZUseROI : public MetaBoolean
 {
 public:
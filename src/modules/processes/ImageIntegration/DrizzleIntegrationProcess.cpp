@@ -87,6 +87,7 @@ DrizzleIntegrationProcess::DrizzleIntegrationProcess() : MetaProcess()
    new DZEnableRejection( this );
    new DZEnableImageWeighting( this );
    new DZEnableSurfaceSplines( this );
+   new DZSplineGridTolerance( this );
    new DZUseROI( this );
    new DZROIX0( this );
    new DZROIY0( this );
@@ -133,6 +133,7 @@ ImageIntegrationInstance::ImageIntegrationInstance( const MetaProcess* m ) :
    p_closePreviousImages( TheIIClosePreviousImagesParameter->DefaultValue() ),
    p_bufferSizeMB( TheIIBufferSizeParameter->DefaultValue() ),
    p_stackSizeMB( TheIIStackSizeParameter->DefaultValue() ),
+   p_readAheadSizeMB( TheIIReadAheadSizeParameter->DefaultValue() ),
    p_useROI( TheIIUseROIParameter->DefaultValue() ),
    p_roi( 0 ),
    p_useCache( TheIIUseCacheParameter->DefaultValue() ),
@@ -190,6 +191,7 @@ void ImageIntegrationInstance::Assign( const ProcessImplementation& p )
       p_closePreviousImages     = x->p_closePreviousImages;
       p_bufferSizeMB            = x->p_bufferSizeMB;
       p_stackSizeMB             = x->p_stackSizeMB;
+      p_readAheadSizeMB         = x->p_readAheadSizeMB;
       p_useROI                  = x->p_useROI;
       p_roi                     = x->p_roi;
       p_useCache                = x->p_useCache;
@@ -637,14 +639,70 @@ public:
       return s_bufferRows;
    }
 
+   /*
+    * Load the strip of s_bufferRows pixel rows starting at startRow of the
+    * specified channel in the row buffers of all input files.
+    *
+    * In incremental mode, rows are read by a set of I/O threads, provided
+    * that all input file formats support quiet reading (see Open()).
+    * With read-ahead enabled, once the requested strip is available the next
+    * strip (or the first strip of the next channel) is read asynchronously
+    * into secondary buffers, while the current strip is being integrated.
+    */
    static void UpdateBuffers( int startRow, int channel )
    {
-      for ( file_list::const_iterator i = s_files.Begin(); i != s_files.End(); ++i )
-         (*i)->Read( startRow, channel );
+      if ( !s_incremental || !s_threadedReads )
+      {
+         for ( file_list::const_iterator i = s_files.Begin(); i != s_files.End(); ++i )
+            (*i)->Read( startRow, channel );
+         return;
+      }
+
+      if ( s_readAhead && startRow == s_readAheadRow && channel == s_readAheadChannel )
+      {
+         WaitForReadThreads();
+         for ( file_list::iterator i = s_files.Begin(); i != s_files.End(); ++i )
+            Swap( (*i)->m_buffer, (*i)->m_nextBuffer );
+      }
+      else
+      {
+         WaitForReadThreads();
+         StartReadThreads( startRow, channel, false/*readAhead*/ );
+         WaitForReadThreads();
+      }
+
+      s_readAheadRow = s_readAheadChannel = -1;
+      if ( s_readAhead )
+      {
+         int nextRow = startRow + s_bufferRows;
+         int nextChannel = channel;
+         if ( nextRow >= s_roi.Height() )
+         {
+            nextRow = 0;
+            ++nextChannel;
+         }
+         if ( nextChannel < s_numberOfChannels )
+         {
+            StartReadThreads( nextRow, nextChannel, true/*readAhead*/ );
+            s_readAheadRow = nextRow;
+            s_readAheadChannel = nextChannel;
+         }
+      }
    }
 
    static void CloseAll()
    {
+      try
+      {
+         WaitForReadThreads();
+      }
+      catch ( ... )
+      {
+      }
+      s_readThreads.Destroy();
+      s_threadedReads = false;
+      s_readAhead = false;
+      s_readAheadRow = s_readAheadChannel = -1;
       s_files.Destroy();
    }
 
@@ -655,11 +713,73 @@ private:
 
    typedef IndirectArray<IntegrationFile>       file_list;
 
+   /*
+    * I/O thread for incremental reading of a subset of input files.
+    */
+   class ReadThread : public Thread
+   {
+   public:
+
+      ReadThread( int firstFile, int endFile ) :
+      Thread(),
+      m_firstFile( firstFile ), m_endFile( endFile ), m_startRow( 0 ), m_channel( 0 ),
+      m_readAhead( false ), m_failed( false )
+      {
+      }
+
+      void Initialize( int startRow, int channel, bool readAhead )
+      {
+         m_startRow = startRow;
+         m_channel = channel;
+         m_readAhead = readAhead;
+         m_errorMessage.Clear();
+         m_failed = false;
+      }
+
+      virtual void Run()
+      {
+         try
+         {
+            for ( int i = m_firstFile; i < m_endFile; ++i )
+               s_files[i]->Read( m_readAhead ? s_files[i]->m_nextBuffer : s_files[i]->m_buffer, m_startRow, m_channel );
+         }
+         catch ( Exception& x )
+         {
+            m_errorMessage = x.Message();
+            m_failed = true;
+         }
+         catch ( ... )
+         {
+            m_failed = true;
+         }
+      }
+
+      void ThrowIfFailed() const
+      {
+         if ( m_failed )
+            if ( m_errorMessage.IsEmpty() )
+               throw CatchedException();
+            else
+               throw Error( m_errorMessage );
+      }
+
+   private:
+
+      int    m_firstFile, m_endFile;
+      int    m_startRow, m_channel;
+      bool   m_readAhead;
+      bool   m_failed;
+      String m_errorMessage;
+   };
+
+   typedef ReferenceArray<ReadThread>           read_thread_list;
+
    FileFormatInstance*    m_file;
    String                 m_drzPath;
    Image*                 m_image;  // used for nonincremental file reading
    int                    m_currentChannel;
    FMatrix                m_buffer; // used for incremental file reading
+   FMatrix                m_nextBuffer; // used for asynchronous read-ahead
    DVector                m_scale;
    DVector                m_mean;
    DVector                m_median;
@@ -688,25 +808,82 @@ private:
    static bool            s_isColor;
    static bool            s_incremental;
    static int             s_bufferRows;
+   static bool            s_threadedReads;
+   static bool            s_readAhead;
+   static int             s_readAheadRow;
+   static int             s_readAheadChannel;
+   static read_thread_list s_readThreads;
+   static bool            s_readThreadsRunning;
 
    IntegrationFile() : m_file( 0 ), m_image( 0 )
    {
    }
 
+   static void StartReadThreads( int startRow, int channel, bool readAhead )
+   {
+      if ( s_readThreads.IsEmpty() )
+      {
+         int numberOfThreads = Thread::NumberOfThreads( s_files.Length(), 1 );
+         int filesPerThread = int( s_files.Length() )/numberOfThreads;
+         for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+            s_readThreads.Add( new ReadThread( i*filesPerThread,
+                                               (j < numberOfThreads) ? j*filesPerThread : int( s_files.Length() ) ) );
+      }
+
+      for ( read_thread_list::iterator i = s_readThreads.Begin(); i != s_readThreads.End(); ++i )
+         i->Initialize( startRow, channel, readAhead );
+
+      if ( s_readThreads.Length() > 1 )
+      {
+         for ( read_thread_list::iterator i = s_readThreads.Begin(); i != s_readThreads.End(); ++i )
+            i->Start( ThreadPriority::DefaultMax );
+         s_readThreadsRunning = true;
+      }
+      else
+         s_readThreads[0].Run();
+   }
+
+   static void WaitForReadThreads()
+   {
+      if ( s_readThreadsRunning )
+      {
+         for ( read_thread_list::iterator i = s_readThreads.Begin(); i != s_readThreads.End(); ++i )
+            i->Wait();
+         s_readThreadsRunning = false;
+      }
+
+      for ( read_thread_list::const_iterator i = s_readThreads.Begin(); i != s_readThreads.End(); ++i )
+         i->ThrowIfFailed();
+   }
+
    void Open( const String&, const String&, const ImageIntegrationInstance*, bool isReference );
 
+   /*
+    * Incremental reads can only be delegated to I/O threads for file formats
+    * whose readers neither write to the console nor process GUI events when
+    * opened with a zero verbosity hint. File format instances must not do
+    * either out of the main thread.
+    */
+   static bool CanReadQuietly( const FileFormat& format )
+   {
+      return IIReadAheadSize::IsQuietReadFormat( IsoString( format.Name() ) );
+   }
+
    void Read( int startRow, int channel )
    {
       if ( s_incremental )
-      {
-         startRow += s_roi.y0;
-         if ( !m_file->Read( *m_buffer, startRow, Min( s_bufferRows, s_roi.y1 - startRow ), channel ) )
-            throw CatchedException();
-      }
+         Read( m_buffer, startRow, channel );
       else
          m_currentChannel = channel;
    }
 
+   void Read( FMatrix& buffer, int startRow, int channel )
+   {
+      startRow += s_roi.y0;
+      if ( !m_file->Read( *buffer, startRow, Min( s_bufferRows, s_roi.y1 - startRow ), channel ) )
+         throw CatchedException();
+   }
+
    double KeywordValue( const IsoString& keyName );
 
    template <class S>
@@ -728,6 +905,12 @@ int IntegrationFile::s_numberOfChannels = 0;
 bool IntegrationFile::s_isColor = false;
 bool IntegrationFile::s_incremental = false;
 int IntegrationFile::s_bufferRows = 0;
+bool IntegrationFile::s_threadedReads = false;
+bool IntegrationFile::s_readAhead = false;
+int IntegrationFile::s_readAheadRow = -1;
+int IntegrationFile::s_readAheadChannel = -1;
+IntegrationFile::read_thread_list IntegrationFile::s_readThreads;
+bool IntegrationFile::s_readThreadsRunning = false;
 
 void IntegrationFile::ToDrizzleData( File& f ) const
 {
@@ -823,9 +1006,20 @@ void IntegrationFile::Open( const String& path, const String& drzPath,
 
    m_file = new FileFormatInstance( format );
 
+   /*
+    * A trailing verbosity hint takes precedence over user-defined hints.
+    */
+   String hints = instance->p_inputHints;
+   if ( format.CanReadIncrementally() && CanReadQuietly( format ) )
+   {
+      if ( !hints.IsEmpty() )
+         hints += ' ';
+      hints += "verbosity 0";
+   }
+
    ImageDescriptionArray images;
 
-   if ( !m_file->Open( images, path, instance->p_inputHints ) )
+   if ( !m_file->Open( images, path, hints ) )
       throw CatchedException();
 
    if ( images.IsEmpty() )
@@ -862,13 +1056,31 @@ void IntegrationFile::Open( const String& path, const String& drzPath,
          console.NoteLn( "<end><cbr><br>* Incremental image integration disabled due to lack of file format support: " + format.Name() + "<br>" );
          s_bufferRows = s_roi.Height();
       }
+
+      s_threadedReads = s_incremental && CanReadQuietly( format );
+
+      // Read-ahead is pointless if the whole image fits in a single strip.
+      s_readAhead = s_threadedReads && instance->p_readAheadSizeMB > 0 &&
+                    (s_bufferRows < s_roi.Height() || s_numberOfChannels > 1);
+      s_readAheadRow = s_readAheadChannel = -1;
    }
    else
    {
       if ( s_incremental )
+      {
          if ( !format.CanReadIncrementally() )
             throw Error( "Invalid combination of file formats with and without incremental file read capabilities: " + format.Name() );
 
+         if ( s_threadedReads )
+            if ( !CanReadQuietly( format ) )
+            {
+               console.NoteLn( "<end><cbr>* Parallel file reading disabled due to lack of file format support: " + format.Name() );
+               s_threadedReads = s_readAhead = false;
+               for ( file_list::iterator i = s_files.Begin(); i != s_files.End(); ++i )
+                  (*i)->m_nextBuffer = FMatrix();
+            }
+      }
+
       if ( s_width != images[0].info.width ||
            s_height != images[0].info.height ||
            s_numberOfChannels != images[0].info.numberOfChannels )
@@ -876,7 +1088,25 @@ void IntegrationFile::Open( const String& path, const String& drzPath,
    }
 
    if ( s_incremental )
+   {
       m_buffer = FMatrix( s_bufferRows, s_width );
+
+      /*
+       * Allocate a secondary buffer for asynchronous read-ahead, as long as
+       * the total size of secondary buffers does not exceed the user-defined
+       * limit. Otherwise read-ahead is disabled for all files.
+       */
+      if ( s_readAhead )
+         if ( uint64( s_files.Length() )*s_bufferRows*s_width*sizeof( float ) <= uint64( instance->p_readAheadSizeMB )*1024*1024 )
+            m_nextBuffer = FMatrix( s_bufferRows, s_width );
+         else
+         {
+            console.NoteLn( "<end><cbr>* Asynchronous read-ahead disabled: Read-ahead size limit exceeded." );
+            s_readAhead = false;
+            for ( file_list::iterator i = s_files.Begin(); i != s_files.End(); ++i )
+               (*i)->m_nextBuffer = FMatrix();
+         }
+   }
    else
    {
       m_image = new Image( (void*)0, 0, 0 ); // shared image
@@ -1393,24 +1623,23 @@ class DataLoaderEngine : public ImageIntegrationEngine
 {
 public:
 
-   typedef ImageIntegrationInstance::RejectionDataItem   RejectionDataItem;
-   typedef ImageIntegrationInstance::RejectionMatrix     RejectionMatrix;
+   typedef ImageIntegrationInstance::RejectionStack      RejectionStack;
    typedef ImageIntegrationInstance::RejectionStacks     RejectionStacks;
    typedef ImageIntegrationInstance::RejectionCounts     RejectionCounts;
    typedef ImageIntegrationInstance::RejectionSlopes     RejectionSlopes;
 
    DataLoaderEngine( const ImageIntegrationInstance& aInstance, StatusMonitor& aMonitor,
-                     int ar, RejectionStacks& aR, RejectionCounts& aN, RejectionSlopes& aM ) :
+                     int ar, int an, RejectionStacks& aR, RejectionCounts& aN, RejectionSlopes& aM ) :
    ImageIntegrationEngine( aInstance, aMonitor ),
-   r( ar ), R( aR ), N( aN ), M( aM ), threads()
+   r( ar ), n( an ), R( aR ), N( aN ), M( aM ), threads()
    {
-      int numberOfThreads = Thread::NumberOfThreads( R.Length(), 1 );
-      int stacksPerThread = R.Length()/numberOfThreads;
+      int numberOfThreads = Thread::NumberOfThreads( n, 1 );
+      int stacksPerThread = n/numberOfThreads;
 
       for ( int i = 0; i < numberOfThreads; ++i )
       {
          int k0 = i*stacksPerThread;
-         int k1 = (i == numberOfThreads-1) ? R.Length() : k0+stacksPerThread;
+         int k1 = (i == numberOfThreads-1) ? n : k0+stacksPerThread;
          threads.Add( new DataLoaderThread( *this, k0, k1 ) );
       }
    }
@@ -1424,7 +1653,7 @@ public:
    {
       if ( !threads.IsEmpty() )
       {
-         threadData.total = R.Length();
+         threadData.total = n;
          threadData.count = 0;
          AbstractImage::RunThreads( threads, threadData );
          monitor = threadData.status;
@@ -1453,6 +1682,7 @@ private:
    typedef ReferenceArray<DataLoaderThread> thread_list;
 
    int              r; // starting row
+   int              n; // number of pixel stacks to load
    RejectionStacks& R; // set of pixel stacks
    RejectionCounts& N; // set of counts
    RejectionSlopes& M; // set of slopes, for linear fit clipping only
@@ -1472,23 +1702,45 @@ void DataLoaderEngine::DataLoaderThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int w = IntegrationFile::Width();
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      // Source pixels
-      E.R[k] = RejectionMatrix( IntegrationFile::Width(), IntegrationFile::NumberOfFiles() );
-      for ( int i = 0; i < IntegrationFile::NumberOfFiles(); ++i )
+      // Source pixels. Stack buffers are reused for successive pixel rows.
+      RejectionStack& S = E.R[k];
+      S.Allocate( w, nf );
+      float* value = S.value.Begin();
+      float* raw = S.raw.Begin();
+      for ( int i = 0; i < nf; ++i )
       {
          const float* b = IntegrationFile::FileByIndex( i )[E.r+k];
-         for ( int x = 0; x < IntegrationFile::Width(); ++x )
-            E.R[k][x][i].Set( *b++, i );
+         for ( int x = 0, j = i; x < w; ++x, j += nf )
+         {
+            float v = *b++;
+            value[j] = raw[j] = IsFinite( v ) ? v : .0F;
+         }
       }
+      int* index = S.index.Begin();
+      for ( int x = 0; x < w; ++x )
+         for ( int i = 0; i < nf; ++i )
+            *index++ = i;
+      S.flags = uint8( 0 );
 
       // Pixel counters
-      E.N[k] = IVector( IntegrationFile::NumberOfFiles(), IntegrationFile::Width() );
+      if ( E.N[k].Length() != w )
+         E.N[k] = IVector( nf, w );
+      else
+         E.N[k] = nf;
 
       // Rejection slopes for the linear fit clipping algorithm
       if ( I.p_rejection == IIRejection::LinearFit )
-         E.M[k] = FVector( .0F, IntegrationFile::Width() );
+      {
+         if ( E.M[k].Length() != w )
+            E.M[k] = FVector( .0F, w );
+         else
+            E.M[k] = .0F;
+      }
 
       UPDATE_THREAD_MONITOR( 10 )
    }
@@ -1497,30 +1749,29 @@ void DataLoaderEngine::DataLoaderThread::Run()
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
 
-class RejectionEngine : public ImageIntegrationEngine
+class RejectionEngine : public ImageIntegrationEngine, public RejectionKernels
 {
 public:
 
-   typedef ImageIntegrationInstance::RejectionDataItem   RejectionDataItem;
-   typedef ImageIntegrationInstance::RejectionMatrix     RejectionMatrix;
+   typedef ImageIntegrationInstance::RejectionStack      RejectionStack;
    typedef ImageIntegrationInstance::RejectionStacks     RejectionStacks;
    typedef ImageIntegrationInstance::RejectionCounts     RejectionCounts;
    typedef ImageIntegrationInstance::RejectionSlopes     RejectionSlopes;
 
    RejectionEngine( const ImageIntegrationInstance& aInstance, StatusMonitor& aMonitor,
-                    RejectionStacks& aR, RejectionCounts& aN, RejectionSlopes& aM,
+                    int an, RejectionStacks& aR, RejectionCounts& aN, RejectionSlopes& aM,
                     const DVector& am, const DVector& as, const DVector& aq ) :
    ImageIntegrationEngine( aInstance, aMonitor ),
-   R( aR ), N( aN ), M( aM ), m( am ), s( as ), q( aq ),
+   n( an ), R( aR ), N( aN ), M( aM ), m( am ), s( as ), q( aq ),
    rangeThreads(), normalizeThreads(), rejectThreads(), threadPrivate( 0 )
    {
-      int numberOfThreads = Thread::NumberOfThreads( R.Length(), 1 );
-      int stacksPerThread = R.Length()/numberOfThreads;
+      int numberOfThreads = Thread::NumberOfThreads( n, 1 );
+      int stacksPerThread = n/numberOfThreads;
 
       for ( int i = 0; i < numberOfThreads; ++i )
       {
          int k0 = i*stacksPerThread;
-         int k1 = (i == numberOfThreads-1) ? R.Length() : k0+stacksPerThread;
+         int k1 = (i == numberOfThreads-1) ? n : k0+stacksPerThread;
 
          if ( instance.p_rejection != IIRejection::NoRejection )
             normalizeThreads.Add( new NormalizationThread( *this, k0, k1 ) );
@@ -1570,7 +1821,7 @@ public:
    {
       if ( !normalizeThreads.IsEmpty() )
       {
-         threadData.total = R.Length();
+         threadData.total = n;
          threadData.count = 0;
          AbstractImage::RunThreads( normalizeThreads, threadData );
          monitor = threadData.status;
@@ -1581,7 +1832,7 @@ public:
    {
       if ( !rangeThreads.IsEmpty() )
       {
-         threadData.total = R.Length();
+         threadData.total = n;
          threadData.count = 0;
          AbstractImage::RunThreads( rangeThreads, threadData );
          monitor = threadData.status;
@@ -1595,7 +1846,7 @@ public:
          for ( size_type i = 0; i < rejectThreads.Length(); ++i )
             rejectThreads[i].PreRun();
 
-         threadData.total = R.Length();
+         threadData.total = n;
          threadData.count = 0;
          AbstractImage::RunThreads( rejectThreads, threadData );
          monitor = threadData.status;
@@ -1605,87 +1856,15 @@ public:
       }
    }
 
-   static double RejectionMedian( const RejectionDataItem* r, int n )
-   {
-      // NB: Assume that {r0...rn} is already sorted by value.
-      if ( n < 2 )
-         return 0;
-      int n2 = n >> 1;
-      return (n & 1) ? r[n2].value : (r[n2].value + r[n2-1].value)/2;
-   }
-
-   static double RejectionSigma( const RejectionDataItem* r, int n )
-   {
-      if ( n < 2 )
-         return 0;
-      double mean = 0;
-      for ( int i = 0; i < n; ++i )
-         mean += r[i].value;
-      mean /= n;
-      double var = 0, eps = 0;
-      for ( int i = 0; i < n; ++i )
-      {
-         double d = r[i].value - mean;
-         var += d*d;
-         eps += d;
-      }
-      return Sqrt( (var - (eps*eps)/n)/(n - 1) );
-   }
-
-   static double RejectionADev( const RejectionDataItem* r, int n, double median )
-   {
-      if ( n < 2 )
-         return 0;
-      double sd = 0;
-      for ( int i = 0; i < n; ++i )
-         sd += Abs( r[i].value - median );
-      return sd/n;
-   }
-
-   static double RejectionMAD( const RejectionDataItem* r, int n, double median )
+   /*
+    * Rejects low and high pixels from the window [lo,hi) of a sorted pixel
+    * stack, according to the low and high clipping options of the instance.
+    */
+   bool ClipStack( int& lo, int& hi, const float* v, const int* ix, uint8* f,
+                   double center, double sigma, double kLow, double kHigh ) const
    {
-      if ( n < 2 )
-         return 0;
-      DVector d( n );
-      for ( int i = 0; i < n; ++i )
-         d[i] = r[i].value - median;
-      return pcl::Median( d.Begin(), d.End() );
-   }
-
-   static void RejectionWinsorization( double& mean, double& sigma, const RejectionDataItem* r, int n )
-   {
-      if ( n < 2 )
-      {
-         mean = sigma = 0;
-         return;
-      }
-
-      mean = RejectionMedian( r, n );
-      sigma = RejectionSigma( r, n );
-
-      DVector v( n );
-      for ( int i = 0; i < n; ++i )
-         v[i] = r[i].value;
-
-      for ( int it = 0; ; )
-      {
-         if ( 1 + sigma == 1 )
-            break;
-
-         double t0 = mean - 1.5*sigma;
-         double t1 = mean + 1.5*sigma;
-
-         for ( int i = 0; i < n; ++i )
-            if ( v[i] < t0 )
-               v[i] = t0;
-            else if ( v[i] > t1 )
-               v[i] = t1;
-
-         double s0 = sigma;
-         sigma = 1.134*v.StdDev();
-         if ( ++it > 1 && Abs( s0 - sigma )/s0 < 0.0005 )
-            break;
-      }
+      return RejectionKernels::ClipStack( lo, hi, v, ix, f, center, sigma, kLow, kHigh,
+                                          instance.p_clipLow, instance.p_clipHigh );
    }
 
 private:
@@ -1709,7 +1888,8 @@ private:
 
       RejectionThread( RejectionEngine& engine, int firstStack, int endStack ) :
       EngineThread( engine, firstStack, endStack ),
-      m_engine( engine )
+      m_engine( engine ),
+      m_buffer( IntegrationFile::NumberOfFiles() )
       {
       }
 
@@ -1739,6 +1919,7 @@ private:
    protected:
 
       RejectionEngine& m_engine;
+      stack_buffer     m_buffer;   // working storage for SortStack()
    };
 
    typedef ReferenceArray<RejectionThread> thread_list;
@@ -1837,7 +2018,7 @@ private:
          Array<DVector> m;
          Array<DVector> s;
 
-         RejectionData( RejectionStacks&, RejectionCounts& );
+         RejectionData( RejectionStacks&, RejectionCounts&, int );
       };
    };
 
@@ -1878,6 +2059,7 @@ private:
       };
    };
 
+         int              n; // number of pixel stacks
          RejectionStacks& R; // set of pixel stacks
          RejectionCounts& N; // set of counts
          RejectionSlopes& M; // set of slopes, for linear fit clipping only
@@ -1909,32 +2091,40 @@ void RejectionEngine::RangeRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 1 )
             continue;
 
-         RejectionDataItem* r = R.DataPtr()[i];
-
-         // ### Do not change the order in the stack of pixels here (i.e. do not
-         //     sort them). Pixels are required in file order for rejection
-         //     normalization, which takes place AFTER range rejection.
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         uint8* f = S.flags.Begin() + size_type( x )*nf;
 
+         // Flag out-of-range pixels and move them to the end of the stack.
+         // The order of non-rejected pixels is preserved.
          // Note that the sets of low and high out-of-range pixels are disjoint.
-         // For this reason we can accumulate a single rejection counter (nr).
          int nr = 0;
          for ( int j = 0; j < n; ++j )
-            if ( I.p_rangeClipLow && r[j].value <= I.p_rangeLow )
-               r[j].rejectRangeLow = true, ++nr;
-            else if ( I.p_rangeClipHigh && r[j].value >= I.p_rangeHigh )
-               r[j].rejectRangeHigh = true, ++nr;
-         N.DataPtr()[i] -= nr;
+         {
+            if ( I.p_rangeClipLow && v[j] <= I.p_rangeLow )
+               f[ix[j]] |= RejectionStack::RejectRangeLow, ++nr;
+            else if ( I.p_rangeClipHigh && v[j] >= I.p_rangeHigh )
+               f[ix[j]] |= RejectionStack::RejectRangeHigh, ++nr;
+            else if ( nr > 0 )
+            {
+               v[j-nr] = v[j];
+               ix[j-nr] = ix[j];
+            }
+         }
+         N.DataPtr()[x] -= nr;
       }
 
       UPDATE_THREAD_MONITOR( 10 )
@@ -1947,9 +2137,14 @@ void RejectionEngine::NormalizationThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
+      const IVector& N = E.N[k];
+
+      // Pixels of the reference image (file index = 0) are not normalized.
 
       switch ( I.p_rejectionNormalization )
       {
@@ -1965,25 +2160,25 @@ void RejectionEngine::NormalizationThread::Run()
             const DVector& s = E.s;
 
             float rmin = 0;
-            for ( int x = 0; x < R.Rows(); ++x )
+            for ( int x = 0; x < N.Length(); ++x )
             {
-               RejectionDataItem* r = R[x] + 1;
-               for ( int i = 1; i < R.Columns(); ++i, ++r )
-                  if ( !r->IsRejected() )
+               float* v = S.value.Begin() + size_type( x )*nf;
+               const int* ix = S.index.Begin() + size_type( x )*nf;
+               for ( int j = 0, n = N[x]; j < n; ++j )
+                  if ( ix[j] != 0 )
                   {
-                     r->value = (r->value - m[i])*s[i] + m[0];
-                     if ( r->value < rmin )
-                        rmin = r->value;
+                     v[j] = (v[j] - m[ix[j]])*s[ix[j]] + m[0];
+                     if ( v[j] < rmin )
+                        rmin = v[j];
                   }
             }
 
             if ( rmin < 0 )
-               for ( int x = 0; x < R.Rows(); ++x )
+               for ( int x = 0; x < N.Length(); ++x )
                {
-                  RejectionDataItem* r = R[x];
-                  for ( int i = 0; i < R.Columns(); ++i, ++r )
-                     if ( !r->IsRejected() )
-                        r->value -= rmin;
+                  float* v = S.value.Begin() + size_type( x )*nf;
+                  for ( int j = 0, n = N[x]; j < n; ++j )
+                     v[j] -= rmin;
                }
          }
          break;
@@ -1994,12 +2189,13 @@ void RejectionEngine::NormalizationThread::Run()
 
             const DVector& q = E.q;
 
-            for ( int x = 0; x < R.Rows(); ++x )
+            for ( int x = 0; x < N.Length(); ++x )
             {
-               RejectionDataItem* r = R[x] + 1;
-               for ( int i = 1; i < R.Columns(); ++i, ++r )
-                  if ( !r->IsRejected() )
-                     r->value *= q[i];
+               float* v = S.value.Begin() + size_type( x )*nf;
+               const int* ix = S.index.Begin() + size_type( x )*nf;
+               for ( int j = 0, n = N[x]; j < n; ++j )
+                  if ( ix[j] != 0 )
+                     v[j] *= q[ix[j]];
             }
          }
          break;
@@ -2014,18 +2210,26 @@ void RejectionEngine::NormalizationThread::Run()
 
 // ----------------------------------------------------------------------------
 
+/*
+ * All rejection algorithms sort each pixel stack only once. Rejected pixels
+ * are excluded by shrinking a window [lo,hi) of non-rejected pixels, which
+ * remain sorted, and the final window is moved to the beginning of the stack.
+ */
+
 void RejectionEngine::MinMaxRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 1 )
             continue;
 
@@ -2034,16 +2238,17 @@ void RejectionEngine::MinMaxRejectionThread::Run()
 
          if ( nl > 0 || nh > 0 )
          {
-            RejectionDataItem* r = R.DataPtr()[i];
-            Sort( r, r + n );
+            float* v = S.value.Begin() + size_type( x )*nf;
+            int* ix = S.index.Begin() + size_type( x )*nf;
+            uint8* f = S.flags.Begin() + size_type( x )*nf;
+            SortStack( v, ix, n, m_buffer.Begin() );
 
             for ( int j = 0; j < nl; ++j )
-               r[j].rejectLow = true;
-            for ( int j = n, nj = nh; nj > 0; --nj )
-               r[--j].rejectHigh = true;
+               f[ix[j]] |= RejectionStack::RejectLow;
+            for ( int j = n-nh; j < n; ++j )
+               f[ix[j]] |= RejectionStack::RejectHigh;
 
-            Sort( r, r + n );
-            N.DataPtr()[i] -= Min( n, nl+nh );
+            N.DataPtr()[x] = CloseWindow( v, ix, nl, n-nh );
          }
       }
 
@@ -2057,47 +2262,31 @@ void RejectionEngine::PercentileClipRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 2 )
             continue;
 
-         RejectionDataItem* r = R.DataPtr()[i];
-         Sort( r, r + n );
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         uint8* f = S.flags.Begin() + size_type( x )*nf;
+         SortStack( v, ix, n, m_buffer.Begin() );
 
-         double median = E.RejectionMedian( r, n );
+         double median = E.RejectionMedian( v, n );
          if ( 1 + median == 1 )
             continue;
 
-         int nc = 0;
-
-         if ( I.p_clipLow )
-            for ( RejectionDataItem* d = r, * d1 = r + n; d < d1; ++d )
-            {
-               if ( (median - d->value)/median <= I.p_pcClipLow )
-                  break;
-               d->rejectLow = true, ++nc;
-            }
-
-         if ( I.p_clipHigh )
-            for ( RejectionDataItem* d = r + n; --d >= r; )
-            {
-               if ( (d->value - median)/median <= I.p_pcClipHigh )
-                  break;
-               d->rejectHigh = true, ++nc;
-            }
-
-         if ( nc > 0 )
-         {
-            Sort( r, r + n );
-            N.DataPtr()[i] -= nc;
-         }
+         int lo = 0, hi = n;
+         if ( E.ClipStack( lo, hi, v, ix, f, median, median, I.p_pcClipLow, I.p_pcClipHigh ) )
+            N.DataPtr()[x] = CloseWindow( v, ix, lo, hi );
       }
 
       UPDATE_THREAD_MONITOR( 10 )
@@ -2110,57 +2299,28 @@ void RejectionEngine::SigmaClipRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 3 )
             continue;
 
-         RejectionDataItem* r = R.DataPtr()[i];
-         Sort( r, r + n );
-
-         for ( ;; )
-         {
-            double sigma = E.RejectionSigma( r, n );
-            if ( 1 + sigma == 1 )
-               break;
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         uint8* f = S.flags.Begin() + size_type( x )*nf;
+         SortStack( v, ix, n, m_buffer.Begin() );
 
-            double median = E.RejectionMedian( r, n );
+         int lo, hi;
+         SigmaClip( lo, hi, v, ix, f, n, I.p_sigmaLow, I.p_sigmaHigh, I.p_clipLow, I.p_clipHigh );
 
-            int nc = 0;
-
-            if ( I.p_clipLow )
-               for ( RejectionDataItem* d = r, * d1 = r + n; d < d1; ++d )
-               {
-                  if ( (median - d->value)/sigma <= I.p_sigmaLow )
-                     break;
-                  d->rejectLow = true, ++nc;
-               }
-
-            if ( I.p_clipHigh )
-               for ( RejectionDataItem* d = r + n; --d >= r; )
-               {
-                  if ( (d->value - median)/sigma <= I.p_sigmaHigh )
-                     break;
-                  d->rejectHigh = true, ++nc;
-               }
-
-            if ( nc == 0 )
-               break;
-
-            Sort( r, r + n );
-
-            n -= nc;
-            if ( n < 3 )
-               break;
-         }
-
-         N.DataPtr()[i] = n;
+         N.DataPtr()[x] = CloseWindow( v, ix, lo, hi );
       }
 
       UPDATE_THREAD_MONITOR( 10 )
@@ -2173,56 +2333,40 @@ void RejectionEngine::WinsorizedSigmaClipRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 3 )
             continue;
 
-         RejectionDataItem* r = R.DataPtr()[i];
-         Sort( r, r + n );
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         uint8* f = S.flags.Begin() + size_type( x )*nf;
+         SortStack( v, ix, n, m_buffer.Begin() );
 
+         int lo = 0, hi = n;
          for ( ;; )
          {
             double mean, sigma;
-            RejectionWinsorization( mean, sigma, r, n );
+            RejectionWinsorization( mean, sigma, v+lo, hi-lo );
             if ( 1 + sigma == 1 )
                break;
 
-            int nc = 0;
-
-            if ( I.p_clipLow )
-               for ( RejectionDataItem* d = r, * d1 = r + n; d < d1; ++d )
-               {
-                  if ( (mean - d->value)/sigma <= I.p_sigmaLow )
-                     break;
-                  d->rejectLow = true, ++nc;
-               }
-
-            if ( I.p_clipHigh )
-               for ( RejectionDataItem* d = r + n; --d >= r; )
-               {
-                  if ( (d->value - mean)/sigma <= I.p_sigmaHigh )
-                     break;
-                  d->rejectHigh = true, ++nc;
-               }
-
-            if ( nc == 0 )
+            if ( !E.ClipStack( lo, hi, v, ix, f, mean, sigma, I.p_sigmaLow, I.p_sigmaHigh ) )
                break;
 
-            Sort( r, r + n );
-
-            n -= nc;
-            if ( n < 3 )
+            if ( hi-lo < 3 )
                break;
          }
 
-         N.DataPtr()[i] = n;
+         N.DataPtr()[x] = CloseWindow( v, ix, lo, hi );
       }
 
       UPDATE_THREAD_MONITOR( 10 )
@@ -2232,45 +2376,49 @@ void RejectionEngine::WinsorizedSigmaClipRejectionThread::Run()
 // ----------------------------------------------------------------------------
 
 RejectionEngine::AveragedSigmaClipRejectionThread::RejectionData::RejectionData(
-                                    RejectionStacks& aR, RejectionCounts& aN ) :
-RejectionEngine::RejectionThreadPrivate(), m( aR.Length() ), s( aR.Length() )
+                                    RejectionStacks& aR, RejectionCounts& aN, int numberOfStacks ) :
+RejectionEngine::RejectionThreadPrivate(), m( numberOfStacks ), s( numberOfStacks )
 {
-   for ( int k = 0; k < aR.Length(); ++k )
+   int nf = IntegrationFile::NumberOfFiles();
+   stack_buffer buffer( nf );
+
+   for ( int k = 0; k < numberOfStacks; ++k )
    {
-      RejectionMatrix& R = aR[k];
+      RejectionStack& S = aR[k];
       IVector& N = aN[k];
 
-      m[k] = DVector( R.Rows() );
-      s[k] = DVector( R.Rows() );
+      m[k] = DVector( N.Length() );
+      s[k] = DVector( N.Length() );
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 3 )
          {
-            m[k][i] = s[k][i] = .0F;
+            m[k][x] = s[k][x] = .0F;
             continue;
          }
 
-         RejectionDataItem* r = R.DataPtr()[i];
-         Sort( r, r + n );
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         SortStack( v, ix, n, buffer.Begin() );
 
-         double median = m[k][i] = RejectionEngine::RejectionMedian( r, n );
+         double median = m[k][x] = RejectionEngine::RejectionMedian( v, n );
          if ( 1 + median != 1 )
          {
             double acc = 0;
             for ( int j = 0; j < n; ++j )
             {
-               double d = r[j].value - median;
+               double d = v[j] - median;
                acc += d*d/median;
             }
 
-            s[k][i] = Sqrt( acc/(n - 1) );
+            s[k][x] = Sqrt( acc/(n - 1) );
          }
          else
          {
-            s[k][i] = m[k][i] = 0;
-            N.DataPtr()[i] = 0;
+            s[k][x] = m[k][x] = 0;
+            N.DataPtr()[x] = 0;
          }
       }
    }
@@ -2279,67 +2427,52 @@ RejectionEngine::RejectionThreadPrivate(), m( aR.Length() ), s( aR.Length() )
 void RejectionEngine::AveragedSigmaClipRejectionThread::PreRun()
 {
    if ( E.threadPrivate == 0 )
-      E.threadPrivate = new RejectionData( E.R, E.N );
+      E.threadPrivate = new RejectionData( E.R, E.N, E.n );
 }
 
 void RejectionEngine::AveragedSigmaClipRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
       const DVector& m = P->m[k];
       const DVector& s = P->s[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 3 )
             continue;
 
-         RejectionDataItem* r = R.DataPtr()[i];
+         // Stacks have already been sorted by RejectionData's constructor.
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         uint8* f = S.flags.Begin() + size_type( x )*nf;
 
-         double median = m[i];
+         double median = m[x];
 
+         int lo = 0, hi = n;
          for ( ;; )
          {
-            double sigma = s[i] * Sqrt( median );
+            double sigma = s[x] * Sqrt( median );
             if ( 1 + sigma == 1 )
                break;
 
-            int nc = 0;
-
-            if ( I.p_clipLow )
-               for ( RejectionDataItem* d = r, * d1 = r + n; d < d1; ++d )
-               {
-                  if ( (median - d->value)/sigma <= I.p_sigmaLow )
-                     break;
-                  d->rejectLow = true, ++nc;
-               }
-
-            if ( I.p_clipHigh )
-               for ( RejectionDataItem* d = r + n; --d >= r; )
-               {
-                  if ( (d->value - median)/sigma <= I.p_sigmaHigh )
-                     break;
-                  d->rejectHigh = true, ++nc;
-               }
-
-            if ( nc == 0 )
+            if ( !E.ClipStack( lo, hi, v, ix, f, median, sigma, I.p_sigmaLow, I.p_sigmaHigh ) )
                break;
 
-            Sort( r, r + n );
-
-            n -= nc;
-            if ( n < 3 )
+            if ( hi-lo < 3 )
                break;
 
-            median = E.RejectionMedian( r, n );
+            median = E.RejectionMedian( v+lo, hi-lo );
          }
 
-         N.DataPtr()[i] = n;
+         N.DataPtr()[x] = CloseWindow( v, ix, lo, hi );
       }
 
       UPDATE_THREAD_MONITOR( 10 )
@@ -2358,34 +2491,38 @@ void RejectionEngine::LinearFitRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
       FVector& M = E.M[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 5 )
             continue;
 
-         RejectionDataItem* r = R.DataPtr()[i];
-         Sort( r, r + n );
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         uint8* f = S.flags.Begin() + size_type( x )*nf;
+         SortStack( v, ix, n, m_buffer.Begin() );
 
          for ( ;; )
          {
             FVector X( n ), Y( n );
             for ( int j = 0; j < n; ++j )
-               X[j] = float( j ), Y[j] = r[j].value;
+               X[j] = float( j ), Y[j] = v[j];
 
             LinearFit L( X, Y );
             if ( !L.IsValid() )
             {
-               for ( RejectionDataItem* d = r, * d1 = r + n; d < d1; ++d )
-                  d->rejectLow = d->rejectHigh = true;
-               N.DataPtr()[i] = 0;
-               M.DataPtr()[i] = 0;
+               for ( int j = 0; j < n; ++j )
+                  f[ix[j]] |= RejectionStack::RejectLow | RejectionStack::RejectHigh;
+               n = 0;
+               M.DataPtr()[x] = 0;
                break;
             }
 
@@ -2393,22 +2530,36 @@ void RejectionEngine::LinearFitRejectionThread::Run()
             if ( 1 + sigma == 1 )
                break;
 
+            // Rejected pixels can be located anywhere in the stack. Remove
+            // them preserving the order of non-rejected pixels.
             int nc = 0;
             for ( int j = 0; j < n; ++j )
             {
                double y = L( j );
 
-               if ( r[j].value < y )
+               if ( v[j] < y )
                {
                   if ( I.p_clipLow )
-                     if ( (y - r[j].value)/sigma >= I.p_linearFitLow )
-                        r[j].rejectLow = true, ++nc;
+                     if ( (y - v[j])/sigma >= I.p_linearFitLow )
+                     {
+                        f[ix[j]] |= RejectionStack::RejectLow, ++nc;
+                        continue;
+                     }
                }
                else
                {
                   if ( I.p_clipHigh )
-                     if ( (r[j].value - y)/sigma >= I.p_linearFitHigh )
-                        r[j].rejectHigh = true, ++nc;
+                     if ( (v[j] - y)/sigma >= I.p_linearFitHigh )
+                     {
+                        f[ix[j]] |= RejectionStack::RejectHigh, ++nc;
+                        continue;
+                     }
+               }
+
+               if ( nc > 0 )
+               {
+                  v[j-nc] = v[j];
+                  ix[j-nc] = ix[j];
                }
             }
 
@@ -2419,18 +2570,16 @@ void RejectionEngine::LinearFitRejectionThread::Run()
                 * number because of roundoff - do not propagate it. See bug
                 * report: http://pixinsight.com/forum/index.php?topic=8704.0
                 */
-               M.DataPtr()[i] = (L.b > 0) ? ((L.b < 1e7) ? ArcTan( L.b )/Const<double>::pi4() : 1.0) : 0.0;
+               M.DataPtr()[x] = (L.b > 0) ? ((L.b < 1e7) ? ArcTan( L.b )/Const<double>::pi4() : 1.0) : 0.0;
                break;
             }
 
-            Sort( r, r + n );
-
             n -= nc;
             if ( n < 3 )
                break;
          }
 
-         N.DataPtr()[i] = n;
+         N.DataPtr()[x] = n;
       }
 
       UPDATE_THREAD_MONITOR( 10 )
@@ -2465,23 +2614,28 @@ void RejectionEngine::CCDClipRejectionThread::Run()
 {
    INIT_THREAD_MONITOR()
 
+   int nf = IntegrationFile::NumberOfFiles();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      RejectionStack& S = E.R[k];
       IVector& N = E.N[k];
 
-      for ( int i = 0; i < R.Rows(); ++i )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         int n = N[i];
+         int n = N[x];
          if ( n < 2 )
             continue;
 
-         RejectionDataItem* r = R.DataPtr()[i];
-         Sort( r, r + n );
+         float* v = S.value.Begin() + size_type( x )*nf;
+         int* ix = S.index.Begin() + size_type( x )*nf;
+         uint8* f = S.flags.Begin() + size_type( x )*nf;
+         SortStack( v, ix, n, m_buffer.Begin() );
 
+         int lo = 0, hi = n;
          for ( ;; )
          {
-            double median = E.RejectionMedian( r, n );
+            double median = E.RejectionMedian( v+lo, hi-lo );
             double sigma = P->r2g2 + P->gk*median;
             if ( P->isScaleNoise )
                sigma += P->sn2*median*median;
@@ -2493,35 +2647,14 @@ void RejectionEngine::CCDClipRejectionThread::Run()
                                    + ccdScaleNoise*ccdScaleNoise*DN*DN)/65535 );
             */
 
-            int nc = 0;
-
-            if ( I.p_clipLow )
-               for ( RejectionDataItem* d = r, * d1 = r + n; d < d1; ++d )
-               {
-                  if ( (median - d->value)/sigma <= I.p_sigmaLow )
-                     break;
-                  d->rejectLow = true, ++nc;
-               }
-
-            if ( I.p_clipHigh )
-               for ( RejectionDataItem* d = r + n; --d >= r; )
-               {
-                  if ( (d->value - median)/sigma <= I.p_sigmaHigh )
-                     break;
-                  d->rejectHigh = true, ++nc;
-               }
-
-            if ( nc == 0 )
+            if ( !E.ClipStack( lo, hi, v, ix, f, median, sigma, I.p_sigmaLow, I.p_sigmaHigh ) )
                break;
 
-            Sort( r, r + n );
-
-            n -= nc;
-            if ( n < 2 )
+            if ( hi-lo < 2 )
                break;
          }
 
-         N.DataPtr()[i] = n;
+         N.DataPtr()[x] = CloseWindow( v, ix, lo, hi );
       }
 
       UPDATE_THREAD_MONITOR( 10 )
@@ -2539,28 +2672,27 @@ class IntegrationEngine : public ImageIntegrationEngine
 {
 public:
 
-   typedef ImageIntegrationInstance::RejectionDataItem   RejectionDataItem;
-   typedef ImageIntegrationInstance::RejectionMatrix     RejectionMatrix;
+   typedef ImageIntegrationInstance::RejectionStack      RejectionStack;
    typedef ImageIntegrationInstance::RejectionStacks     RejectionStacks;
    typedef ImageIntegrationInstance::RejectionCounts     RejectionCounts;
    typedef ImageIntegrationInstance::RejectionSlopes     RejectionSlopes;
 
    IntegrationEngine( const ImageIntegrationInstance& aInstance, StatusMonitor& aMonitor,
-                      int c, RejectionStacks& aR, const RejectionCounts& aN,
+                      int c, int an, const RejectionStacks& aR, const RejectionCounts& aN,
                       const DVector& ad, DVector& am, const DVector& as,
                       float* aResult32, double* aResult64 ) :
    ImageIntegrationEngine( aInstance, aMonitor ),
-   chn( c ), R( aR ), N( aN ), d( ad ), m( am ), s( as ),
+   chn( c ), n( an ), R( aR ), N( aN ), d( ad ), m( am ), s( as ),
    result32( aResult32 ), result64( aResult64 ),
    threads()
    {
-      int numberOfThreads = Thread::NumberOfThreads( R.Length(), 1 );
-      int stacksPerThread = R.Length()/numberOfThreads;
+      int numberOfThreads = Thread::NumberOfThreads( n, 1 );
+      int stacksPerThread = n/numberOfThreads;
 
       for ( int i = 0; i < numberOfThreads; ++i )
       {
          int k0 = i*stacksPerThread;
-         int k1 = (i == numberOfThreads-1) ? R.Length() : k0+stacksPerThread;
+         int k1 = (i == numberOfThreads-1) ? n : k0+stacksPerThread;
          threads.Add( new IntegrationThread( *this, k0, k1 ) );
       }
    }
@@ -2574,7 +2706,7 @@ public:
    {
       if ( !threads.IsEmpty() )
       {
-         threadData.total = R.Length();
+         threadData.total = n;
          threadData.count = 0;
          AbstractImage::RunThreads( threads, threadData );
          monitor = threadData.status;
@@ -2603,7 +2735,8 @@ private:
    typedef ReferenceArray<IntegrationThread> thread_list;
 
          int              chn; // current channel
-         RejectionStacks& R;   // set of pixel stacks
+         int              n;   // number of pixel stacks
+   const RejectionStacks& R;   // set of pixel stacks
    const RejectionCounts& N;   // set of counts
    const DVector&         d;   // normalization: zero offset
    const DVector&         m;   //              : median
@@ -2628,14 +2761,24 @@ void IntegrationEngine::IntegrationThread::Run()
    else
       result32 = E.result32 + m_firstStack*IntegrationFile::Width();
 
+   int nf = IntegrationFile::NumberOfFiles();
+
+   // Working storage for (normalized) raw pixel values and file indices
+   FVector buffer( nf );
+   IVector fileIndex( nf );
+   for ( int i = 0; i < nf; ++i )
+      fileIndex[i] = i;
+   float* r = buffer.Begin();
+
    for ( int k = m_firstStack; k < m_endStack; ++k )
    {
-      RejectionMatrix& R = E.R[k];
+      const RejectionStack& S = E.R[k];
       const IVector& N = E.N[k];
 
-      for ( int x = 0; x < R.Rows(); ++x )
+      for ( int x = 0; x < N.Length(); ++x )
       {
-         RejectionDataItem* r = R[x];
+         const float* raw = S.raw.Begin() + size_type( x )*nf;
+         const int* ix = S.index.Begin() + size_type( x )*nf;
          double f;
          int n = N[x];
 
@@ -2644,10 +2787,14 @@ void IntegrationEngine::IntegrationThread::Run()
          {
             // If all pixels have been rejected, take the median as
             // the final pixel value for this stack.
-            n = IntegrationFile::NumberOfFiles();
+            n = nf;
+            ix = fileIndex.Begin();
             thisCombination = IICombination::Median;
          }
 
+         for ( int i = 0; i < n; ++i )
+            r[i] = raw[ix[i]];
+
          const DVector& d = E.d;
          const DVector& m = E.m;
          const DVector& s = E.s;
@@ -2660,19 +2807,19 @@ void IntegrationEngine::IntegrationThread::Run()
          default:
          case IINormalization::Additive:
             for ( int i = 0; i < n; ++i )
-               r[i].raw += d[r[i].index];
+               r[i] += d[ix[i]];
             break;
          case IINormalization::Multiplicative:
             for ( int i = 0; i < n; ++i )
-               r[i].raw *= d[r[i].index];
+               r[i] *= d[ix[i]];
             break;
          case IINormalization::AdditiveWithScaling:
             for ( int i = 0; i < n; ++i )
-               r[i].raw = (double( r[i].raw ) - m[r[i].index])*s[r[i].index] + m[0];
+               r[i] = (double( r[i] ) - m[ix[i]])*s[ix[i]] + m[0];
             break;
          case IINormalization::MultiplicativeWithScaling:
             for ( int i = 0; i < n; ++i )
-               r[i].raw = (double( r[i].raw ) / m[r[i].index])*s[r[i].index] * m[0];
+               r[i] = (double( r[i] ) / m[ix[i]])*s[ix[i]] * m[0];
             break;
          }
 
@@ -2685,17 +2832,17 @@ void IntegrationEngine::IntegrationThread::Run()
                f = 0;
                if ( I.p_weightMode == IIWeightMode::DontCare )
                {
-                  for ( int i = 0; i < n; ++i, ++r )
-                     f += r->raw;
+                  for ( int i = 0; i < n; ++i )
+                     f += r[i];
                   f /= n;
                }
                else
                {
                   double ws = 0;
-                  for ( int i = 0; i < n; ++i, ++r )
+                  for ( int i = 0; i < n; ++i )
                   {
-                     double w = IntegrationFile::FileByIndex( r->index ).Weight( E.chn );
-                     f += w*r->raw;
+                     double w = IntegrationFile::FileByIndex( ix[i] ).Weight( E.chn );
+                     f += w*r[i];
                      ws += w;
                   }
                   f /= ws;
@@ -2706,7 +2853,7 @@ void IntegrationEngine::IntegrationThread::Run()
          case IICombination::Median:
          case IICombination::Minimum:
          case IICombination::Maximum:
-            Sort( R[x], R[x]+n, RejectionDataItem::CompareRaw );
+            Sort( r, r+n );
             switch ( thisCombination )
             {
             default:
@@ -2714,16 +2861,16 @@ void IntegrationEngine::IntegrationThread::Run()
                {
                   int n2 = n >> 1;
                   if ( n & 1 )
-                     f = r[n2].raw;
+                     f = r[n2];
                   else
-                     f = 0.5*(r[n2].raw + r[n2-1].raw);
+                     f = 0.5*(r[n2] + r[n2-1]);
                }
                break;
             case IICombination::Minimum:
-               f = r[0].raw;
+               f = r[0];
                break;
             case IICombination::Maximum:
-               f = r[n-1].raw;
+               f = r[n-1];
                break;
             }
             break;
@@ -3014,7 +3161,7 @@ bool ImageIntegrationInstance::ExecuteGlobal()
       int totalStacks;
       {
          size_type stackSize = size_type( IntegrationFile::Width() ) * (
-                                    IntegrationFile::NumberOfFiles()*sizeof( RejectionDataItem )
+                                    IntegrationFile::NumberOfFiles()*(2*sizeof( float ) + sizeof( int ) + sizeof( uint8 ))
                                   + sizeof( int )
                                   + ((p_rejection == IIRejection::LinearFit) ? sizeof( float ) : 0) );
          size_type stackBufferSize = p_stackSizeMB;
@@ -3029,6 +3176,13 @@ bool ImageIntegrationInstance::ExecuteGlobal()
 
       o_output.imageData.Add( OutputData::ImageData(), IntegrationFile::NumberOfFiles() );
 
+      // Pixel stack buffers, reused for all channels and pixel rows.
+      RejectionStacks stacks( totalStacks );
+      RejectionCounts counts( totalStacks );
+      RejectionSlopes slopes;
+      if ( p_rejection == IIRejection::LinearFit )
+         slopes = RejectionSlopes( totalStacks );
+
       // For each channel
       for ( int c = 0; c < IntegrationFile::NumberOfChannels(); ++c )
       {
@@ -3150,23 +3304,16 @@ bool ImageIntegrationInstance::ExecuteGlobal()
                if ( console.AbortRequested() )
                   throw ProcessAborted();
 
-               RejectionStacks stacks( numberOfStacks );
-               RejectionCounts counts( numberOfStacks );
-               RejectionSlopes slopes;
-               if ( p_rejection == IIRejection::LinearFit )
-                  slopes = RejectionSlopes( numberOfStacks );
-
-               DataLoaderEngine( *this, monitor, r, stacks, counts, slopes ).LoadData();
+               DataLoaderEngine( *this, monitor, r, numberOfStacks, stacks, counts, slopes ).LoadData();
 
                // Perform pixel rejection
                if ( doReject )
                {
-                  RejectionEngine rejector( *this, monitor, stacks, counts, slopes, m, s, q );
+                  RejectionEngine rejector( *this, monitor, numberOfStacks, stacks, counts, slopes, m, s, q );
 
                   // Range rejection must be done in first place to exclude
-                  // all out-of-range pixels.
-                  // ### The order of pixels in each stack must NOT be changed
-                  //     because rejection normalization depends on file order.
+                  // all out-of-range pixels, which are moved to the end of
+                  // each pixel stack.
                   if ( p_rangeClipLow || p_rangeClipHigh )
                      rejector.RejectRange();
                   else
@@ -3178,19 +3325,6 @@ bool ImageIntegrationInstance::ExecuteGlobal()
                   else
                      monitor += numberOfStacks;
 
-                  // In case we have performed range rejection, each stack with
-                  // out-of-range pixels must be sorted to send rejected pixels
-                  // to the bottom of the stack.
-                  if ( p_rangeClipLow || p_rangeClipHigh )
-                     for ( int k = 0; k < numberOfStacks; ++k )
-                     {
-                        RejectionMatrix& R = stacks[k];
-                        IVector& N = counts[k];
-                        for ( int x = 0; x < IntegrationFile::Width(); ++x )
-                           if ( N[x] < IntegrationFile::NumberOfFiles() )
-                              Sort( R[x], R[x] + IntegrationFile::NumberOfFiles() );
-                     }
-
                   // Reject pixels
                   if ( p_rejection != IIRejection::NoRejection )
                      rejector.Reject();
@@ -3202,7 +3336,7 @@ bool ImageIntegrationInstance::ExecuteGlobal()
 
                if ( p_generateIntegratedImage )
                {
-                  IntegrationEngine( *this, monitor, c,
+                  IntegrationEngine( *this, monitor, c, numberOfStacks,
                                      stacks, counts, d, m, s, resultData32, resultData64 ).Integrate();
                   size_type delta = size_type( numberOfStacks )*IntegrationFile::Width();
                   if ( resultData32 != 0 )
@@ -3217,67 +3351,66 @@ bool ImageIntegrationInstance::ExecuteGlobal()
                if ( doReject )
                   for ( int k = 0, y = y0+r; k < numberOfStacks; ++k, ++y )
                   {
-                     const RejectionMatrix& R = stacks[k];
+                     int nf = IntegrationFile::NumberOfFiles();
+                     const uint8* f = stacks[k].flags.Begin();
 
-                     for ( int x = 0; x < IntegrationFile::Width(); ++x )
+                     for ( int x = 0; x < IntegrationFile::Width(); ++x, f += nf )
                      {
                         if ( p_clipLow || p_rangeClipLow )
                         {
                            int n = 0, nr = 0;
-                           const RejectionDataItem* r = R[x];
-                           for ( int i = 0; i < R.Cols(); ++i, ++r )
+                           for ( int i = 0; i < nf; ++i )
                            {
-                              if ( r->rejectLow )
+                              if ( f[i] & RejectionStack::RejectLow )
                               {
                                  ++n;
-                                 ++NRL[r->index];
+                                 ++NRL[i];
                               }
-                              if ( r->rejectRangeLow )
+                              if ( f[i] & RejectionStack::RejectRangeLow )
                               {
                                  ++nr;
-                                 ++NRRL[r->index];
+                                 ++NRRL[i];
                               }
 
                               if ( p_generateDrizzleData )
-                                 if ( r->rejectLow || r->rejectRangeLow )
-                                    IntegrationFile::FileByIndex( r->index ).AppendDrizzleLowRejectionData( x, y, c );
+                                 if ( f[i] & (RejectionStack::RejectLow | RejectionStack::RejectRangeLow) )
+                                    IntegrationFile::FileByIndex( i ).AppendDrizzleLowRejectionData( x, y, c );
                            }
 
                            if ( generateLowRejectionMap )
                            {
                               if ( p_mapRangeRejection )
                                  n += nr;
-                              *rejectionLowData++ = float( n )/R.Cols();
+                              *rejectionLowData++ = float( n )/nf;
                            }
                         }
 
                         if ( p_clipHigh || p_rangeClipHigh )
                         {
                            int n = 0, nr = 0;
-                           const RejectionDataItem* r = R[x];
-                           for ( int i = 0; i < R.Cols(); ++i, ++r )
+                           for ( int i = 0; i < nf; ++i )
                            {
-                              if ( r->rejectHigh )
+                              if ( f[i] & RejectionStack::RejectHigh )
                               {
                                  ++n;
-                                 ++NRH[r->index];
+                                 ++NRH[i];
                               }
-                              if ( r->rejectRangeHigh )
+                              if ( f[i] & RejectionStack::RejectRangeHigh )
                               {
                                  ++nr;
-                                 ++NRRH[r->index];
+                                 ++NRRH[i];
                               }
 
                               if ( p_generateDrizzleData )
-                                 if ( r->rejectHigh || r->rejectRangeHigh )
-                                    IntegrationFile::FileByIndex( r->index ).AppendDrizzleHighRejectionData( x, y, c );
+                                 if ( f[i] & (RejectionStack::RejectHigh | RejectionStack::RejectRangeHigh) )
+                                    IntegrationFile::FileByIndex( i ).AppendDrizzleHighRejectionData( x, y, c );
                            }
 
                            if ( generateHighRejectionMap )
                            {
                               if ( p_mapRangeRejection )
                                  n += nr;
-                              *rejectionHighData++ = float( n )/R.Cols();
+                              *rejectionHighData++ = float( n )/nf;
                            }
                         }
 
@@ -3741,6 +3874,8 @@ void* ImageIntegrationInstance::LockParameter( const MetaParameter* p, size_type
       return &p_bufferSizeMB;
    if ( p == TheIIStackSizeParameter )
       return &p_stackSizeMB;
+   if ( p == TheIIReadAheadSizeParameter )
+      return &p_readAheadSizeMB;
    if ( p == TheIIUseROIParameter )
       return &p_useROI;
    if ( p == TheIIROIX0Parameter )
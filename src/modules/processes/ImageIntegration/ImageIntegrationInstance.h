@@ -58,6 +58,7 @@
 #include <pcl/Matrix.h>
 
 #include "ImageIntegrationParameters.h"
+#include "RejectionKernels.h"
 
 namespace pcl
 {
@@ -158,6 +159,7 @@ private:
 
    int32       p_bufferSizeMB;  // size of a row buffer in megabytes
    int32       p_stackSizeMB;   // size of the pixel integration stack in megabytes
+   int32       p_readAheadSizeMB; // maximum size of read-ahead row buffers in megabytes
 
    pcl_bool    p_useROI;        // use a region of interest; entire image otherwise
    Rect        p_roi;           // region of interest
@@ -278,67 +280,49 @@ private:
 
    //
 
-   struct RejectionDataItem
+   /*
+    * A row of pixel stacks in structure-of-arrays layout. The stack of the
+    * pixel at column x occupies the range [x*n, (x+1)*n) of each array, where
+    * n is the number of integrated files.
+    *
+    * Pixel values and file indices are permuted together by pixel rejection
+    * routines: the first N[x] items of a stack are always its non-rejected
+    * pixels, where N is the corresponding vector of pixel counts. Raw values
+    * and rejection flags are always stored in file order.
+    */
+   struct RejectionStack
    {
-      float value;            // scaled value
-      float raw;              // raw value
-      int   index           : 28;  // file index
-      bool  rejectLow       :  1;  // statistically rejected low pixel?
-      bool  rejectHigh      :  1;  // statistically rejected high pixel?
-      bool  rejectRangeLow  :  1;  // range rejected low pixel?
-      bool  rejectRangeHigh :  1;  // range rejected high pixel?
-
-      RejectionDataItem()
-      {
-      }
-
-      RejectionDataItem( const RejectionDataItem& x ) :
-         value( x.value ), raw( x.raw ), index( x.index ),
-         rejectLow( x.rejectLow ), rejectHigh( x.rejectHigh ),
-         rejectRangeLow( x.rejectRangeLow ), rejectRangeHigh( x.rejectRangeHigh )
-      {
-      }
-
-      void Set( float v, int i )
-      {
-         value = raw = IsFinite( v ) ? v : .0F;
-         index = i;
-         rejectLow = rejectHigh = rejectRangeLow = rejectRangeHigh = false;
-      }
-
-      bool IsStatisticallyRejected() const
-      {
-         return rejectLow || rejectHigh;
-      }
-
-      bool IsRangeRejected() const
-      {
-         return rejectRangeLow || rejectRangeHigh;
-      }
-
-      bool IsRejected() const
-      {
-         return IsStatisticallyRejected() || IsRangeRejected();
-      }
-
-      bool operator ==( const RejectionDataItem& x ) const
+      enum
       {
-         return index == x.index;
-      }
+         RejectLow       = RejectionKernels::RejectLow,
+         RejectHigh      = RejectionKernels::RejectHigh,
+         RejectRangeLow  = RejectionKernels::RejectRangeLow,
+         RejectRangeHigh = RejectionKernels::RejectRangeHigh
+      };
 
-      bool operator <( const RejectionDataItem& x ) const
-      {
-         return (IsRejected() == x.IsRejected()) ? value < x.value : !IsRejected();
-      }
+      FVector   value; // scaled values
+      FVector   raw;   // raw values, in file order
+      IVector   index; // file indices
+      UI8Vector flags; // rejection flags, in file order
 
-      static bool CompareRaw( const RejectionDataItem& a, const RejectionDataItem& b )
+      /*
+       * Ensures that this object can store w stacks of n items each. Existing
+       * arrays are reused if they already have the required length.
+       */
+      void Allocate( int w, int n )
       {
-         return a.raw < b.raw;
+         int length = w*n;
+         if ( value.Length() != length )
+         {
+            value = FVector( length );
+            raw = FVector( length );
+            index = IVector( length );
+            flags = UI8Vector( length );
+         }
       }
    };
 
-   typedef GenericMatrix<RejectionDataItem>  RejectionMatrix;
-   typedef GenericVector<RejectionMatrix>    RejectionStacks;
+   typedef GenericVector<RejectionStack>     RejectionStacks;
    typedef GenericVector<IVector>            RejectionCounts;
    typedef GenericVector<FVector>            RejectionSlopes;
 
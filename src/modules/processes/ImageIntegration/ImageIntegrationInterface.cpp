@@ -313,6 +313,7 @@ void ImageIntegrationInterface::UpdateIntegrationControls()
 
    GUI->BufferSize_SpinBox.SetValue( instance.p_bufferSizeMB );
    GUI->StackSize_SpinBox.SetValue( instance.p_stackSizeMB );
+   GUI->ReadAheadSize_SpinBox.SetValue( instance.p_readAheadSizeMB );
 
    GUI->UseCache_CheckBox.SetChecked( instance.p_useCache );
 }
@@ -717,6 +718,8 @@ void ImageIntegrationInterface::__Integration_SpinValueUpdated( SpinBox& sender,
       instance.p_bufferSizeMB = value;
    else if ( sender == GUI->StackSize_SpinBox )
       instance.p_stackSizeMB = value;
+   else if ( sender == GUI->ReadAheadSize_SpinBox )
+      instance.p_readAheadSizeMB = value;
 }
 
 void ImageIntegrationInterface::__Integration_Click( Button& sender, bool checked )
@@ -1307,6 +1310,33 @@ ImageIntegrationInterface::GUIData::GUIData( ImageIntegrationInterface& w )
    StackSize_Sizer.Add( StackSize_SpinBox );
    StackSize_Sizer.AddStretch();
 
+   const char* readAheadSizeToolTip =
+      "<p>Maximum amount of memory used for asynchronous file reading. When input files can be read "
+      "incrementally, the next strip of pixel rows of all input images is read in the background while "
+      "the current strip is being rejected and integrated. This requires a second row buffer per input "
+      "image, which can improve performance considerably for large image sets on fast storage devices.</p>"
+      "<p>Read-ahead is only used when the total size of the additional buffers (buffer size times the "
+      "number of input images) does not exceed this limit. Set this parameter to zero to disable "
+      "asynchronous file reading.</p>"
+      "<p>Asynchronous file reading is currently available for the XISF and FITS formats. Files in other "
+      "formats are always read sequentially.</p>";
+
+   ReadAheadSize_Label.SetText( "Read-ahead (MiB):" );
+   ReadAheadSize_Label.SetFixedWidth( labelWidth1 );
+   ReadAheadSize_Label.SetTextAlignment( TextAlign::Right|TextAlign::VertCenter );
+   ReadAheadSize_Label.SetToolTip( readAheadSizeToolTip );
+
+   // Limit to one half the parameter's maximum (500 GiB) to keep the SpinBox size within editWidth2.
+   ReadAheadSize_SpinBox.SetRange( int( TheIIReadAheadSizeParameter->MinimumValue() ), int( TheIIReadAheadSizeParameter->MaximumValue() ) >> 1 );
+   ReadAheadSize_SpinBox.SetToolTip( readAheadSizeToolTip );
+   ReadAheadSize_SpinBox.SetFixedWidth( editWidth2 );
+   ReadAheadSize_SpinBox.OnValueUpdated( (SpinBox::value_event_handler)&ImageIntegrationInterface::__Integration_SpinValueUpdated, w );
+
+   ReadAheadSize_Sizer.SetSpacing( 4 );
+   ReadAheadSize_Sizer.Add( ReadAheadSize_Label );
+   ReadAheadSize_Sizer.Add( ReadAheadSize_SpinBox );
+   ReadAheadSize_Sizer.AddStretch();
+
    UseCache_CheckBox.SetText( "Use file cache" );
    UseCache_CheckBox.SetToolTip( "<p>By default, ImageIntegration generates and uses a dynamic cache of "
       "working image parameters, including pixel statistics and normalization data. This cache greatly "
@@ -1337,6 +1367,7 @@ ImageIntegrationInterface::GUIData::GUIData( ImageIntegrationInterface& w )
    Integration_Sizer.Add( ClosePreviousImages_Sizer );
    Integration_Sizer.Add( BufferSize_Sizer );
    Integration_Sizer.Add( StackSize_Sizer );
+   Integration_Sizer.Add( ReadAheadSize_Sizer );
    Integration_Sizer.Add( Cache_Sizer );
 
    Integration_Control.SetSizer( Integration_Sizer );
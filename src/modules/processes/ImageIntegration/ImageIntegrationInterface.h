@@ -168,6 +168,9 @@ private:
          HorizontalSizer   StackSize_Sizer;
             Label             StackSize_Label;
             SpinBox           StackSize_SpinBox;
+         HorizontalSizer   ReadAheadSize_Sizer;
+            Label             ReadAheadSize_Label;
+            SpinBox           ReadAheadSize_SpinBox;
          HorizontalSizer   Cache_Sizer;
             CheckBox          UseCache_CheckBox;
 
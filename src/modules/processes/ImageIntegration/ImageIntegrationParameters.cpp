@@ -96,6 +96,7 @@ IIGenerateDrizzleData*       TheIIGenerateDrizzleDataParameter = 0;
 IIClosePreviousImages*       TheIIClosePreviousImagesParameter = 0;
 IIBufferSize*                TheIIBufferSizeParameter = 0;
 IIStackSize*                 TheIIStackSizeParameter = 0;
+IIReadAheadSize*             TheIIReadAheadSizeParameter = 0;
 IIUseROI*                    TheIIUseROIParameter = 0;
 IIROIX0*                     TheIIROIX0Parameter = 0;
 IIROIY0*                     TheIIROIY0Parameter = 0;
@@ -1128,6 +1129,50 @@ double IIStackSize::MaximumValue() const
 
 // ----------------------------------------------------------------------------
 
+IIReadAheadSize::IIReadAheadSize( MetaProcess* P ) : MetaInt32( P )
+{
+   TheIIReadAheadSizeParameter = this;
+}
+
+IsoString IIReadAheadSize::Id() const
+{
+   return "readAheadSizeMB";
+}
+
+double IIReadAheadSize::DefaultValue() const
+{
+   return 1024; // 1 GB
+}
+
+double IIReadAheadSize::MinimumValue() const
+{
+   return 0;   // zero means no asynchronous read-ahead
+}
+
+double IIReadAheadSize::MaximumValue() const
+{
+   return 1024*1024;   // 1 TB
+}
+
+/*
+ * Names of the file formats whose incremental readers are known to be safe to
+ * run out of the main thread when opened with a "verbosity 0" format hint:
+ * they neither write to the console nor process GUI events. The XISF and FITS
+ * readers meet these conditions. Other formats are read sequentially from the
+ * main thread, without read-ahead, until they are verified and added here.
+ */
+static const char* QuietReadFormats[] = { "XISF", "FITS" };
+
+bool IIReadAheadSize::IsQuietReadFormat( const IsoString& formatName )
+{
+   for ( size_type i = 0; i < ItemsInArray( QuietReadFormats ); ++i )
+      if ( formatName == QuietReadFormats[i] )
+         return true;
+   return false;
+}
+
+// ----------------------------------------------------------------------------
+
 IIUseROI::IIUseROI( MetaProcess* P ) : MetaBoolean( P )
 {
    TheIIUseROIParameter = this;
@@ -712,6 +712,29 @@ extern IIStackSize* TheIIStackSizeParameter;
 
 // ----------------------------------------------------------------------------
 
+class IIReadAheadSize : public MetaInt32
+{
+public:
+
+   IIReadAheadSize( MetaProcess* );
+
+   virtual IsoString Id() const;
+   virtual double DefaultValue() const;
+   virtual double MinimumValue() const;
+   virtual double MaximumValue() const;
+
+   /*
+    * Returns true iff files in the specified format can be read from I/O
+    * threads, which is a prerequisite for parallel file reading and
+    * read-ahead. See the QuietReadFormats list in the implementation.
+    */
+   static bool IsQuietReadFormat( const IsoString& formatName );
+};
+
+extern IIReadAheadSize* TheIIReadAheadSizeParameter;
+
+// ----------------------------------------------------------------------------
+
 class IIUseROI : public MetaBoolean
 {
 public:
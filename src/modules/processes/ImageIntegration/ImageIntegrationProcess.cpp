@@ -116,6 +116,7 @@ ImageIntegrationProcess::ImageIntegrationProcess() : MetaProcess()
    new IIClosePreviousImages( this );
    new IIBufferSize( this );
    new IIStackSize( this );
+   new IIReadAheadSize( this );
    new IIUseROI( this );
    new IIROIX0( this );
    new IIROIY0( this );
@@ -0,0 +1,324 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// Standard ImageIntegration Process Module Version 01.09.04.0322
+// ----------------------------------------------------------------------------
+// RejectionKernels.h - Released 2016/02/21 20:22:43 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the standard ImageIntegration PixInsight module.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#ifndef __RejectionKernels_h
+#define __RejectionKernels_h
+
+#include <pcl/Array.h>
+#include <pcl/Math.h>
+#include <pcl/Sort.h>
+#include <pcl/Vector.h>
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Pixel stack routines of the ImageIntegration pixel rejection engine.
+ *
+ * A pixel stack is a set of n pixel values, one for each integrated file,
+ * stored along with an array of file indices and an array of rejection flags
+ * indexed by file. These routines only depend on the PCL core, so they can be
+ * used by standalone tools such as the PCLBench benchmark suite.
+ */
+class RejectionKernels
+{
+public:
+
+   /*
+    * Pixel rejection flags.
+    */
+   enum
+   {
+      RejectLow       = 0x01,  // statistically rejected low pixel
+      RejectHigh      = 0x02,  // statistically rejected high pixel
+      RejectRangeLow  = 0x04,  // range rejected low pixel
+      RejectRangeHigh = 0x08   // range rejected high pixel
+   };
+
+   /*
+    * An item of a pixel stack in array-of-structures form, used as working
+    * storage to sort large pixel stacks.
+    */
+   struct StackItem
+   {
+      float value;
+      int   index;
+
+      bool operator <( const StackItem& x ) const
+      {
+         return value < x.value;
+      }
+   };
+
+   typedef Array<StackItem> stack_buffer;
+
+   /*
+    * Sorts a pixel stack of n items by value. The index array is permuted
+    * along with the array of values.
+    *
+    * Small stacks are sorted in place with a sorting network (Batcher's merge
+    * exchange, Knuth's Algorithm 5.2.2M), whose sequence of comparisons does
+    * not depend on the data. Larger stacks are sorted as an array of value
+    * and index pairs in the specified working buffer, which must have room
+    * for at least n items.
+    */
+   static void SortStack( float* v, int* ix, int n, StackItem* buffer )
+   {
+      if ( n < 2 )
+         return;
+
+      if ( n <= 32 )
+      {
+         int t = 1;
+         while ( (1 << t) < n )
+            ++t;
+         for ( int p = 1 << (t-1); p > 0; p >>= 1 )
+            for ( int q = 1 << (t-1), r = 0, d = p; ; )
+            {
+               for ( int i = 0; i < n-d; ++i )
+                  if ( (i & p) == r )
+                  {
+                     float a = v[i], b = v[i+d];
+                     if ( b < a )
+                     {
+                        v[i] = b; v[i+d] = a;
+                        Swap( ix[i], ix[i+d] );
+                     }
+                  }
+               if ( q == p )
+                  break;
+               d = q - p;
+               q >>= 1;
+               r = p;
+            }
+      }
+      else
+      {
+         for ( int i = 0; i < n; ++i )
+            buffer[i].value = v[i], buffer[i].index = ix[i];
+         Sort( buffer, buffer + n );
+         for ( int i = 0; i < n; ++i )
+            v[i] = buffer[i].value, ix[i] = buffer[i].index;
+      }
+   }
+
+   /*
+    * Moves the window [lo,hi) of non-rejected items in a sorted pixel stack
+    * to the beginning of the stack. Returns the number of non-rejected items.
+    */
+   static int CloseWindow( float* v, int* ix, int lo, int hi )
+   {
+      if ( hi <= lo )
+         return 0;
+      if ( lo > 0 )
+         for ( int i = lo; i < hi; ++i )
+         {
+            v[i-lo] = v[i];
+            ix[i-lo] = ix[i];
+         }
+      return hi - lo;
+   }
+
+   /*
+    * Rejects low and high pixels from the window [lo,hi) of a sorted pixel
+    * stack, with respect to the specified center and dispersion values. The
+    * window is shrunk to exclude all rejected pixels, which are flagged in
+    * the array of rejection flags f, indexed by file. Returns true iff one or
+    * more pixels have been rejected.
+    */
+   static bool ClipStack( int& lo, int& hi, const float* v, const int* ix, uint8* f,
+                          double center, double sigma, double kLow, double kHigh,
+                          bool clipLow, bool clipHigh )
+   {
+      int lo0 = lo, hi0 = hi;
+
+      if ( clipLow )
+         for ( ; lo < hi; ++lo )
+         {
+            if ( (center - v[lo])/sigma <= kLow )
+               break;
+            f[ix[lo]] |= RejectLow;
+         }
+
+      if ( clipHigh )
+         for ( ; hi > lo; --hi )
+         {
+            if ( (v[hi-1] - center)/sigma <= kHigh )
+               break;
+            f[ix[hi-1]] |= RejectHigh;
+         }
+
+      return lo != lo0 || hi != hi0;
+   }
+
+   /*
+    * Iterative sigma clipping of a sorted pixel stack of n items. Returns the
+    * window [lo,hi) of non-rejected items. Rejected pixels are flagged in the
+    * array of rejection flags f, indexed by file.
+    */
+   static void SigmaClip( int& lo, int& hi, const float* v, const int* ix, uint8* f, int n,
+                          double kLow, double kHigh, bool clipLow, bool clipHigh )
+   {
+      lo = 0, hi = n;
+      if ( n < 3 )
+         return;
+
+      for ( ;; )
+      {
+         double sigma = RejectionSigma( v+lo, hi-lo );
+         if ( 1 + sigma == 1 )
+            break;
+
+         double median = RejectionMedian( v+lo, hi-lo );
+
+         if ( !ClipStack( lo, hi, v, ix, f, median, sigma, kLow, kHigh, clipLow, clipHigh ) )
+            break;
+
+         if ( hi-lo < 3 )
+            break;
+      }
+   }
+
+   static double RejectionMedian( const float* v, int n )
+   {
+      // NB: Assume that {v0...vn} is already sorted.
+      if ( n < 2 )
+         return 0;
+      int n2 = n >> 1;
+      return (n & 1) ? v[n2] : (v[n2] + v[n2-1])/2;
+   }
+
+   static double RejectionSigma( const float* v, int n )
+   {
+      if ( n < 2 )
+         return 0;
+      double mean = 0;
+      for ( int i = 0; i < n; ++i )
+         mean += v[i];
+      mean /= n;
+      double var = 0, eps = 0;
+      for ( int i = 0; i < n; ++i )
+      {
+         double d = v[i] - mean;
+         var += d*d;
+         eps += d;
+      }
+      return Sqrt( (var - (eps*eps)/n)/(n - 1) );
+   }
+
+   static double RejectionADev( const float* v, int n, double median )
+   {
+      if ( n < 2 )
+         return 0;
+      double sd = 0;
+      for ( int i = 0; i < n; ++i )
+         sd += Abs( v[i] - median );
+      return sd/n;
+   }
+
+   static double RejectionMAD( const float* v, int n, double median )
+   {
+      if ( n < 2 )
+         return 0;
+      DVector d( n );
+      for ( int i = 0; i < n; ++i )
+         d[i] = v[i] - median;
+      return pcl::Median( d.Begin(), d.End() );
+   }
+
+   static void RejectionWinsorization( double& mean, double& sigma, const float* v, int n )
+   {
+      if ( n < 2 )
+      {
+         mean = sigma = 0;
+         return;
+      }
+
+      mean = RejectionMedian( v, n );
+      sigma = RejectionSigma( v, n );
+
+      DVector w( n );
+      for ( int i = 0; i < n; ++i )
+         w[i] = v[i];
+
+      for ( int it = 0; ; )
+      {
+         if ( 1 + sigma == 1 )
+            break;
+
+         double t0 = mean - 1.5*sigma;
+         double t1 = mean + 1.5*sigma;
+
+         for ( int i = 0; i < n; ++i )
+            if ( w[i] < t0 )
+               w[i] = t0;
+            else if ( w[i] > t1 )
+               w[i] = t1;
+
+         double s0 = sigma;
+         sigma = 1.134*w.StdDev();
+         if ( ++it > 1 && Abs( s0 - sigma )/s0 < 0.0005 )
+            break;
+      }
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+#endif   // __RejectionKernels_h
+
+// ----------------------------------------------------------------------------
+// EOF RejectionKernels.h - Released 2016/02/21 20:22:43 UTC
@@ -57,6 +57,7 @@
 #include <pcl/ImageWindow.h>
 #include <pcl/Random.h>
 #include <pcl/StdStatus.h>
+#include <pcl/Thread.h>
 #include <pcl/View.h>
 
 namespace pcl
@@ -69,6 +70,7 @@ ProcessImplementation( m ),
 p_amount( TheNGNoiseAmountParameter->DefaultValue() ),
 p_distribution( NGNoiseDistribution::Default ),
 p_impulsionalNoiseProbability( TheNGImpulsionalNoiseProbabilityParameter->DefaultValue() ),
+p_seed( TheNGSeedParameter->DefaultValue() ),
 p_preserveBrightness( false /*NGPreserveBrightness::Default*/ ) // ### deprecated
 {
 }
@@ -91,6 +93,7 @@ void NoiseGeneratorInstance::Assign( const ProcessImplementation& p )
       p_amount = x->p_amount;
       p_distribution = x->p_distribution;
       p_impulsionalNoiseProbability = x->p_impulsionalNoiseProbability;
+      p_seed = x->p_seed;
       p_preserveBrightness = x->p_preserveBrightness; // ### deprecated
    }
 }
@@ -129,41 +132,127 @@ public:
             TheNGImpulsionalNoiseProbabilityParameter->Precision(), G.p_impulsionalNoiseProbability ); break;
       }
 
-      size_type N = image.NumberOfNominalSamples();
+      /*
+       * Each row of each channel is generated with its own stream of a
+       * counter-based generator, so the result depends only on the seed and
+       * never on the number of threads or on the order of execution.
+       */
+      int height = image.Height();
+      int numberOfThreads = Thread::NumberOfThreads( height, 1 );
+      int rowsPerThread = height/numberOfThreads;
 
-      image.Status().Initialize( "Generating noise, " + sdist, N );
-      image.Status().DisableInitialization();
+      image.Status().Initialize( "Generating noise, " + sdist, size_type( image.NumberOfNominalChannels() )*height );
 
-      RandomNumberGenerator R;
-      double a = G.p_amount;
+      ThreadData data( image, size_type( image.NumberOfNominalChannels() )*height );
+      data.seed = (G.p_seed != 0) ? uint64( G.p_seed ) : RandomSeed64();
 
-      for ( int c = 0; c < image.NumberOfNominalChannels(); ++c )
-         for ( typename GenericImage<P>::sample_iterator i( image, c ); i; ++i, ++image.Status() )
-         {
-            double v; P::FromSample( v, *i );
-            switch ( G.p_distribution )
+      ReferenceArray<NoiseThread<P> > threads;
+      for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+         threads.Add( new NoiseThread<P>( G, data, image,
+                                          i*rowsPerThread,
+                                          (j < numberOfThreads) ? j*rowsPerThread : height ) );
+      AbstractImage::RunThreads( threads, data );
+      threads.Destroy();
+      image.Status() = data.status;
+   }
+
+private:
+
+   struct ThreadData : public AbstractImage::ThreadData
+   {
+      ThreadData( const AbstractImage& image, size_type count ) :
+      AbstractImage::ThreadData( image, count )
+      {
+      }
+
+      uint64 seed;
+   };
+
+   template <class P>
+   class NoiseThread : public Thread
+   {
+   public:
+
+      NoiseThread( const NoiseGeneratorInstance& instance, const ThreadData& data,
+                   GenericImage<P>& image, int startRow, int endRow ) :
+      Thread(), m_instance( instance ), m_data( data ), m_image( image ), m_startRow( startRow ), m_endRow( endRow )
+      {
+      }
+
+      virtual void Run()
+      {
+         INIT_THREAD_MONITOR()
+
+         int width = m_image.Width();
+         double a = m_instance.p_amount;
+         double k = 65535/a;
+         double prob = m_instance.p_impulsionalNoiseProbability;
+
+         Philox4x32 R( m_data.seed );
+         DVector r( (m_instance.p_distribution == NGNoiseDistribution::Impulsional) ? 2*width : width );
+         IVector n( (m_instance.p_distribution == NGNoiseDistribution::Poisson) ? width : 0 );
+
+         for ( int c = 0; c < m_image.NumberOfNominalChannels(); ++c )
+            for ( int y = m_startRow; y < m_endRow; ++y )
             {
-            default:
-            case NGNoiseDistribution::Uniform:
-               v += a*(R() - 0.5);
-               break;
-            case NGNoiseDistribution::Normal:
-               v += R.Normal( 0.0, a );
-               break;
-            case NGNoiseDistribution::Poisson:
-               v = double( R.Poisson( v*65535/a ) )/(65535/a);
-               break;
-            case NGNoiseDistribution::Impulsional:
-               if ( R() <= G.p_impulsionalNoiseProbability )
-                  v += (R() >= 0.5) ? a : -a;
-               else
-                  continue;
-               break;
+               R.SetStream( (uint64( c ) << 32) | uint64( y ) );
+
+               typename P::sample* f = m_image.ScanLine( y, c );
+
+               switch ( m_instance.p_distribution )
+               {
+               default:
+               case NGNoiseDistribution::Uniform:
+                  R.Uniform( r.Begin(), width );
+                  for ( int x = 0; x < width; ++x, ++f )
+                  {
+                     double v; P::FromSample( v, *f );
+                     *f = P::ToSample( Range( v + a*(r[x] - 0.5), 0.0, 1.0 ) );
+                  }
+                  break;
+               case NGNoiseDistribution::Normal:
+                  R.Normal( r.Begin(), width, 0.0, a );
+                  for ( int x = 0; x < width; ++x, ++f )
+                  {
+                     double v; P::FromSample( v, *f );
+                     *f = P::ToSample( Range( v + r[x], 0.0, 1.0 ) );
+                  }
+                  break;
+               case NGNoiseDistribution::Poisson:
+                  for ( int x = 0; x < width; ++x )
+                  {
+                     double v; P::FromSample( v, f[x] );
+                     r[x] = v*k;
+                  }
+                  R.Poisson( n.Begin(), r.Begin(), width );
+                  for ( int x = 0; x < width; ++x, ++f )
+                     *f = P::ToSample( Range( n[x]/k, 0.0, 1.0 ) );
+                  break;
+               case NGNoiseDistribution::Impulsional:
+                  // Two uniform deviates per pixel, consumed even for pixels
+                  // left unchanged.
+                  R.Uniform( r.Begin(), 2*width );
+                  for ( int x = 0; x < width; ++x, ++f )
+                     if ( r[2*x] <= prob )
+                     {
+                        double v; P::FromSample( v, *f );
+                        *f = P::ToSample( Range( v + ((r[2*x+1] >= 0.5) ? a : -a), 0.0, 1.0 ) );
+                     }
+                  break;
+               }
+
+               UPDATE_THREAD_MONITOR( 16 )
             }
+      }
 
-            *i = P::ToSample( Range( v, 0.0, 1.0 ) );
-         }
-   }
+   private:
+
+      const NoiseGeneratorInstance& m_instance;
+      const ThreadData&             m_data;
+      GenericImage<P>&              m_image;
+      int                           m_startRow;
+      int                           m_endRow;
+   };
 };
 
 bool NoiseGeneratorInstance::ExecuteOn( View& view )
@@ -205,6 +294,8 @@ void* NoiseGeneratorInstance::LockParameter( const MetaParameter* p, size_type /
       return &p_distribution;
    if ( p == TheNGImpulsionalNoiseProbabilityParameter )
       return &p_impulsionalNoiseProbability;
+   if ( p == TheNGSeedParameter )
+      return &p_seed;
    if ( p == TheNGPreserveBrightnessParameter ) // ### deprecated
       return &p_preserveBrightness;
    return 0;
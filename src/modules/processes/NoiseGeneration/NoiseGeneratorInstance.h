@@ -79,6 +79,7 @@ private:
    float    p_amount;
    pcl_enum p_distribution;
    float    p_impulsionalNoiseProbability;
+   uint32   p_seed;
    pcl_enum p_preserveBrightness; // ### deprecated
 
    friend class NoiseGeneratorEngine;
@@ -159,6 +159,10 @@ void NoiseGeneratorInterface::UpdateControls()
    GUI->Impulsional_RadioButton.SetChecked( instance.p_distribution == NGNoiseDistribution::Impulsional );
    GUI->ImpulsionalProb_NumericControl.SetValue( instance.p_impulsionalNoiseProbability );
    GUI->ImpulsionalProb_NumericControl.Enable( instance.p_distribution == NGNoiseDistribution::Impulsional );
+   GUI->Seed_CheckBox.SetChecked( instance.p_seed != 0 );
+   if ( instance.p_seed != 0 )
+      GUI->Seed_SpinBox.SetValue( int( Min( instance.p_seed, uint32( int32_max ) ) ) );
+   GUI->Seed_SpinBox.Enable( instance.p_seed != 0 );
 }
 
 // ----------------------------------------------------------------------------
@@ -181,10 +185,22 @@ void NoiseGeneratorInterface::__Click( Button& sender, bool checked )
       instance.p_distribution = NGNoiseDistribution::Poisson;
    else if ( sender == GUI->Impulsional_RadioButton )
       instance.p_distribution = NGNoiseDistribution::Impulsional;
+   else if ( sender == GUI->Seed_CheckBox )
+   {
+      // A zero seed generates a random seed for each execution.
+      instance.p_seed = checked ? uint32( GUI->Seed_SpinBox.Value() ) : 0u;
+      GUI->Seed_SpinBox.Enable( checked );
+   }
 
    GUI->ImpulsionalProb_NumericControl.Enable( instance.p_distribution == NGNoiseDistribution::Impulsional );
 }
 
+void NoiseGeneratorInterface::__IntValueUpdated( SpinBox& sender, int value )
+{
+   if ( sender == GUI->Seed_SpinBox )
+      instance.p_seed = uint32( value );
+}
+
 // ----------------------------------------------------------------------------
 
 NoiseGeneratorInterface::GUIData::GUIData( NoiseGeneratorInterface& w )
@@ -229,10 +245,24 @@ NoiseGeneratorInterface::GUIData::GUIData( NoiseGeneratorInterface& w )
    Distribution_GroupBox.SetTitle( "Distribution" );
    Distribution_GroupBox.SetSizer( Distribution_Sizer );
 
+   Seed_CheckBox.SetText( "Reproducible seed:" );
+   Seed_CheckBox.OnClick( (Button::click_event_handler)&NoiseGeneratorInterface::__Click, w );
+
+   Seed_SpinBox.SetRange( 1, int32_max );
+   Seed_SpinBox.SetValue( 1 );
+   Seed_SpinBox.SetFixedWidth( w.Font().Width( String( '0', 12 ) ) );
+   Seed_SpinBox.OnValueUpdated( (SpinBox::value_event_handler)&NoiseGeneratorInterface::__IntValueUpdated, w );
+
+   Seed_Sizer.SetSpacing( 4 );
+   Seed_Sizer.Add( Seed_CheckBox );
+   Seed_Sizer.Add( Seed_SpinBox );
+   Seed_Sizer.AddStretch();
+
    Global_Sizer.SetMargin( 8 );
    Global_Sizer.SetSpacing( 6 );
    Global_Sizer.Add( Amount_NumericControl );
    Global_Sizer.Add( Distribution_GroupBox );
+   Global_Sizer.Add( Seed_Sizer );
 
    w.SetSizer( Global_Sizer );
    w.AdjustToContents();
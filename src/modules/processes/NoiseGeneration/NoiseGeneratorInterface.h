@@ -59,6 +59,7 @@
 #include <pcl/ProcessInterface.h>
 #include <pcl/RadioButton.h>
 #include <pcl/Sizer.h>
+#include <pcl/SpinBox.h>
 
 #include "NoiseGeneratorInstance.h"
 
@@ -108,6 +109,9 @@ private:
          RadioButton    Poisson_RadioButton;
          RadioButton    Impulsional_RadioButton;
          NumericControl ImpulsionalProb_NumericControl;
+      HorizontalSizer   Seed_Sizer;
+         CheckBox       Seed_CheckBox;
+         SpinBox        Seed_SpinBox;
    };
 
    GUIData* GUI;
@@ -116,6 +120,7 @@ private:
 
    void __ValueUpdated( NumericEdit& sender, double value );
    void __Click( Button& sender, bool checked );
+   void __IntValueUpdated( SpinBox& sender, int value );
 
    friend struct GUIData;
 };
@@ -60,6 +60,7 @@ namespace pcl
 NGNoiseAmount*                 TheNGNoiseAmountParameter = 0;
 NGNoiseDistribution*           TheNGNoiseDistributionParameter = 0;
 NGImpulsionalNoiseProbability* TheNGImpulsionalNoiseProbabilityParameter = 0;
+NGSeed*                        TheNGSeedParameter = 0;
 NGPreserveBrightness*          TheNGPreserveBrightnessParameter = 0; // ### deprecated
 
 // ----------------------------------------------------------------------------
@@ -147,6 +148,23 @@ double NGImpulsionalNoiseProbability::DefaultValue() const
 
 // ----------------------------------------------------------------------------
 
+NGSeed::NGSeed( MetaProcess* p ) : MetaUInt32( p )
+{
+   TheNGSeedParameter = this;
+}
+
+IsoString NGSeed::Id() const
+{
+   return "seed";
+}
+
+double NGSeed::DefaultValue() const
+{
+   return 0; // zero = generate a random seed for each execution
+}
+
+// ----------------------------------------------------------------------------
+
 /*
  * ### Deprecated
  */
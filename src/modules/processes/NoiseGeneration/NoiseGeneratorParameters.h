@@ -118,6 +118,20 @@ extern NGImpulsionalNoiseProbability* TheNGImpulsionalNoiseProbabilityParameter;
 
 // ----------------------------------------------------------------------------
 
+class NGSeed : public MetaUInt32
+{
+public:
+
+   NGSeed( MetaProcess* );
+
+   virtual IsoString Id() const;
+   virtual double DefaultValue() const;
+};
+
+extern NGSeed* TheNGSeedParameter;
+
+// ----------------------------------------------------------------------------
+
 /*
  * ### Deprecated
  */
@@ -76,6 +76,7 @@ NoiseGeneratorProcess::NoiseGeneratorProcess() : MetaProcess()
    new NGNoiseAmount( this );
    new NGNoiseDistribution( this );
    new NGImpulsionalNoiseProbability( this );
+   new NGSeed( this );
    new NGPreserveBrightness( this ); // ### deprecated
 }
 
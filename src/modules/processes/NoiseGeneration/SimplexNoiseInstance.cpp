@@ -56,6 +56,7 @@
 #include <pcl/ImageWindow.h>
 #include <pcl/Random.h>
 #include <pcl/StdStatus.h>
+#include <pcl/Thread.h>
 #include <pcl/View.h>
 
 namespace pcl
@@ -122,13 +123,6 @@ public:
       static const double F2 = 0.5*( Sqrt( 3.0 ) - 1.0 );
       static const double G2 = (3.0 - Sqrt( 3.0 ))/6;
 
-      if ( perm == 0 )
-      {
-         perm = new int[ 512 ];
-         for ( int i = 0; i < 512; ++i )
-            perm[i] = p[i & 255];
-      }
-
       double n0, n1, n2; // Noise contributions from the three corners
 
       // Skew the input space to determine which simplex cell we're in
@@ -170,9 +164,9 @@ public:
       // Work out the hashed gradient indices of the three simplex corners
       int ii = i & 255;
       int jj = j & 255;
-      int gi0 = perm[ii + perm[jj]] % 12;
-      int gi1 = perm[ii + i1 + perm[jj + j1]] % 12;
-      int gi2 = perm[ii + 1 + perm[jj + 1]] % 12;
+      int gi0 = Perm( ii + Perm( jj ) ) % 12;
+      int gi1 = Perm( ii + i1 + Perm( jj + j1 ) ) % 12;
+      int gi2 = Perm( ii + 1 + Perm( jj + 1 ) ) % 12;
 
       // Calculate the contribution from the three corners
       double t0 = 0.5 - x0*x0 - y0*y0;
@@ -212,8 +206,12 @@ private:
    static int grad3[ 12 ][ 3 ];
    static int p[ 256 ];
 
-   // To remove the need for index wrapping, double the permutation table length
-   static int* perm;
+   // Index wrapping instead of a lazily allocated double-length table, so
+   // that Noise() can be called concurrently from multiple threads.
+   static int Perm( int i )
+   {
+      return p[i & 255];
+   }
 
    static int FastFloor( double x )
    {
@@ -250,8 +248,6 @@ int SimplexNoise::p[ 256 ] =
    138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
 };
 
-int* SimplexNoise::perm = 0;
-
 // ----------------------------------------------------------------------------
 
 class SimplexNoiseEngine
@@ -261,73 +257,118 @@ public:
    template <class P>
    static void Apply( GenericImage<P>& image, const SimplexNoiseInstance& instance )
    {
-      size_type N = image.NumberOfNominalSamples();
+      /*
+       * Simplex noise is a pure function of pixel coordinates, so rows can be
+       * generated in parallel with identical results for any number of threads.
+       */
+      int height = image.Height();
+      int numberOfThreads = Thread::NumberOfThreads( height, 1 );
+      int rowsPerThread = height/numberOfThreads;
+
+      image.Status().Initialize( "Generating 2D simplex noise", size_type( image.NumberOfNominalChannels() )*height );
+
+      AbstractImage::ThreadData data( image, size_type( image.NumberOfNominalChannels() )*height );
+
+      ReferenceArray<SimplexNoiseThread<P> > threads;
+      for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+         threads.Add( new SimplexNoiseThread<P>( instance, data, image,
+                                                 i*rowsPerThread,
+                                                 (j < numberOfThreads) ? j*rowsPerThread : height ) );
+      AbstractImage::RunThreads( threads, data );
+      threads.Destroy();
+      image.Status() = data.status;
+   }
+
+private:
 
-      image.Status().Initialize( "Generating 2D simplex noise", N );
-      image.Status().DisableInitialization();
+   template <class P>
+   class SimplexNoiseThread : public Thread
+   {
+   public:
 
-      double a = instance.p_amount;
-      double a1 = 1 - a;
+      SimplexNoiseThread( const SimplexNoiseInstance& instance, const AbstractImage::ThreadData& data,
+                          GenericImage<P>& image, int startRow, int endRow ) :
+      Thread(), m_instance( instance ), m_data( data ), m_image( image ), m_startRow( startRow ), m_endRow( endRow )
+      {
+      }
 
-      for ( int c = 0; c < image.NumberOfNominalChannels(); ++c )
+      virtual void Run()
       {
-         typename GenericImage<P>::sample_iterator i( image, c );
-         for ( int y = 0; y < image.Height(); ++y, image.Status() += image.Width() )
-            for ( int x = 0; x < image.Width(); ++x, ++i )
+         INIT_THREAD_MONITOR()
+
+         double a = m_instance.p_amount;
+         double a1 = 1 - a;
+
+         for ( int c = 0; c < m_image.NumberOfNominalChannels(); ++c )
+            for ( int y = m_startRow; y < m_endRow; ++y )
             {
-               double v; P::FromSample( v, *i );
-               double r = (1 + SimplexNoise::Noise( double( x + instance.p_offsetX )/instance.p_scale,
-                                                    double( y + instance.p_offsetY )/instance.p_scale ))/2;
-               switch ( instance.p_operator )
+               typename P::sample* i = m_image.ScanLine( y, c );
+               for ( int x = 0; x < m_image.Width(); ++x, ++i )
                {
-               default:
-               case SNOperator::Copy:
-                  break;
-               case SNOperator::Add:
-                  r = Min( v + r, 1.0 );
-                  break;
-               case SNOperator::Sub:
-                  r = Max( 0.0, v - r );
-                  break;
-               case SNOperator::Mul:
-                  r *= v;
-                  break;
-               case SNOperator::Div:
-                  r = (r + 1 != 1) ? Range( v/r, 0.0, 1.0 ) : 1.0;
-                  break;
-               case SNOperator::Pow:
-                  r = Pow( v, r );
-                  break;
-               case SNOperator::Dif:
-                  r = Abs( v - r );
-                  break;
-               case SNOperator::Screen:
-                  r = 1 - (1 - v)*(1 - r);
-                  break;
-               case SNOperator::Or:
-                  r = double( uint16( RoundInt( 0xffff*v ) ) | uint16( RoundInt( 0xffff*r ) ) )/0xffff;
-                  break;
-               case SNOperator::And:
-                  r = double( uint16( RoundInt( 0xffff*v ) ) & uint16( RoundInt( 0xffff*r ) ) )/0xffff;
-                  break;
-               case SNOperator::Xor:
-                  r = double( uint16( RoundInt( 0xffff*v ) ) ^ uint16( RoundInt( 0xffff*r ) ) )/0xffff;
-                  break;
-               case SNOperator::Nor:
-                  r = double( ~(uint16( RoundInt( 0xffff*v ) ) | uint16( RoundInt( 0xffff*r ) )) )/0xffff;
-                  break;
-               case SNOperator::Nand:
-                  r = double( ~(uint16( RoundInt( 0xffff*v ) ) & uint16( RoundInt( 0xffff*r ) )) )/0xffff;
-                  break;
-               case SNOperator::Xnor:
-                  r = double( ~(uint16( RoundInt( 0xffff*v ) ) ^ uint16( RoundInt( 0xffff*r ) )) )/0xffff;
-                  break;
+                  double v; P::FromSample( v, *i );
+                  double r = (1 + SimplexNoise::Noise( double( x + m_instance.p_offsetX )/m_instance.p_scale,
+                                                       double( y + m_instance.p_offsetY )/m_instance.p_scale ))/2;
+                  switch ( m_instance.p_operator )
+                  {
+                  default:
+                  case SNOperator::Copy:
+                     break;
+                  case SNOperator::Add:
+                     r = Min( v + r, 1.0 );
+                     break;
+                  case SNOperator::Sub:
+                     r = Max( 0.0, v - r );
+                     break;
+                  case SNOperator::Mul:
+                     r *= v;
+                     break;
+                  case SNOperator::Div:
+                     r = (r + 1 != 1) ? Range( v/r, 0.0, 1.0 ) : 1.0;
+                     break;
+                  case SNOperator::Pow:
+                     r = Pow( v, r );
+                     break;
+                  case SNOperator::Dif:
+                     r = Abs( v - r );
+                     break;
+                  case SNOperator::Screen:
+                     r = 1 - (1 - v)*(1 - r);
+                     break;
+                  case SNOperator::Or:
+                     r = double( uint16( RoundInt( 0xffff*v ) ) | uint16( RoundInt( 0xffff*r ) ) )/0xffff;
+                     break;
+                  case SNOperator::And:
+                     r = double( uint16( RoundInt( 0xffff*v ) ) & uint16( RoundInt( 0xffff*r ) ) )/0xffff;
+                     break;
+                  case SNOperator::Xor:
+                     r = double( uint16( RoundInt( 0xffff*v ) ) ^ uint16( RoundInt( 0xffff*r ) ) )/0xffff;
+                     break;
+                  case SNOperator::Nor:
+                     r = double( ~(uint16( RoundInt( 0xffff*v ) ) | uint16( RoundInt( 0xffff*r ) )) )/0xffff;
+                     break;
+                  case SNOperator::Nand:
+                     r = double( ~(uint16( RoundInt( 0xffff*v ) ) & uint16( RoundInt( 0xffff*r ) )) )/0xffff;
+                     break;
+                  case SNOperator::Xnor:
+                     r = double( ~(uint16( RoundInt( 0xffff*v ) ) ^ uint16( RoundInt( 0xffff*r ) )) )/0xffff;
+                     break;
+                  }
+
+                  *i = P::ToSample( a1*v + a*r );
                }
 
-               *i = P::ToSample( a1*v + a*r );
+               UPDATE_THREAD_MONITOR( 16 )
             }
       }
-   }
+
+   private:
+
+      const SimplexNoiseInstance&       m_instance;
+      const AbstractImage::ThreadData&  m_data;
+      GenericImage<P>&                  m_image;
+      int                               m_startRow;
+      int                               m_endRow;
+   };
 };
 
 bool SimplexNoiseInstance::ExecuteOn( View& view )
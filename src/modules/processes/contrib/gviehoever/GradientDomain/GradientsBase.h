@@ -71,11 +71,11 @@ namespace pcl {
 ///
 /// Uses solver by Carlos Milovic F (see #define USE_PIFFT).
 /// It is implemented in solver_dct3.h.
-/// This one is slower and uses more memory than the FFTW solver, but it uses
-/// PI internal routines only. Used with kind permission by Carlos.
+/// It computes an in-place 2D DCT with PCL's native FFT engine, so it
+/// needs no padding or working copies of the image. Used with kind
+/// permission by Carlos.
 ///
-/// As an alternative uses FFTW3 for FFT like ops, which currently is faster and more memory efficient
-/// than the PI version (see #define USE_FFTW). FFTW3 http://www.fftw.org/ is free
+/// As an alternative uses FFTW3 for FFT like ops (see #define USE_FFTW). FFTW3 http://www.fftw.org/ is free
 /// for non-commercial use, and is delivered with Fedora 14. You
 /// may need to install development headers ("yum install fftw-devel-3").
 /// Package for Windows can be downloaded on FFTW web page.
@@ -387,11 +387,11 @@ namespace pcl
 
     // ----------------------------------------------------------------------------
     // ----------------------------------------------------------------------------
-    // CosmeticCorrection Thread
+    // CosmeticCorrection Task
     // ----------------------------------------------------------------------------
     // ----------------------------------------------------------------------------
 
-   struct CCThreadData
+   struct CCTaskData
    {
       MorphologicalTransformation* avrMT;
       MorphologicalTransformation* medMT;
@@ -399,19 +399,19 @@ namespace pcl
       int maxProcessors;  // maximum number of nested threads allowed
    };
 
-   class CCThread : public Thread
+   class CCTask : public BatchPipeline::Task
    {
    public:
 
-      CCThread(Image* t, FileData* fd, const String& tp, int i,
-               const CCThreadData& d, const CosmeticCorrectionInstance* _instance) :
-      target(t), fileData(fd), targetPath(tp), subimageIndex(i), success( false ), data(d)
+      CCTask(Image* t, FileData* fd, const String& tp, int i,
+             const CCTaskData& d, CosmeticCorrectionInstance* _instance) :
+      target(t), fileData(fd), targetPath(tp), subimageIndex(i), data(d)
       {
          instance = _instance;
          count = 0;
       }
 
-      virtual ~CCThread()
+      virtual ~CCTask()
       {
          if (target != 0)
                delete target, target = 0;
@@ -419,214 +419,202 @@ namespace pcl
                delete fileData, fileData = 0;
       }
 
-      virtual void Run()
+      // Errors are reported by throwing exceptions, which are managed by the pipeline.
+      virtual void Process()
       {
-         try
-         {
-            success = false; /* ### */
-
-            //Console().Show(); /* ### */ Cannot do this from a running thread!
+         //Console().Show(); /* ### */ Cannot do this from a running thread!
 
-            // prepare filtered( a,m,b = average, median, background )images according checked methods
-            // AutoHot : a,m,b
-            // AutoCold:  ,m,b
-            // DarkHot : a, ,
-            // DarkCold:  ,m,
+         // prepare filtered( a,m,b = average, median, background )images according checked methods
+         // AutoHot : a,m,b
+         // AutoCold:  ,m,b
+         // DarkHot : a, ,
+         // DarkCold:  ,m,
 
-            MuteStatus status;
-            target->SetStatusCallback( &status );
-            target->Status().DisableInitialization();
+         MuteStatus status;
+         target->SetStatusCallback( &status );
+         target->Status().DisableInitialization();
 
-            Image avr, med, bkg;
-            bool needAvr, needMed, needBkg;
-            needAvr = needMed = needBkg = false;
+         Image avr, med, bkg;
+         bool needAvr, needMed, needBkg;
+         needAvr = needMed = needBkg = false;
 
-            if (instance->p_useAutoDetect)
-            {
-               if (instance->p_hotAutoCheck) needAvr = needMed = needBkg = true;
-               if (instance->p_coldAutoCheck) needMed = needBkg = true;
-            }
+         if (instance->p_useAutoDetect)
+         {
+            if (instance->p_hotAutoCheck) needAvr = needMed = needBkg = true;
+            if (instance->p_coldAutoCheck) needMed = needBkg = true;
+         }
 
-            if (needAvr) avr.Assign(*target), (*data.avrMT) >> avr; // prepare surrounding neighbors Mean
-            if (needMed) med.Assign(*target), (*data.medMT) >> med; // prepare surrounding neighbors Median
-            if (needBkg) bkg.Assign(*target), (*data.bkgMT) >> bkg; // prepare background Median
+         if (needAvr) avr.Assign(*target), (*data.avrMT) >> avr; // prepare surrounding neighbors Mean
+         if (needMed) med.Assign(*target), (*data.medMT) >> med; // prepare surrounding neighbors Median
+         if (needBkg) bkg.Assign(*target), (*data.bkgMT) >> bkg; // prepare background Median
 
-            const float f0 = instance->p_amount;
-            const float f1 = 1 - f0;
+         const float f0 = instance->p_amount;
+         const float f1 = 1 - f0;
 
-            const int width = target->Width();
-            const int height = target->Height();
+         const int width = target->Width();
+         const int height = target->Height();
 
-            for (int c = 0; c < target->NumberOfChannels(); ++c)
+         for (int c = 0; c < target->NumberOfChannels(); ++c)
+         {
+            if (instance->m_mapDarkHot) // Apply mapDarkHot ----------------------------------------------------
             {
-               if (instance->m_mapDarkHot) // Apply mapDarkHot ----------------------------------------------------
+               const MapImg::sample *map = instance->m_mapDarkHot->PixelData(Min(c, instance->m_mapDarkHot->NumberOfChannels() - 1));
+               for (int y = 0; y < height; y++)
                {
-                  const MapImg::sample *map = instance->m_mapDarkHot->PixelData(Min(c, instance->m_mapDarkHot->NumberOfChannels() - 1));
-                  for (int y = 0; y < height; y++)
-                  {
-                     /* ### */
-                     if ( TryIsAborted() )
-                        return;
-                     /* ### */
+                  /* ### */
+                  if ( IsAborted() )
+                     return;
+                  /* ### */
 
-                     for (int x = 0; x < width; x++)
+                  for (int x = 0; x < width; x++)
+                  {
+                     if (*map != 0)
                      {
-                        if (*map != 0)
-                        {
-                           count++;
-                           const Image::sample v = GetAverage3x3(target, x, y, c, width, height);
-                           target->Pixel(x, y, c) = v * f0 + target->Pixel(x, y, c) * f1;
-                        }
-                        map++;
+                        count++;
+                        const Image::sample v = GetAverage3x3(target, x, y, c, width, height);
+                        target->Pixel(x, y, c) = v * f0 + target->Pixel(x, y, c) * f1;
                      }
+                     map++;
                   }
                }
+            }
 
-               if (instance->m_mapDarkCold) // Apply mapDarkCold ----------------------------------------------------
+            if (instance->m_mapDarkCold) // Apply mapDarkCold ----------------------------------------------------
+            {
+               const MapImg::sample *map = instance->m_mapDarkCold->PixelData(Min(c, instance->m_mapDarkCold->NumberOfChannels() - 1));
+               for (int y = 0; y < height; y++)
                {
-                  const MapImg::sample *map = instance->m_mapDarkCold->PixelData(Min(c, instance->m_mapDarkCold->NumberOfChannels() - 1));
-                  for (int y = 0; y < height; y++)
-                  {
-                     /* ### */
-                     if ( TryIsAborted() )
-                        return;
-                     /* ### */
+                  /* ### */
+                  if ( IsAborted() )
+                     return;
+                  /* ### */
 
-                     for (int x = 0; x < width; x++)
+                  for (int x = 0; x < width; x++)
+                  {
+                     if (*map != 0)
                      {
-                        if (*map != 0)
-                        {
-                           count++;
-                           const Image::sample v = GetMedian5x5(target, x, y, c, width, height);
-                           target->Pixel(x, y, c) = v * f0 + target->Pixel(x, y, c) * f1;
-                        }
-                        map++;
+                        count++;
+                        const Image::sample v = GetMedian5x5(target, x, y, c, width, height);
+                        target->Pixel(x, y, c) = v * f0 + target->Pixel(x, y, c) * f1;
                      }
+                     map++;
                   }
                }
+            }
 
-               if (instance->p_useAutoDetect && (instance->p_coldAutoCheck || instance->p_hotAutoCheck))
-               {
-                  double median = target->Median( target->Bounds(), c, c, data.maxProcessors );
-                  double avgDev = target->AvgDev( median, target->Bounds(), c, c, data.maxProcessors );
+            if (instance->p_useAutoDetect && (instance->p_coldAutoCheck || instance->p_hotAutoCheck))
+            {
+               double median = target->Median( target->Bounds(), c, c, data.maxProcessors );
+               double avgDev = target->AvgDev( median, target->Bounds(), c, c, data.maxProcessors );
 
-                  if (instance->p_hotAutoCheck) // Processing hotAutoDetect -----------------------------------------------
+               if (instance->p_hotAutoCheck) // Processing hotAutoDetect -----------------------------------------------
+               {
+                  /* ### */
+                  if ( IsAborted() )
+                     return;
+                  /* ### */
+
+                  Image::sample *t = target->PixelData(c);
+                  const Image::sample *end = t + target->NumberOfPixels();
+                  const Image::sample* m = med.PixelData(c);
+                  const Image::sample* b = bkg.PixelData(c);
+                  const Image::sample* a = avr.PixelData(c);
+
+                  const double k1 = avgDev;
+                  const double k2 = k1 / 2; // avrDev / 2
+                  const double k3 = instance->p_hotAutoValue * k1; // avrDev * k
+
+                  while (t < end)
                   {
-                     /* ### */
-                     if ( TryIsAborted() )
-                        return;
-                     /* ### */
-
-                     Image::sample *t = target->PixelData(c);
-                     const Image::sample *end = t + target->NumberOfPixels();
-                     const Image::sample* m = med.PixelData(c);
-                     const Image::sample* b = bkg.PixelData(c);
-                     const Image::sample* a = avr.PixelData(c);
-
-                     const double k1 = avgDev;
-                     const double k2 = k1 / 2; // avrDev / 2
-                     const double k3 = instance->p_hotAutoValue * k1; // avrDev * k
-
-                     while (t < end)
+                     if ((*a < *b + k2) //ignore pixel surrounded by other bright pixels at avrDev/2
+                              && (*t > *b + k1) //ignore pixel with brightnes less then (background + avrDev)
+                              && (*t > *m + k3) //ignore pixel with brightnes less then avr of surrounded pixels * k * avrDev
+                              )
                      {
-                        if ((*a < *b + k2) //ignore pixel surrounded by other bright pixels at avrDev/2
-                                 && (*t > *b + k1) //ignore pixel with brightnes less then (background + avrDev)
-                                 && (*t > *m + k3) //ignore pixel with brightnes less then avr of surrounded pixels * k * avrDev
-                                 )
-                        {
-                           count++;
-                           *t = *a * f0 + *t * f1;
-                        }
-                        t++, m++, b++, a++;
+                        count++;
+                        *t = *a * f0 + *t * f1;
                      }
+                     t++, m++, b++, a++;
                   }
+               }
 
-                  if (instance->p_coldAutoCheck) // Processing coldAutoDetect -----------------------------------------------
+               if (instance->p_coldAutoCheck) // Processing coldAutoDetect -----------------------------------------------
+               {
+                  /* ### */
+                  if ( IsAborted() )
+                     return;
+                  /* ### */
+
+                  Image::sample *t = target->PixelData(c);
+                  const Image::sample *end = t + target->NumberOfPixels();
+                  const Image::sample* m = med.PixelData(c);
+                  const Image::sample* b = bkg.PixelData(c);
+
+                  const double k = avgDev * instance->p_coldAutoValue; // avrDev * how much pixel must be less
+                  while (t < end)
                   {
-                     /* ### */
-                     if ( TryIsAborted() )
-                        return;
-                     /* ### */
-
-                     Image::sample *t = target->PixelData(c);
-                     const Image::sample *end = t + target->NumberOfPixels();
-                     const Image::sample* m = med.PixelData(c);
-                     const Image::sample* b = bkg.PixelData(c);
-
-                     const double k = avgDev * instance->p_coldAutoValue; // avrDev * how much pixel must be less
-                     while (t < end)
+                     const double T = *t + k;
+                     if ((T < *b) && (T < *m))
                      {
-                        const double T = *t + k;
-                        if ((T < *b) && (T < *m))
-                        {
-                           count++;
-                           *t = *b * f0 + *t * f1;
-                        }
-                        t++, m++, b++;
+                        count++;
+                        *t = *b * f0 + *t * f1;
                      }
+                     t++, m++, b++;
                   }
                }
+            }
 
-               if (instance->p_useDefectList && !instance->p_defects.IsEmpty()) // Processing DefectList -----------------------------------------------
+            if (instance->p_useDefectList && !instance->p_defects.IsEmpty()) // Processing DefectList -----------------------------------------------
+            {
+               for (size_t i = 0; i < instance->p_defects.Length(); i++)
                {
-                  for (size_t i = 0; i < instance->p_defects.Length(); i++)
-                  {
-                     /* ### */
-                     if ( TryIsAborted() )
-                        return;
-                     /* ### */
+                  /* ### */
+                  if ( IsAborted() )
+                     return;
+                  /* ### */
 
-                     const CosmeticCorrectionInstance::DefectItem& item = instance->p_defects[i];
-                     if (!item.enabled) continue; // skip distable defects
+                  const CosmeticCorrectionInstance::DefectItem& item = instance->p_defects[i];
+                  if (!item.enabled) continue; // skip distable defects
 
-                     int h = height - 1, w = width - 1;
-                     if (item.isRow) Swap(w, h);
+                  int h = height - 1, w = width - 1;
+                  if (item.isRow) Swap(w, h);
 
-                     int x = item.address; // address in mainView coordinate
-                     if (x > w) continue; // skip because the defect out of image view
+                  int x = item.address; // address in mainView coordinate
+                  if (x > w) continue; // skip because the defect out of image view
+
+                  int y0 = 0, y1 = h; // first and last possible pixel
+                  if (item.isRange)
+                  {
+                     y0 = Min(item.begin, item.end); // chouse minimum value for begining coordinate
+                     if (y0 > h) continue; // skip out of view defects
+                     y1 = Max(item.begin, item.end); // chouse maximum value for ending coordinate
+                     y1 = Min(y1, h); // cut out of view defective pixels
+                  }
 
-                     int y0 = 0, y1 = h; // first and last possible pixel
-                     if (item.isRange)
+                  for (int y = y0; y <= y1; y++)
+                  {
+                     if (item.isRow)
                      {
-                        y0 = Min(item.begin, item.end); // chouse minimum value for begining coordinate
-                        if (y0 > h) continue; // skip out of view defects
-                        y1 = Max(item.begin, item.end); // chouse maximum value for ending coordinate
-                        y1 = Min(y1, h); // cut out of view defective pixels
+                        Image::sample v = GetMedian5x5(target, y, x, c, height, width);
+                        target->Pixel(y, x, c) = v * f0 + target->Pixel(y, x, c) * f1;
+                        count++;
                      }
-
-                     for (int y = y0; y <= y1; y++)
+                     else
                      {
-                        if (item.isRow)
-                        {
-                           Image::sample v = GetMedian5x5(target, y, x, c, height, width);
-                           target->Pixel(y, x, c) = v * f0 + target->Pixel(y, x, c) * f1;
-                           count++;
-                        }
-                        else
-                        {
-                           Image::sample v = GetMedian5x5(target, x, y, c, width, height);
-                           target->Pixel(x, y, c) = v * f0 + target->Pixel(x, y, c) * f1;
-                           count++;
-                        }
+                        Image::sample v = GetMedian5x5(target, x, y, c, width, height);
+                        target->Pixel(x, y, c) = v * f0 + target->Pixel(x, y, c) * f1;
+                        count++;
                      }
                   }
                }
-            } // for
-
-            success = true; /* ### */
-
-         } // try
-         catch ( ... )
-         {
-            /* ### */
-            ClearConsoleOutputText();
-            try
-            {
-               throw;
             }
-            ERROR_HANDLER
-            /* ### */
-         }
+         } // for
+      }
+
+      virtual void Write()
+      {
+         Console().WriteLn(String().Format("<end><cbr><br>%u pixels corrected: ", count) + targetPath);
+         instance->SaveImage(this);
       }
 
       const Image* TargetImage() const
@@ -654,22 +642,16 @@ namespace pcl
          return count;
       }
 
-      bool Success() const
-      {
-         return success;
-      }
-
    private:
 
-      const CosmeticCorrectionInstance* instance;
-      Image*    target;        // The image being CosmeticCorrected. It belongs to this thread.
-      FileData* fileData;      // Target image parameters and embedded data. It belongs to this thread.
+      CosmeticCorrectionInstance* instance;
+      Image*    target;        // The image being CosmeticCorrected. It belongs to this task.
+      FileData* fileData;      // Target image parameters and embedded data. It belongs to this task.
       String    targetPath;    // File path of this target image
       int       subimageIndex; // > 0 in case of a multiple image; = 0 otherwise
       size_t    count;         // count of corrected pixels in the image
-      bool      success : 1;   // The thread completed execution successfully /* ### */
 
-      const CCThreadData& data;
+      const CCTaskData& data;
 
       inline Image::sample GetMedian5x5(const Image* t, const int x, const int y, const int chanel, const int width, const int height) const
       {
@@ -820,13 +802,13 @@ namespace pcl
 
    }
 
-    inline thread_list CosmeticCorrectionInstance::LoadTargetFrame(const String& filePath, const CCThreadData& threadData)
+    inline void CosmeticCorrectionInstance::LoadTargetFrame(BatchPipeline::task_list& tasks, const String& filePath, const CCTaskData& taskData)
     {
         Console console;
         console.WriteLn("Open " + filePath);
 
         Image* target = 0;
-        thread_list threads;
+        BatchPipeline::task_list newTasks;
 
         FileFormat format(File::ExtractExtension(filePath), true, false);
         FileFormatInstance file(format);
@@ -842,21 +824,22 @@ namespace pcl
                 if (images.Length() > 1)
                     console.WriteLn(String().Format("* Subimage %u of %u", index + 1, images.Length()));
                 target = LoadImageFile(file, index);
-                Module->ProcessEvents(); /* ### */
                 if (m_geometry.IsRect() && (target->Bounds() != m_geometry))
                 {
                     throw Error("Image and MasterDark geometries are not equal.");
                 }
                 FileData* inputData = new FileData(file, images[index].options);
-                threads.Add(new CCThread(target, inputData, filePath, index, threadData, this));
+                newTasks.Add(new CCTask(target, inputData, filePath, index, taskData, this));
                 target = 0;
             }
             console.WriteLn("Close " + filePath);
             file.Close();
+            tasks.Add(newTasks);
         }
         catch (...)
         {
             if (target != 0) delete target;
+            newTasks.Destroy();
             if (file.IsOpen()) file.Close();
             try
             {
@@ -864,7 +847,6 @@ namespace pcl
             }
             ERROR_HANDLER;
         }
-        return threads;
     }
 
     inline String CosmeticCorrectionInstance::OutputFilePath(const String& filePath, const size_t index)
@@ -906,7 +888,7 @@ namespace pcl
          return outputFilePath;
     }
 
-    void CosmeticCorrectionInstance::SaveImage(const CCThread* t)
+    void CosmeticCorrectionInstance::SaveImage(const CCTask* t)
     {
         Console console;
         String outputFilePath = OutputFilePath(t->TargetPath(), t->SubimageIndex());
@@ -944,6 +926,46 @@ namespace pcl
 
     // ----------------------------------------------------------------------------
 
+    // Batch pipeline: target frames are read by a single loader thread,
+    // corrected by a set of compute threads, and written by a single writer
+    // thread, so LoadTargetFrame() and SaveImage() are never run concurrently.
+    class CCPipeline : public BatchPipeline
+    {
+    public:
+
+        CCPipeline(CosmeticCorrectionInstance& _instance, const CCTaskData& d, int numberOfWorkers) :
+        BatchPipeline(1, numberOfWorkers, 1), instance(_instance), data(d)
+        {
+        }
+
+        virtual ~CCPipeline()
+        {
+            Abort();
+        }
+
+    protected:
+
+        virtual void Load(task_list& tasks, size_type item)
+        {
+            Console console;
+            console.WriteLn(String().Format("<end><cbr><br>File %u of %u", item + 1, instance.p_targetFrames.Length()));
+            const CosmeticCorrectionInstance::ImageItem& target = instance.p_targetFrames[item];
+            if (target.enabled)
+            {
+                instance.LoadTargetFrame(tasks, target.path, data); // all sub-images from file
+                if (tasks.IsEmpty()) // sothing wrong with target image. Maybe incompatible geometry or etc.
+                    console.NoteLn("* Skipping target on error");
+            }
+            else
+                console.NoteLn("* Skipping disabled target");
+        }
+
+    private:
+
+        CosmeticCorrectionInstance& instance;
+        const CCTaskData& data;
+    };
+
     bool CosmeticCorrectionInstance::ExecuteGlobal()
     {
         Console console;
@@ -964,136 +986,59 @@ namespace pcl
 
             PrepareMasterDarkMaps();
 
-            //Console().WriteLn( "Prepare thread TargetList." );
-            ImageItem item;
-
-            /* ### */
-
             size_t succeeded = 0;
             size_t skipped = 0;
             int numberOfThreads = Thread::NumberOfThreads( PCL_MAX_PROCESSORS, 1 );
-            thread_list runningThreads( Min( int( p_targetFrames.Length() ), numberOfThreads ) );
-            thread_list waitingThreads;
-            image_list targets( p_targetFrames );
+            int numberOfWorkers = Max( 1, Min( int( p_targetFrames.Length() ), numberOfThreads ) );
 
-            CCThreadData threadData;
-            threadData.avrMT = AvrMT();
-            threadData.medMT = MedMT();
-            threadData.bkgMT = BkgMT();
-            threadData.maxProcessors = 1 + (numberOfThreads - runningThreads.Length())/runningThreads.Length();
-            threadData.avrMT->EnableParallelProcessing( threadData.maxProcessors > 1, threadData.maxProcessors );
-            threadData.medMT->EnableParallelProcessing( threadData.maxProcessors > 1, threadData.maxProcessors );
-            threadData.bkgMT->EnableParallelProcessing( threadData.maxProcessors > 1, threadData.maxProcessors );
-
-            /* ### */
+            CCTaskData taskData;
+            taskData.avrMT = AvrMT();
+            taskData.medMT = MedMT();
+            taskData.bkgMT = BkgMT();
+            taskData.maxProcessors = 1 + (numberOfThreads - numberOfWorkers)/numberOfWorkers;
+            taskData.avrMT->EnableParallelProcessing( taskData.maxProcessors > 1, taskData.maxProcessors );
+            taskData.medMT->EnableParallelProcessing( taskData.maxProcessors > 1, taskData.maxProcessors );
+            taskData.bkgMT->EnableParallelProcessing( taskData.maxProcessors > 1, taskData.maxProcessors );
 
             console.WriteLn(String().Format("<br>CosmeticCorrection of %u target frames:", p_targetFrames.Length()));
-            console.WriteLn(String().Format("* Using %u worker threads", runningThreads.Length()));
+            console.WriteLn(String().Format("* Using %d worker threads", numberOfWorkers));
+
+            // Files are loaded, corrected and written by a three-stage pipeline.
+            // We are woken up as soon as a stage completes; the wait timeout
+            // only serves to keep the GUI responsive.
+            CCPipeline pipeline(*this, taskData, numberOfWorkers);
 
             try //try 2
             {
-                int running = 0; // running = Qty sub-images processing now = Qty CPU isActiv now. /* ### */
-                do
+                pipeline.Start(p_targetFrames.Length());
+                for (;;)
                 {
-                     /* ### */
                      // Keep the GUI responsive
                      Module->ProcessEvents();
                      if ( console.AbortRequested() )
                         throw ProcessAborted();
-                     /* ### */
-
-                     // ------------------------------------------------------------
-                    // Open File
-                    if (!targets.IsEmpty() && waitingThreads.IsEmpty())
-                    {
-                        item = *targets; // take one from the top of targets list
-                        targets.Remove(targets.Begin()); // remove top file from the list
-                        console.WriteLn(String().Format("<br>File %u of %u",
-                                p_targetFrames.Length() - targets.Length(), p_targetFrames.Length()));
-                        if (item.enabled)
-                        {
-                            waitingThreads = LoadTargetFrame(item.path, threadData); // put all sub-images from file to waitingThreads
-                            if (waitingThreads.IsEmpty()) // sothing wrong with target image. Maybe incompatible geometry or etc.
-                            {
-                                ++skipped;
-                                console.NoteLn("* Skipping target on error");
-                            }
-                        }
-                        else
-                        {
-                            ++skipped;
-                            console.NoteLn("* Skipping disabled target");
-                        }
-                    }
-
-                    // ------------------------------------------------------------
-                    // Find idle or free CPU
-                    thread_list::iterator i = 0;
-                    for (thread_list::iterator j = runningThreads.Begin(); j != runningThreads.End(); ++j) //Cycle in CPU units
-                    {
-                        if (*j == 0) // the CPU is free and empty.
-                        {
-                            if (!waitingThreads.IsEmpty()) // there are not processed images
-                            {
-                                i = j;
-                                break; // i pointed to CPU which is free now.
-                            }
-                        } // *j != 0 the CPU is non free and maybe idle or active
-                        else if (!(*j)->IsActive()) // the CPU is idle = the CPU has finished processing
-                        {
-                            i = j;
-                            break; // i pointed to CPU thread which ready to save.
-                        }
-                    }
-
-                    if (i == 0) // all CPU IsActive or no new images
-                    {
-                        pcl::Sleep(100);
+
+                     BatchPipeline::Event event;
+                     if (!pipeline.WaitForEvent(event, 250))
+                     {
+                        if (pipeline.IsComplete())
+                           break;
                         continue;
-                    }
-
-                    // ------------------------------------------------------------
-                    // Write File
-                    if (*i != 0) //the CPU is idle
-                    {
-                        running--;
-                        try
-                        {
-                           if ( !(*i)->Success() )
-                              throw Error( (*i)->ConsoleOutputText() );
-
-                            console.WriteLn(String().Format("<br>CPU#%u done. %u pixels corrected.",
-                                                            i - runningThreads.Begin(), (*i)->Count() ) );
-                            SaveImage(*i);
-                            runningThreads.Delete(i); //prepare thread for next image. now (*i == 0) the CPU is free
-                        }
-                        catch (...)
-                        {
-                            runningThreads.Delete(i);
-                            throw;
-                        }
-                        ++succeeded;
-                    } //now (*i == 0) the CPU is free
+                     }
 
-                     /* ### */
-                     // Keep the GUI responsive
-                     Module->ProcessEvents();
-                     if ( console.AbortRequested() )
-                        throw ProcessAborted();
-                     /* ### */
-
-                    // ------------------------------------------------------------
-                    // Put image to empty runningThreads slot and Run()
-                    if (!waitingThreads.IsEmpty())
-                    {
-                        *i = *waitingThreads; //put one sub-image to runningThreads. so, now (*i != 0)
-                        waitingThreads.Remove(waitingThreads.Begin()); //remove one sub-image from waitingThreads
-                        console.WriteLn(String().Format("<br>CPU#%u processing file ", i - runningThreads.Begin()) + item.path);
-                        (*i)->Start(ThreadPriority::DefaultMax, i - runningThreads.Begin());
-                        running++;
-                    }
+                     if (!event.consoleText.IsEmpty())
+                        console.Write("<end><cbr>" + event.consoleText);
+
+                     if (!event.success)
+                        throw CatchedException(); // error already reported by the pipeline
+
+                     if (event.stage == BatchStage::Load && event.numberOfTasks == 0)
+                        ++skipped;
+                     else if (event.stage == BatchStage::Write)
+                        ++succeeded;
                 }
-                while (running > 0 || !targets.IsEmpty());
+
+                console.WriteLn("<end><cbr><br>Pipeline timing:\n" + pipeline.TimingReport());
             }// try 2
             catch (...)
             {
@@ -1103,36 +1048,9 @@ namespace pcl
                }
                ERROR_HANDLER;
 
-               /* ### */
-
                console.NoteLn( "<end><cbr><br>* Waiting for running tasks to terminate ..." );
-               for ( thread_list::iterator i = runningThreads.Begin(); i != runningThreads.End(); ++i )
-                  if ( *i != 0 ) (*i)->Abort();
-               for ( thread_list::iterator i = runningThreads.Begin(); i != runningThreads.End(); ++i )
-                  if ( *i != 0 ) (*i)->Wait();
-               runningThreads.Destroy();
-               waitingThreads.Destroy();
+               pipeline.Abort();
                throw;
-
-               /*
-                bool printed = false;
-                for (thread_list::iterator i = runningThreads.Begin(); i != runningThreads.End(); ++i)
-                    if (*i != 0)
-                    {
-                        if (!printed)
-                        {
-                            console.Write("<br>** Waiting for running tasks at CPU# ");
-                            printed = true;
-                        }
-                        console.Write(String().Format(":%u ", i - runningThreads.Begin()));
-                        console.Flush();
-                        (*i)->Wait();
-                    }
-                console.WriteLn("<br>** All running tasks are terminated.");
-                runningThreads.Destroy();
-                waitingThreads.Destroy();
-                */
-               /* ### */
             }
 
             if (m_mapDarkHot != 0) delete m_mapDarkHot, m_mapDarkHot = 0;
@@ -55,6 +55,7 @@
 #define __CosmeticCorrectionInstance_h
 
 #include <pcl/ProcessImplementation.h>
+#include <pcl/BatchPipeline.h>
 #include <pcl/Convolution.h>
 #include <pcl/FileFormatInstance.h>
 #include <pcl/MorphologicalTransformation.h>
@@ -69,10 +70,8 @@ namespace pcl
 
 // ----------------------------------------------------------------------------
 
-class CCThread;
-struct CCThreadData;
-
-typedef IndirectArray<CCThread> thread_list;
+class CCTask;
+struct CCTaskData;
 
 class CosmeticCorrectionInstance : public ProcessImplementation
 {
@@ -173,11 +172,12 @@ private:
     inline DarkImg GetDark( const String& );
     void   PrepareMasterDarkMaps();
 
-    inline thread_list LoadTargetFrame( const String& , const CCThreadData& );
+    inline void LoadTargetFrame( BatchPipeline::task_list&, const String& , const CCTaskData& );
     inline String OutputFilePath( const String& , const size_t );
-    inline void SaveImage( const CCThread* );
+    inline void SaveImage( const CCTask* );
 
-    friend class CCThread;
+    friend class CCTask;
+    friend class CCPipeline;
     friend class CosmeticCorrectionInterface;
 };
 
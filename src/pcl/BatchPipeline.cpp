@@ -0,0 +1,488 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/BatchPipeline.cpp - Released 2016/02/21 20:22:12 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#include <pcl/BatchPipeline.h>
+#include <pcl/ErrorHandler.h>
+#include <pcl/ReferenceArray.h>
+#include <pcl/Thread.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+typedef std::chrono::steady_clock   pipeline_clock;
+
+class PipelineWorker;
+
+struct PipelineData
+{
+   BatchPipeline&                  pipeline;
+   int                             numberOfThreads[ BatchStage::NumberOfStages ];
+   int                             activeThreads[ BatchStage::NumberOfStages ];
+   size_type                       capacity;
+   ReferenceArray<PipelineWorker>  workers;
+
+   std::mutex                      mutex;
+   std::condition_variable         wakeUp;       // workers wait for tasks or room in queues
+   std::condition_variable         eventPosted;  // the controlling thread waits for events
+   std::deque<BatchPipeline::Task*> processQueue; // loaded tasks
+   std::deque<BatchPipeline::Task*> writeQueue;   // processed tasks
+   std::deque<BatchPipeline::Event> events;
+   size_type                       numberOfItems;
+   size_type                       nextItem;
+   bool                            started;
+   std::atomic<bool>               aborted;
+
+   double                          stageTime[ BatchStage::NumberOfStages ];
+   size_type                       stageCount[ BatchStage::NumberOfStages ];
+   pipeline_clock::time_point      startTime;
+   pipeline_clock::time_point      endTime;
+
+   PipelineData( BatchPipeline& p ) :
+      pipeline( p ), capacity( 0 ), numberOfItems( 0 ), nextItem( 0 ), started( false ), aborted( false )
+   {
+      for ( int i = 0; i < BatchStage::NumberOfStages; ++i )
+      {
+         numberOfThreads[i] = activeThreads[i] = 0;
+         stageTime[i] = 0;
+         stageCount[i] = 0;
+      }
+   }
+
+   bool IsFinished() const
+   {
+      for ( int i = 0; i < BatchStage::NumberOfStages; ++i )
+         if ( activeThreads[i] > 0 )
+            return false;
+      return true;
+   }
+
+   /*
+    * The following member functions must be called with the mutex locked.
+    */
+
+   void PostEvent( const BatchPipeline::Event& event )
+   {
+      events.push_back( event );
+      eventPosted.notify_all();
+   }
+
+   void ThreadFinished( BatchStage::value_type stage )
+   {
+      if ( --activeThreads[stage] == 0 )
+      {
+         if ( IsFinished() )
+         {
+            endTime = pipeline_clock::now();
+            eventPosted.notify_all();
+         }
+         wakeUp.notify_all();
+      }
+   }
+
+   void AddTime( BatchStage::value_type stage, pipeline_clock::time_point t0 )
+   {
+      stageTime[stage] += std::chrono::duration<double>( pipeline_clock::now() - t0 ).count();
+      ++stageCount[stage];
+   }
+};
+
+#define D   reinterpret_cast<PipelineData*>( m_data )
+
+// ----------------------------------------------------------------------------
+
+class PipelineWorker : public Thread
+{
+public:
+
+   PipelineWorker( PipelineData& data, BatchStage::value_type stage ) :
+      Thread(), m_data( data ), m_stage( stage )
+   {
+   }
+
+   virtual void Run()
+   {
+      try
+      {
+         switch ( m_stage )
+         {
+         case BatchStage::Load:    RunLoader(); break;
+         case BatchStage::Process: RunProcessor(); break;
+         case BatchStage::Write:   RunWriter(); break;
+         default: break;
+         }
+      }
+      catch ( ... )
+      {
+         /* ### Do _not_ propagate exceptions from a running thread */
+      }
+
+      std::lock_guard<std::mutex> lock( m_data.mutex );
+      m_data.ThreadFinished( m_stage );
+   }
+
+private:
+
+   PipelineData&          m_data;
+   BatchStage::value_type m_stage;
+
+   /*
+    * Executes a stage function. Returns true iff the function completed
+    * without throwing exceptions and the pipeline has not been aborted. The
+    * console output generated by the function is returned in text.
+    */
+   template <class F>
+   bool Execute( F f, String& text )
+   {
+      bool success = true;
+      try
+      {
+         f();
+      }
+      catch ( ... )
+      {
+         success = false;
+         try
+         {
+            try
+            {
+               throw;
+            }
+            ERROR_HANDLER
+         }
+         catch ( ... )
+         {
+         }
+      }
+
+      text = ConsoleOutputText();
+      ClearConsoleOutputText();
+      return success && !m_data.aborted;
+   }
+
+   void RunLoader()
+   {
+      for ( ;; )
+      {
+         size_type item;
+         {
+            std::unique_lock<std::mutex> lock( m_data.mutex );
+            m_data.wakeUp.wait( lock, [this]{ return m_data.aborted ||
+                                                     m_data.nextItem == m_data.numberOfItems ||
+                                                     m_data.processQueue.size() < m_data.capacity; } );
+            if ( m_data.aborted || m_data.nextItem == m_data.numberOfItems )
+               return;
+            item = m_data.nextItem++;
+         }
+
+         BatchPipeline::task_list tasks;
+         BatchPipeline::Event event;
+         event.stage = BatchStage::Load;
+         event.item = item;
+         pipeline_clock::time_point t0 = pipeline_clock::now();
+         event.success = Execute( [&]{ m_data.pipeline.Load( tasks, item ); }, event.consoleText );
+
+         std::lock_guard<std::mutex> lock( m_data.mutex );
+         m_data.AddTime( BatchStage::Load, t0 );
+         if ( event.success )
+         {
+            for ( BatchPipeline::task_list::iterator i = tasks.Begin(); i != tasks.End(); ++i )
+            {
+               (*i)->m_pipeline = &m_data.pipeline;
+               (*i)->m_item = item;
+               m_data.processQueue.push_back( *i );
+            }
+            event.numberOfTasks = int( tasks.Length() );
+            tasks.Clear();
+            m_data.wakeUp.notify_all();
+         }
+         else
+            tasks.Destroy();
+         m_data.PostEvent( event );
+      }
+   }
+
+   void RunProcessor()
+   {
+      for ( ;; )
+      {
+         BatchPipeline::Task* task;
+         {
+            std::unique_lock<std::mutex> lock( m_data.mutex );
+            m_data.wakeUp.wait( lock, [this]{ return m_data.aborted ||
+                                                     !m_data.processQueue.empty() ||
+                                                     m_data.activeThreads[BatchStage::Load] == 0; } );
+            if ( m_data.aborted || m_data.processQueue.empty() )
+               return;
+            task = m_data.processQueue.front();
+            m_data.processQueue.pop_front();
+            // There is room for more loaded tasks now.
+            m_data.wakeUp.notify_all();
+         }
+
+         BatchPipeline::Event event;
+         event.stage = BatchStage::Process;
+         event.item = task->m_item;
+         pipeline_clock::time_point t0 = pipeline_clock::now();
+         event.success = Execute( [task]{ task->Process(); }, event.consoleText );
+
+         std::unique_lock<std::mutex> lock( m_data.mutex );
+         m_data.AddTime( BatchStage::Process, t0 );
+         m_data.PostEvent( event );
+         if ( event.success )
+         {
+            m_data.wakeUp.wait( lock, [this]{ return m_data.aborted || m_data.writeQueue.size() < m_data.capacity; } );
+            if ( !m_data.aborted )
+            {
+               m_data.writeQueue.push_back( task );
+               m_data.wakeUp.notify_all();
+               continue;
+            }
+         }
+         delete task;
+      }
+   }
+
+   void RunWriter()
+   {
+      for ( ;; )
+      {
+         BatchPipeline::Task* task;
+         {
+            std::unique_lock<std::mutex> lock( m_data.mutex );
+            m_data.wakeUp.wait( lock, [this]{ return m_data.aborted ||
+                                                     !m_data.writeQueue.empty() ||
+                                                     m_data.activeThreads[BatchStage::Load] == 0 &&
+                                                     m_data.activeThreads[BatchStage::Process] == 0; } );
+            if ( m_data.aborted || m_data.writeQueue.empty() )
+               return;
+            task = m_data.writeQueue.front();
+            m_data.writeQueue.pop_front();
+            // There is room for more processed tasks now.
+            m_data.wakeUp.notify_all();
+         }
+
+         BatchPipeline::Event event;
+         event.stage = BatchStage::Write;
+         event.item = task->m_item;
+         pipeline_clock::time_point t0 = pipeline_clock::now();
+         event.success = Execute( [task]{ task->Write(); }, event.consoleText );
+         delete task;
+
+         std::lock_guard<std::mutex> lock( m_data.mutex );
+         m_data.AddTime( BatchStage::Write, t0 );
+         m_data.PostEvent( event );
+      }
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+bool BatchPipeline::Task::IsAborted() const
+{
+   return m_pipeline != nullptr && m_pipeline->IsAborted();
+}
+
+// ----------------------------------------------------------------------------
+
+BatchPipeline::BatchPipeline( int numberOfLoaders, int numberOfWorkers, int numberOfWriters, int queueCapacity ) :
+   m_data( nullptr )
+{
+   PipelineData* data = new PipelineData( *this );
+   data->numberOfThreads[BatchStage::Load] = Max( 1, numberOfLoaders );
+   data->numberOfThreads[BatchStage::Process] = Max( 1, numberOfWorkers );
+   data->numberOfThreads[BatchStage::Write] = Max( 1, numberOfWriters );
+   data->capacity = size_type( (queueCapacity > 0) ? queueCapacity : 1 );
+   m_data = data;
+}
+
+BatchPipeline::~BatchPipeline()
+{
+   try
+   {
+      Abort();
+   }
+   catch ( ... )
+   {
+   }
+   delete D;
+}
+
+void BatchPipeline::Start( size_type numberOfItems )
+{
+   {
+      std::lock_guard<std::mutex> lock( D->mutex );
+      if ( D->started )
+         throw Error( "BatchPipeline::Start(): The pipeline has already been started." );
+      D->started = true;
+      D->numberOfItems = numberOfItems;
+      D->startTime = D->endTime = pipeline_clock::now();
+      for ( int s = 0; s < BatchStage::NumberOfStages; ++s )
+         D->activeThreads[s] = D->numberOfThreads[s];
+   }
+
+   /*
+    * Compute stage threads can be given processor affinity, if enabled on
+    * the platform via global preferences.
+    */
+   for ( int s = 0; s < BatchStage::NumberOfStages; ++s )
+      for ( int i = 0; i < D->numberOfThreads[s]; ++i )
+      {
+         PipelineWorker* worker = new PipelineWorker( *D, BatchStage::value_type( s ) );
+         D->workers.Add( worker );
+         if ( s == BatchStage::Process )
+            worker->Start( ThreadPriority::DefaultMax, i );
+         else
+            worker->Start( ThreadPriority::DefaultMax );
+      }
+}
+
+bool BatchPipeline::WaitForEvent( Event& event, unsigned ms )
+{
+   std::unique_lock<std::mutex> lock( D->mutex );
+   D->eventPosted.wait_for( lock, std::chrono::milliseconds( ms ),
+                            [this]{ return !D->events.empty() || D->started && D->IsFinished(); } );
+   if ( D->events.empty() )
+      return false;
+   event = D->events.front();
+   D->events.pop_front();
+   return true;
+}
+
+bool BatchPipeline::IsComplete() const
+{
+   std::lock_guard<std::mutex> lock( D->mutex );
+   return D->started && D->IsFinished() && D->events.empty();
+}
+
+void BatchPipeline::Abort()
+{
+   {
+      std::lock_guard<std::mutex> lock( D->mutex );
+      D->aborted = true;
+      D->wakeUp.notify_all();
+   }
+
+   for ( ReferenceArray<PipelineWorker>::iterator i = D->workers.Begin(); i != D->workers.End(); ++i )
+      i->Abort();
+   for ( ReferenceArray<PipelineWorker>::iterator i = D->workers.Begin(); i != D->workers.End(); ++i )
+      i->Wait();
+   D->workers.Destroy();
+
+   std::lock_guard<std::mutex> lock( D->mutex );
+   for ( std::deque<Task*>::iterator i = D->processQueue.begin(); i != D->processQueue.end(); ++i )
+      delete *i;
+   D->processQueue.clear();
+   for ( std::deque<Task*>::iterator i = D->writeQueue.begin(); i != D->writeQueue.end(); ++i )
+      delete *i;
+   D->writeQueue.clear();
+}
+
+bool BatchPipeline::IsAborted() const
+{
+   return D->aborted;
+}
+
+double BatchPipeline::StageTime( BatchStage::value_type stage ) const
+{
+   std::lock_guard<std::mutex> lock( D->mutex );
+   return D->stageTime[stage];
+}
+
+size_type BatchPipeline::StageCount( BatchStage::value_type stage ) const
+{
+   std::lock_guard<std::mutex> lock( D->mutex );
+   return D->stageCount[stage];
+}
+
+double BatchPipeline::ElapsedTime() const
+{
+   std::lock_guard<std::mutex> lock( D->mutex );
+   if ( !D->started )
+      return 0;
+   pipeline_clock::time_point t1 = D->IsFinished() ? D->endTime : pipeline_clock::now();
+   return std::chrono::duration<double>( t1 - D->startTime ).count();
+}
+
+String BatchPipeline::TimingReport() const
+{
+   static const char* stageNames[] = { "Load", "Process", "Write" };
+
+   String report;
+   for ( int s = 0; s < BatchStage::NumberOfStages; ++s )
+   {
+      double t = StageTime( BatchStage::value_type( s ) );
+      size_type n = StageCount( BatchStage::value_type( s ) );
+      report.AppendFormat( "%-8s: %2d thread(s), %6llu task(s), %10.3f s",
+                           stageNames[s], D->numberOfThreads[s], (unsigned long long)n, t );
+      if ( n > 0 )
+         report.AppendFormat( " (%.3f s/task)", t/n );
+      report << '\n';
+   }
+   report.AppendFormat( "Elapsed : %.3f s", ElapsedTime() );
+   return report;
+}
+
+#undef D
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+// ----------------------------------------------------------------------------
+// EOF pcl/BatchPipeline.cpp - Released 2016/02/21 20:22:12 UTC
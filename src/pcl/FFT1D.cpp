@@ -49,140 +49,1056 @@
 // POSSIBILITY OF SUCH DAMAGE.
 // ----------------------------------------------------------------------------
 
+#include <pcl/AutoPointer.h>
 #include <pcl/FFT1D.h>
 
-#include <pcl/api/APIException.h>
-#include <pcl/api/APIInterface.h>
+#include <mutex>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __PCL_MACOSX )
+# define __PCL_FFT_SSE2 1
+# include <emmintrin.h>
+#endif
+
+/*
+ * Native mixed-radix FFT engine.
+ *
+ * Complex transforms are computed with a recursive decimation-in-time
+ * algorithm derived from the KISS FFT library, with specialized butterflies
+ * for radices 2, 3, 4 and 5, and a generic butterfly for other prime factors.
+ * Twiddle factors are stored contiguously for each stage, which allows for
+ * SSE2 vectorization of the radix-2 and radix-4 butterflies. Lengths with
+ * prime factors larger than FFT_MAX_GENERIC_RADIX are transformed with
+ * Bluestein's algorithm.
+ *
+ * Real transforms of even length are computed as complex transforms of half
+ * length with pre- and post-processing. DCT-II and DCT-III transforms are
+ * computed with Makhoul's algorithm, as real transforms of the same length.
+ *
+ * Transform plans are immutable and can be used concurrently from multiple
+ * threads. Plans are cached and shared by all transforms of the same type
+ * and length.
+ */
 
 namespace pcl
 {
 
 // ----------------------------------------------------------------------------
 
+/*
+ * Largest prime factor transformed with a generic butterfly.
+ */
+#define FFT_MAX_GENERIC_RADIX    61
+
+/*
+ * Maximum number of cached plans that are not currently in use.
+ */
+#define FFT_MAX_IDLE_PLANS       32
+
+// ----------------------------------------------------------------------------
+
+template <typename T> inline static
+Complex<T> FFTMul( const Complex<T>& a, const Complex<T>& b )
+{
+   return Complex<T>( a.Real()*b.Real() - a.Imag()*b.Imag(), a.Real()*b.Imag() + a.Imag()*b.Real() );
+}
+
+template <typename T> inline static
+Complex<T> FFTRoot( double k, double n, bool inverse )
+{
+   double s, c;
+   SinCos( (inverse ? +2 : -2)*double( Pi() )*k/n, s, c );
+   return Complex<T>( T( c ), T( s ) );
+}
+
+/*
+ * Complex vector operations for SIMD butterflies.
+ */
+template <typename T>
+struct FFTScalarOps
+{
+   typedef Complex<T> complex;
+   typedef Complex<T> vector;
+
+   static const int length = 1;
+
+   static vector Load( const complex* p )
+   {
+      return *p;
+   }
+
+   static void Store( complex* p, const vector& v )
+   {
+      *p = v;
+   }
+
+   static vector Add( const vector& a, const vector& b )
+   {
+      return vector( a.Real() + b.Real(), a.Imag() + b.Imag() );
+   }
+
+   static vector Sub( const vector& a, const vector& b )
+   {
+      return vector( a.Real() - b.Real(), a.Imag() - b.Imag() );
+   }
+
+   static vector Mul( const vector& a, const vector& b )
+   {
+      return FFTMul( a, b );
+   }
+
+   static vector MulI( const vector& a )
+   {
+      return vector( -a.Imag(), a.Real() );
+   }
+};
+
+#ifdef __PCL_FFT_SSE2
+
+/*
+ * Two single precision complex numbers per vector.
+ */
+struct FFTSSE2OpsF
+{
+   typedef fcomplex complex;
+   typedef __m128   vector;
+
+   static const int length = 2;
+
+   static vector Load( const complex* p )
+   {
+      return _mm_loadu_ps( reinterpret_cast<const float*>( p ) );
+   }
+
+   static void Store( complex* p, vector v )
+   {
+      _mm_storeu_ps( reinterpret_cast<float*>( p ), v );
+   }
+
+   static vector Add( vector a, vector b )
+   {
+      return _mm_add_ps( a, b );
+   }
+
+   static vector Sub( vector a, vector b )
+   {
+      return _mm_sub_ps( a, b );
+   }
+
+   static vector RealSign()
+   {
+      return _mm_castsi128_ps( _mm_set_epi32( 0, int( 0x80000000 ), 0, int( 0x80000000 ) ) );
+   }
+
+   static vector Mul( vector a, vector b )
+   {
+      vector re = _mm_shuffle_ps( b, b, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+      vector im = _mm_shuffle_ps( b, b, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+      vector sw = _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+      return _mm_add_ps( _mm_mul_ps( a, re ), _mm_xor_ps( _mm_mul_ps( sw, im ), RealSign() ) );
+   }
+
+   static vector MulI( vector a )
+   {
+      return _mm_xor_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 3, 0, 1 ) ), RealSign() );
+   }
+};
+
+/*
+ * One double precision complex number per vector.
+ */
+struct FFTSSE2OpsD
+{
+   typedef dcomplex complex;
+   typedef __m128d  vector;
+
+   static const int length = 1;
+
+   static vector Load( const complex* p )
+   {
+      return _mm_loadu_pd( reinterpret_cast<const double*>( p ) );
+   }
+
+   static void Store( complex* p, vector v )
+   {
+      _mm_storeu_pd( reinterpret_cast<double*>( p ), v );
+   }
+
+   static vector Add( vector a, vector b )
+   {
+      return _mm_add_pd( a, b );
+   }
+
+   static vector Sub( vector a, vector b )
+   {
+      return _mm_sub_pd( a, b );
+   }
+
+   static vector RealSign()
+   {
+      return _mm_set_pd( 0.0, -0.0 );
+   }
+
+   static vector Mul( vector a, vector b )
+   {
+      vector re = _mm_unpacklo_pd( b, b );
+      vector im = _mm_unpackhi_pd( b, b );
+      vector sw = _mm_shuffle_pd( a, a, 1 );
+      return _mm_add_pd( _mm_mul_pd( a, re ), _mm_xor_pd( _mm_mul_pd( sw, im ), RealSign() ) );
+   }
+
+   static vector MulI( vector a )
+   {
+      return _mm_xor_pd( _mm_shuffle_pd( a, a, 1 ), RealSign() );
+   }
+};
+
+#endif   // __PCL_FFT_SSE2
+
+// ----------------------------------------------------------------------------
+
+template <class V, typename C> static PCL_HOT_FUNCTION
+void FFTRadix2( C* F, const C* tw, int m )
+{
+   C* F1 = F + m;
+   for ( int j = 0; j < m; j += V::length )
+   {
+      typename V::vector t = V::Mul( V::Load( F1+j ), V::Load( tw+j ) );
+      typename V::vector f = V::Load( F+j );
+      V::Store( F1+j, V::Sub( f, t ) );
+      V::Store( F+j, V::Add( f, t ) );
+   }
+}
+
+template <class V, typename C> static PCL_HOT_FUNCTION
+void FFTRadix4( C* F, const C* tw, int m, bool inverse )
+{
+   C* F1 = F + m;
+   C* F2 = F1 + m;
+   C* F3 = F2 + m;
+   const C* tw1 = tw;
+   const C* tw2 = tw1 + m;
+   const C* tw3 = tw2 + m;
+   for ( int j = 0; j < m; j += V::length )
+   {
+      typename V::vector f0 = V::Load( F+j );
+      typename V::vector s0 = V::Mul( V::Load( F1+j ), V::Load( tw1+j ) );
+      typename V::vector s1 = V::Mul( V::Load( F2+j ), V::Load( tw2+j ) );
+      typename V::vector s2 = V::Mul( V::Load( F3+j ), V::Load( tw3+j ) );
+      typename V::vector s5 = V::Sub( f0, s1 );
+      f0 = V::Add( f0, s1 );
+      typename V::vector s3 = V::Add( s0, s2 );
+      typename V::vector s4 = V::MulI( V::Sub( s0, s2 ) );
+      V::Store( F2+j, V::Sub( f0, s3 ) );
+      V::Store( F+j, V::Add( f0, s3 ) );
+      if ( inverse )
+      {
+         V::Store( F1+j, V::Add( s5, s4 ) );
+         V::Store( F3+j, V::Sub( s5, s4 ) );
+      }
+      else
+      {
+         V::Store( F1+j, V::Sub( s5, s4 ) );
+         V::Store( F3+j, V::Add( s5, s4 ) );
+      }
+   }
+}
+
+template <typename T> static PCL_HOT_FUNCTION
+void FFTRadix3( Complex<T>* F, const Complex<T>* tw, int m, bool inverse )
+{
+   typedef Complex<T> complex;
+   const T epi3 = T( inverse ? +0.86602540378443864676 : -0.86602540378443864676 ); // sin( ±2*pi/3 )
+   complex* F1 = F + m;
+   complex* F2 = F1 + m;
+   const complex* tw1 = tw;
+   const complex* tw2 = tw1 + m;
+   for ( int j = 0; j < m; ++j )
+   {
+      complex s1 = FFTMul( F1[j], tw1[j] );
+      complex s2 = FFTMul( F2[j], tw2[j] );
+      complex s3( s1.Real() + s2.Real(), s1.Imag() + s2.Imag() );
+      complex s0( epi3*(s1.Real() - s2.Real()), epi3*(s1.Imag() - s2.Imag()) );
+      complex f1( F[j].Real() - s3.Real()/2, F[j].Imag() - s3.Imag()/2 );
+      F[j] = complex( F[j].Real() + s3.Real(), F[j].Imag() + s3.Imag() );
+      F2[j] = complex( f1.Real() + s0.Imag(), f1.Imag() - s0.Real() );
+      F1[j] = complex( f1.Real() - s0.Imag(), f1.Imag() + s0.Real() );
+   }
+}
+
+template <typename T> static PCL_HOT_FUNCTION
+void FFTRadix5( Complex<T>* F, const Complex<T>* tw, int m, bool inverse )
+{
+   typedef Complex<T> complex;
+   const complex ya = FFTRoot<T>( 1, 5, inverse );
+   const complex yb = FFTRoot<T>( 2, 5, inverse );
+   complex* F1 = F + m;
+   complex* F2 = F1 + m;
+   complex* F3 = F2 + m;
+   complex* F4 = F3 + m;
+   const complex* tw1 = tw;
+   const complex* tw2 = tw1 + m;
+   const complex* tw3 = tw2 + m;
+   const complex* tw4 = tw3 + m;
+   for ( int j = 0; j < m; ++j )
+   {
+      complex s0 = F[j];
+      complex s1 = FFTMul( F1[j], tw1[j] );
+      complex s2 = FFTMul( F2[j], tw2[j] );
+      complex s3 = FFTMul( F3[j], tw3[j] );
+      complex s4 = FFTMul( F4[j], tw4[j] );
+
+      complex s7( s1.Real() + s4.Real(), s1.Imag() + s4.Imag() );
+      complex s10( s1.Real() - s4.Real(), s1.Imag() - s4.Imag() );
+      complex s8( s2.Real() + s3.Real(), s2.Imag() + s3.Imag() );
+      complex s9( s2.Real() - s3.Real(), s2.Imag() - s3.Imag() );
+
+      F[j] = complex( s0.Real() + s7.Real() + s8.Real(), s0.Imag() + s7.Imag() + s8.Imag() );
+
+      complex s5( s0.Real() + s7.Real()*ya.Real() + s8.Real()*yb.Real(),
+                  s0.Imag() + s7.Imag()*ya.Real() + s8.Imag()*yb.Real() );
+      complex s6( s10.Imag()*ya.Imag() + s9.Imag()*yb.Imag(),
+                 -s10.Real()*ya.Imag() - s9.Real()*yb.Imag() );
+      F1[j] = complex( s5.Real() - s6.Real(), s5.Imag() - s6.Imag() );
+      F4[j] = complex( s5.Real() + s6.Real(), s5.Imag() + s6.Imag() );
+
+      complex s11( s0.Real() + s7.Real()*yb.Real() + s8.Real()*ya.Real(),
+                   s0.Imag() + s7.Imag()*yb.Real() + s8.Imag()*ya.Real() );
+      complex s12( -s10.Imag()*yb.Imag() + s9.Imag()*ya.Imag(),
+                    s10.Real()*yb.Imag() - s9.Real()*ya.Imag() );
+      F2[j] = complex( s11.Real() + s12.Real(), s11.Imag() + s12.Imag() );
+      F3[j] = complex( s11.Real() - s12.Real(), s11.Imag() - s12.Imag() );
+   }
+}
+
+template <typename T> static PCL_HOT_FUNCTION
+void FFTRadixGeneric( Complex<T>* F, const Complex<T>* roots, int n, size_type fstride, int p, int m )
+{
+   typedef Complex<T> complex;
+   complex buffer[ FFT_MAX_GENERIC_RADIX ];
+   for ( int u = 0; u < m; ++u )
+   {
+      for ( int q = 0, k = u; q < p; ++q, k += m )
+         buffer[q] = F[k];
+      for ( int q1 = 0, k = u; q1 < p; ++q1, k += m )
+      {
+         size_type step = (fstride*k) % n;
+         size_type t = 0;
+         complex f = buffer[0];
+         for ( int q = 1; q < p; ++q )
+         {
+            t += step;
+            if ( t >= size_type( n ) )
+               t -= n;
+            f += FFTMul( buffer[q], roots[t] );
+         }
+         F[k] = f;
+      }
+   }
+}
+
+/*
+ * Vectorized butterflies for each scalar type. Single precision vectors store
+ * two complex numbers, so they require an even number of butterflies.
+ */
+template <typename T>
+struct FFTButterflies
+{
+   static void Radix2( Complex<T>* F, const Complex<T>* tw, int m )
+   {
+      FFTRadix2<FFTScalarOps<T> >( F, tw, m );
+   }
+
+   static void Radix4( Complex<T>* F, const Complex<T>* tw, int m, bool inverse )
+   {
+      FFTRadix4<FFTScalarOps<T> >( F, tw, m, inverse );
+   }
+};
+
+#ifdef __PCL_FFT_SSE2
+
+template <>
+struct FFTButterflies<float>
+{
+   static void Radix2( fcomplex* F, const fcomplex* tw, int m )
+   {
+      if ( m & 1 )
+         FFTRadix2<FFTScalarOps<float> >( F, tw, m );
+      else
+         FFTRadix2<FFTSSE2OpsF>( F, tw, m );
+   }
+
+   static void Radix4( fcomplex* F, const fcomplex* tw, int m, bool inverse )
+   {
+      if ( m & 1 )
+         FFTRadix4<FFTScalarOps<float> >( F, tw, m, inverse );
+      else
+         FFTRadix4<FFTSSE2OpsF>( F, tw, m, inverse );
+   }
+};
+
+template <>
+struct FFTButterflies<double>
+{
+   static void Radix2( dcomplex* F, const dcomplex* tw, int m )
+   {
+      FFTRadix2<FFTSSE2OpsD>( F, tw, m );
+   }
+
+   static void Radix4( dcomplex* F, const dcomplex* tw, int m, bool inverse )
+   {
+      FFTRadix4<FFTSSE2OpsD>( F, tw, m, inverse );
+   }
+};
+
+#endif   // __PCL_FFT_SSE2
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Smallest integer >= n whose only prime factors are 2, 3 and 5.
+ */
+static int FFTNextFastLength( int n )
+{
+   for ( n = Max( 1, n ); ; ++n )
+   {
+      int m = n;
+      while ( (m & 1) == 0 )
+         m >>= 1;
+      while ( m % 3 == 0 )
+         m /= 3;
+      while ( m % 5 == 0 )
+         m /= 5;
+      if ( m == 1 )
+         return n;
+   }
+}
+
+static int FFTNextFastEvenLength( int n )
+{
+   for ( n = FFTNextFastLength( n ); n & 1; n = FFTNextFastLength( n+1 ) ) {}
+   return n;
+}
+
+// ----------------------------------------------------------------------------
+
+class FFTPlanBase
+{
+public:
+
+   virtual ~FFTPlanBase()
+   {
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+class FFTComplexPlan : public FFTPlanBase
+{
+public:
+
+   typedef Complex<T>     complex;
+   typedef Array<complex> complex_array;
+
+   FFTComplexPlan( int n, bool inverse ) : m_length( n ), m_inverse( inverse )
+   {
+      if ( n < 1 )
+         throw Error( "Invalid FFT length: " + String( n ) );
+
+      /*
+       * Factorization, with radix 4 first, then radices 2, 3, 5, ...
+       */
+      Array<int> radices;
+      for ( int p = 4, q = n, sqrtq = TruncInt( Sqrt( double( q ) ) ); q > 1; q /= p )
+      {
+         while ( q % p )
+         {
+            switch ( p )
+            {
+            case 4:  p = 2; break;
+            case 2:  p = 3; break;
+            default: p += 2; break;
+            }
+            if ( p > sqrtq )
+               p = q;
+         }
+         radices.Add( p );
+      }
+
+      for ( Array<int>::const_iterator p = radices.Begin(); p != radices.End(); ++p )
+         if ( *p > FFT_MAX_GENERIC_RADIX )
+         {
+            InitializeBluestein();
+            return;
+         }
+
+      /*
+       * Twiddle factors for stage s, radix p, are stored contiguously for
+       * each k = 1,...,p-1 as exp( -/+ 2*pi*i*j*k/(p*m) ), j = 0,...,m-1.
+       */
+      bool generic = false;
+      for ( int i = 0, m = n; i < int( radices.Length() ); ++i )
+      {
+         Stage s;
+         s.p = radices[i];
+         s.m = m /= s.p;
+         if ( s.p > 5 )
+            generic = true;
+         else
+         {
+            s.twiddles = complex_array( size_type( s.p - 1 )*s.m );
+            for ( int k = 1; k < s.p; ++k )
+               for ( int j = 0; j < s.m; ++j )
+                  s.twiddles[(k-1)*s.m + j] = FFTRoot<T>( double( j )*k, s.p*s.m, inverse );
+         }
+         m_stages.Add( s );
+      }
+
+      if ( generic )
+      {
+         m_roots = complex_array( n );
+         for ( int k = 0; k < n; ++k )
+            m_roots[k] = FFTRoot<T>( k, n, inverse );
+      }
+   }
+
+   int Length() const
+   {
+      return m_length;
+   }
+
+   void Transform( complex* y, const complex* x ) const
+   {
+      if ( m_length == 1 )
+      {
+         *y = *x;
+         return;
+      }
+
+      if ( !m_chirp.IsEmpty() )
+      {
+         TransformBluestein( y, x );
+         return;
+      }
+
+      const void* x0 = x;
+      const void* x1 = x + m_length;
+      const void* y0 = y;
+      const void* y1 = y + m_length;
+      if ( y1 > x0 && y0 < x1 )
+      {
+         complex_array t( x, x + m_length );
+         Work( y, t.Begin(), 1, 0 );
+      }
+      else
+         Work( y, x, 1, 0 );
+   }
+
+private:
+
+   struct Stage
+   {
+      int           p, m;
+      complex_array twiddles;
+   };
+
+   int                            m_length;
+   bool                           m_inverse;
+   Array<Stage>                   m_stages;
+   complex_array                  m_roots;       // for generic radices
+   complex_array                  m_chirp;       // Bluestein's algorithm
+   complex_array                  m_chirpDFT;
+   AutoPointer<FFTComplexPlan<T> > m_forward;
+   AutoPointer<FFTComplexPlan<T> > m_backward;
+
+   void Work( complex* out, const complex* in, size_type fstride, int stage ) const
+   {
+      const Stage& s = m_stages[stage];
+      int p = s.p;
+      int m = s.m;
+      complex* outEnd = out + size_type( p )*m;
+
+      if ( m == 1 )
+         for ( complex* o = out; o < outEnd; ++o, in += fstride )
+            *o = *in;
+      else
+         for ( complex* o = out; o < outEnd; o += m, in += fstride )
+            Work( o, in, fstride*p, stage+1 );
+
+      switch ( p )
+      {
+      case 2:
+         FFTButterflies<T>::Radix2( out, s.twiddles.Begin(), m );
+         break;
+      case 3:
+         FFTRadix3( out, s.twiddles.Begin(), m, m_inverse );
+         break;
+      case 4:
+         FFTButterflies<T>::Radix4( out, s.twiddles.Begin(), m, m_inverse );
+         break;
+      case 5:
+         FFTRadix5( out, s.twiddles.Begin(), m, m_inverse );
+         break;
+      default:
+         FFTRadixGeneric( out, m_roots.Begin(), m_length, fstride, p, m );
+         break;
+      }
+   }
+
+   /*
+    * Bluestein's algorithm: the transform is computed as a circular
+    * convolution with a chirp sequence, evaluated with transforms of a larger
+    * length with small prime factors.
+    */
+   void InitializeBluestein()
+   {
+      int n = m_length;
+      int M = FFTNextFastLength( 2*n - 1 );
+      m_forward = new FFTComplexPlan<T>( M, false );
+      m_backward = new FFTComplexPlan<T>( M, true );
+
+      m_chirp = complex_array( n );
+      for ( int k = 0; k < n; ++k )
+      {
+         // Reduce k^2 modulo 2n to preserve accuracy.
+         uint64 k2 = (uint64( k )*uint64( k )) % (2*uint64( n ));
+         m_chirp[k] = FFTRoot<T>( double( k2 )/2, n, m_inverse );
+      }
+
+      complex_array b( M, complex( 0, 0 ) );
+      b[0] = ~m_chirp[0];
+      for ( int k = 1; k < n; ++k )
+         b[k] = b[M-k] = ~m_chirp[k];
+      m_chirpDFT = complex_array( M );
+      m_forward->Transform( m_chirpDFT.Begin(), b.Begin() );
+      for ( typename complex_array::iterator i = m_chirpDFT.Begin(); i != m_chirpDFT.End(); ++i )
+         *i /= T( M );
+   }
+
+   void TransformBluestein( complex* y, const complex* x ) const
+   {
+      int n = m_length;
+      int M = m_forward->Length();
+      complex_array a( M, complex( 0, 0 ) );
+      complex_array A( M );
+      for ( int k = 0; k < n; ++k )
+         a[k] = FFTMul( x[k], m_chirp[k] );
+      m_forward->Transform( A.Begin(), a.Begin() );
+      for ( int k = 0; k < M; ++k )
+         A[k] = FFTMul( A[k], m_chirpDFT[k] );
+      m_backward->Transform( a.Begin(), A.Begin() );
+      for ( int k = 0; k < n; ++k )
+         y[k] = FFTMul( a[k], m_chirp[k] );
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+class FFTRealPlan : public FFTPlanBase
+{
+public:
+
+   typedef T              scalar;
+   typedef Complex<T>     complex;
+   typedef Array<complex> complex_array;
+
+   FFTRealPlan( int n, bool inverse ) :
+      m_length( n ), m_inverse( inverse ),
+      m_plan( new FFTComplexPlan<T>( (n & 1) ? n : n/2, inverse ) )
+   {
+      if ( (n & 1) == 0 )
+      {
+         int ncfft = n/2;
+         m_superTwiddles = complex_array( ncfft/2 );
+         for ( int i = 0; i < ncfft/2; ++i )
+         {
+            double s, c;
+            SinCos( (inverse ? +1 : -1)*double( Pi() )*(double( i+1 )/ncfft + 0.5), s, c );
+            m_superTwiddles[i] = complex( T( c ), T( s ) );
+         }
+      }
+   }
+
+   int Length() const
+   {
+      return m_length;
+   }
+
+   /*
+    * Forward transform: y[0..n/2] = DFT( x[0..n-1] )
+    */
+   void Transform( complex* y, const scalar* x ) const
+   {
+      int n = m_length;
+      if ( n & 1 )
+      {
+         complex_array a( n ), b( n );
+         for ( int i = 0; i < n; ++i )
+            a[i] = complex( x[i], 0 );
+         m_plan->Transform( b.Begin(), a.Begin() );
+         for ( int i = 0; i <= n/2; ++i )
+            y[i] = b[i];
+         return;
+      }
+
+      int ncfft = n/2;
+      m_plan->Transform( y, reinterpret_cast<const complex*>( x ) );
+
+      complex tdc = y[0];
+      y[0] = complex( tdc.Real() + tdc.Imag(), 0 );
+      y[ncfft] = complex( tdc.Real() - tdc.Imag(), 0 );
+      for ( int k = 1; k <= ncfft/2; ++k )
+      {
+         complex fpk = y[k];
+         complex fpnk = ~y[ncfft-k];
+         complex f1k( fpk.Real() + fpnk.Real(), fpk.Imag() + fpnk.Imag() );
+         complex f2k( fpk.Real() - fpnk.Real(), fpk.Imag() - fpnk.Imag() );
+         complex tw = FFTMul( f2k, m_superTwiddles[k-1] );
+         y[k] = complex( (f1k.Real() + tw.Real())/2, (f1k.Imag() + tw.Imag())/2 );
+         y[ncfft-k] = complex( (f1k.Real() - tw.Real())/2, (tw.Imag() - f1k.Imag())/2 );
+      }
+   }
+
+   /*
+    * Inverse transform: y[0..n-1] = IDFT( x[0..n/2] ), not normalized.
+    */
+   void Transform( scalar* y, const complex* x ) const
+   {
+      int n = m_length;
+      if ( n & 1 )
+      {
+         complex_array a( n ), b( n );
+         a[0] = x[0];
+         for ( int k = 1; k <= n/2; ++k )
+         {
+            a[k] = x[k];
+            a[n-k] = ~x[k];
+         }
+         m_plan->Transform( b.Begin(), a.Begin() );
+         for ( int i = 0; i < n; ++i )
+            y[i] = b[i].Real();
+         return;
+      }
+
+      int ncfft = n/2;
+      complex_array t( ncfft );
+      t[0] = complex( x[0].Real() + x[ncfft].Real(), x[0].Real() - x[ncfft].Real() );
+      for ( int k = 1; k <= ncfft/2; ++k )
+      {
+         complex fk = x[k];
+         complex fnkc = ~x[ncfft-k];
+         complex fek( fk.Real() + fnkc.Real(), fk.Imag() + fnkc.Imag() );
+         complex fok = FFTMul( complex( fk.Real() - fnkc.Real(), fk.Imag() - fnkc.Imag() ), m_superTwiddles[k-1] );
+         t[k] = complex( fek.Real() + fok.Real(), fek.Imag() + fok.Imag() );
+         t[ncfft-k] = complex( fek.Real() - fok.Real(), fok.Imag() - fek.Imag() );
+      }
+      m_plan->Transform( reinterpret_cast<complex*>( y ), t.Begin() );
+   }
+
+private:
+
+   int                             m_length;
+   bool                            m_inverse;
+   AutoPointer<FFTComplexPlan<T> > m_plan;
+   complex_array                   m_superTwiddles;
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+class FFTDCTPlan : public FFTPlanBase
+{
+public:
+
+   typedef T              scalar;
+   typedef Complex<T>     complex;
+   typedef Array<complex> complex_array;
+
+   FFTDCTPlan( int n, bool inverse ) :
+      m_length( n ), m_inverse( inverse ),
+      m_plan( new FFTRealPlan<T>( n, inverse ) ),
+      m_twiddles( n/2 + 1 )
+   {
+      for ( int k = 0; k <= n/2; ++k )
+         m_twiddles[k] = FFTRoot<T>( k, 4*n, inverse );
+   }
+
+   /*
+    * DCT-II:  y[k] = 2 * Sum_j x[j]*cos( pi*(2*j + 1)*k/(2*n) )
+    * DCT-III: y[k] = x[0] + 2 * Sum_{j>0} x[j]*cos( pi*j*(2*k + 1)/(2*n) )
+    */
+   void Transform( scalar* y, const scalar* x ) const
+   {
+      int n = m_length;
+      Array<scalar> v( n );
+      complex_array V( n/2 + 1 );
+
+      if ( m_inverse )
+      {
+         V[0] = complex( x[0], 0 );
+         for ( int k = 1; k <= n/2; ++k )
+            V[k] = FFTMul( m_twiddles[k], complex( x[k], -x[n-k] ) );
+         m_plan->Transform( v.Begin(), V.Begin() );
+         for ( int j = 0; j < (n + 1)/2; ++j )
+            y[2*j] = v[j];
+         for ( int j = 0; j < n/2; ++j )
+            y[2*j + 1] = v[n-1-j];
+      }
+      else
+      {
+         for ( int j = 0; j < (n + 1)/2; ++j )
+            v[j] = x[2*j];
+         for ( int j = 0; j < n/2; ++j )
+            v[n-1-j] = x[2*j + 1];
+         m_plan->Transform( V.Begin(), v.Begin() );
+         y[0] = 2*V[0].Real();
+         for ( int k = 1; k <= n/2; ++k )
+         {
+            complex z = FFTMul( m_twiddles[k], V[k] );
+            y[k] = 2*z.Real();
+            if ( k != n-k )
+               y[n-k] = -2*z.Imag();
+         }
+      }
+   }
+
+private:
+
+   int                          m_length;
+   bool                         m_inverse;
+   AutoPointer<FFTRealPlan<T> > m_plan;
+   complex_array                m_twiddles;
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Cache of transform plans, shared by all transforms of the same type, length
+ * and direction.
+ */
+class FFTPlanCache
+{
+public:
+
+   enum plan_type { ComplexF, ComplexD, RealF, RealD, DCTF, DCTD };
+
+   FFTPlanCache() : m_clock( 0 )
+   {
+   }
+
+   ~FFTPlanCache()
+   {
+      for ( Array<Entry>::iterator i = m_entries.Begin(); i != m_entries.End(); ++i )
+         delete i->plan;
+   }
+
+   template <class P>
+   void* Acquire( plan_type type, int n, bool inverse )
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      for ( Array<Entry>::iterator i = m_entries.Begin(); i != m_entries.End(); ++i )
+         if ( i->type == type && i->length == n && i->inverse == inverse )
+         {
+            ++i->references;
+            i->lastUse = ++m_clock;
+            return i->plan;
+         }
+
+      Entry e;
+      e.plan = new P( n, inverse );
+      e.type = type;
+      e.length = n;
+      e.inverse = inverse;
+      e.references = 1;
+      e.lastUse = ++m_clock;
+      m_entries.Add( e );
+      return e.plan;
+   }
+
+   void Release( void* handle )
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      Array<Entry>::iterator entry = m_entries.End();
+      for ( Array<Entry>::iterator i = m_entries.Begin(); i != m_entries.End(); ++i )
+         if ( i->plan == handle )
+         {
+            entry = i;
+            break;
+         }
+      if ( entry == m_entries.End() || entry->references == 0 )
+         throw Error( "FFT: Invalid transform handle." );
+
+      if ( --entry->references > 0 )
+         return;
+
+      // Evict the least recently used idle plan if there are too many.
+      int idle = 0;
+      Array<Entry>::iterator lru = m_entries.End();
+      for ( Array<Entry>::iterator i = m_entries.Begin(); i != m_entries.End(); ++i )
+         if ( i->references == 0 )
+         {
+            ++idle;
+            if ( lru == m_entries.End() || i->lastUse < lru->lastUse )
+               lru = i;
+         }
+      if ( idle > FFT_MAX_IDLE_PLANS )
+      {
+         delete lru->plan;
+         m_entries.Remove( lru );
+      }
+   }
+
+private:
+
+   struct Entry
+   {
+      FFTPlanBase* plan;
+      plan_type    type;
+      int          length;
+      bool         inverse;
+      int          references;
+      uint64       lastUse;
+   };
+
+   Array<Entry> m_entries;
+   std::mutex   m_mutex;
+   uint64       m_clock;
+};
+
+static FFTPlanCache s_planCache;
+
+template <class P> inline static
+const P* PlanFromHandle( void* handle )
+{
+   return static_cast<const P*>( static_cast<const FFTPlanBase*>( handle ) );
+}
+
+// ----------------------------------------------------------------------------
+
 int FFT1DBase::OptimizedLength( int n, fcomplex* )
 {
-   return int( (*API->Numerical->FFTComplexOptimizedLengthF)( n ) );
+   return FFTNextFastLength( n );
 }
 
 int FFT1DBase::OptimizedLength( int n, dcomplex* )
 {
-   return int( (*API->Numerical->FFTComplexOptimizedLengthD)( n ) );
+   return FFTNextFastLength( n );
 }
 
 int FFT1DBase::OptimizedLength( int n, float* )
 {
-   return int( (*API->Numerical->FFTRealOptimizedLengthF)( n ) );
+   return FFTNextFastEvenLength( n );
 }
 
 int FFT1DBase::OptimizedLength( int n, double* )
 {
-   return int( (*API->Numerical->FFTRealOptimizedLengthD)( n ) );
+   return FFTNextFastEvenLength( n );
 }
 
 void* FFT1DBase::Create( int n, fcomplex* )
 {
-   void* handle = (*API->Numerical->FFTCreateComplexTransformF)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateComplexTransformF" );
-   return handle;
+   return s_planCache.Acquire<FFTComplexPlan<float> >( FFTPlanCache::ComplexF, n, false );
 }
 
 void* FFT1DBase::Create( int n, dcomplex* )
 {
-   void* handle = (*API->Numerical->FFTCreateComplexTransformD)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateComplexTransformD" );
-   return handle;
+   return s_planCache.Acquire<FFTComplexPlan<double> >( FFTPlanCache::ComplexD, n, false );
 }
 
 void* FFT1DBase::Create( int n, float* )
 {
-   void* handle = (*API->Numerical->FFTCreateRealTransformF)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateRealTransformF" );
-   return handle;
+   return s_planCache.Acquire<FFTRealPlan<float> >( FFTPlanCache::RealF, n, false );
 }
 
 void* FFT1DBase::Create( int n, double* )
 {
-   void* handle = (*API->Numerical->FFTCreateRealTransformD)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateRealTransformD" );
-   return handle;
+   return s_planCache.Acquire<FFTRealPlan<double> >( FFTPlanCache::RealD, n, false );
 }
 
 void* FFT1DBase::CreateInv( int n, fcomplex* )
 {
-   void* handle = (*API->Numerical->FFTCreateComplexInverseTransformF)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateComplexInverseTransformF" );
-   return handle;
+   return s_planCache.Acquire<FFTComplexPlan<float> >( FFTPlanCache::ComplexF, n, true );
 }
 
 void* FFT1DBase::CreateInv( int n, dcomplex* )
 {
-   void* handle = (*API->Numerical->FFTCreateComplexInverseTransformD)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateComplexInverseTransformD" );
-   return handle;
+   return s_planCache.Acquire<FFTComplexPlan<double> >( FFTPlanCache::ComplexD, n, true );
 }
 
 void* FFT1DBase::CreateInv( int n, float* )
 {
-   void* handle = (*API->Numerical->FFTCreateRealInverseTransformF)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateRealInverseTransformF" );
-   return handle;
+   return s_planCache.Acquire<FFTRealPlan<float> >( FFTPlanCache::RealF, n, true );
 }
 
 void* FFT1DBase::CreateInv( int n, double* )
 {
-   void* handle = (*API->Numerical->FFTCreateRealInverseTransformD)( n );
-   if ( handle == 0 )
-      throw APIFunctionError( "FFTCreateRealInverseTransformD" );
-   return handle;
+   return s_planCache.Acquire<FFTRealPlan<double> >( FFTPlanCache::RealD, n, true );
+}
+
+void* FFT1DBase::CreateDCT( int n, float* )
+{
+   return s_planCache.Acquire<FFTDCTPlan<float> >( FFTPlanCache::DCTF, n, false );
+}
+
+void* FFT1DBase::CreateDCT( int n, double* )
+{
+   return s_planCache.Acquire<FFTDCTPlan<double> >( FFTPlanCache::DCTD, n, false );
+}
+
+void* FFT1DBase::CreateInvDCT( int n, float* )
+{
+   return s_planCache.Acquire<FFTDCTPlan<float> >( FFTPlanCache::DCTF, n, true );
+}
+
+void* FFT1DBase::CreateInvDCT( int n, double* )
+{
+   return s_planCache.Acquire<FFTDCTPlan<double> >( FFTPlanCache::DCTD, n, true );
 }
 
 void FFT1DBase::Destroy( void* handle )
 {
-   if ( (*API->Numerical->FFTDestroyTransform)( handle ) == api_false )
-      throw APIFunctionError( "FFTDestroyTransform" );
+   s_planCache.Release( handle );
 }
 
 void FFT1DBase::Transform( void* handle, fcomplex* y, const fcomplex* x )
 {
-   if ( (*API->Numerical->FFTComplexTransformF)( handle, y, x ) == api_false )
-      throw APIFunctionError( "FFTComplexTransformF" );
+   PlanFromHandle<FFTComplexPlan<float> >( handle )->Transform( y, x );
 }
 
 void FFT1DBase::Transform( void* handle, dcomplex* y, const dcomplex* x )
 {
-   if ( (*API->Numerical->FFTComplexTransformD)( handle, y, x ) == api_false )
-      throw APIFunctionError( "FFTComplexTransformD" );
+   PlanFromHandle<FFTComplexPlan<double> >( handle )->Transform( y, x );
 }
 
 void FFT1DBase::Transform( void* handle, fcomplex* y, const float* x )
 {
-   if ( (*API->Numerical->FFTRealTransformF)( handle, y, x ) == api_false )
-      throw APIFunctionError( "FFTRealTransformF" );
+   PlanFromHandle<FFTRealPlan<float> >( handle )->Transform( y, x );
 }
 
 void FFT1DBase::Transform( void* handle, dcomplex* y, const double* x )
 {
-   if ( (*API->Numerical->FFTRealTransformD)( handle, y, x ) == api_false )
-      throw APIFunctionError( "FFTRealTransformD" );
+   PlanFromHandle<FFTRealPlan<double> >( handle )->Transform( y, x );
 }
 
 void FFT1DBase::Transform( void* handle, float* y, const fcomplex* x )
 {
-   if ( (*API->Numerical->FFTRealInverseTransformF)( handle, y, x ) == api_false )
-      throw APIFunctionError( "FFTRealInverseTransformF" );
+   PlanFromHandle<FFTRealPlan<float> >( handle )->Transform( y, x );
 }
 
 void FFT1DBase::Transform( void* handle, double* y, const dcomplex* x )
 {
-   if ( (*API->Numerical->FFTRealInverseTransformD)( handle, y, x ) == api_false )
-      throw APIFunctionError( "FFTRealInverseTransformD" );
+   PlanFromHandle<FFTRealPlan<double> >( handle )->Transform( y, x );
+}
+
+void FFT1DBase::TransformDCT( void* handle, float* y, const float* x )
+{
+   PlanFromHandle<FFTDCTPlan<float> >( handle )->Transform( y, x );
+}
+
+void FFT1DBase::TransformDCT( void* handle, double* y, const double* x )
+{
+   PlanFromHandle<FFTDCTPlan<double> >( handle )->Transform( y, x );
 }
 
 // ----------------------------------------------------------------------------
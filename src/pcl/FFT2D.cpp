@@ -51,6 +51,14 @@
 
 #include <pcl/FFT2D.h>
 #include <pcl/Thread.h>
+#include <pcl/ThreadPool.h>
+
+/*
+ * Number of contiguous matrix columns gathered and transformed as a block by
+ * column transform threads. Gathering several adjacent columns at once makes
+ * a better use of each cache line read from (and written to) the matrix.
+ */
+#define FFT2D_COLUMN_BLOCK 8
 
 namespace pcl
 {
@@ -66,13 +74,14 @@ public:
    typedef To             output_type;
    typedef ReferenceArray<Thread> thread_list;
 
-   PCL_FFT2DEngineBase( int rows, int cols, To* output, const Ti* input, int dir, StatusMonitor* monitor, bool parallel, int maxProcessors ) :
+   PCL_FFT2DEngineBase( int rows, int cols, To* output, const Ti* input, int dir, StatusMonitor* monitor, bool parallel, int maxProcessors,
+                        const char* forwardInfo = "FFT", const char* inverseInfo = "Inverse FFT" ) :
    m_rows( rows ), m_cols( cols ), m_output( output ), m_input( input ), m_dir( dir ),
    m_monitor( monitor ), m_parallel( parallel ), m_maxProcessors( maxProcessors )
    {
       if ( m_monitor != 0 )
          if ( m_monitor->IsInitializationEnabled() )
-            m_monitor->Initialize( (m_dir == PCL_FFT_FORWARD) ? "FFT" : "Inverse FFT", m_rows + m_cols );
+            m_monitor->Initialize( (m_dir == PCL_FFT_FORWARD) ? forwardInfo : inverseInfo, m_rows + m_cols );
    }
 
    virtual ~PCL_FFT2DEngineBase()
@@ -92,10 +101,19 @@ protected:
 
    void RunThreads( thread_list& threads, int count )
    {
-      for ( typename thread_list::iterator i = threads.Begin(); i != threads.End(); ++i )
-         i->Start( ThreadPriority::DefaultMax, Distance( threads.Begin(), i ) );
-      for ( typename thread_list::iterator i = threads.Begin(); i != threads.End(); ++i )
-         i->Wait();
+      if ( threads.Length() > 1 )
+      {
+         Array<ThreadPool::ThreadTask> tasks;
+         for ( typename thread_list::iterator i = threads.Begin(); i != threads.End(); ++i )
+            tasks.Add( ThreadPool::ThreadTask( *i ) );
+
+         ThreadPool::TaskGroup group;
+         for ( Array<ThreadPool::ThreadTask>::iterator i = tasks.Begin(); i != tasks.End(); ++i )
+            group.Run( *i );
+         group.Wait();
+      }
+      else if ( !threads.IsEmpty() )
+         threads[0].Run();
 
       threads.Destroy();
 
@@ -215,18 +233,27 @@ private:
          void* h = (m_engine.m_dir == PCL_FFT_FORWARD) ?
                this->Create( m_engine.m_rows, (complex*)0 ) : this->CreateInv( m_engine.m_rows, (complex*)0 );
 
-         GenericVector<complex> icol( m_engine.m_rows );
-         GenericVector<complex> ocol( m_engine.m_rows );
+         int rows = m_engine.m_rows;
+         int cols = m_engine.m_cols;
+         GenericVector<complex> icol( FFT2D_COLUMN_BLOCK*rows );
+         GenericVector<complex> ocol( FFT2D_COLUMN_BLOCK*rows );
 
-         for ( int j = m_firstCol; j < m_endCol; ++j )
+         for ( int j = m_firstCol; j < m_endCol; j += FFT2D_COLUMN_BLOCK )
          {
-            for ( int i = 0, k = j; i < m_engine.m_rows; ++i, k += m_engine.m_cols )
-               icol[i] = m_engine.m_output[k];
+            int nb = Min( FFT2D_COLUMN_BLOCK, m_endCol - j );
+
+            const complex* r = m_engine.m_output + j;
+            for ( int i = 0; i < rows; ++i, r += cols )
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  icol[k] = r[b];
 
-            this->Transform( h, *ocol, *icol );
+            for ( int b = 0, k = 0; b < nb; ++b, k += rows )
+               this->Transform( h, *ocol + k, *icol + k );
 
-            for ( int i = 0, k = j; i < m_engine.m_rows; ++i, k += m_engine.m_cols )
-               m_engine.m_output[k] = ocol[i];
+            complex* w = m_engine.m_output + j;
+            for ( int i = 0; i < rows; ++i, w += cols )
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  w[b] = ocol[k];
          }
 
          this->Destroy( h );
@@ -347,18 +374,27 @@ private:
       {
          void* h = this->Create( m_engine.m_rows, (complex*)0 );
 
-         GenericVector<complex> icol( m_engine.m_rows );
-         GenericVector<complex> ocol( m_engine.m_rows );
+         int rows = m_engine.m_rows;
+         int cols = m_engine.m_transformCols;
+         GenericVector<complex> icol( FFT2D_COLUMN_BLOCK*rows );
+         GenericVector<complex> ocol( FFT2D_COLUMN_BLOCK*rows );
 
-         for ( int j = m_firstCol; j < m_endCol; ++j )
+         for ( int j = m_firstCol; j < m_endCol; j += FFT2D_COLUMN_BLOCK )
          {
-            for ( int i = 0, k = j; i < m_engine.m_rows; ++i, k += m_engine.m_transformCols )
-               icol[i] = m_engine.m_output[k];
+            int nb = Min( FFT2D_COLUMN_BLOCK, m_endCol - j );
 
-            this->Transform( h, *ocol, *icol );
+            const complex* r = m_engine.m_output + j;
+            for ( int i = 0; i < rows; ++i, r += cols )
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  icol[k] = r[b];
 
-            for ( int i = 0, k = j; i < m_engine.m_rows; ++i, k += m_engine.m_transformCols )
-               m_engine.m_output[k] = ocol[i];
+            for ( int b = 0, k = 0; b < nb; ++b, k += rows )
+               this->Transform( h, *ocol + k, *icol + k );
+
+            complex* w = m_engine.m_output + j;
+            for ( int i = 0; i < rows; ++i, w += cols )
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  w[b] = ocol[k];
          }
 
          this->Destroy( h );
@@ -433,18 +469,29 @@ private:
       {
          void* h = this->CreateInv( m_engine.m_rows, (complex*)0 );
 
-         GenericVector<complex> icol( m_engine.m_rows );
-         GenericVector<complex> ocol( m_engine.m_rows );
+         int rows = m_engine.m_rows;
+         int cols = m_engine.m_transformCols;
+         GenericVector<complex> icol( FFT2D_COLUMN_BLOCK*rows );
+         GenericVector<complex> ocol( FFT2D_COLUMN_BLOCK*rows );
 
-         for ( int j = m_firstCol; j < m_endCol; ++j )
+         for ( int j = m_firstCol; j < m_endCol; j += FFT2D_COLUMN_BLOCK )
          {
-            for ( int i = 0, k = j; i < m_engine.m_rows; ++i, k += m_engine.m_transformCols )
-               icol[i] = m_engine.m_input[k];
+            int nb = Min( FFT2D_COLUMN_BLOCK, m_endCol - j );
+
+            const complex* r = m_engine.m_input + j;
+            for ( int i = 0; i < rows; ++i, r += cols )
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  icol[k] = r[b];
 
-            this->Transform( h, *ocol, *icol );
+            for ( int b = 0, k = 0; b < nb; ++b, k += rows )
+               this->Transform( h, *ocol + k, *icol + k );
 
-            for ( int i = 0; i < m_engine.m_rows; ++i )
-               m_engine.m_colTransform[i][j] = ocol[i];
+            for ( int i = 0; i < rows; ++i )
+            {
+               complex* w = m_engine.m_colTransform[i] + j;
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  w[b] = ocol[k];
+            }
          }
 
          this->Destroy( h );
@@ -485,6 +532,155 @@ private:
 
 // ----------------------------------------------------------------------------
 
+/*
+ * 2-D discrete cosine transforms of real data
+ */
+template <typename T>
+class PCL_DCT2DEngine : public PCL_FFT2DEngineBase<T,T>
+{
+public:
+
+   typedef T                                  scalar;
+   typedef PCL_FFT2DEngineBase<scalar,scalar> base;
+   typedef typename base::thread_list         thread_list;
+
+   PCL_DCT2DEngine( int rows, int cols, scalar* output, const scalar* input, int dir, StatusMonitor* monitor, bool parallel, int maxProcessors ) :
+   base( rows, cols, output, input, dir, monitor, parallel, maxProcessors, "DCT", "Inverse DCT" )
+   {
+      size_type N = size_type( this->m_rows )*size_type( this->m_cols );
+      const void* i0 = this->m_input;
+      const void* i1 = this->m_input + N;
+      const void* o0 = this->m_output;
+      const void* o1 = this->m_output + N;
+      m_overlapped = o1 > i0 && o0 < i1 && o0 != i0;
+
+      for ( int direction = 0; direction < 2; ++direction ) // DCT of m_rows, m_cols
+      {
+         int numberOfItems = (direction == 0) ? this->m_rows : this->m_cols;
+         int numberOfThreads = this->m_parallel ? Min( int( this->m_maxProcessors ), pcl::Thread::NumberOfThreads( numberOfItems, 1 ) ) : 1;
+         int itemsPerThread = numberOfItems/numberOfThreads;
+
+         thread_list threads;
+         for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+         {
+            int a = i*itemsPerThread;
+            int b = (j < numberOfThreads) ? j*itemsPerThread : numberOfItems;
+            threads.Add( (direction == 0) ? static_cast<Thread*>( new RowThread( *this, a, b ) ) :
+                                            static_cast<Thread*>( new ColThread( *this, a, b ) ) );
+         }
+
+         this->RunThreads( threads, numberOfItems );
+      }
+   }
+
+   virtual ~PCL_DCT2DEngine()
+   {
+   }
+
+private:
+
+   bool m_overlapped : 1;
+
+   friend class RowThread;
+
+   class RowThread : public Thread, public FFT1DBase
+   {
+   public:
+
+      RowThread( PCL_DCT2DEngine& e, int r0, int r1 ) : m_engine( e ), m_firstRow( r0 ), m_endRow( r1 )
+      {
+      }
+
+      virtual void Run()
+      {
+         void* h = (m_engine.m_dir == PCL_FFT_FORWARD) ?
+               this->CreateDCT( m_engine.m_cols, (scalar*)0 ) : this->CreateInvDCT( m_engine.m_cols, (scalar*)0 );
+
+         /*
+          * One-dimensional DCTs can be performed in place, so a working copy
+          * of each input row is only necessary for partially overlapped input
+          * and output matrices.
+          */
+         if ( m_engine.m_overlapped )
+         {
+            GenericVector<scalar> irow( m_engine.m_cols );
+
+            for ( int i = m_firstRow; i < m_endRow; ++i )
+            {
+               size_type d = size_type( i )*size_type( m_engine.m_cols );
+               memcpy( *irow, m_engine.m_input + d, m_engine.m_cols*sizeof( scalar ) );
+               this->TransformDCT( h, m_engine.m_output + d, *irow );
+            }
+         }
+         else
+         {
+            for ( int i = m_firstRow; i < m_endRow; ++i )
+            {
+               size_type d = size_type( i )*size_type( m_engine.m_cols );
+               this->TransformDCT( h, m_engine.m_output + d, m_engine.m_input + d );
+            }
+         }
+
+         this->Destroy( h );
+      }
+
+   private:
+
+      PCL_DCT2DEngine& m_engine;
+      int              m_firstRow;
+      int              m_endRow;
+   };
+
+   friend class ColThread;
+
+   class ColThread : public Thread, public FFT1DBase
+   {
+   public:
+
+      ColThread( PCL_DCT2DEngine& e, int c0, int c1 ) : m_engine( e ), m_firstCol( c0 ), m_endCol( c1 )
+      {
+      }
+
+      virtual void Run()
+      {
+         void* h = (m_engine.m_dir == PCL_FFT_FORWARD) ?
+               this->CreateDCT( m_engine.m_rows, (scalar*)0 ) : this->CreateInvDCT( m_engine.m_rows, (scalar*)0 );
+
+         int rows = m_engine.m_rows;
+         int cols = m_engine.m_cols;
+         GenericVector<scalar> col( FFT2D_COLUMN_BLOCK*rows );
+
+         for ( int j = m_firstCol; j < m_endCol; j += FFT2D_COLUMN_BLOCK )
+         {
+            int nb = Min( FFT2D_COLUMN_BLOCK, m_endCol - j );
+
+            const scalar* r = m_engine.m_output + j;
+            for ( int i = 0; i < rows; ++i, r += cols )
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  col[k] = r[b];
+
+            for ( int b = 0, k = 0; b < nb; ++b, k += rows )
+               this->TransformDCT( h, *col + k, *col + k );
+
+            scalar* w = m_engine.m_output + j;
+            for ( int i = 0; i < rows; ++i, w += cols )
+               for ( int b = 0, k = i; b < nb; ++b, k += rows )
+                  w[b] = col[k];
+         }
+
+         this->Destroy( h );
+      }
+
+   private:
+
+      PCL_DCT2DEngine& m_engine;
+      int              m_firstCol;
+      int              m_endCol;
+   };
+};
+
+// ----------------------------------------------------------------------------
+
 void FFT2DBase::Transform( int rows, int cols, fcomplex* y, const fcomplex* x, int dir, StatusMonitor* monitor, bool parallel, int maxProcessors )
 {
    PCL_FFT2DEngine<float>( rows, cols, y, x, dir, monitor, parallel, maxProcessors );
@@ -515,6 +711,16 @@ void FFT2DBase::Transform( int rows, int cols, double* y, const dcomplex* x, Sta
    PCL_FFT2DRealInverseEngine<double>( rows, cols, y, x, monitor, parallel, maxProcessors );
 }
 
+void FFT2DBase::DCT( int rows, int cols, float* y, const float* x, int dir, StatusMonitor* monitor, bool parallel, int maxProcessors )
+{
+   PCL_DCT2DEngine<float>( rows, cols, y, x, dir, monitor, parallel, maxProcessors );
+}
+
+void FFT2DBase::DCT( int rows, int cols, double* y, const double* x, int dir, StatusMonitor* monitor, bool parallel, int maxProcessors )
+{
+   PCL_DCT2DEngine<double>( rows, cols, y, x, dir, monitor, parallel, maxProcessors );
+}
+
 // ----------------------------------------------------------------------------
 
 } // pcl
@@ -49,8 +49,10 @@
 // POSSIBILITY OF SUCH DAMAGE.
 // ----------------------------------------------------------------------------
 
+#include <pcl/FFT2D.h>
 #include <pcl/FFTConvolution.h>
 #include <pcl/FourierTransform.h>
+#include <pcl/ThreadPool.h>
 
 namespace pcl
 {
@@ -64,20 +66,254 @@ public:
    template <class P>
    static void Apply( GenericImage<P>& image, const FFTConvolution& F )
    {
-      if ( !F.m_h )
+      int nx, ny;
+      if ( F.m_filter )
       {
-         Rect r = image.SelectedRectangle();
+         nx = ny = F.m_filter->Size();
+         if ( nx == 0 )
+            throw Error( "Attempt to perform an FFT-based convolution with an empty kernel filter." );
+      }
+      else
+      {
+         if ( !F.m_image || F.m_image->IsEmpty() )
+            throw Error( "Attempt to perform an FFT-based convolution with an empty response function image." );
+         nx = F.m_image->Width();
+         ny = F.m_image->Height();
+      }
+
+      Rect r = image.SelectedRectangle();
+      int w = FFT2D::OptimizedLength( r.Width() + nx );
+      int h = FFT2D::OptimizedLength( r.Height() + ny );
+
+      int concurrency = F.IsParallelProcessingEnabled() ? pcl::Min( F.MaxProcessors(), ThreadPool::NumberOfWorkers() ) : 1;
+      bool tiled = GetTileDimensions( w, h, nx, ny, F.MemoryLimit(), concurrency );
+
+      /*
+       * The DFT of the response function depends on the dimensions of the
+       * target image, or on the tile dimensions for tiled convolutions.
+       */
+      if ( !F.m_h || F.m_h->Width() != w || F.m_h->Height() != h )
+      {
+         F.m_h.Destroy();
          if ( F.m_filter )
-            const_cast<FFTConvolution&>( F ).m_h = Initialize( *F.m_filter, r.Width(), r.Height(), F.IsParallelProcessingEnabled(), F.MaxProcessors() );
+            F.m_h = Initialize( *F.m_filter, w, h, F.IsParallelProcessingEnabled(), F.MaxProcessors() );
          else
-            const_cast<FFTConvolution&>( F ).m_h = Initialize( F.m_image, r.Width(), r.Height(), F.IsParallelProcessingEnabled(), F.MaxProcessors() );
+            F.m_h = Initialize( F.m_image, w, h, F.IsParallelProcessingEnabled(), F.MaxProcessors() );
       }
 
-      Convolve( image, *F.m_h, F.IsParallelProcessingEnabled(), F.MaxProcessors() );
+      if ( tiled )
+         ConvolveTiled( image, *F.m_h, nx, ny, concurrency );
+      else
+         Convolve( image, *F.m_h, F.IsParallelProcessingEnabled(), F.MaxProcessors() );
    }
 
 private:
 
+   /*
+    * Returns the largest optimized FFT length smaller than or equal to n.
+    */
+   static int OptimizedLengthBelow( int n )
+   {
+      for ( int m = n; m > 1; --m )
+         if ( FFT2D::OptimizedLength( m ) == m )
+            return m;
+      return 1;
+   }
+
+   /*
+    * Selects tile dimensions for an overlap-save convolution with a response
+    * function of nx*ny pixels. On input, w and h are the dimensions of the
+    * padded FFT matrices required to convolve the whole target. If these
+    * dimensions exceed the memory limit, they are replaced with the tile
+    * dimensions and true is returned.
+    *
+    * The memory required is the DFT of the response function plus one
+    * working matrix per concurrent tile.
+    */
+   static bool GetTileDimensions( int& w, int& h, int nx, int ny, size_type limit, int concurrency )
+   {
+      const size_type sampleSize = sizeof( ComplexImage::sample );
+
+      if ( limit == 0 || 2*size_type( w )*size_type( h )*sampleSize <= limit )
+         return false;
+
+      double maxTilePixels = double( limit )/sampleSize/(1 + concurrency);
+      int tw = pcl::Max( FFT2D::OptimizedLength( 2*nx ), OptimizedLengthBelow( TruncInt( pcl::Min( Sqrt( maxTilePixels ), double( w ) ) ) ) );
+      int th = pcl::Max( FFT2D::OptimizedLength( 2*ny ), OptimizedLengthBelow( TruncInt( pcl::Min( maxTilePixels/tw, double( h ) ) ) ) );
+
+      if ( tw >= w && th >= h )
+         return false;
+
+      w = pcl::Min( w, tw );
+      h = pcl::Min( h, th );
+      return true;
+   }
+
+   /*
+    * Mirrored coordinate for the extension of a sequence of n elements, with
+    * the same boundary conditions applied by Convolve(): whole-sample
+    * symmetry at the origin and half-sample symmetry at the end.
+    */
+   static int MirrorIndex( int x, int n )
+   {
+      for ( ;; )
+         if ( x < 0 )
+            x = -x;
+         else if ( x >= n )
+            x = 2*n - 1 - x;
+         else
+            return x;
+   }
+
+   /*
+    * Overlap-save tiled convolution.
+    *
+    * Tiles are arranged in rows (bands) of tiles, and the tiles of each band
+    * are convolved in parallel. A tile convolution yields bw*bh valid pixels
+    * from an input region extending (nx-1)*(ny-1) pixels beyond them. Since
+    * input regions of adjacent bands overlap, the output pixels of a band are
+    * kept in a working buffer and written to the target image after the next
+    * band has been convolved.
+    */
+   template <class P>
+   static void ConvolveTiled( GenericImage<P>& image, const ComplexImage& psfFFT, int nx, int ny, int concurrency )
+   {
+      typedef typename P::sample sample;
+
+      Rect r = image.SelectedRectangle();
+      int width = r.Width();
+      int height = r.Height();
+
+      int ch0 = image.FirstSelectedChannel();
+      int ch1 = image.LastSelectedChannel();
+
+      int tw = psfFFT.Width();  // tile dimensions, already optimized FFT lengths
+      int th = psfFFT.Height();
+
+      int lx = nx - 1 - (nx >> 1);  // left/top input margins
+      int ly = ny - 1 - (ny >> 1);
+      int rx = nx >> 1;             // right/bottom input margins
+      int ry = ny >> 1;
+
+      int bw = tw - nx + 1;         // valid output pixels per tile
+      int bh = th - ny + 1;
+
+      int tilesPerBand = (width + bw - 1)/bw;
+      int numberOfBands = (height + bh - 1)/bh;
+
+      // At most one task (hence one working tile matrix) per concurrent tile.
+      int grain = (tilesPerBand + concurrency - 1)/concurrency;
+
+      bool statusInitialized = false;
+      if ( image.Status().IsInitializationEnabled() )
+      {
+         image.Status().Initialize( "Convolution (FFT)", image.NumberOfSelectedSamples() );
+         image.Status().DisableInitialization();
+         statusInitialized = true;
+      }
+
+      try
+      {
+         GenericVector<sample> band0( size_type( bh )*size_type( width ) );
+         GenericVector<sample> band1( size_type( bh )*size_type( width ) );
+
+         for ( int ch = ch0; ch <= ch1; ++ch )
+         {
+            sample* pending = nullptr;
+            int pendingY = 0, pendingRows = 0;
+
+            for ( int band = 0; band < numberOfBands; ++band )
+            {
+               int y0 = band*bh;
+               int rows = pcl::Min( bh, height - y0 );
+               sample* output = (band & 1) ? *band1 : *band0;
+
+               ThreadPool::ParallelFor( tilesPerBand, grain,
+                  [&]( int begin, int end )
+                  {
+                     GenericVector<ComplexImage::sample> C( size_type( tw )*size_type( th ) );
+                     GenericVector<int> xs( tw );
+                     FFT2D fft( th, tw );
+                     fft.DisableParallelProcessing();
+
+                     for ( int t = begin; t < end; ++t )
+                     {
+                        int x0 = t*bw;
+                        int cols = pcl::Min( bw, width - x0 );
+
+                        /*
+                         * Input pixels not required to compute valid output
+                         * pixels are set to zero.
+                         */
+                        int xn = x0 + cols + rx - (x0 - lx);
+                        int yn = y0 + rows + ry - (y0 - ly);
+                        for ( int i = 0; i < xn; ++i )
+                           xs[i] = r.x0 + MirrorIndex( x0 - lx + i, width );
+
+                        ComplexImage::sample* c = *C;
+                        for ( int j = 0; j < yn; ++j )
+                        {
+                           const sample* f = image.ScanLine( r.y0 + MirrorIndex( y0 - ly + j, height ), ch );
+                           int i = 0;
+                           for ( ; i < xn; ++i, ++c )
+                              ComplexPixelTraits::Mov( *c, f[xs[i]] );
+                           for ( ; i < tw; ++i, ++c )
+                              *c = 0;
+                        }
+                        for ( ComplexImage::sample* cN = *C + C.Length(); c < cN; ++c )
+                           *c = 0;
+
+                        fft( *C, *C, PCL_FFT_FORWARD );
+
+                        double k = 1.0/tw/th; // FFT scaling factor
+                              ComplexImage::sample* c1 = *C;
+                        const ComplexImage::sample* cN = c1 + C.Length();
+                        const ComplexImage::sample* p  = *psfFFT;
+                        for ( ; c1 < cN; ++c1, ++p )
+                           *c1 *= k * *p;
+
+                        fft( *C, *C, PCL_FFT_BACKWARD );
+
+                        for ( int j = 0; j < rows; ++j )
+                        {
+                           const ComplexImage::sample* cj = *C + size_type( ly + j )*size_type( tw ) + lx;
+                           sample* f = output + size_type( j )*size_type( width ) + x0;
+                           for ( int i = 0; i < cols; ++i )
+                              P::Mov( f[i], cj[i] );
+                        }
+                     }
+                  } );
+
+               /*
+                * The input region of this band has been consumed, so the
+                * output pixels of the previous band can be written now.
+                */
+               if ( pending != nullptr )
+                  for ( int j = 0; j < pendingRows; ++j )
+                     P::Copy( image.PixelAddress( r.x0, r.y0 + pendingY + j, ch ), pending + size_type( j )*size_type( width ), width );
+
+               pending = output;
+               pendingY = y0;
+               pendingRows = rows;
+
+               image.Status() += size_type( rows )*size_type( width );
+            }
+
+            for ( int j = 0; j < pendingRows; ++j )
+               P::Copy( image.PixelAddress( r.x0, r.y0 + pendingY + j, ch ), pending + size_type( j )*size_type( width ), width );
+         }
+
+         if ( statusInitialized )
+            image.Status().EnableInitialization();
+      }
+      catch ( ... )
+      {
+         if ( statusInitialized )
+            image.Status().EnableInitialization();
+         throw;
+      }
+   }
+
    template <class P>
    static void Convolve( GenericImage<P>& image, const ComplexImage& psfFFT, bool parallel, int maxProcessors )
    {
@@ -202,17 +438,11 @@ private:
       }
    }
 
-   static ComplexImage* Initialize( const KernelFilter& PSF,
-                                    int targetWidth, int targetHeight, bool parallel, int maxProcessors )
+   static ComplexImage* Initialize( const KernelFilter& PSF, int w, int h, bool parallel, int maxProcessors )
    {
       PCL_CHECK( !PSF.IsEmpty() )
 
       int n = PSF.Size();
-      if ( n == 0 )
-         throw Error( "Attempt to perform an FFT-based convolution with an empty kernel filter." );
-
-      int w = FFT2D::OptimizedLength( targetWidth + n );
-      int h = FFT2D::OptimizedLength( targetHeight + n );
 
       ComplexImage* psfFFT = new ComplexImage( w, h );
       psfFFT->Zero();
@@ -331,15 +561,8 @@ private:
             psfFFT( tx, ty ) = k*PSF( sx, sy );
    }
 
-   static ComplexImage* Initialize( const ImageVariant& PSF,
-                                    int targetWidth, int targetHeight, bool parallel, int maxProcessors )
+   static ComplexImage* Initialize( const ImageVariant& PSF, int w, int h, bool parallel, int maxProcessors )
    {
-      if ( !PSF || PSF->IsEmpty() )
-         throw Error( "Attempt to perform an FFT-based convolution with an empty response function image." );
-
-      int w = FFT2D::OptimizedLength( targetWidth + PSF->Width() );
-      int h = FFT2D::OptimizedLength( targetHeight + PSF->Height() );
-
       ComplexImage* psfFFT = new ComplexImage( w, h );
       psfFFT->Zero();
 
@@ -0,0 +1,2108 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/HeadlessAPI.cpp - Released 2016/02/21 20:22:19 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+
+#include <pcl/Atomic.h>
+#include <pcl/AutoLock.h>
+#include <pcl/Exception.h>
+#include <pcl/HeadlessAPI.h>
+#include <pcl/SortedArray.h>
+#include <pcl/String.h>
+#include <pcl/ThreadPool.h>
+
+#include <pcl/api/APIInterface.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Error codes reported by Global/LastError.
+ */
+enum
+{
+   HeadlessError_None = 0,
+   HeadlessError_UnsupportedFunction,
+   HeadlessError_InvalidHandle,
+   HeadlessError_InvalidArgument,
+   HeadlessError_UndefinedSetting,
+   HeadlessError_SettingsContext,
+   HeadlessError_ThreadCreation,
+   HeadlessError_Compression,
+   HeadlessError_OutOfMemory,
+
+   HeadlessError_NumberOfErrors
+};
+
+static const char* s_errorMessages[ HeadlessError_NumberOfErrors ] =
+{
+   "No error",
+   "The requested API function is not available in headless applications",
+   "Invalid object handle",
+   "Invalid function argument",
+   "Undefined global variable or type mismatch",
+   "Global settings can only be modified within an update context",
+   "Unable to create a new thread",
+   "Compression or decompression error",
+   "Out of memory"
+};
+
+static pthread_key_t  s_lastErrorKey;
+static pthread_key_t  s_currentThreadKey;
+static pthread_once_t s_keysOnce = PTHREAD_ONCE_INIT;
+
+static void CreateThreadKeys()
+{
+   (void)pthread_key_create( &s_lastErrorKey, nullptr );
+   (void)pthread_key_create( &s_currentThreadKey, nullptr );
+}
+
+static void SetLastError( uint32 code )
+{
+   (void)pthread_setspecific( s_lastErrorKey, reinterpret_cast<void*>( size_type( code ) ) );
+}
+
+/*
+ * Copies a string to a buffer provided by the caller, following the
+ * conventions of the core API: If the buffer is null, the required buffer
+ * length, including a null terminator, is stored in *len.
+ */
+template <class S, typename C> static
+api_bool CopyString( C* buffer, size_type* len, const S& s )
+{
+   if ( buffer == nullptr )
+   {
+      if ( len != nullptr )
+         *len = s.Length() + 1;
+      return api_true;
+   }
+   if ( len == nullptr || *len == 0 )
+   {
+      SetLastError( HeadlessError_InvalidArgument );
+      return api_false;
+   }
+   size_type n = pcl::Min( s.Length(), *len - 1 );
+   for ( size_type i = 0; i < n; ++i )
+      buffer[i] = C( s[i] );
+   buffer[n] = C( 0 );
+   *len = n;
+   return api_true;
+}
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Base class of all objects created through the native API. Object handles
+ * are pointers to NativeObject instances. Objects are created with a
+ * reference count of one, which belongs to the client object that creates
+ * them, and are destroyed when their reference count drops to zero.
+ */
+class NativeObject
+{
+public:
+
+   NativeObject( api_handle module, const char* type ) :
+      m_module( module ), m_type( type ), m_refCount( 1 )
+   {
+   }
+
+   virtual ~NativeObject()
+   {
+   }
+
+   api_handle Module() const
+   {
+      return m_module;
+   }
+
+   const char* Type() const
+   {
+      return m_type;
+   }
+
+   size_type RefCount() const
+   {
+      return size_type( pcl::Max( 0, const_cast<AtomicInt&>( m_refCount ).Load() ) );
+   }
+
+   void Attach()
+   {
+      m_refCount.Increment();
+   }
+
+   void Detach()
+   {
+      if ( !m_refCount.Dereference() )
+         delete this;
+   }
+
+   String Id() const
+   {
+      volatile AutoLock lock( m_idMutex );
+      return m_id;
+   }
+
+   void SetId( const String& id )
+   {
+      volatile AutoLock lock( m_idMutex );
+      m_id = id;
+   }
+
+private:
+
+           api_handle  m_module;
+           const char* m_type;
+           AtomicInt   m_refCount;
+           String      m_id;
+   mutable pcl::Mutex  m_idMutex;
+};
+
+#define O  reinterpret_cast<NativeObject*>( const_cast<void*>( handle ) )
+
+// ----------------------------------------------------------------------------
+// Console
+// ----------------------------------------------------------------------------
+
+/*
+ * Console sink. Console tags are removed, line breaks are translated, and
+ * character entities are decoded. ANSI escape sequences are only preserved
+ * when the output stream is a terminal.
+ */
+class NativeConsole
+{
+public:
+
+   NativeConsole() :
+      m_output( HeadlessConsoleOutput::StandardOutput ), m_column( 0 )
+   {
+   }
+
+   HeadlessConsoleOutput::value_type Output() const
+   {
+      return m_output;
+   }
+
+   void SetOutput( HeadlessConsoleOutput::value_type output )
+   {
+      volatile AutoLock lock( m_mutex );
+      Flush();
+      m_output = output;
+      m_column = 0;
+   }
+
+   void Write( const char16_type* text, bool appendNewline )
+   {
+      volatile AutoLock lock( m_mutex );
+
+      FILE* f = Stream();
+      if ( f == nullptr )
+         return;
+
+      bool isTerminal = isatty( fileno( f ) ) != 0;
+
+      String s;
+      if ( text != nullptr )
+         for ( const char16_type* p = text; *p != 0; )
+         {
+            if ( *p == '<' )
+            {
+               const char16_type* q = p+1;
+               while ( *q != 0 && *q != '>' && *q != '<' && *q != ' ' )
+                  ++q;
+               if ( *q == '>' || *q == ' ' )
+               {
+                  IsoString tag = IsoString( String( p+1, 0, q-p-1 ) ).CaseFolded();
+                  bool isTag = true;
+                  if ( tag == "br" || tag == "br/" )
+                     s << '\n';
+                  else if ( tag == "cbr" )
+                  {
+                     if ( !s.IsEmpty() ? s[s.Length()-1] != '\n' : m_column > 0 )
+                        s << '\n';
+                  }
+                  else if ( tag == "raw" )
+                  {
+                     const char16_type* e = Find( q, "</raw>" );
+                     const char16_type* r = q;
+                     if ( *r == ' ' )
+                        r = Find( r, ">" );
+                     if ( *r == '>' )
+                     {
+                        s.Append( String( r+1, 0, e-r-1 ) );
+                        p = (*e != 0) ? e+6 : e;
+                        continue;
+                     }
+                  }
+                  else
+                     isTag = IsConsoleTag( tag );
+
+                  if ( isTag )
+                  {
+                     if ( *q == ' ' )
+                        q = Find( q, ">" );
+                     p = (*q != 0) ? q+1 : q;
+                     continue;
+                  }
+               }
+            }
+            else if ( *p == '&' )
+            {
+               const char16_type* q = p+1;
+               while ( *q != 0 && *q != ';' && q-p < 8 )
+                  ++q;
+               if ( *q == ';' )
+               {
+                  IsoString entity( String( p+1, 0, q-p-1 ) );
+                  char16_type c = 0;
+                  if ( entity == "lt" )
+                     c = '<';
+                  else if ( entity == "gt" )
+                     c = '>';
+                  else if ( entity == "amp" )
+                     c = '&';
+                  else if ( entity == "quot" )
+                     c = '\"';
+                  else if ( entity == "apos" )
+                     c = '\'';
+                  else if ( entity == "nbsp" )
+                     c = ' ';
+                  if ( c != 0 )
+                  {
+                     s << c;
+                     p = q+1;
+                     continue;
+                  }
+               }
+            }
+            else if ( *p == 0x1b && !isTerminal )
+            {
+               // Skip ANSI control sequences: ESC '[' parameters final-byte
+               const char16_type* q = p+1;
+               if ( *q == '[' )
+               {
+                  ++q;
+                  while ( *q != 0 && (*q < 0x40 || *q > 0x7e) )
+                     ++q;
+                  p = (*q != 0) ? q+1 : q;
+                  continue;
+               }
+            }
+
+            s << *p++;
+         }
+
+      if ( appendNewline )
+         s << '\n';
+
+      if ( !s.IsEmpty() )
+      {
+         IsoString u = s.ToUTF8();
+         fwrite( u.c_str(), 1, u.Length(), f );
+         size_type n = s.FindLast( '\n' );
+         m_column = (n == String::notFound) ? m_column + s.Length() : s.Length() - n - 1;
+      }
+   }
+
+   void Flush()
+   {
+      FILE* f = Stream();
+      if ( f != nullptr )
+         fflush( f );
+   }
+
+private:
+
+   HeadlessConsoleOutput::value_type m_output;
+   size_type                         m_column;
+   pcl::Mutex                        m_mutex;
+
+   FILE* Stream() const
+   {
+      switch ( m_output )
+      {
+      case HeadlessConsoleOutput::StandardOutput: return stdout;
+      case HeadlessConsoleOutput::StandardError:  return stderr;
+      default:                                    return nullptr;
+      }
+   }
+
+   static const char16_type* Find( const char16_type* p, const char* s )
+   {
+      size_type n = strlen( s );
+      for ( ; *p != 0; ++p )
+      {
+         size_type i = 0;
+         for ( ; i < n; ++i )
+            if ( p[i] == 0 || CharTraits::ToLowercase( p[i] ) != char16_type( s[i] ) )
+               break;
+         if ( i == n )
+            return p;
+      }
+      return p;
+   }
+
+   static bool IsConsoleTag( const IsoString& tag )
+   {
+      static const char* tags[] =
+      {
+         "b", "/b", "i", "/i", "u", "/u", "o", "/o", "s", "/s", "sub", "/sub", "sup", "/sup",
+         "end", "reset", "clear", "clrbol", "clreol", "flush", "bol", "/raw",
+         "a", "/a", "code", "/code", "p", "/p", "pre", "/pre"
+      };
+      for ( size_type i = 0; i < ItemsInArray( tags ); ++i )
+         if ( tag == tags[i] )
+            return true;
+      return tag.StartsWith( "a href=" );
+   }
+};
+
+static NativeConsole* s_console = nullptr;
+
+// ----------------------------------------------------------------------------
+// Threads
+// ----------------------------------------------------------------------------
+
+class NativeThread : public NativeObject
+{
+public:
+
+   NativeThread( api_handle module, api_handle client ) :
+      NativeObject( module, "Thread" ),
+      m_client( client ), m_routine( nullptr ),
+      m_active( false ), m_priority( 0 ), m_stackSize( 0 ), m_status( 0 )
+   {
+      pthread_mutex_init( &m_mutex, nullptr );
+      pthread_cond_init( &m_finished, nullptr );
+   }
+
+   virtual ~NativeThread()
+   {
+      pthread_cond_destroy( &m_finished );
+      pthread_mutex_destroy( &m_mutex );
+   }
+
+   void SetExecRoutine( pcl::thread_exec_routine routine )
+   {
+      m_routine = routine;
+   }
+
+   bool Start( uint32 priority )
+   {
+      pthread_mutex_lock( &m_mutex );
+      if ( m_active || m_routine == nullptr )
+      {
+         pthread_mutex_unlock( &m_mutex );
+         return false;
+      }
+      m_active = true;
+      m_priority = priority;
+      pthread_mutex_unlock( &m_mutex );
+
+      // The running thread holds a reference to this object.
+      Attach();
+
+      /*
+       * Worker threads are created detached, and completion is signaled
+       * through a condition variable. The default stack size is 8 MiB on all
+       * platforms, since some platforms provide much smaller secondary thread
+       * stacks by default.
+       */
+      pthread_attr_t attr;
+      pthread_attr_init( &attr );
+      pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+      size_type stackSize = (m_stackSize > 0) ? m_stackSize : 8*1024*1024;
+      pthread_attr_setstacksize( &attr, pcl::Max( stackSize, size_type( PTHREAD_STACK_MIN ) ) );
+      pthread_t thread;
+      int result = pthread_create( &thread, &attr, ThreadEntry, this );
+      pthread_attr_destroy( &attr );
+
+      if ( result != 0 )
+      {
+         Finished();
+         Detach();
+         SetLastError( HeadlessError_ThreadCreation );
+         return false;
+      }
+      return true;
+   }
+
+   bool IsActive()
+   {
+      pthread_mutex_lock( &m_mutex );
+      bool active = m_active;
+      pthread_mutex_unlock( &m_mutex );
+      return active;
+   }
+
+   bool Wait( uint32 ms )
+   {
+      pthread_mutex_lock( &m_mutex );
+      if ( ms == uint32_max )
+      {
+         while ( m_active )
+            pthread_cond_wait( &m_finished, &m_mutex );
+      }
+      else if ( m_active )
+      {
+         struct timeval now;
+         gettimeofday( &now, nullptr );
+         uint64 ns = uint64( now.tv_usec )*1000u + uint64( ms )*1000000u;
+         struct timespec deadline;
+         deadline.tv_sec = now.tv_sec + time_t( ns/1000000000u );
+         deadline.tv_nsec = long( ns%1000000000u );
+         while ( m_active )
+            if ( pthread_cond_timedwait( &m_finished, &m_mutex, &deadline ) == ETIMEDOUT )
+               break;
+      }
+      bool finished = !m_active;
+      pthread_mutex_unlock( &m_mutex );
+      return finished;
+   }
+
+   uint32 Priority() const
+   {
+      return m_priority;
+   }
+
+   void SetPriority( uint32 priority )
+   {
+      m_priority = priority;
+   }
+
+   uint32 StackSize() const
+   {
+      return m_stackSize;
+   }
+
+   void SetStackSize( uint32 size )
+   {
+      m_stackSize = size;
+   }
+
+   uint32 Status() const
+   {
+      return uint32( const_cast<AtomicInt&>( m_status ).Load() );
+   }
+
+   void SetStatus( uint32 status )
+   {
+      m_status.Store( int( status ) );
+   }
+
+   String ConsoleOutputText() const
+   {
+      volatile AutoLock lock( m_consoleMutex );
+      return m_consoleText;
+   }
+
+   void AppendConsoleOutputText( const char16_type* text, bool appendNewline )
+   {
+      volatile AutoLock lock( m_consoleMutex );
+      if ( text != nullptr )
+         m_consoleText.Append( text );
+      if ( appendNewline )
+         m_consoleText.Append( '\n' );
+   }
+
+   void ClearConsoleOutputText()
+   {
+      volatile AutoLock lock( m_consoleMutex );
+      m_consoleText.Clear();
+   }
+
+   static NativeThread* CurrentThread()
+   {
+      return reinterpret_cast<NativeThread*>( pthread_getspecific( s_currentThreadKey ) );
+   }
+
+private:
+
+           api_handle               m_client;
+           pcl::thread_exec_routine m_routine;
+           pthread_mutex_t          m_mutex;
+           pthread_cond_t           m_finished;
+           bool                     m_active;
+           uint32                   m_priority;
+           uint32                   m_stackSize;
+           AtomicInt                m_status;
+           String                   m_consoleText;
+   mutable pcl::Mutex               m_consoleMutex;
+
+   void Finished()
+   {
+      pthread_mutex_lock( &m_mutex );
+      m_active = false;
+      pthread_cond_broadcast( &m_finished );
+      pthread_mutex_unlock( &m_mutex );
+   }
+
+   static void* ThreadEntry( void* data )
+   {
+      NativeThread* T = reinterpret_cast<NativeThread*>( data );
+      (void)pthread_setspecific( s_currentThreadKey, T );
+      (*T->m_routine)( T->m_client );
+      (void)pthread_setspecific( s_currentThreadKey, nullptr );
+      T->Finished();
+      T->Detach();
+      return nullptr;
+   }
+};
+
+#define T  reinterpret_cast<NativeThread*>( const_cast<void*>( handle ) )
+
+// ----------------------------------------------------------------------------
+// Read/write mutexes
+// ----------------------------------------------------------------------------
+
+class NativeReadWriteMutex : public NativeObject
+{
+public:
+
+   NativeReadWriteMutex( api_handle module, const char* type ) :
+      NativeObject( module, type )
+   {
+      pthread_rwlock_init( &m_lock, nullptr );
+   }
+
+   virtual ~NativeReadWriteMutex()
+   {
+      pthread_rwlock_destroy( &m_lock );
+   }
+
+   bool LockForRead( bool tryLock )
+   {
+      return (tryLock ? pthread_rwlock_tryrdlock( &m_lock ) : pthread_rwlock_rdlock( &m_lock )) == 0;
+   }
+
+   bool LockForWrite( bool tryLock )
+   {
+      return (tryLock ? pthread_rwlock_trywrlock( &m_lock ) : pthread_rwlock_wrlock( &m_lock )) == 0;
+   }
+
+   void Unlock()
+   {
+      pthread_rwlock_unlock( &m_lock );
+   }
+
+private:
+
+   pthread_rwlock_t m_lock;
+};
+
+#define M  reinterpret_cast<NativeReadWriteMutex*>( handle )
+
+// ----------------------------------------------------------------------------
+// Cryptographic hashes
+// ----------------------------------------------------------------------------
+
+static inline uint32 RotateLeft32( uint32 x, int n )
+{
+   return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32 RotateRight32( uint32 x, int n )
+{
+   return (x >> n) | (x << (32 - n));
+}
+
+static inline uint64 RotateRight64( uint64 x, int n )
+{
+   return (x >> n) | (x << (64 - n));
+}
+
+static inline uint32 LoadBE32( const uint8* p )
+{
+   return (uint32( p[0] ) << 24) | (uint32( p[1] ) << 16) | (uint32( p[2] ) << 8) | uint32( p[3] );
+}
+
+static inline uint32 LoadLE32( const uint8* p )
+{
+   return (uint32( p[3] ) << 24) | (uint32( p[2] ) << 16) | (uint32( p[1] ) << 8) | uint32( p[0] );
+}
+
+static inline uint64 LoadBE64( const uint8* p )
+{
+   return (uint64( LoadBE32( p ) ) << 32) | uint64( LoadBE32( p+4 ) );
+}
+
+static inline void StoreBE32( uint8* p, uint32 x )
+{
+   p[0] = uint8( x >> 24 ); p[1] = uint8( x >> 16 ); p[2] = uint8( x >> 8 ); p[3] = uint8( x );
+}
+
+static inline void StoreLE32( uint8* p, uint32 x )
+{
+   p[0] = uint8( x ); p[1] = uint8( x >> 8 ); p[2] = uint8( x >> 16 ); p[3] = uint8( x >> 24 );
+}
+
+static inline void StoreBE64( uint8* p, uint64 x )
+{
+   StoreBE32( p, uint32( x >> 32 ) ); StoreBE32( p+4, uint32( x ) );
+}
+
+/*
+ * Merkle-Damgård hash engine with 64-byte (MD5, SHA-1, SHA-224, SHA-256) or
+ * 128-byte (SHA-384, SHA-512) message blocks.
+ */
+class NativeHash : public NativeObject
+{
+public:
+
+   NativeHash( api_handle module, int algorithm ) :
+      NativeObject( module, "CryptographicHash" ),
+      m_algorithm( algorithm )
+   {
+      Initialize();
+   }
+
+   static bool IsValidAlgorithm( int algorithm )
+   {
+      switch ( algorithm )
+      {
+      case CryptographyContext::MD5:
+      case CryptographyContext::SHA1:
+      case CryptographyContext::SHA224:
+      case CryptographyContext::SHA256:
+      case CryptographyContext::SHA384:
+      case CryptographyContext::SHA512:
+         return true;
+      default:
+         return false;
+      }
+   }
+
+   void Initialize()
+   {
+      static const uint32 iv224[ 8 ] = { 0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+                                         0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4 };
+      static const uint32 iv256[ 8 ] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+      static const uint64 iv384[ 8 ] = { 0xcbbb9d5dc1059ed8ull, 0x629a292a367cd507ull, 0x9159015a3070dd17ull, 0x152fecd8f70e5939ull,
+                                         0x67332667ffc00b31ull, 0x8eb44a8768581511ull, 0xdb0c2e0d64f98fa7ull, 0x47b5481dbefa4fa4ull };
+      static const uint64 iv512[ 8 ] = { 0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull, 0xa54ff53a5f1d36f1ull,
+                                         0x510e527fade682d1ull, 0x9b05688c2b3e6c1full, 0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull };
+      switch ( m_algorithm )
+      {
+      case CryptographyContext::MD5:
+         m_h32[0] = 0x67452301; m_h32[1] = 0xefcdab89; m_h32[2] = 0x98badcfe; m_h32[3] = 0x10325476;
+         break;
+      case CryptographyContext::SHA1:
+         m_h32[0] = 0x67452301; m_h32[1] = 0xefcdab89; m_h32[2] = 0x98badcfe; m_h32[3] = 0x10325476; m_h32[4] = 0xc3d2e1f0;
+         break;
+      case CryptographyContext::SHA224:
+         memcpy( m_h32, iv224, sizeof( iv224 ) );
+         break;
+      case CryptographyContext::SHA256:
+         memcpy( m_h32, iv256, sizeof( iv256 ) );
+         break;
+      case CryptographyContext::SHA384:
+         memcpy( m_h64, iv384, sizeof( iv384 ) );
+         break;
+      case CryptographyContext::SHA512:
+         memcpy( m_h64, iv512, sizeof( iv512 ) );
+         break;
+      }
+      m_length = 0;
+      m_count = 0;
+   }
+
+   void Update( const void* data, size_type length )
+   {
+      const uint8* p = reinterpret_cast<const uint8*>( data );
+      size_type blockSize = BlockSize();
+      m_length += length;
+      if ( m_count > 0 )
+      {
+         size_type n = pcl::Min( blockSize - m_count, length );
+         memcpy( m_block + m_count, p, n );
+         m_count += n;
+         p += n;
+         length -= n;
+         if ( m_count < blockSize )
+            return;
+         Transform( m_block );
+         m_count = 0;
+      }
+      for ( ; length >= blockSize; p += blockSize, length -= blockSize )
+         Transform( p );
+      if ( length > 0 )
+      {
+         memcpy( m_block, p, length );
+         m_count = length;
+      }
+   }
+
+   void Finalize( void* hash )
+   {
+      size_type blockSize = BlockSize();
+      size_type lengthSize = blockSize >> 3; // 8 or 16 bytes
+      uint64 bits = m_length << 3;
+
+      uint8 pad[ 2*128 ];
+      memset( pad, 0, sizeof( pad ) );
+      pad[0] = 0x80;
+      size_type n = blockSize - (m_count + 1 + lengthSize)%blockSize;
+      n = ((n == blockSize) ? 0 : n) + 1;
+      uint8 len[ 16 ];
+      memset( len, 0, sizeof( len ) );
+      if ( m_algorithm == CryptographyContext::MD5 )
+      {
+         StoreLE32( len, uint32( bits ) );
+         StoreLE32( len+4, uint32( bits >> 32 ) );
+      }
+      else
+         StoreBE64( len + lengthSize - 8, bits );
+      Update( pad, n );
+      Update( len, lengthSize );
+
+      uint8* h = reinterpret_cast<uint8*>( hash );
+      switch ( m_algorithm )
+      {
+      case CryptographyContext::MD5:
+         for ( int i = 0; i < 4; ++i )
+            StoreLE32( h + 4*i, m_h32[i] );
+         break;
+      case CryptographyContext::SHA1:
+      case CryptographyContext::SHA224:
+      case CryptographyContext::SHA256:
+         for ( size_type i = 0, n = HashLength()/4; i < n; ++i )
+            StoreBE32( h + 4*i, m_h32[i] );
+         break;
+      case CryptographyContext::SHA384:
+      case CryptographyContext::SHA512:
+         for ( size_type i = 0, n = HashLength()/8; i < n; ++i )
+            StoreBE64( h + 8*i, m_h64[i] );
+         break;
+      }
+
+      Initialize();
+   }
+
+private:
+
+   int       m_algorithm;
+   uint32    m_h32[ 8 ];
+   uint64    m_h64[ 8 ];
+   uint64    m_length;        // total message length in bytes
+   size_type m_count;         // bytes in the pending block buffer
+   uint8     m_block[ 128 ];
+
+   size_type BlockSize() const
+   {
+      return (m_algorithm == CryptographyContext::SHA384 || m_algorithm == CryptographyContext::SHA512) ? 128 : 64;
+   }
+
+   size_type HashLength() const
+   {
+      switch ( m_algorithm )
+      {
+      case CryptographyContext::MD5:    return 16;
+      case CryptographyContext::SHA1:   return 20;
+      case CryptographyContext::SHA224: return 28;
+      case CryptographyContext::SHA256: return 32;
+      case CryptographyContext::SHA384: return 48;
+      default:
+      case CryptographyContext::SHA512: return 64;
+      }
+   }
+
+   void Transform( const uint8* block )
+   {
+      switch ( m_algorithm )
+      {
+      case CryptographyContext::MD5:
+         TransformMD5( block );
+         break;
+      case CryptographyContext::SHA1:
+         TransformSHA1( block );
+         break;
+      case CryptographyContext::SHA224:
+      case CryptographyContext::SHA256:
+         TransformSHA256( block );
+         break;
+      case CryptographyContext::SHA384:
+      case CryptographyContext::SHA512:
+         TransformSHA512( block );
+         break;
+      }
+   }
+
+   void TransformMD5( const uint8* block )
+   {
+      static const uint32 K[ 64 ] =
+      {
+         0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+         0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+         0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+         0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+         0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+         0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+         0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+         0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+      };
+      static const int S[ 16 ] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+      uint32 X[ 16 ];
+      for ( int i = 0; i < 16; ++i )
+         X[i] = LoadLE32( block + 4*i );
+
+      uint32 a = m_h32[0], b = m_h32[1], c = m_h32[2], d = m_h32[3];
+      for ( int i = 0; i < 64; ++i )
+      {
+         uint32 f;
+         int g;
+         switch ( i >> 4 )
+         {
+         case 0:  f = (b & c) | (~b & d); g = i;             break;
+         case 1:  f = (d & b) | (~d & c); g = (5*i + 1)&15;  break;
+         case 2:  f = b ^ c ^ d;          g = (3*i + 5)&15;  break;
+         default: f = c ^ (b | ~d);       g = (7*i)&15;      break;
+         }
+         uint32 t = d;
+         d = c;
+         c = b;
+         b += RotateLeft32( a + f + K[i] + X[g], S[((i >> 4) << 2) + (i & 3)] );
+         a = t;
+      }
+      m_h32[0] += a; m_h32[1] += b; m_h32[2] += c; m_h32[3] += d;
+   }
+
+   void TransformSHA1( const uint8* block )
+   {
+      uint32 W[ 80 ];
+      for ( int i = 0; i < 16; ++i )
+         W[i] = LoadBE32( block + 4*i );
+      for ( int i = 16; i < 80; ++i )
+         W[i] = RotateLeft32( W[i-3] ^ W[i-8] ^ W[i-14] ^ W[i-16], 1 );
+
+      uint32 a = m_h32[0], b = m_h32[1], c = m_h32[2], d = m_h32[3], e = m_h32[4];
+      for ( int i = 0; i < 80; ++i )
+      {
+         uint32 f, k;
+         if ( i < 20 )
+            f = (b & c) | (~b & d), k = 0x5a827999;
+         else if ( i < 40 )
+            f = b ^ c ^ d, k = 0x6ed9eba1;
+         else if ( i < 60 )
+            f = (b & c) | (b & d) | (c & d), k = 0x8f1bbcdc;
+         else
+            f = b ^ c ^ d, k = 0xca62c1d6;
+         uint32 t = RotateLeft32( a, 5 ) + f + e + k + W[i];
+         e = d;
+         d = c;
+         c = RotateLeft32( b, 30 );
+         b = a;
+         a = t;
+      }
+      m_h32[0] += a; m_h32[1] += b; m_h32[2] += c; m_h32[3] += d; m_h32[4] += e;
+   }
+
+   void TransformSHA256( const uint8* block )
+   {
+      static const uint32 K[ 64 ] =
+      {
+         0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+         0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+         0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+         0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+         0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+         0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+         0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+         0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+      };
+
+      uint32 W[ 64 ];
+      for ( int i = 0; i < 16; ++i )
+         W[i] = LoadBE32( block + 4*i );
+      for ( int i = 16; i < 64; ++i )
+      {
+         uint32 s0 = RotateRight32( W[i-15], 7 ) ^ RotateRight32( W[i-15], 18 ) ^ (W[i-15] >> 3);
+         uint32 s1 = RotateRight32( W[i-2], 17 ) ^ RotateRight32( W[i-2], 19 ) ^ (W[i-2] >> 10);
+         W[i] = W[i-16] + s0 + W[i-7] + s1;
+      }
+
+      uint32 a = m_h32[0], b = m_h32[1], c = m_h32[2], d = m_h32[3],
+             e = m_h32[4], f = m_h32[5], g = m_h32[6], h = m_h32[7];
+      for ( int i = 0; i < 64; ++i )
+      {
+         uint32 t1 = h + (RotateRight32( e, 6 ) ^ RotateRight32( e, 11 ) ^ RotateRight32( e, 25 )) + ((e & f) ^ (~e & g)) + K[i] + W[i];
+         uint32 t2 = (RotateRight32( a, 2 ) ^ RotateRight32( a, 13 ) ^ RotateRight32( a, 22 )) + ((a & b) ^ (a & c) ^ (b & c));
+         h = g; g = f; f = e; e = d + t1;
+         d = c; c = b; b = a; a = t1 + t2;
+      }
+      m_h32[0] += a; m_h32[1] += b; m_h32[2] += c; m_h32[3] += d;
+      m_h32[4] += e; m_h32[5] += f; m_h32[6] += g; m_h32[7] += h;
+   }
+
+   void TransformSHA512( const uint8* block )
+   {
+      static const uint64 K[ 80 ] =
+      {
+         0x428a2f98d728ae22ull, 0x7137449123ef65cdull, 0xb5c0fbcfec4d3b2full, 0xe9b5dba58189dbbcull,
+         0x3956c25bf348b538ull, 0x59f111f1b605d019ull, 0x923f82a4af194f9bull, 0xab1c5ed5da6d8118ull,
+         0xd807aa98a3030242ull, 0x12835b0145706fbeull, 0x243185be4ee4b28cull, 0x550c7dc3d5ffb4e2ull,
+         0x72be5d74f27b896full, 0x80deb1fe3b1696b1ull, 0x9bdc06a725c71235ull, 0xc19bf174cf692694ull,
+         0xe49b69c19ef14ad2ull, 0xefbe4786384f25e3ull, 0x0fc19dc68b8cd5b5ull, 0x240ca1cc77ac9c65ull,
+         0x2de92c6f592b0275ull, 0x4a7484aa6ea6e483ull, 0x5cb0a9dcbd41fbd4ull, 0x76f988da831153b5ull,
+         0x983e5152ee66dfabull, 0xa831c66d2db43210ull, 0xb00327c898fb213full, 0xbf597fc7beef0ee4ull,
+         0xc6e00bf33da88fc2ull, 0xd5a79147930aa725ull, 0x06ca6351e003826full, 0x142929670a0e6e70ull,
+         0x27b70a8546d22ffcull, 0x2e1b21385c26c926ull, 0x4d2c6dfc5ac42aedull, 0x53380d139d95b3dfull,
+         0x650a73548baf63deull, 0x766a0abb3c77b2a8ull, 0x81c2c92e47edaee6ull, 0x92722c851482353bull,
+         0xa2bfe8a14cf10364ull, 0xa81a664bbc423001ull, 0xc24b8b70d0f89791ull, 0xc76c51a30654be30ull,
+         0xd192e819d6ef5218ull, 0xd69906245565a910ull, 0xf40e35855771202aull, 0x106aa07032bbd1b8ull,
+         0x19a4c116b8d2d0c8ull, 0x1e376c085141ab53ull, 0x2748774cdf8eeb99ull, 0x34b0bcb5e19b48a8ull,
+         0x391c0cb3c5c95a63ull, 0x4ed8aa4ae3418acbull, 0x5b9cca4f7763e373ull, 0x682e6ff3d6b2b8a3ull,
+         0x748f82ee5defb2fcull, 0x78a5636f43172f60ull, 0x84c87814a1f0ab72ull, 0x8cc702081a6439ecull,
+         0x90befffa23631e28ull, 0xa4506cebde82bde9ull, 0xbef9a3f7b2c67915ull, 0xc67178f2e372532bull,
+         0xca273eceea26619cull, 0xd186b8c721c0c207ull, 0xeada7dd6cde0eb1eull, 0xf57d4f7fee6ed178ull,
+         0x06f067aa72176fbaull, 0x0a637dc5a2c898a6ull, 0x113f9804bef90daeull, 0x1b710b35131c471bull,
+         0x28db77f523047d84ull, 0x32caab7b40c72493ull, 0x3c9ebe0a15c9bebcull, 0x431d67c49c100d4cull,
+         0x4cc5d4becb3e42b6ull, 0x597f299cfc657e2aull, 0x5fcb6fab3ad6faecull, 0x6c44198c4a475817ull
+      };
+
+      uint64 W[ 80 ];
+      for ( int i = 0; i < 16; ++i )
+         W[i] = LoadBE64( block + 8*i );
+      for ( int i = 16; i < 80; ++i )
+      {
+         uint64 s0 = RotateRight64( W[i-15], 1 ) ^ RotateRight64( W[i-15], 8 ) ^ (W[i-15] >> 7);
+         uint64 s1 = RotateRight64( W[i-2], 19 ) ^ RotateRight64( W[i-2], 61 ) ^ (W[i-2] >> 6);
+         W[i] = W[i-16] + s0 + W[i-7] + s1;
+      }
+
+      uint64 a = m_h64[0], b = m_h64[1], c = m_h64[2], d = m_h64[3],
+             e = m_h64[4], f = m_h64[5], g = m_h64[6], h = m_h64[7];
+      for ( int i = 0; i < 80; ++i )
+      {
+         uint64 t1 = h + (RotateRight64( e, 14 ) ^ RotateRight64( e, 18 ) ^ RotateRight64( e, 41 )) + ((e & f) ^ (~e & g)) + K[i] + W[i];
+         uint64 t2 = (RotateRight64( a, 28 ) ^ RotateRight64( a, 34 ) ^ RotateRight64( a, 39 )) + ((a & b) ^ (a & c) ^ (b & c));
+         h = g; g = f; f = e; e = d + t1;
+         d = c; c = b; b = a; a = t1 + t2;
+      }
+      m_h64[0] += a; m_h64[1] += b; m_h64[2] += c; m_h64[3] += d;
+      m_h64[4] += e; m_h64[5] += f; m_h64[6] += g; m_h64[7] += h;
+   }
+};
+
+#define H  reinterpret_cast<NativeHash*>( handle )
+
+// ----------------------------------------------------------------------------
+// Global settings
+// ----------------------------------------------------------------------------
+
+namespace GlobalVariableKind
+{
+   enum value_type { Flag, Integer, Unsigned, Real, Color, String, Font };
+}
+
+struct GlobalVariable
+{
+   IsoString id;
+   int       kind;
+   union
+   {
+      uint32 flag;
+      int32  integer;
+      uint32 unsignedInteger;
+      double real;
+      uint32 color;
+      int32  fontSize;
+   };
+   pcl::String text;
+
+   GlobalVariable( const IsoString& a_id, int a_kind = 0 ) : id( a_id ), kind( a_kind ), real( 0 )
+   {
+   }
+
+   GlobalVariable( const GlobalVariable& ) = default;
+   GlobalVariable& operator =( const GlobalVariable& ) = default;
+
+   bool operator ==( const GlobalVariable& x ) const
+   {
+      return id == x.id;
+   }
+
+   bool operator <( const GlobalVariable& x ) const
+   {
+      return id < x.id;
+   }
+};
+
+typedef SortedArray<GlobalVariable> global_variable_list;
+
+static global_variable_list s_globals;
+static global_variable_list s_savedGlobals;
+static bool                 s_globalsUpdate = false;
+static pcl::Mutex           s_globalsMutex;
+
+static const GlobalVariable* FindGlobal( const char* id, int kind )
+{
+   if ( id == nullptr )
+      return nullptr;
+   global_variable_list::const_iterator i = s_globals.Search( GlobalVariable( id ) );
+   if ( i == s_globals.End() || i->kind != kind )
+      return nullptr;
+   return i;
+}
+
+static GlobalVariable* DefineGlobal( const char* id, int kind )
+{
+   global_variable_list::const_iterator i = s_globals.Search( GlobalVariable( id ) );
+   if ( i == s_globals.End() )
+   {
+      s_globals.Add( GlobalVariable( id, kind ) );
+      i = s_globals.Search( GlobalVariable( id ) );
+   }
+   else if ( i->kind != kind )
+      return nullptr;
+   return s_globals.MutableIterator( i );
+}
+
+static GlobalVariable* ModifiableGlobal( const char* id, int kind )
+{
+   if ( id == nullptr )
+   {
+      SetLastError( HeadlessError_InvalidArgument );
+      return nullptr;
+   }
+   if ( !s_globalsUpdate )
+   {
+      SetLastError( HeadlessError_SettingsContext );
+      return nullptr;
+   }
+   GlobalVariable* v = DefineGlobal( id, kind );
+   if ( v == nullptr )
+      SetLastError( HeadlessError_UndefinedSetting );
+   return v;
+}
+
+// ----------------------------------------------------------------------------
+// Pixel traits LUT
+// ----------------------------------------------------------------------------
+
+static api_pixtraits_lut* s_lut = nullptr;
+
+static api_pixtraits_lut* CreatePixelTraitsLUT()
+{
+   api_pixtraits_lut* L = new api_pixtraits_lut;
+
+   for ( int i = 0; i <= uint8_max; ++i )
+   {
+      L->pFLUT8[i]  = float( i )/uint8_max;
+      L->pFLUTA[i]  = float( i )/(uint8_max*uint8_max);
+      L->p1FLUT8[i] = 1.0F - L->pFLUT8[i];
+      L->pDLUT8[i]  = double( i )/uint8_max;
+      L->pDLUTA[i]  = double( i )/(uint8_max*uint8_max);
+      L->p1DLUT8[i] = 1.0 - L->pDLUT8[i];
+      L->p16LUT8[i] = uint16( i*uint8_to_uint16 );
+      L->p20LUT8[i] = uint32( RoundInt( i*uint8_to_uint20 ) );
+      L->p24LUT8[i] = uint32( i*uint8_to_uint24 );
+      L->p32LUT8[i] = uint32( i )*uint8_to_uint32;
+   }
+
+   for ( int i = 0; i <= uint16_max; ++i )
+   {
+      L->pFLUT16[i]  = float( i )/uint16_max;
+      L->pDLUT16[i]  = double( i )/uint16_max;
+      L->p8LUT16[i]  = uint8( Round( double( i )*uint16_to_uint8 ) );
+      L->p20LUT16[i] = uint32( RoundInt( i*uint16_to_uint20 ) );
+      L->p24LUT16[i] = uint32( RoundInt( i*uint16_to_uint24 ) );
+      L->p32LUT16[i] = uint32( i )*uint16_to_uint32;
+   }
+
+   for ( int i = 0; i <= int( uint20_max ); ++i )
+   {
+      L->pFLUT20[i]  = float( i )/uint20_max;
+      L->pDLUT20[i]  = double( i )/uint20_max;
+      L->p8LUT20[i]  = uint8( RoundInt( i*uint20_to_uint8 ) );
+      L->p16LUT20[i] = uint16( RoundInt( i*uint20_to_uint16 ) );
+      L->p32LUT20[i] = uint32( RoundInt64( i*uint20_to_uint32 ) );
+   }
+
+   return L;
+}
+
+// ----------------------------------------------------------------------------
+// Native API function implementations
+// ----------------------------------------------------------------------------
+
+static AtomicInt s_processStatus;
+
+class NativeGlobal
+{
+public:
+
+   static void api_func GetPixInsightVersion( uint32* major, uint32* minor, uint32* release, uint32* build,
+                                              uint32* beta, uint32* confidential, uint32* le, char* lang )
+   {
+      *major = 1; *minor = 8; *release = 4; *build = 0;
+      *beta = 0; *confidential = 0; *le = 0;
+      strcpy( lang, "en" );
+   }
+
+   static char16_type* api_func GetPixInsightCodename( api_handle )
+   {
+      // The codename must be allocated by the calling module.
+      return nullptr;
+   }
+
+   static uint32 api_func LastError()
+   {
+      return uint32( reinterpret_cast<size_type>( pthread_getspecific( s_lastErrorKey ) ) );
+   }
+
+   static void api_func ClearError()
+   {
+      SetLastError( HeadlessError_None );
+   }
+
+   static api_bool api_func ErrorMessage( uint32 code, char16_type* message, size_type* len )
+   {
+      if ( code >= HeadlessError_NumberOfErrors )
+      {
+         if ( len != nullptr )
+            *len = 0;
+         return api_false;
+      }
+      return CopyString( message, len, IsoString( s_errorMessages[code] ) );
+   }
+
+   static void* api_func Allocate( size_type size )
+   {
+      void* p = malloc( size );
+      if ( p == nullptr )
+         SetLastError( HeadlessError_OutOfMemory );
+      return p;
+   }
+
+   static api_bool api_func Deallocate( void* p )
+   {
+      free( p );
+      return api_true;
+   }
+
+   static uint32 api_func GetProcessStatus()
+   {
+      return uint32( s_processStatus.Load() );
+   }
+
+   static api_bool api_func ResetProcessStatus()
+   {
+      s_processStatus.Store( int( uint32( s_processStatus.Load() ) & 0x40000000 ) );
+      return api_true;
+   }
+
+   static api_bool api_func EnableAbort()
+   {
+      s_processStatus.Store( int( uint32( s_processStatus.Load() ) | 0x40000000 ) );
+      return api_true;
+   }
+
+   static api_bool api_func DisableAbort()
+   {
+      s_processStatus.Store( int( uint32( s_processStatus.Load() ) & ~0x40000000u ) );
+      return api_true;
+   }
+
+   static api_bool api_func Abort()
+   {
+      uint32 status = uint32( s_processStatus.Load() );
+      if ( (status & 0x40000000) == 0 )
+         return api_false;
+      s_processStatus.Store( int( status | 0x80000000 ) );
+      return api_true;
+   }
+
+   static void api_func ProcessEvents( api_bool /*excludeUserInputEvents*/ )
+   {
+      // There is no event loop in headless applications.
+   }
+
+   static console_handle api_func GetConsole()
+   {
+      return s_console;
+   }
+
+   static api_bool api_func ValidateConsole( const_console_handle handle )
+   {
+      return api_bool( handle != nullptr && handle == s_console );
+   }
+
+   static api_bool api_func WriteConsole( console_handle handle, const char16_type* text, api_bool appendNewline )
+   {
+      if ( handle != s_console || s_console == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      s_console->Write( text, appendNewline != api_false );
+      return api_true;
+   }
+
+   static api_bool api_func FlushConsole( console_handle handle )
+   {
+      if ( handle != s_console || s_console == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      s_console->Flush();
+      return api_true;
+   }
+
+   static api_bool api_func ShowConsole( console_handle handle, api_bool )
+   {
+      return api_bool( handle != nullptr && handle == s_console );
+   }
+
+   static api_bool api_func GetGlobalFlag( const char* id, api_bool* value )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      const GlobalVariable* v = FindGlobal( id, GlobalVariableKind::Flag );
+      if ( v == nullptr )
+         return api_false;
+      if ( value != nullptr )
+         *value = v->flag;
+      return api_true;
+   }
+
+   static api_bool api_func GetGlobalInteger( const char* id, void* value, api_bool isSigned )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      const GlobalVariable* v = FindGlobal( id, isSigned ? GlobalVariableKind::Integer : GlobalVariableKind::Unsigned );
+      if ( v == nullptr )
+         return api_false;
+      if ( value != nullptr )
+         if ( isSigned )
+            *reinterpret_cast<int32*>( value ) = v->integer;
+         else
+            *reinterpret_cast<uint32*>( value ) = v->unsignedInteger;
+      return api_true;
+   }
+
+   static api_bool api_func GetGlobalReal( const char* id, double* value )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      const GlobalVariable* v = FindGlobal( id, GlobalVariableKind::Real );
+      if ( v == nullptr )
+         return api_false;
+      if ( value != nullptr )
+         *value = v->real;
+      return api_true;
+   }
+
+   static api_bool api_func GetGlobalColor( const char* id, uint32* value )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      const GlobalVariable* v = FindGlobal( id, GlobalVariableKind::Color );
+      if ( v == nullptr )
+         return api_false;
+      if ( value != nullptr )
+         *value = v->color;
+      return api_true;
+   }
+
+   static api_bool api_func GetGlobalFont( const char* id, char16_type* face, size_type* len, int32* sizePt )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      const GlobalVariable* v = FindGlobal( id, GlobalVariableKind::Font );
+      if ( v == nullptr )
+         return api_false;
+      if ( sizePt != nullptr )
+         *sizePt = v->fontSize;
+      return CopyString( face, len, v->text );
+   }
+
+   static api_bool api_func GetGlobalString( const char* id, char16_type* value, size_type* len )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      const GlobalVariable* v = FindGlobal( id, GlobalVariableKind::String );
+      if ( v == nullptr )
+         return api_false;
+      return CopyString( value, len, v->text );
+   }
+
+   static api_bool api_func EnterGlobalSettingsUpdateContext()
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      if ( s_globalsUpdate )
+      {
+         SetLastError( HeadlessError_SettingsContext );
+         return api_false;
+      }
+      s_savedGlobals = s_globals;
+      s_globalsUpdate = true;
+      return api_true;
+   }
+
+   static api_bool api_func IsGlobalSettingsUpdateContextActive()
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      return api_bool( s_globalsUpdate );
+   }
+
+   static api_bool api_func SetGlobalFlag( const char* id, api_bool value )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      GlobalVariable* v = ModifiableGlobal( id, GlobalVariableKind::Flag );
+      if ( v == nullptr )
+         return api_false;
+      v->flag = api_bool( value != api_false );
+      return api_true;
+   }
+
+   static api_bool api_func SetGlobalInteger( const char* id, uint32 value, api_bool isSigned )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      GlobalVariable* v = ModifiableGlobal( id, isSigned ? GlobalVariableKind::Integer : GlobalVariableKind::Unsigned );
+      if ( v == nullptr )
+         return api_false;
+      v->unsignedInteger = value;
+      return api_true;
+   }
+
+   static api_bool api_func SetGlobalReal( const char* id, double value )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      GlobalVariable* v = ModifiableGlobal( id, GlobalVariableKind::Real );
+      if ( v == nullptr )
+         return api_false;
+      v->real = value;
+      return api_true;
+   }
+
+   static api_bool api_func SetGlobalColor( const char* id, uint32 value )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      GlobalVariable* v = ModifiableGlobal( id, GlobalVariableKind::Color );
+      if ( v == nullptr )
+         return api_false;
+      v->color = value;
+      return api_true;
+   }
+
+   static api_bool api_func SetGlobalFont( const char* id, const char16_type* face, int32 sizePt )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      GlobalVariable* v = ModifiableGlobal( id, GlobalVariableKind::Font );
+      if ( v == nullptr )
+         return api_false;
+      v->text = (face != nullptr) ? pcl::String( face ) : pcl::String();
+      v->fontSize = sizePt;
+      return api_true;
+   }
+
+   static api_bool api_func SetGlobalString( const char* id, const char16_type* value )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      GlobalVariable* v = ModifiableGlobal( id, GlobalVariableKind::String );
+      if ( v == nullptr )
+         return api_false;
+      v->text = (value != nullptr) ? pcl::String( value ) : pcl::String();
+      return api_true;
+   }
+
+   static api_bool api_func CancelGlobalSettingsUpdate( api_handle, uint32 )
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      if ( !s_globalsUpdate )
+      {
+         SetLastError( HeadlessError_SettingsContext );
+         return api_false;
+      }
+      s_globals = s_savedGlobals;
+      return api_true;
+   }
+
+   static api_bool api_func ExitGlobalSettingsUpdateContext()
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      if ( !s_globalsUpdate )
+      {
+         SetLastError( HeadlessError_SettingsContext );
+         return api_false;
+      }
+      s_savedGlobals.Clear();
+      s_globalsUpdate = false;
+      return api_true;
+   }
+
+   static const api_pixtraits_lut* api_func GetPixelTraitsLUT( uint32 version )
+   {
+      if ( version != 0 )
+      {
+         SetLastError( HeadlessError_InvalidArgument );
+         return nullptr;
+      }
+      return s_lut;
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+class NativeUI
+{
+public:
+
+   static api_bool api_func AttachToUIObject( api_handle, api_handle handle )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      O->Attach();
+      return api_true;
+   }
+
+   static api_bool api_func DetachFromUIObject( api_handle, api_handle handle )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      O->Detach();
+      return api_true;
+   }
+
+   static api_handle api_func GetUIObjectModule( const_api_handle handle )
+   {
+      return (handle != nullptr) ? O->Module() : nullptr;
+   }
+
+   static size_type api_func GetUIObjectRefCount( const_api_handle handle )
+   {
+      return (handle != nullptr) ? O->RefCount() : 0;
+   }
+
+   static api_bool api_func GetUIObjectType( const_api_handle handle, char* type, size_type* len )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      return CopyString( type, len, IsoString( O->Type() ) );
+   }
+
+   static api_bool api_func GetUIObjectId( const_api_handle handle, char16_type* id, size_type* len )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      return CopyString( id, len, O->Id() );
+   }
+
+   static api_bool api_func SetUIObjectId( api_handle handle, const char16_type* id )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      O->SetId( (id != nullptr) ? String( id ) : String() );
+      return api_true;
+   }
+
+   static api_bool api_func SetHandleDestroyedEventRoutine( api_handle, pcl::destroy_event_routine )
+   {
+      // Native objects are only destroyed when their last client detaches.
+      return api_true;
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+class NativeThreads
+{
+public:
+
+   static thread_handle api_func CreateThread( api_handle module, api_handle client, uint32 /*flags*/ )
+   {
+      return new NativeThread( module, client );
+   }
+
+   static void api_func StartThread( thread_handle handle, uint32 priority )
+   {
+      if ( handle != nullptr )
+         T->Start( priority );
+   }
+
+   static void api_func KillThread( thread_handle )
+   {
+      // Threads cannot be terminated asynchronously in headless applications,
+      // since C++ stack unwinding would not be guaranteed.
+      SetLastError( HeadlessError_UnsupportedFunction );
+   }
+
+   static api_bool api_func IsThreadActive( const_thread_handle handle )
+   {
+      return api_bool( handle != nullptr && T->IsActive() );
+   }
+
+   static uint32 api_func GetThreadPriority( const_thread_handle handle )
+   {
+      return (handle != nullptr) ? T->Priority() : 0;
+   }
+
+   static void api_func SetThreadPriority( thread_handle handle, uint32 priority )
+   {
+      if ( handle != nullptr )
+         T->SetPriority( priority );
+   }
+
+   static uint32 api_func GetThreadStackSize( const_thread_handle handle )
+   {
+      return (handle != nullptr) ? T->StackSize() : 0;
+   }
+
+   static void api_func SetThreadStackSize( thread_handle handle, uint32 size )
+   {
+      if ( handle != nullptr )
+         T->SetStackSize( size );
+   }
+
+   static api_bool api_func WaitThread( thread_handle handle, uint32 ms )
+   {
+      return api_bool( handle == nullptr || T->Wait( ms ) );
+   }
+
+   static void api_func SleepThread( thread_handle, uint32 ms )
+   {
+      usleep( useconds_t( ms )*1000u );
+   }
+
+   static uint32 api_func GetThreadStatus( const_thread_handle handle )
+   {
+      return (handle != nullptr) ? T->Status() : 0;
+   }
+
+   static void api_func SetThreadStatus( thread_handle handle, uint32 status )
+   {
+      if ( handle != nullptr )
+         T->SetStatus( status );
+   }
+
+   static api_bool api_func GetThreadStatusEx( const_thread_handle handle, uint32* status, uint32 /*flags*/ )
+   {
+      if ( handle == nullptr || status == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidArgument );
+         return api_false;
+      }
+      *status = T->Status();
+      return api_true;
+   }
+
+   static api_bool api_func GetThreadConsoleOutputText( const_thread_handle handle, char16_type* text, size_type* len )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      String s = T->ConsoleOutputText();
+      if ( text == nullptr && s.IsEmpty() )
+      {
+         if ( len != nullptr )
+            *len = 0;
+         return api_true;
+      }
+      return CopyString( text, len, s );
+   }
+
+   static void api_func AppendThreadConsoleOutputText( thread_handle handle, const char16_type* text, api_bool appendNewline )
+   {
+      if ( handle != nullptr )
+         T->AppendConsoleOutputText( text, appendNewline != api_false );
+   }
+
+   static void api_func ClearThreadConsoleOutputText( thread_handle handle )
+   {
+      if ( handle != nullptr )
+         T->ClearConsoleOutputText();
+   }
+
+   static thread_handle api_func GetCurrentThread()
+   {
+      return NativeThread::CurrentThread();
+   }
+
+   static api_bool api_func SetThreadExecRoutine( thread_handle handle, pcl::thread_exec_routine routine )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      T->SetExecRoutine( routine );
+      return api_true;
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+class NativeMutexes
+{
+public:
+
+   static mutex_handle api_func CreateMutex( api_handle module, api_handle, uint32 )
+   {
+      return new NativeReadWriteMutex( module, "Mutex" );
+   }
+
+   static mutex_handle api_func CreateReadWriteMutex( api_handle module, api_handle, uint32 )
+   {
+      return new NativeReadWriteMutex( module, "ReadWriteMutex" );
+   }
+
+   static api_bool api_func Lock( mutex_handle handle, api_bool tryLock )
+   {
+      return api_bool( handle != nullptr && M->LockForWrite( tryLock != api_false ) );
+   }
+
+   static api_bool api_func LockForRead( mutex_handle handle, api_bool tryLock )
+   {
+      return api_bool( handle != nullptr && M->LockForRead( tryLock != api_false ) );
+   }
+
+   static api_bool api_func LockForWrite( mutex_handle handle, api_bool tryLock )
+   {
+      return api_bool( handle != nullptr && M->LockForWrite( tryLock != api_false ) );
+   }
+
+   static void api_func Unlock( mutex_handle handle )
+   {
+      if ( handle != nullptr )
+         M->Unlock();
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+class NativeCompression
+{
+public:
+
+   static uint32 api_func ZLibMinUncompressedBlockSize()
+   {
+      return 64;
+   }
+
+   static uint32 api_func ZLibMaxUncompressedBlockSize()
+   {
+      // compressBound() must be representable as a 32-bit unsigned integer.
+      return uint32( int32_max );
+   }
+
+   static uint32 api_func ZLibMaxCompressedBlockSize( uint32 size )
+   {
+      return uint32( compressBound( uLong( size ) ) );
+   }
+
+   static int32 api_func ZLibMaxCompressionLevel()
+   {
+      return Z_BEST_COMPRESSION;
+   }
+
+   static int32 api_func ZLibDefaultCompressionLevel()
+   {
+      return 6;
+   }
+
+   static api_bool api_func ZLibCompressBlock( void* outputData, uint32* outputSize,
+                                               const void* inputData, uint32 inputSize, int32 level )
+   {
+      if ( outputData == nullptr || outputSize == nullptr || inputData == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidArgument );
+         return api_false;
+      }
+      uLongf n = uLongf( *outputSize );
+      if ( compress2( reinterpret_cast<Bytef*>( outputData ), &n,
+                      reinterpret_cast<const Bytef*>( inputData ), uLong( inputSize ),
+                      (level <= 0) ? ZLibDefaultCompressionLevel() : pcl::Min( level, ZLibMaxCompressionLevel() ) ) != Z_OK )
+      {
+         SetLastError( HeadlessError_Compression );
+         return api_false;
+      }
+      *outputSize = uint32( n );
+      return api_true;
+   }
+
+   static api_bool api_func ZLibUncompressBlock( void* outputData, uint32* outputSize,
+                                                 const void* inputData, uint32 inputSize )
+   {
+      if ( outputData == nullptr || outputSize == nullptr || inputData == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidArgument );
+         return api_false;
+      }
+      uLongf n = uLongf( *outputSize );
+      if ( uncompress( reinterpret_cast<Bytef*>( outputData ), &n,
+                       reinterpret_cast<const Bytef*>( inputData ), uLong( inputSize ) ) != Z_OK )
+      {
+         SetLastError( HeadlessError_Compression );
+         return api_false;
+      }
+      *outputSize = uint32( n );
+      return api_true;
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+class NativeCryptography
+{
+public:
+
+   static crypto_handle api_func CreateCryptographicHash( api_handle module, int32 algorithm )
+   {
+      if ( !NativeHash::IsValidAlgorithm( algorithm ) )
+      {
+         SetLastError( HeadlessError_InvalidArgument );
+         return nullptr;
+      }
+      return new NativeHash( module, algorithm );
+   }
+
+   static api_bool api_func InitializeCryptographicHash( crypto_handle handle )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      H->Initialize();
+      return api_true;
+   }
+
+   static api_bool api_func UpdateCryptographicHash( crypto_handle handle, const void* data, size_type length )
+   {
+      if ( handle == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidHandle );
+         return api_false;
+      }
+      if ( length > 0 )
+      {
+         if ( data == nullptr )
+         {
+            SetLastError( HeadlessError_InvalidArgument );
+            return api_false;
+         }
+         H->Update( data, length );
+      }
+      return api_true;
+   }
+
+   static api_bool api_func FinalizeCryptographicHash( crypto_handle handle, void* hash )
+   {
+      if ( handle == nullptr || hash == nullptr )
+      {
+         SetLastError( HeadlessError_InvalidArgument );
+         return api_false;
+      }
+      H->Finalize( hash );
+      return api_true;
+   }
+};
+
+#undef O
+#undef T
+#undef M
+#undef H
+
+// ----------------------------------------------------------------------------
+// Function resolver
+// ----------------------------------------------------------------------------
+
+/*
+ * Stub for API functions without a native implementation. All core API
+ * functions use the C calling convention, which allows us to call this
+ * function through any API function pointer: the caller will receive a zero
+ * value as returned pointer, integer or Boolean, and the error code can be
+ * retrieved with Global/LastError.
+ */
+static void* api_func UnsupportedFunction()
+{
+   SetLastError( HeadlessError_UnsupportedFunction );
+   return nullptr;
+}
+
+struct NativeFunction
+{
+   const char* name;
+   void*       address;
+};
+
+#define NATIVE( context, implementation, function ) \
+   { #context "/" #function, reinterpret_cast<void*>( implementation::function ) }
+
+static const NativeFunction s_nativeFunctions[] =
+{
+   NATIVE( Global, NativeGlobal, GetPixInsightVersion ),
+   NATIVE( Global, NativeGlobal, GetPixInsightCodename ),
+   NATIVE( Global, NativeGlobal, LastError ),
+   NATIVE( Global, NativeGlobal, ClearError ),
+   NATIVE( Global, NativeGlobal, ErrorMessage ),
+   NATIVE( Global, NativeGlobal, Allocate ),
+   NATIVE( Global, NativeGlobal, Deallocate ),
+   NATIVE( Global, NativeGlobal, GetProcessStatus ),
+   NATIVE( Global, NativeGlobal, ResetProcessStatus ),
+   NATIVE( Global, NativeGlobal, EnableAbort ),
+   NATIVE( Global, NativeGlobal, DisableAbort ),
+   NATIVE( Global, NativeGlobal, Abort ),
+   NATIVE( Global, NativeGlobal, ProcessEvents ),
+   NATIVE( Global, NativeGlobal, GetConsole ),
+   NATIVE( Global, NativeGlobal, ValidateConsole ),
+   NATIVE( Global, NativeGlobal, WriteConsole ),
+   NATIVE( Global, NativeGlobal, FlushConsole ),
+   NATIVE( Global, NativeGlobal, ShowConsole ),
+   NATIVE( Global, NativeGlobal, GetGlobalFlag ),
+   NATIVE( Global, NativeGlobal, GetGlobalInteger ),
+   NATIVE( Global, NativeGlobal, GetGlobalReal ),
+   NATIVE( Global, NativeGlobal, GetGlobalColor ),
+   NATIVE( Global, NativeGlobal, GetGlobalFont ),
+   NATIVE( Global, NativeGlobal, GetGlobalString ),
+   NATIVE( Global, NativeGlobal, EnterGlobalSettingsUpdateContext ),
+   NATIVE( Global, NativeGlobal, IsGlobalSettingsUpdateContextActive ),
+   NATIVE( Global, NativeGlobal, SetGlobalFlag ),
+   NATIVE( Global, NativeGlobal, SetGlobalInteger ),
+   NATIVE( Global, NativeGlobal, SetGlobalReal ),
+   NATIVE( Global, NativeGlobal, SetGlobalColor ),
+   NATIVE( Global, NativeGlobal, SetGlobalFont ),
+   NATIVE( Global, NativeGlobal, SetGlobalString ),
+   NATIVE( Global, NativeGlobal, CancelGlobalSettingsUpdate ),
+   NATIVE( Global, NativeGlobal, ExitGlobalSettingsUpdateContext ),
+   NATIVE( Global, NativeGlobal, GetPixelTraitsLUT ),
+
+   NATIVE( UI, NativeUI, AttachToUIObject ),
+   NATIVE( UI, NativeUI, DetachFromUIObject ),
+   NATIVE( UI, NativeUI, GetUIObjectModule ),
+   NATIVE( UI, NativeUI, GetUIObjectRefCount ),
+   NATIVE( UI, NativeUI, GetUIObjectType ),
+   NATIVE( UI, NativeUI, GetUIObjectId ),
+   NATIVE( UI, NativeUI, SetUIObjectId ),
+   NATIVE( UI, NativeUI, SetHandleDestroyedEventRoutine ),
+
+   NATIVE( Thread, NativeThreads, CreateThread ),
+   NATIVE( Thread, NativeThreads, StartThread ),
+   NATIVE( Thread, NativeThreads, KillThread ),
+   NATIVE( Thread, NativeThreads, IsThreadActive ),
+   NATIVE( Thread, NativeThreads, GetThreadPriority ),
+   NATIVE( Thread, NativeThreads, SetThreadPriority ),
+   NATIVE( Thread, NativeThreads, GetThreadStackSize ),
+   NATIVE( Thread, NativeThreads, SetThreadStackSize ),
+   NATIVE( Thread, NativeThreads, WaitThread ),
+   NATIVE( Thread, NativeThreads, SleepThread ),
+   NATIVE( Thread, NativeThreads, GetThreadStatus ),
+   NATIVE( Thread, NativeThreads, SetThreadStatus ),
+   NATIVE( Thread, NativeThreads, GetThreadStatusEx ),
+   NATIVE( Thread, NativeThreads, GetThreadConsoleOutputText ),
+   NATIVE( Thread, NativeThreads, AppendThreadConsoleOutputText ),
+   NATIVE( Thread, NativeThreads, ClearThreadConsoleOutputText ),
+   NATIVE( Thread, NativeThreads, GetCurrentThread ),
+   NATIVE( Thread, NativeThreads, SetThreadExecRoutine ),
+
+   NATIVE( Mutex, NativeMutexes, CreateMutex ),
+   NATIVE( Mutex, NativeMutexes, CreateReadWriteMutex ),
+   NATIVE( Mutex, NativeMutexes, Lock ),
+   NATIVE( Mutex, NativeMutexes, LockForRead ),
+   NATIVE( Mutex, NativeMutexes, LockForWrite ),
+   NATIVE( Mutex, NativeMutexes, Unlock ),
+
+   NATIVE( Compression, NativeCompression, ZLibMinUncompressedBlockSize ),
+   NATIVE( Compression, NativeCompression, ZLibMaxUncompressedBlockSize ),
+   NATIVE( Compression, NativeCompression, ZLibMaxCompressedBlockSize ),
+   NATIVE( Compression, NativeCompression, ZLibMaxCompressionLevel ),
+   NATIVE( Compression, NativeCompression, ZLibDefaultCompressionLevel ),
+   NATIVE( Compression, NativeCompression, ZLibCompressBlock ),
+   NATIVE( Compression, NativeCompression, ZLibUncompressBlock ),
+
+   NATIVE( Cryptography, NativeCryptography, CreateCryptographicHash ),
+   NATIVE( Cryptography, NativeCryptography, InitializeCryptographicHash ),
+   NATIVE( Cryptography, NativeCryptography, UpdateCryptographicHash ),
+   NATIVE( Cryptography, NativeCryptography, FinalizeCryptographicHash )
+};
+
+#undef NATIVE
+
+static const NativeFunction* FindNativeFunction( const char* name )
+{
+   if ( name != nullptr )
+      for ( size_type i = 0; i < ItemsInArray( s_nativeFunctions ); ++i )
+         if ( strcmp( s_nativeFunctions[i].name, name ) == 0 )
+            return s_nativeFunctions + i;
+   return nullptr;
+}
+
+static void* api_func NativeFunctionResolver( const char* name )
+{
+   const NativeFunction* f = FindNativeFunction( name );
+   return (f != nullptr) ? f->address : reinterpret_cast<void*>( UnsupportedFunction );
+}
+
+// ----------------------------------------------------------------------------
+// HeadlessAPI
+// ----------------------------------------------------------------------------
+
+static bool s_initialized = false;
+
+static void DefineGlobalFlag( const char* id, bool value )
+{
+   DefineGlobal( id, GlobalVariableKind::Flag )->flag = api_bool( value );
+}
+
+static void DefineGlobalInteger( const char* id, int value )
+{
+   DefineGlobal( id, GlobalVariableKind::Integer )->integer = int32( value );
+}
+
+void HeadlessAPI::Initialize( int maxProcessors )
+{
+   if ( API != nullptr )
+      throw Error( "HeadlessAPI::Initialize(): The global API object has already been initialized." );
+
+   pthread_once( &s_keysOnce, CreateThreadKeys );
+
+   if ( s_console == nullptr )
+      s_console = new NativeConsole;
+
+   if ( s_lut == nullptr )
+      s_lut = CreatePixelTraitsLUT();
+
+   int numberOfProcessors = pcl::Range( int( sysconf( _SC_NPROCESSORS_ONLN ) ), 1, PCL_MAX_PROCESSORS );
+   {
+      volatile AutoLock lock( s_globalsMutex );
+      s_globals.Clear();
+      s_globalsUpdate = false;
+      DefineGlobalInteger( "System/NumberOfProcessors", numberOfProcessors );
+      DefineGlobalInteger( "Process/MaxProcessors", (maxProcessors > 0) ? pcl::Min( maxProcessors, numberOfProcessors ) : numberOfProcessors );
+      DefineGlobalFlag( "Process/EnableParallelProcessing", maxProcessors != 1 );
+      DefineGlobalFlag( "Process/EnableParallelModuleProcessing", maxProcessors != 1 );
+      DefineGlobalFlag( "Process/EnableThreadCPUAffinity", false );
+      DefineGlobalFlag( "Process/EnableParallelCoreRendering", false );
+      DefineGlobalFlag( "Process/EnableParallelCoreColorManagement", false );
+   }
+
+   s_processStatus.Store( 0 );
+
+   API = new APIInterface( NativeFunctionResolver );
+   s_initialized = true;
+
+   // Errors are reported on the console; there is no graphical interface.
+   Exception::EnableConsoleOutput( true );
+   Exception::EnableGUIOutput( false );
+}
+
+void HeadlessAPI::Terminate()
+{
+   if ( s_initialized )
+   {
+      if ( s_console != nullptr )
+         s_console->Flush();
+
+      // Pool worker threads depend on the API, so they must go first.
+      ThreadPool::Shutdown();
+
+      delete API;
+      API = nullptr;
+      s_initialized = false;
+   }
+}
+
+bool HeadlessAPI::IsInitialized()
+{
+   return s_initialized;
+}
+
+HeadlessConsoleOutput::value_type HeadlessAPI::ConsoleOutput()
+{
+   return (s_console != nullptr) ? s_console->Output() : HeadlessConsoleOutput::StandardOutput;
+}
+
+void HeadlessAPI::SetConsoleOutput( HeadlessConsoleOutput::value_type output )
+{
+   if ( s_console == nullptr )
+      s_console = new NativeConsole;
+   s_console->SetOutput( output );
+}
+
+void* HeadlessAPI::FunctionAddress( const char* name )
+{
+   return NativeFunctionResolver( name );
+}
+
+bool HeadlessAPI::IsNativeFunction( const char* name )
+{
+   return FindNativeFunction( name ) != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+// ----------------------------------------------------------------------------
+// EOF pcl/HeadlessAPI.cpp - Released 2016/02/21 20:22:19 UTC
@@ -52,6 +52,13 @@
 #include <pcl/Histogram.h>
 #include <pcl/HistogramTransformation.h>
 #include <pcl/Thread.h>
+#include <pcl/ThreadPool.h>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __PCL_MACOSX )
+# define __PCL_HT_EVALUATOR_SSE2 1
+# include <xmmintrin.h>
+# include <emmintrin.h>
+#endif
 
 namespace pcl
 {
@@ -120,6 +127,13 @@ void ApplyHistogramTransformation( T* a, size_type n, T x0, T x1, const Histogra
    }
 }
 
+/*
+ * Minimum number of samples to approximate a transformation chain for 32-bit
+ * floating point data. For smaller data sets, building the evaluator may be
+ * more expensive than exact evaluation.
+ */
+#define FAST_EVALUATION_MIN_SAMPLES   size_type( 256*1024 )
+
 void HistogramTransformation::Apply( double* a, size_type n, double x0, double x1 ) const
 {
    ApplyHistogramTransformation( a, n, x0, x1, *this );
@@ -127,11 +141,246 @@ void HistogramTransformation::Apply( double* a, size_type n, double x0, double x
 
 void HistogramTransformation::Apply( float* a, size_type n, float x0, float x1 ) const
 {
+   if ( !m_exact && n >= FAST_EVALUATION_MIN_SAMPLES && !IsIdentityTransformationSet() )
+   {
+      Evaluator E( *this, m_tolerance );
+      if ( E.IsValid() )
+      {
+         const size_type blockSize = 65536;
+         size_type blocks = (n + blockSize - 1)/blockSize;
+         if ( m_parallel && blocks > 1 && blocks <= size_type( int_max ) )
+            ThreadPool::ParallelFor( int( blocks ), 0,
+               [=,&E]( int startBlock, int endBlock )
+               {
+                  size_type i = size_type( startBlock )*blockSize;
+                  size_type j = pcl::Min( n, size_type( endBlock )*blockSize );
+                  E.Apply( a+i, j-i, x0, x1 );
+               } );
+         else
+            E.Apply( a, n, x0, x1 );
+         return;
+      }
+   }
+
    ApplyHistogramTransformation( a, n, x0, x1, *this );
 }
 
 // ----------------------------------------------------------------------------
 
+/*
+ * Maximum number of cubic interpolation intervals for fast evaluation of
+ * transformation chains.
+ */
+#define MAX_EVALUATOR_INTERVALS  (1 << 18)
+
+/*
+ * Number of intervals processed by a single task during construction of a
+ * fast evaluator.
+ */
+#define EVALUATOR_GRAIN          4096
+
+static double EvaluateChain( const HistogramTransformation& H, double x )
+{
+   for ( size_type j = 0; j < H.Length(); ++j )
+      H[j].Transform( x );
+   return x;
+}
+
+HistogramTransformation::Evaluator::Evaluator( const HistogramTransformation& H, double tolerance ) :
+   m_table(),
+   m_intervals( 0 ),
+   m_x0( 0 ),
+   m_scale( 0 ),
+   m_maxIndex( 0 ),
+   m_tolerance( Max( 0.0, tolerance ) ),
+   m_error( 0 )
+{
+   double f0 = EvaluateChain( H, 0 );
+   double f1 = EvaluateChain( H, 1 );
+   if ( f0 == f1 )
+   {
+      // Constant transformation.
+      Build( H, 0, 1, 1 );
+      m_error = Abs( double( float( f0 ) ) - f0 );
+      return;
+   }
+
+   /*
+    * All transformations in the chain are nondecreasing functions, constant
+    * out of their clipping points and smooth between them. Hence the whole
+    * chain is constant in [0,a] and [b,1], and smooth on (a,b). Find both
+    * breakpoints by bisection.
+    */
+   double a = 0;
+   for ( double x1 = 1; x1 - a > 1.0e-15; )
+   {
+      double x = (a + x1)/2;
+      if ( EvaluateChain( H, x ) == f0 )
+         a = x;
+      else
+         x1 = x;
+   }
+   double b = 1;
+   for ( double x0 = a; b - x0 > 1.0e-15; )
+   {
+      double x = (x0 + b)/2;
+      if ( EvaluateChain( H, x ) == f1 )
+         b = x;
+      else
+         x0 = x;
+   }
+
+   /*
+    * The interpolation error decreases as the fourth power of the interval
+    * length. Increase the number of intervals until the error is acceptable.
+    */
+   for ( int n = 256;; )
+   {
+      Build( H, a, b, n );
+      m_error = Measure( H, a, b );
+      if ( m_error <= m_tolerance || n >= MAX_EVALUATOR_INTERVALS )
+         break;
+      double r = 1.25*Pow( m_error/Max( m_tolerance, 1.0e-12 ), 0.25 );
+      int n1 = 2*n;
+      while ( n1 < MAX_EVALUATOR_INTERVALS && n1 < r*n )
+         n1 *= 2;
+      n = Min( n1, MAX_EVALUATOR_INTERVALS );
+   }
+}
+
+void HistogramTransformation::Evaluator::Build( const HistogramTransformation& H, double a, double b, int n )
+{
+   m_intervals = n;
+   m_x0 = float( a );
+   m_scale = float( n/(b - a) );
+   m_maxIndex = float( n - 1 );
+   m_table = Array<float>( 4*size_type( n ) );
+
+   /*
+    * Cubic polynomial interpolating the chain at t = 0, 1/3, 2/3 and 1 on
+    * each interval, in power form p(t) = c0 + c1*t + c2*t^2 + c3*t^3.
+    */
+   double h = (b - a)/n;
+   ThreadPool::ParallelFor( n, EVALUATOR_GRAIN,
+      [&]( int startInterval, int endInterval )
+      {
+         float* c = m_table.Begin() + 4*size_type( startInterval );
+         double v0 = EvaluateChain( H, a + startInterval*h );
+         for ( int i = startInterval; i < endInterval; ++i, c += 4 )
+         {
+            double x = a + i*h;
+            double v1 = EvaluateChain( H, x + h/3 );
+            double v2 = EvaluateChain( H, x + 2*h/3 );
+            double v3 = (i == n-1) ? EvaluateChain( H, b ) : EvaluateChain( H, a + (i + 1)*h );
+            double d1 = v1 - v0;
+            double d2 = v2 - 2*v1 + v0;
+            double d3 = v3 - 3*v2 + 3*v1 - v0;
+            c[0] = float( v0 );
+            c[1] = float( 3*(d1 - d2/2 + d3/3) );
+            c[2] = float( 9*(d2 - d3)/2 );
+            c[3] = float( 27*d3/6 );
+            v0 = v3;
+         }
+      } );
+}
+
+double HistogramTransformation::Evaluator::Measure( const HistogramTransformation& H, double a, double b ) const
+{
+   /*
+    * Compare with exact evaluation at the float representations of the
+    * sample points, so the estimate includes single precision roundoff.
+    */
+   int n = m_intervals;
+   double h = (b - a)/n;
+   Array<double> errors( (n + EVALUATOR_GRAIN - 1)/EVALUATOR_GRAIN, 0.0 );
+   ThreadPool::ParallelFor( n, EVALUATOR_GRAIN,
+      [&]( int startInterval, int endInterval )
+      {
+         double e = 0;
+         for ( int i = startInterval; i < endInterval; ++i )
+         {
+            const double t[] = { 0.0, 1.0/6, 0.5, 5.0/6 };
+            for ( int j = 0; j < 4; ++j )
+            {
+               float x = float( a + (i + t[j])*h );
+               double d = Abs( double( (*this)( x ) ) - EvaluateChain( H, x ) );
+               if ( d > e )
+                  e = d;
+            }
+         }
+         errors[startInterval/EVALUATOR_GRAIN] = e;
+      } );
+   double e = Abs( double( (*this)( 1.0F ) ) - EvaluateChain( H, 1 ) );
+   for ( Array<double>::const_iterator i = errors.Begin(); i != errors.End(); ++i )
+      if ( *i > e )
+         e = *i;
+   return e;
+}
+
+void HistogramTransformation::Evaluator::Apply( float* a, size_type n, float x0, float x1 ) const
+{
+   if ( a == nullptr || n == 0 )
+      return;
+
+   if ( x1 < x0 )
+      pcl::Swap( x0, x1 );
+   float dx = x1 - x0;
+   if ( 1 + dx == 1 )
+      return;
+
+   /*
+    * Samples are transformed as x0 + dx*F( (x - x0)/dx ), with the interval
+    * coordinate u = (x - x0 - m_x0*dx)*m_scale/dx.
+    */
+   float offset = x0 + m_x0*dx;
+   float scale = m_scale/dx;
+   const float* table = m_table.Begin();
+   float N = float( m_intervals );
+   size_type i = 0;
+
+#ifdef __PCL_HT_EVALUATOR_SSE2
+   const __m128 vOffset = _mm_set1_ps( offset );
+   const __m128 vScale = _mm_set1_ps( scale );
+   const __m128 vZero = _mm_setzero_ps();
+   const __m128 vN = _mm_set1_ps( N );
+   const __m128 vMaxIndex = _mm_set1_ps( m_maxIndex );
+   const __m128 vDx = _mm_set1_ps( dx );
+   const __m128 vX0 = _mm_set1_ps( x0 );
+   for ( ; i+4 <= n; i += 4 )
+   {
+      __m128 u = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( a+i ), vOffset ), vScale );
+      u = _mm_min_ps( _mm_max_ps( u, vZero ), vN ); // NaN -> 0
+      __m128i k = _mm_cvttps_epi32( _mm_min_ps( u, vMaxIndex ) );
+      __m128 t = _mm_sub_ps( u, _mm_cvtepi32_ps( k ) );
+      __m128i k4 = _mm_slli_epi32( k, 2 );
+      __m128 c0 = _mm_loadu_ps( table + _mm_cvtsi128_si32( k4 ) );
+      __m128 c1 = _mm_loadu_ps( table + _mm_cvtsi128_si32( _mm_shuffle_epi32( k4, 0x55 ) ) );
+      __m128 c2 = _mm_loadu_ps( table + _mm_cvtsi128_si32( _mm_shuffle_epi32( k4, 0xAA ) ) );
+      __m128 c3 = _mm_loadu_ps( table + _mm_cvtsi128_si32( _mm_shuffle_epi32( k4, 0xFF ) ) );
+      _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+      __m128 r = _mm_add_ps( c2, _mm_mul_ps( t, c3 ) );
+      r = _mm_add_ps( c1, _mm_mul_ps( t, r ) );
+      r = _mm_add_ps( c0, _mm_mul_ps( t, r ) );
+      _mm_storeu_ps( a+i, _mm_add_ps( _mm_mul_ps( r, vDx ), vX0 ) );
+   }
+#endif
+
+   for ( ; i < n; ++i )
+   {
+      float u = (a[i] - offset)*scale;
+      if ( !(u > 0) )
+         u = 0;
+      else if ( u > N )
+         u = N;
+      int k = TruncInt( pcl::Min( u, m_maxIndex ) );
+      float t = u - k;
+      const float* c = table + 4*k;
+      a[i] = (c[0] + t*(c[1] + t*(c[2] + t*c[3])))*dx + x0;
+   }
+}
+
+// ----------------------------------------------------------------------------
+
 void HistogramTransformation::Apply( Histogram& dstH, const Histogram& srcH ) const
 {
    dstH.Allocate();
@@ -409,6 +658,50 @@ public:
       image.Status() = data.status;
    }
 
+   static void Apply( Image& image, const HistogramTransformation::Evaluator& E, const HistogramTransformation& H )
+   {
+      if ( image.IsEmptySelection() )
+         return;
+
+      image.EnsureUnique();
+
+      Rect r = image.SelectedRectangle();
+      int w = r.Width();
+      int h = r.Height();
+      int c0 = image.FirstSelectedChannel();
+      int maxThreads = H.IsParallelProcessingEnabled() ? H.MaxProcessors() : 1;
+
+      size_type N = image.NumberOfSelectedSamples();
+      if ( image.Status().IsInitializationEnabled() )
+         image.Status().Initialize( "Histogram transformation", N );
+
+      auto transformRows = [&]( int begin, int end )
+      {
+         for ( int i = begin; i < end; ++i )
+            E.Apply( image.PixelAddress( r.x0, r.y0 + i%h, c0 + i/h ), w );
+      };
+
+      /*
+       * Rows are transformed by blocks of 64 grains. The monitor is updated
+       * from the calling thread after each block, which may throw if the
+       * process has been aborted.
+       */
+      int rows = h*image.NumberOfSelectedChannels();
+      int grain = Max( 1, 65536/w );
+      int blockRows = 64*grain;
+      for ( int i = 0; i < rows; i += blockRows )
+      {
+         int end = Min( rows, i + blockRows );
+         if ( maxThreads > 1 )
+            ThreadPool::ParallelFor( end - i, grain,
+                                     [&]( int k0, int k1 ) { transformRows( i + k0, i + k1 ); },
+                                     maxThreads );
+         else
+            transformRows( i, end );
+         image.Status() += size_type( end - i )*w;
+      }
+   }
+
    template <class P> static PCL_HOT_FUNCTION
    void Apply( GenericImage<P>& image, const typename P::sample* lut )
    {
@@ -489,6 +782,18 @@ private:
 
 void HistogramTransformation::Apply( pcl::Image& image ) const
 {
+   if ( !m_exact )
+      if ( image.NumberOfSelectedSamples() >= FAST_EVALUATION_MIN_SAMPLES )
+         if ( !IsIdentityTransformationSet() )
+         {
+            Evaluator E( *this, m_tolerance );
+            if ( E.IsValid() )
+            {
+               PCL_HistogramTransformationEngine::Apply( image, E, *this );
+               return;
+            }
+         }
+
    PCL_HistogramTransformationEngine::Apply( image, *this );
 }
 
@@ -50,8 +50,8 @@
 // ----------------------------------------------------------------------------
 
 #include <pcl/ImageStatistics.h>
-#include <pcl/Matrix.h>
 #include <pcl/Selection.h>
+#include <pcl/Thread.h>
 
 namespace pcl
 {
@@ -63,7 +63,7 @@ class PCL_ImageStatisticsEngine
 public:
 
    template <class P> static
-   void Compute( const GenericImage<P>& image, ImageStatistics::Data& data, bool /*parallel*/, int /*maxProcessors*/ )
+   void Compute( const GenericImage<P>& image, ImageStatistics::Data& data, bool parallel, int maxProcessors )
    {
       data.AssignStatisticalData( ImageStatistics::Data() );
 
@@ -79,322 +79,536 @@ public:
 
       Rect rect = image.SelectedRectangle();
       int channel = image.SelectedChannel();
-
-      data.minimum = data.maximum = 0;
-      data.minPos = data.maxPos = Point( 0 );
-
-      if ( data.rejectLow || data.rejectHigh )
+      int width = rect.Width();
+      int height = rect.Height();
+
+      // Rejection bounds in the native range
+      double s0 = 0, s1 = 0;
+      if ( data.rejectLow )
+         s0 = data.low * P::MaxSampleValue();
+      if ( data.rejectHigh )
+         s1 = data.high * P::MaxSampleValue();
+
+      /*
+       * Sample buffers are only required for estimators that cannot be
+       * computed from running sums.
+       */
+      bool storeSamples = !data.noMean && !data.noVariance || !data.noMedian || !data.noSn || !data.noQn;
+
+      int numberOfThreads = parallel ? Min( maxProcessors, Thread::NumberOfThreads( height, Max( 1, 1024/width ) ) ) : 1;
+      int rowsPerThread = height/numberOfThreads;
+      bool useAffinity = parallel && Thread::IsRootThread();
+
+      /*
+       * First stage: Gather samples, partial moments and extremes.
+       */
+      ReferenceArray<GatherThread<P> > gatherThreads;
+      for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+         gatherThreads.Add( new GatherThread<P>( image, rect, channel, data, s0, s1, storeSamples,
+                                                 i*rowsPerThread, (j < numberOfThreads) ? j*rowsPerThread : height ) );
+      RunThreads( gatherThreads, useAffinity );
+
+      sample_buffer_list buffers;
+      double sum = 0, sumOfSquares = 0;
+      bool extremesSeen = false;
+      for ( typename ReferenceArray<GatherThread<P> >::iterator t = gatherThreads.Begin(); t != gatherThreads.End(); ++t )
       {
-         // Rejection bounds in the native range
-         double s0 = 0, s1 = 0;
-         if ( data.rejectLow )
-            s0 = data.low * P::MaxSampleValue();
-         if ( data.rejectHigh )
-            s1 = data.high * P::MaxSampleValue();
-
-         Array<double> v;
-         v.Reserve( N ); // clearly, optimize for speed
-
-         typename GenericImage<P>::const_roi_sample_iterator i( image, rect, channel );
-         P::FromSample( data.minimum, *i );
-         data.maximum = data.minimum;
-
-         if ( data.noExtremes )
+         data.count += t->n;
+         sum += t->sum;
+         sumOfSquares += t->sumOfSquares;
+         if ( t->n > 0 )
          {
-            if ( data.rejectLow )
-            {
-               if ( data.rejectHigh )
+            if ( !data.noExtremes )
+               if ( extremesSeen )
                {
-                  for ( ; i; ++i )
-                     if ( *i > s0 )
-                        if ( *i < s1 )
-                        {
-                           double f; P::FromSample( f, *i );
-                           v.Append( f );
-                        }
-               }
-               else
-               {
-                  for ( ; i; ++i )
-                     if ( *i > s0 )
-                     {
-                        double f; P::FromSample( f, *i );
-                        v.Append( f );
-                     }
-               }
-            }
-            else
-            {
-               for ( ; i; ++i )
-                  if ( *i < s1 )
+                  // Strict comparisons preserve the scan order of the serial implementation.
+                  if ( t->minimum < data.minimum )
                   {
-                     double f; P::FromSample( f, *i );
-                     v.Append( f );
+                     data.minimum = t->minimum;
+                     data.minPos = t->minPos;
+                  }
+                  if ( t->maximum > data.maximum )
+                  {
+                     data.maximum = t->maximum;
+                     data.maxPos = t->maxPos;
                   }
-            }
-         }
-         else // !data.noExtremes
-         {
-            bool extremesSeen = false;
-            if ( data.rejectLow )
-            {
-               if ( data.rejectHigh )
-               {
-                  for ( int y = rect.y0; y < rect.y1; ++y )
-                     for ( int x = rect.x0; x < rect.x1; ++x, ++i )
-                        if ( *i > s0 )
-                           if ( *i < s1 )
-                           {
-                              double f; P::FromSample( f, *i );
-                              v.Append( f );
-
-                              if ( extremesSeen )
-                              {
-                                 if ( f < data.minimum )
-                                 {
-                                    data.minimum = f;
-                                    data.minPos.x = x;
-                                    data.minPos.y = y;
-                                 }
-                                 else if ( f > data.maximum )
-                                 {
-                                    data.maximum = f;
-                                    data.maxPos.x = x;
-                                    data.maxPos.y = y;
-                                 }
-                              }
-                              else
-                              {
-                                 data.minimum = data.maximum = f;
-                                 data.minPos.x = data.maxPos.x = x;
-                                 data.minPos.y = data.maxPos.y = y;
-                                 extremesSeen = true;
-                              }
-                           }
                }
                else
                {
-                  for ( int y = rect.y0; y < rect.y1; ++y )
-                     for ( int x = rect.x0; x < rect.x1; ++x, ++i )
-                        if ( *i > s0 )
-                        {
-                           double f; P::FromSample( f, *i );
-                           v.Append( f );
-
-                           if ( extremesSeen )
-                           {
-                              if ( f < data.minimum )
-                              {
-                                 data.minimum = f;
-                                 data.minPos.x = x;
-                                 data.minPos.y = y;
-                              }
-                              else if ( f > data.maximum )
-                              {
-                                 data.maximum = f;
-                                 data.maxPos.x = x;
-                                 data.maxPos.y = y;
-                              }
-                           }
-                           else
-                           {
-                              data.minimum = data.maximum = f;
-                              data.minPos.x = data.maxPos.x = x;
-                              data.minPos.y = data.maxPos.y = y;
-                              extremesSeen = true;
-                           }
-                        }
+                  data.minimum = t->minimum;
+                  data.maximum = t->maximum;
+                  data.minPos = t->minPos;
+                  data.maxPos = t->maxPos;
+                  extremesSeen = true;
                }
-            }
-            else
-            {
-               for ( int y = rect.y0; y < rect.y1; ++y )
-                  for ( int x = rect.x0; x < rect.x1; ++x, ++i )
-                     if ( *i < s1 )
-                     {
-                        double f; P::FromSample( f, *i );
-                        v.Append( f );
-
-                        if ( extremesSeen )
-                        {
-                           if ( f < data.minimum )
-                           {
-                              data.minimum = f;
-                              data.minPos.x = x;
-                              data.minPos.y = y;
-                           }
-                           else if ( f > data.maximum )
-                           {
-                              data.maximum = f;
-                              data.maxPos.x = x;
-                              data.maxPos.y = y;
-                           }
-                        }
-                        else
-                        {
-                           data.minimum = data.maximum = f;
-                           data.minPos.x = data.maxPos.x = x;
-                           data.minPos.y = data.maxPos.y = y;
-                           extremesSeen = true;
-                        }
-                     }
-            }
+
+            if ( storeSamples )
+               buffers.Add( SampleBuffer( t->samples, t->n ) );
          }
+      }
 
-         data.count = v.Length();
+      gatherThreads.Destroy();
 
-         if ( !data.noSumOfSquares )
-            data.sumOfSquares = pcl::SumOfSquares( v.Begin(), v.End() );
+      if ( !data.noSumOfSquares )
+         data.sumOfSquares = sumOfSquares;
 
-         image.Status() += NS;
+      image.Status() += NS;
 
-         if ( !data.noMean )
-         {
-            data.mean = pcl::Mean( v.Begin(), v.End() );
+      if ( data.count == 0 )
+      {
+         image.Status() += 6*NS + NN;
+         return;
+      }
+
+      if ( !data.noMean )
+      {
+         data.mean = sum/data.count;
 
-            image.Status() += NS;
+         image.Status() += NS;
 
-            if ( !data.noVariance )
+         if ( !data.noVariance )
+            if ( data.count > 1 )
             {
-               data.variance = pcl::Variance( v.Begin(), v.End(), data.mean );
+               double var = 0, eps = 0;
+               ReferenceArray<DeviationThread> threads;
+               for ( sample_buffer_list::const_iterator b = buffers.Begin(); b != buffers.End(); ++b )
+                  threads.Add( new DeviationThread( *b, DeviationThread::Variance, data.mean ) );
+               RunThreads( threads, useAffinity );
+               for ( ReferenceArray<DeviationThread>::const_iterator t = threads.Begin(); t != threads.End(); ++t )
+               {
+                  var += t->s1;
+                  eps += t->s2;
+               }
+               threads.Destroy();
+               data.variance = (var - eps*eps/data.count)/(data.count - 1);
                data.stdDev = Sqrt( data.variance );
             }
 
-            image.Status() += NS;
-         }
-         else
-         {
-            image.Status() += 2*NS;
-         }
+         image.Status() += NS;
+      }
+      else
+      {
+         image.Status() += 2*NS;
+      }
 
-         if ( !data.noMedian )
+      if ( !data.noMedian )
+      {
+         data.median = Median( buffers, data.count, useAffinity );
+
+         image.Status() += NS;
+
+         if ( !data.noAvgDev )
          {
-            data.median = pcl::Median( v.Begin(), v.End() );
+            double s = 0;
+            ReferenceArray<DeviationThread> threads;
+            for ( sample_buffer_list::const_iterator b = buffers.Begin(); b != buffers.End(); ++b )
+               threads.Add( new DeviationThread( *b, DeviationThread::AbsDev, data.median ) );
+            RunThreads( threads, useAffinity );
+            for ( ReferenceArray<DeviationThread>::const_iterator t = threads.Begin(); t != threads.End(); ++t )
+               s += t->s1;
+            threads.Destroy();
+            data.avgDev = s/data.count;
+         }
 
-            image.Status() += NS;
+         image.Status() += NS;
 
-            if ( !data.noAvgDev )
-               data.avgDev = pcl::AvgDev( v.Begin(), v.End(), data.median );
+         if ( !data.noMAD )
+         {
+            data.MAD = Median( buffers, data.count, useAffinity, data.median );
 
-            image.Status() += NS;
+            if ( !data.noBWMV )
+               if ( data.count > 1 )
+               {
+                  double kd = 9 * data.MAD;
+                  if ( kd >= 0 && 1 + kd != 1 )
+                  {
+                     double num = 0, den = 0;
+                     ReferenceArray<DeviationThread> threads;
+                     for ( sample_buffer_list::const_iterator b = buffers.Begin(); b != buffers.End(); ++b )
+                        threads.Add( new DeviationThread( *b, DeviationThread::BWMV, data.median, kd ) );
+                     RunThreads( threads, useAffinity );
+                     for ( ReferenceArray<DeviationThread>::const_iterator t = threads.Begin(); t != threads.End(); ++t )
+                     {
+                        num += t->s1;
+                        den += t->s2;
+                     }
+                     threads.Destroy();
+                     den *= den;
+                     if ( 1 + den != 1 )
+                        data.bwmv = data.count*num/den;
+                  }
+               }
+         }
 
-            if ( !data.noMAD )
+         if ( !data.noPBMV )
+            if ( data.count > 1 )
             {
-               data.MAD = pcl::MAD( v.Begin(), v.End(), data.median );
-
-               if ( !data.noBWMV )
-                  data.bwmv = pcl::BiweightMidvariance( v.Begin(), v.End(), data.median, data.MAD );
+               // Percentage bend midvariance with beta = 0.2
+               const double beta = 0.2;
+               size_type m = size_type( Floor( (1 - beta)*data.count + 0.5 ) );
+               double wb = OrderStatistic( buffers, Min( m, data.count-1 ), useAffinity, data.median );
+               if ( 1 + wb != 1 )
+               {
+                  double num = 0, den = 0;
+                  ReferenceArray<DeviationThread> threads;
+                  for ( sample_buffer_list::const_iterator b = buffers.Begin(); b != buffers.End(); ++b )
+                     threads.Add( new DeviationThread( *b, DeviationThread::PBMV, data.median, wb ) );
+                  RunThreads( threads, useAffinity );
+                  for ( ReferenceArray<DeviationThread>::const_iterator t = threads.Begin(); t != threads.End(); ++t )
+                  {
+                     num += t->s1;
+                     den += t->s2;
+                  }
+                  threads.Destroy();
+                  if ( den != 0 )
+                     data.pbmv = data.count*wb*wb*num/den/den;
+               }
             }
 
-            if ( !data.noPBMV )
-               data.pbmv = pcl::BendMidvariance( v.Begin(), v.End(), data.median, 0.2 );
+         image.Status() += NS;
+      }
+      else
+      {
+         image.Status() += 3*NS;
+      }
 
-            image.Status() += NS;
-         }
-         else
+      if ( !data.noSn || !data.noQn )
+      {
+         /*
+          * The Sn and Qn algorithms require a contiguous sequence. Per-thread
+          * buffers are released as they are concatenated to limit the peak
+          * memory footprint.
+          */
+         Array<float> v;
+         v.Reserve( data.count );
+         for ( sample_buffer_list::iterator b = buffers.Begin(); b != buffers.End(); ++b )
          {
-            image.Status() += 3*NS;
+            v.Add( b->samples.Begin(), b->samples.At( b->n ) );
+            b->samples.Clear();
          }
+         buffers.Clear();
 
-         if ( !data.noSn )
-            data.Sn = pcl::Sn( v.Begin(), v.End() );
+         if ( !data.noQn )
+            data.Qn = pcl::Qn( v.Begin(), v.End() );
 
          image.Status() += NS;
 
-         if ( !data.noQn )
-            data.Qn = pcl::Qn( v.Begin(), v.End() );
+         if ( !data.noSn )
+            data.Sn = pcl::Sn( v.Begin(), v.End() ); // N.B.: Sn() sorts the sample
 
          image.Status() += NN;
       }
       else
       {
-         data.count = N;
+         image.Status() += NS + NN;
+      }
+   }
 
-         DMatrix V( image, rect, channel );
+private:
 
-         if ( !data.noExtremes )
+   /*
+    * A per-thread set of gathered samples. Samples are stored as 32-bit
+    * floating point values in the normalized [0,1] range.
+    */
+   struct SampleBuffer
+   {
+      Array<float> samples;
+      size_type    n;
+
+      SampleBuffer( const Array<float>& a_samples, size_type a_n ) : samples( a_samples ), n( a_n )
+      {
+      }
+   };
+
+   typedef Array<SampleBuffer>   sample_buffer_list;
+
+   template <class T> static
+   void RunThreads( ReferenceArray<T>& threads, bool useAffinity )
+   {
+      if ( threads.Length() > 1 )
+      {
+         for ( typename ReferenceArray<T>::iterator i = threads.Begin(); i != threads.End(); ++i )
+            i->Start( ThreadPriority::DefaultMax, useAffinity ? Distance( threads.Begin(), i ) : -1 );
+         for ( typename ReferenceArray<T>::iterator i = threads.Begin(); i != threads.End(); ++i )
+            i->Wait();
+      }
+      else if ( !threads.IsEmpty() )
+         threads[0].Run();
+   }
+
+   // -------------------------------------------------------------------------
+
+   template <class P>
+   class GatherThread : public Thread
+   {
+   public:
+
+      Array<float> samples;
+      size_type    n;
+      double       sum, sumOfSquares;
+      double       minimum, maximum;
+      Point        minPos, maxPos;
+
+      GatherThread( const GenericImage<P>& image, const Rect& rect, int channel, const ImageStatistics::Data& data,
+                    double s0, double s1, bool storeSamples, int startRow, int endRow ) :
+      Thread(),
+      samples(), n( 0 ), sum( 0 ), sumOfSquares( 0 ), minimum( 0 ), maximum( 0 ), minPos( 0 ), maxPos( 0 ),
+      m_image( image ), m_rect( rect ), m_channel( channel ), m_data( data ),
+      m_s0( s0 ), m_s1( s1 ), m_storeSamples( storeSamples ), m_startRow( startRow ), m_endRow( endRow )
+      {
+      }
+
+      virtual void Run()
+      {
+         if ( m_storeSamples )
+            samples = Array<float>( size_type( m_rect.Width() )*size_type( m_endRow - m_startRow ) );
+
+         bool rejectLow = m_data.rejectLow;
+         bool rejectHigh = m_data.rejectHigh;
+         bool findExtremes = !m_data.noExtremes;
+         float* v = samples.Begin();
+
+         for ( int y = m_rect.y0+m_startRow, y1 = m_rect.y0+m_endRow; y < y1; ++y )
          {
-            double* i = V.Begin();
-            data.minimum = data.maximum = *i;
-            for ( int y = rect.y0; y < rect.y1; ++y )
-               for ( int x = rect.x0; x < rect.x1; ++x, ++i )
-                  if ( *i < data.minimum )
+            const typename P::sample* f = m_image.ScanLine( y, m_channel ) + m_rect.x0;
+            for ( int x = m_rect.x0; x < m_rect.x1; ++x, ++f )
+            {
+               if ( rejectLow )
+                  if ( *f <= m_s0 )
+                     continue;
+               if ( rejectHigh )
+                  if ( *f >= m_s1 )
+                     continue;
+
+               double d; P::FromSample( d, *f );
+               sum += d;
+               sumOfSquares += d*d;
+               if ( m_storeSamples )
+                  v[n] = float( d );
+
+               if ( findExtremes )
+                  if ( n > 0 )
                   {
-                     data.minimum = *i;
-                     data.minPos.x = x;
-                     data.minPos.y = y;
+                     if ( d < minimum )
+                     {
+                        minimum = d;
+                        minPos.x = x;
+                        minPos.y = y;
+                     }
+                     else if ( d > maximum )
+                     {
+                        maximum = d;
+                        maxPos.x = x;
+                        maxPos.y = y;
+                     }
                   }
-                  else if ( *i > data.maximum )
+                  else
                   {
-                     data.maximum = *i;
-                     data.maxPos.x = x;
-                     data.maxPos.y = y;
+                     minimum = maximum = d;
+                     minPos.x = maxPos.x = x;
+                     minPos.y = maxPos.y = y;
                   }
+
+               ++n;
+            }
          }
+      }
 
-         if ( !data.noSumOfSquares )
-            data.sumOfSquares = pcl::SumOfSquares( V.Begin(), V.End() );
+   private:
 
-         image.Status() += NS;
+      const GenericImage<P>&        m_image;
+      const Rect&                   m_rect;
+            int                     m_channel;
+      const ImageStatistics::Data&  m_data;
+            double                  m_s0, m_s1;
+            bool                    m_storeSamples;
+            int                     m_startRow, m_endRow;
+   };
 
-         if ( !data.noMean )
-         {
-            data.mean = pcl::Mean( V.Begin(), V.End() );
+   // -------------------------------------------------------------------------
 
-            image.Status() += NS;
+   class DeviationThread : public Thread
+   {
+   public:
 
-            if ( !data.noVariance )
-            {
-               data.variance = pcl::Variance( V.Begin(), V.End(), data.mean );
-               data.stdDev = Sqrt( data.variance );
-            }
+      enum mode { Variance, AbsDev, BWMV, PBMV };
 
-            image.Status() += NS;
-         }
-         else
-         {
-            image.Status() += 2*NS;
-         }
+      double s1, s2;
 
-         if ( !data.noMedian )
-         {
-            data.median = pcl::Median( V.Begin(), V.End() );
+      DeviationThread( const SampleBuffer& buffer, mode m, double center, double scale = 1 ) :
+      Thread(), s1( 0 ), s2( 0 ), m_buffer( buffer ), m_mode( m ), m_center( center ), m_scale( scale )
+      {
+      }
 
-            image.Status() += NS;
+      virtual void Run()
+      {
+         const float* x = m_buffer.samples.Begin();
+         const float* xn = m_buffer.samples.At( m_buffer.n );
+
+         switch ( m_mode )
+         {
+         case Variance:
+            for ( ; x < xn; ++x )
+            {
+               double d = *x - m_center;
+               s1 += d*d;
+               s2 += d;
+            }
+            break;
+         case AbsDev:
+            for ( ; x < xn; ++x )
+               s1 += pcl::Abs( *x - m_center );
+            break;
+         case BWMV:
+            for ( ; x < xn; ++x )
+            {
+               double xc = *x - m_center;
+               double y = xc/m_scale;
+               if ( pcl::Abs( y ) < 1 )
+               {
+                  double y2 = y*y;
+                  double y21 = 1 - y2;
+                  s1 += xc*xc * y21*y21*y21*y21;
+                  s2 += y21 * (1 - 5*y2);
+               }
+            }
+            break;
+         case PBMV:
+            for ( ; x < xn; ++x )
+            {
+               double y = (*x - m_center)/m_scale;
+               double f = pcl::Max( -1.0, pcl::Min( 1.0, y ) );
+               s1 += f*f;
+               if ( pcl::Abs( y ) < 1 )
+                  s2 += 1;
+            }
+            break;
+         }
+      }
 
-            if ( !data.noAvgDev )
-               data.avgDev = pcl::AvgDev( V.Begin(), V.End(), data.median );
+   private:
+
+      const SampleBuffer& m_buffer;
+            mode          m_mode;
+            double        m_center;
+            double        m_scale;
+   };
+
+   // -------------------------------------------------------------------------
+
+   /*
+    * Parallel order statistics.
+    *
+    * We implement an exact two-pass radix selection algorithm on 32-bit
+    * integer keys with the same ordering as the floating point values being
+    * selected. The first pass builds per-thread histograms of the 16 most
+    * significant key bits; the second pass resolves the 16 least significant
+    * bits within the bucket containing the requested order statistic. Sample
+    * buffers are never copied or reordered.
+    *
+    * When a center value is specified, order statistics are computed for the
+    * absolute deviations from center, which are generated on the fly.
+    */
+
+   static uint32 FloatToKey( float f )
+   {
+      union { float f; uint32 u; } v;
+      v.f = f;
+      return (v.u & 0x80000000u) ? ~v.u : (v.u | 0x80000000u);
+   }
 
-            image.Status() += NS;
+   static float KeyToFloat( uint32 k )
+   {
+      union { float f; uint32 u; } v;
+      v.u = (k & 0x80000000u) ? (k & 0x7FFFFFFFu) : ~k;
+      return v.f;
+   }
 
-            if ( !data.noMAD )
-            {
-               data.MAD = pcl::MAD( V.Begin(), V.End(), data.median );
+   class KeyHistogramThread : public Thread
+   {
+   public:
 
-               if ( !data.noBWMV )
-                  data.bwmv = pcl::BiweightMidvariance( V.Begin(), V.End(), data.median, data.MAD );
-            }
+      Array<size_type> histogram;
 
-            if ( !data.noPBMV )
-               data.pbmv = pcl::BendMidvariance( V.Begin(), V.End(), data.median, 0.2 );
+      KeyHistogramThread( const SampleBuffer& buffer, bool absDev, double center, bool lowBits, uint32 highKey ) :
+      Thread(), histogram( 0x10000, size_type( 0 ) ),
+      m_buffer( buffer ), m_absDev( absDev ), m_center( center ), m_lowBits( lowBits ), m_highKey( highKey )
+      {
+      }
 
-            image.Status() += NS;
-         }
-         else
+      virtual void Run()
+      {
+         size_type* h = histogram.Begin();
+         const float* x = m_buffer.samples.Begin();
+         const float* xn = m_buffer.samples.At( m_buffer.n );
+         for ( ; x < xn; ++x )
          {
-            image.Status() += 3*NS;
+            uint32 k = FloatToKey( m_absDev ? float( pcl::Abs( *x - m_center ) ) : *x );
+            if ( m_lowBits )
+            {
+               if ( (k >> 16) == m_highKey )
+                  ++h[k & 0xFFFFu];
+            }
+            else
+               ++h[k >> 16];
          }
+      }
 
-         if ( !data.noSn )
-            data.Sn = pcl::Sn( V.Begin(), V.End() );
+   private:
 
-         image.Status() += NS;
+      const SampleBuffer& m_buffer;
+            bool          m_absDev;
+            double        m_center;
+            bool          m_lowBits;
+            uint32        m_highKey;
+   };
 
-         if ( !data.noQn )
-            data.Qn = pcl::Qn( V.Begin(), V.End() );
+   static uint32 SelectKeyBits( const sample_buffer_list& buffers, size_type& k, bool useAffinity,
+                                bool absDev, double center, bool lowBits, uint32 highKey )
+   {
+      ReferenceArray<KeyHistogramThread> threads;
+      for ( sample_buffer_list::const_iterator b = buffers.Begin(); b != buffers.End(); ++b )
+         threads.Add( new KeyHistogramThread( *b, absDev, center, lowBits, highKey ) );
+      RunThreads( threads, useAffinity );
 
-         image.Status() += NN;
+      uint32 bin = 0;
+      for ( ; bin < 0xFFFFu; ++bin )
+      {
+         size_type count = 0;
+         for ( ReferenceArray<KeyHistogramThread>::const_iterator t = threads.Begin(); t != threads.End(); ++t )
+            count += t->histogram[bin];
+         if ( k < count )
+            break;
+         k -= count;
       }
+
+      threads.Destroy();
+      return bin;
+   }
+
+   static double OrderStatistic( const sample_buffer_list& buffers, size_type k, bool useAffinity,
+                                 double center = 0, bool absDev = true )
+   {
+      uint32 high = SelectKeyBits( buffers, k, useAffinity, absDev, center, false, 0 );
+      uint32 low = SelectKeyBits( buffers, k, useAffinity, absDev, center, true, high );
+      return KeyToFloat( (high << 16) | low );
+   }
+
+   static double Median( const sample_buffer_list& buffers, size_type n, bool useAffinity )
+   {
+      return Median( buffers, n, useAffinity, 0, false );
+   }
+
+   static double Median( const sample_buffer_list& buffers, size_type n, bool useAffinity,
+                         double center, bool absDev = true )
+   {
+      if ( n < 2 )
+         return (n == 1 && !absDev) ? buffers[0].samples[0] : 0.0;
+      size_type n2 = n >> 1;
+      double m = OrderStatistic( buffers, n2, useAffinity, center, absDev );
+      if ( (n & 1) == 0 )
+         m = (m + OrderStatistic( buffers, n2-1, useAffinity, center, absDev ))/2;
+      return m;
    }
 };
 
@@ -0,0 +1,186 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/InstructionSet.cpp - Released 2016/02/21 20:22:19 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#include <pcl/InstructionSet.h>
+#include <pcl/Math.h>
+#include <pcl/String.h>
+
+#include <stdlib.h>
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __PCL_MACOSX )
+
+static void CPUID( int32 regs[ 4 ], int32 leaf )
+{
+#ifdef _MSC_VER
+   __cpuidex( regs, leaf, 0 );
+#else
+   asm volatile( "cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3]) : "a" (leaf), "c" (0) );
+#endif
+}
+
+static uint32 XGETBV()
+{
+#ifdef _MSC_VER
+   return uint32( _xgetbv( 0 ) );
+#else
+   uint32 eax, edx;
+   asm volatile( "xgetbv" : "=a" (eax), "=d" (edx) : "c" (0) );
+   return eax;
+#endif
+}
+
+#endif
+
+static InstructionSet::value_type DetectInstructionSet()
+{
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __PCL_MACOSX )
+   if ( !IsAVX2InstructionSetSupported() )
+      return InstructionSet::Baseline;
+
+   int32 regs[ 4 ];
+   CPUID( regs, 1 );
+   if ( (regs[2] & (1u << 12)) == 0 ) // FMA3
+      return InstructionSet::Baseline;
+
+# ifndef __PCL_NO_AVX512_TARGET
+   CPUID( regs, 7 );
+   const uint32 avx512Flags = (1u << 16)  // AVX512F
+                            | (1u << 17)  // AVX512DQ
+                            | (1u << 30)  // AVX512BW
+                            | (1u << 31); // AVX512VL
+   if ( (uint32( regs[1] ) & avx512Flags) == avx512Flags )
+      if ( (XGETBV() & 0xE6u) == 0xE6u ) // XMM, YMM, opmask and ZMM states
+         return InstructionSet::AVX512;
+# endif
+
+   return InstructionSet::AVX2;
+#else
+   return InstructionSet::Baseline;
+#endif
+}
+
+/*
+ * Instruction set levels, initialized on first use.
+ */
+struct PCL_InstructionSetState
+{
+   InstructionSet::value_type supported;
+   InstructionSet::value_type active;
+
+   PCL_InstructionSetState()
+   {
+      supported = active = DetectInstructionSet();
+
+      const char* env = ::getenv( "PCL_INSTRUCTION_SET" );
+      if ( env != nullptr )
+      {
+         IsoString name = IsoString( env ).Trimmed().CaseFolded();
+         for ( int i = 0; i < InstructionSet::NumberOfLevels; ++i )
+            if ( name == InstructionSetName( InstructionSet::value_type( i ) ) )
+            {
+               active = InstructionSet::value_type( Min( i, int( supported ) ) );
+               break;
+            }
+      }
+   }
+};
+
+static PCL_InstructionSetState& State()
+{
+   static PCL_InstructionSetState state;
+   return state;
+}
+
+/*
+ * Select instruction sets when the module is loaded.
+ */
+static const InstructionSet::value_type s_initialInstructionSet = ActiveInstructionSet();
+
+// ----------------------------------------------------------------------------
+
+InstructionSet::value_type SupportedInstructionSet()
+{
+   return State().supported;
+}
+
+InstructionSet::value_type ActiveInstructionSet()
+{
+   return State().active;
+}
+
+InstructionSet::value_type SetActiveInstructionSet( InstructionSet::value_type level )
+{
+   PCL_InstructionSetState& state = State();
+   state.active = InstructionSet::value_type( Range( int( level ), int( InstructionSet::Baseline ), int( state.supported ) ) );
+   return state.active;
+}
+
+const char* InstructionSetName( InstructionSet::value_type level )
+{
+   switch ( level )
+   {
+   case InstructionSet::AVX2:   return "avx2";
+   case InstructionSet::AVX512: return "avx512";
+   default:                     return "baseline";
+   }
+}
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+// ----------------------------------------------------------------------------
+// EOF pcl/InstructionSet.cpp - Released 2016/02/21 20:22:19 UTC
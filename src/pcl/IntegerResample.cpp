@@ -51,6 +51,7 @@
 
 #include <pcl/IntegerResample.h>
 #include <pcl/Selection.h>
+#include <pcl/ThreadPool.h>
 
 // ----------------------------------------------------------------------------
 
@@ -134,102 +135,147 @@ public:
             status.Initialize( info, n*N );
          }
 
-         GenericVector<typename P::sample> fm;
-         if ( Z.ZoomFactor() < 0 && Z.DownsampleMode() == IntegerDownsampleMode::Median )
-            fm = GenericVector<typename P::sample>( z2 );
-
          f0 = image.ReleaseData();
 
+         int numberOfRows = (Z.ZoomFactor() > 0) ? h0 : height;
+         int numberOfThreads = Z.IsParallelProcessingEnabled() ?
+                  pcl::Min( Z.MaxProcessors(), pcl::Thread::NumberOfThreads( numberOfRows, 1 ) ) : 1;
+         int rowsPerThread = (numberOfRows + numberOfThreads - 1)/numberOfThreads;
+
          for ( int c = 0; c < n; ++c, status += N )
          {
             f = image.Allocator().AllocatePixels( width, height );
 
+            const typename P::sample* f0c = f0[c];
+            typename P::sample* fc = f;
+
             if ( Z.ZoomFactor() > 0 )
             {
-               const typename P::sample* f0c = f0[c];
-
-               for ( int y = 0; y < h0; ++y )
+               /*
+                * Upsampling: replicate each source pixel horizontally in the
+                * first output row, then copy that row to the remaining z-1 rows.
+                */
+               auto upsample = [&]( int beginRow, int endRow )
                {
-                  int yz = y*z;
-
-                  for ( int x = 0; x < w0; ++x )
+                  for ( int y = beginRow; y < endRow; ++y )
                   {
-                     int xz = x*z;
-                     typename P::sample v = *f0c++;
-
-                     for ( int i = 0; i < z; ++i )
+                     const typename P::sample* fy = f0c + size_type( y )*w0;
+                     typename P::sample* fz = fc + size_type( y )*z*width;
+                     typename P::sample* fi = fz;
+                     for ( int x = 0; x < w0; ++x )
                      {
-                        typename P::sample* fi = f + (size_type( yz + i )*width + xz);
-
+                        typename P::sample v = fy[x];
                         for ( int j = 0; j < z; ++j )
                            *fi++ = v;
                      }
+                     for ( int i = 1; i < z; ++i )
+                        P::Copy( fz + size_type( i )*width, fz, width );
                   }
-               }
+               };
+
+               RunRows( numberOfRows, rowsPerThread, numberOfThreads, upsample );
             }
-            else
+            else if ( Z.DownsampleMode() == IntegerDownsampleMode::Median )
             {
-               typename P::sample* fz = f;
-
-               for ( int y = 0; y < height; ++y )
+               auto downsample = [&]( int beginRow, int endRow )
                {
-                  const typename P::sample* fy = f0[c] + size_type( y )*z*w0;
+                  GenericVector<typename P::sample> fm( z2 );
+                  for ( int y = beginRow; y < endRow; ++y )
+                  {
+                     const typename P::sample* fy = f0c + size_type( y )*z*w0;
+                     typename P::sample* fz = fc + size_type( y )*width;
+                     for ( int x = 0; x < width; ++x )
+                     {
+                        const typename P::sample* fyx = fy + x*z;
+                        typename P::sample* fmi = *fm;
+                        for ( int i = 0; i < z; ++i, fyx += w0 )
+                           for ( int j = 0; j < z; ++j )
+                              *fmi++ = fyx[j];
+
+                        *fz++ = (z & 1) ?
+                              *Select( *fm, fm.At( z2 ), n2 ) :
+                              P::FloatToSample( 0.5*(double( *Select( *fm, fm.At( z2 ), n2   ) ) +
+                                                     double( *Select( *fm, fm.At( z2 ), n2-1 ) )) );
+                     }
+                  }
+               };
 
-                  for ( int x = 0; x < width; ++x )
+               RunRows( numberOfRows, rowsPerThread, numberOfThreads, downsample );
+            }
+            else
+            {
+               /*
+                * Average, maximum and minimum downsampling are separable: we
+                * first reduce z source rows column-wise, then reduce each group
+                * of z columns.
+                */
+               int wz = width*z;
+               downsample_mode mode = Z.DownsampleMode();
+               auto downsample = [&]( int beginRow, int endRow )
+               {
+                  DVector row( wz );
+                  for ( int y = beginRow; y < endRow; ++y )
                   {
-                     const typename P::sample* fyx = fy + x*z;
+                     const typename P::sample* fy = f0c + size_type( y )*z*w0;
+                     typename P::sample* fz = fc + size_type( y )*width;
+                     double* __restrict__ r = row.Begin();
 
-                     switch ( Z.DownsampleMode() )
+                     switch ( mode )
                      {
                      default:
                      case IntegerDownsampleMode::Average:
+                        for ( int j = 0; j < wz; ++j )
+                           r[j] = 0;
+                        for ( int i = 0; i < z; ++i, fy += w0 )
+                           for ( int j = 0; j < wz; ++j )
+                              r[j] += fy[j];
+                        for ( int x = 0; x < width; ++x, r += z )
                         {
                            double s = 0;
-                           for ( int i = 0; i < z; ++i, fyx += w0 )
-                              for ( int j = 0; j < z; ++j )
-                                 s += fyx[j];
-                           *fz++ = typename P::sample( P::IsFloatSample() ? s/z2 : Round( s/z2 ) );
-                        }
-                        break;
-
-                     case IntegerDownsampleMode::Median:
-                        {
-                           typename P::sample* fmi = *fm;
-                           for ( int i = 0; i < z; ++i, fyx += w0 )
-                              for ( int j = 0; j < z; ++j )
-                                 *fmi++ = fyx[j];
-
-                           *fz++ = (z & 1) ?
-                                 *Select( *fm, fm.At( z2 ), n2 ) :
-                                 P::FloatToSample( 0.5*(double( *Select( *fm, fm.At( z2 ), n2   ) ) +
-                                                        double( *Select( *fm, fm.At( z2 ), n2-1 ) )) );
+                           for ( int j = 0; j < z; ++j )
+                              s += r[j];
+                           fz[x] = typename P::sample( P::IsFloatSample() ? s/z2 : Round( s/z2 ) );
                         }
                         break;
 
                      case IntegerDownsampleMode::Maximum:
+                        for ( int j = 0; j < wz; ++j )
+                           r[j] = P::MinSampleValue();
+                        for ( int i = 0; i < z; ++i, fy += w0 )
+                           for ( int j = 0; j < wz; ++j )
+                              if ( fy[j] > r[j] )
+                                 r[j] = fy[j];
+                        for ( int x = 0; x < width; ++x, r += z )
                         {
-                           *fz = P::MinSampleValue();
-                           for ( int i = 0; i < z; ++i, fyx += w0 )
-                              for ( int j = 0; j < z; ++j )
-                                 if ( fyx[j] > *fz )
-                                    *fz = fyx[j];
-                           ++fz;
+                           double m = r[0];
+                           for ( int j = 1; j < z; ++j )
+                              if ( r[j] > m )
+                                 m = r[j];
+                           fz[x] = typename P::sample( m );
                         }
                         break;
 
                      case IntegerDownsampleMode::Minimum:
+                        for ( int j = 0; j < wz; ++j )
+                           r[j] = P::MaxSampleValue();
+                        for ( int i = 0; i < z; ++i, fy += w0 )
+                           for ( int j = 0; j < wz; ++j )
+                              if ( fy[j] < r[j] )
+                                 r[j] = fy[j];
+                        for ( int x = 0; x < width; ++x, r += z )
                         {
-                           *fz = P::MaxSampleValue();
-                           for ( int i = 0; i < z; ++i, fyx += w0 )
-                              for ( int j = 0; j < z; ++j )
-                                 if ( fyx[j] < *fz )
-                                    *fz = fyx[j];
-                           ++fz;
+                           double m = r[0];
+                           for ( int j = 1; j < z; ++j )
+                              if ( r[j] < m )
+                                 m = r[j];
+                           fz[x] = typename P::sample( m );
                         }
                         break;
                      }
                   }
-               }
+               };
+
+               RunRows( numberOfRows, rowsPerThread, numberOfThreads, downsample );
             }
 
             image.Allocator().Deallocate( f0[c] );
@@ -254,6 +300,23 @@ public:
          throw;
       }
    }
+
+private:
+
+   typedef IntegerResample::downsample_mode downsample_mode;
+
+   /*
+    * Processes the range [0,numberOfRows) of rows with at most numberOfThreads
+    * concurrent thread pool tasks.
+    */
+   template <class F> static
+   void RunRows( int numberOfRows, int rowsPerThread, int numberOfThreads, F f )
+   {
+      if ( numberOfThreads > 1 )
+         ThreadPool::ParallelFor( numberOfRows, rowsPerThread, f );
+      else
+         f( 0, numberOfRows );
+   }
 };
 
 // ----------------------------------------------------------------------------
@@ -52,6 +52,7 @@
 #include <pcl/ErrorHandler.h>
 #include <pcl/MetaModule.h>
 #include <pcl/ProcessInterface.h>
+#include <pcl/ThreadPool.h>
 #include <pcl/Version.h>
 
 #include <pcl/api/APIException.h>
@@ -215,6 +216,8 @@ public:
       {
          Module->OnUnload();
 
+         ThreadPool::Shutdown();
+
          if ( Module != nullptr )
             for ( size_type i = 0; i < Module->Length(); ++i )
                if ( (*Module)[i] != nullptr )
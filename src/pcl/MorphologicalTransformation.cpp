@@ -52,6 +52,7 @@
 #include <pcl/MorphologicalTransformation.h>
 #include <pcl/MultiVector.h>
 #include <pcl/Thread.h>
+#include <pcl/ThreadPool.h>
 
 namespace pcl
 {
@@ -97,7 +98,27 @@ public:
       if ( image.Status().IsInitializationEnabled() )
          image.Status().Initialize( "Morphological transformation, " + transformation.Operator().Description(), N );
 
+      MinMaxFilter M;
+      if ( InitializeMinMaxFilter( M, transformation ) )
+      {
+         try
+         {
+            ApplyMinMaxFilter( image, transformation, M );
+            if ( didReflect )
+               const_cast<StructuringElement&>( transformation.Structure() ).Reflect();
+         }
+         catch ( ... )
+         {
+            if ( didReflect )
+               const_cast<StructuringElement&>( transformation.Structure() ).Reflect();
+            throw;
+         }
+
+         return;
+      }
+
       ThreadData<P> data( image, transformation, N );
+      InitializeHistogramFilter( data, (P*)0 );
 
       ReferenceArray<Thread<P> > threads;
       for ( int i = 0, j = 1, y0 = image.SelectedRectangle().y0; i < numberOfThreads; ++i, ++j )
@@ -141,17 +162,607 @@ public:
 
 private:
 
+   /*
+    * Minimum number of existing structure elements for sliding histogram
+    * order statistic filters. Smaller neighborhoods are filtered exactly to
+    * avoid the 16-bit quantization of floating point samples.
+    */
+   enum { HistogramFilterMinElements = 33 };
+
    template <class P>
    struct ThreadData : public AbstractImage::ThreadData
    {
       ThreadData( GenericImage<P>& a_image, const MorphologicalTransformation& a_transformation, size_type a_count ) :
          AbstractImage::ThreadData( a_image, a_count ),
-         image( a_image ), transformation( a_transformation )
+         image( a_image ), transformation( a_transformation ),
+         useHistogram( false ), median( false ), selectionPoint( 0 ), numberOfElements( 0 )
       {
       }
 
       GenericImage<P>& image;
       const MorphologicalTransformation& transformation;
+
+      /*
+       * Sliding histogram order statistic filter. spanStart[i] and spanEnd[i]
+       * are the first and last existing structure elements on the i-th row of
+       * the structure. spanStart[i] > spanEnd[i] for empty rows.
+       */
+      bool       useHistogram;
+      bool       median;
+      float      selectionPoint;
+      int        numberOfElements;
+      Array<int> spanStart;
+      Array<int> spanEnd;
+   };
+
+   /*
+    * Median and selection filters with single-way structures whose rows are
+    * contiguous spans of existing elements (box, circular and orthogonal
+    * structures, among others) are implemented with sliding histograms
+    * (Huang's algorithm) of samples quantized to 16 bits. For each output
+    * pixel, 2n histogram updates are required for a structure of size n,
+    * instead of gathering and selecting among n^2 neighbor samples. 8-bit and
+    * 16-bit integer images are filtered exactly; floating point samples are
+    * quantized in the normalized [0,1] range. Other sample types, interlaced
+    * and multiway transformations use the general algorithm.
+    */
+   template <class P>
+   static void InitializeHistogramFilter( ThreadData<P>& data, P* )
+   {
+      // Unsupported sample data type.
+   }
+
+   static void InitializeHistogramFilter( ThreadData<FloatPixelTraits>& data, FloatPixelTraits* )
+   {
+      InitializeHistogramFilter( data );
+   }
+
+   static void InitializeHistogramFilter( ThreadData<DoublePixelTraits>& data, DoublePixelTraits* )
+   {
+      InitializeHistogramFilter( data );
+   }
+
+   static void InitializeHistogramFilter( ThreadData<UInt8PixelTraits>& data, UInt8PixelTraits* )
+   {
+      InitializeHistogramFilter( data );
+   }
+
+   static void InitializeHistogramFilter( ThreadData<UInt16PixelTraits>& data, UInt16PixelTraits* )
+   {
+      InitializeHistogramFilter( data );
+   }
+
+   template <class P>
+   static void InitializeHistogramFilter( ThreadData<P>& data )
+   {
+      const MorphologicalTransformation& T = data.transformation;
+      const StructuringElement& S = T.Structure();
+
+      if ( S.NumberOfWays() != 1 || T.InterlacingDistance() != 1 )
+         return;
+
+      const MorphologicalOperator& op = T.Operator();
+      if ( dynamic_cast<const MedianFilter*>( &op ) != nullptr )
+      {
+         data.median = true;
+      }
+      else
+      {
+         const SelectionFilter* selection = dynamic_cast<const SelectionFilter*>( &op );
+         if ( selection == nullptr )
+            return;
+         data.median = false;
+         data.selectionPoint = selection->SelectionPoint();
+      }
+
+      int ne = StructureSpans( data.spanStart, data.spanEnd, S );
+      if ( ne < HistogramFilterMinElements )
+         return;
+
+      data.numberOfElements = ne;
+      data.useHistogram = true;
+   }
+
+   /*
+    * Finds the span of existing elements on each row of a single-way
+    * structure. Structure masks are stored in the same order as neighborhood
+    * samples. spanStart[i] > spanEnd[i] for empty rows. Returns the number of
+    * existing structure elements, or zero if some row is not a contiguous
+    * span of existing elements.
+    */
+   static int StructureSpans( Array<int>& spanStart, Array<int>& spanEnd, const StructuringElement& S )
+   {
+      int n = S.Size();
+      int nh = S.NumberOfElements();
+      IVector index( nh );
+      for ( int i = 0; i < nh; ++i )
+         index[i] = i;
+      IVector existing( nh );
+      int ne;
+      S.PeekElements( *existing, ne, *index, 0 );
+      if ( ne == 0 )
+         return 0;
+
+      spanStart = Array<int>( size_type( n ), n );
+      spanEnd = Array<int>( size_type( n ), -1 );
+      Array<int> rowCount( size_type( n ), 0 );
+      for ( int k = 0; k < ne; ++k )
+      {
+         int i = existing[k]/n;
+         int j = existing[k]%n;
+         spanStart[i] = Min( spanStart[i], j );
+         spanEnd[i] = Max( spanEnd[i], j );
+         ++rowCount[i];
+      }
+
+      for ( int i = 0; i < n; ++i )
+         if ( rowCount[i] > 0 && rowCount[i] != spanEnd[i] - spanStart[i] + 1 )
+            return 0; // not a contiguous span
+
+      return ne;
+   }
+
+   /*
+    * Erosion and dilation with separable single-way structures are computed
+    * with the van Herk/Gil-Werman algorithm, which requires three comparisons
+    * per sample and 1-D pass, independently of the structure size.
+    *
+    * Supported structures are rectangles, including box structures and
+    * horizontal and vertical lines, which are filtered with a horizontal pass
+    * followed by a vertical pass, and crosses centered on the structure's
+    * central column (such as orthogonal structures), which are the union of
+    * a horizontal line and a vertical line. Boundary pixels are mirrored in
+    * the same way as in the general algorithm, so both implementations yield
+    * identical results.
+    */
+   struct MinMaxFilter
+   {
+      bool dilation;
+      bool cross;    // union of a horizontal line and a vertical line
+      int  x0, x1;   // horizontal window, structure columns
+      int  y0, y1;   // vertical window, structure rows
+      int  row;      // structure row of the horizontal line of a cross
+   };
+
+   static bool InitializeMinMaxFilter( MinMaxFilter& M, const MorphologicalTransformation& T )
+   {
+      const StructuringElement& S = T.Structure();
+      if ( S.NumberOfWays() != 1 || T.InterlacingDistance() != 1 )
+         return false;
+
+      const MorphologicalOperator& op = T.Operator();
+      if ( dynamic_cast<const ErosionFilter*>( &op ) != nullptr )
+         M.dilation = false;
+      else if ( dynamic_cast<const DilationFilter*>( &op ) != nullptr )
+         M.dilation = true;
+      else
+         return false;
+
+      Array<int> spanStart, spanEnd;
+      if ( StructureSpans( spanStart, spanEnd, S ) == 0 )
+         return false;
+
+      int n = S.Size();
+      int n2 = n >> 1;
+
+      /*
+       * Nonempty structure rows must be contiguous.
+       */
+      M.y0 = 0;
+      while ( spanStart[M.y0] > spanEnd[M.y0] )
+         ++M.y0;
+      M.y1 = n-1;
+      while ( spanStart[M.y1] > spanEnd[M.y1] )
+         --M.y1;
+      for ( int i = M.y0; i <= M.y1; ++i )
+         if ( spanStart[i] > spanEnd[i] )
+            return false;
+
+      /*
+       * Rectangle: all nonempty rows have identical spans.
+       */
+      M.cross = false;
+      M.x0 = spanStart[M.y0];
+      M.x1 = spanEnd[M.y0];
+      M.row = M.y0;
+      int i = M.y0;
+      for ( ; i <= M.y1; ++i )
+         if ( spanStart[i] != M.x0 || spanEnd[i] != M.x1 )
+            break;
+      if ( i > M.y1 )
+         return true;
+
+      /*
+       * Cross: a single row with a longer span, all other rows having the
+       * central element only.
+       */
+      M.row = -1;
+      for ( i = M.y0; i <= M.y1; ++i )
+         if ( spanStart[i] != n2 || spanEnd[i] != n2 )
+         {
+            if ( M.row >= 0 || spanStart[i] > n2 || spanEnd[i] < n2 )
+               return false;
+            M.row = i;
+         }
+      M.x0 = spanStart[M.row];
+      M.x1 = spanEnd[M.row];
+      M.cross = true;
+      return true;
+   }
+
+   template <typename T>
+   struct MinOp
+   {
+      T operator()( T a, T b ) const
+      {
+         return (b < a) ? b : a;
+      }
+   };
+
+   template <typename T>
+   struct MaxOp
+   {
+      T operator()( T a, T b ) const
+      {
+         return (a < b) ? b : a;
+      }
+   };
+
+   /*
+    * One-dimensional van Herk/Gil-Werman filter:
+    *
+    * r[i] = op( e[i], e[i+1], ..., e[i+L-1] ), 0 <= i < n
+    *
+    * The g and h work arrays must provide room for n+L-1 elements.
+    */
+   template <typename T, class Op>
+   static void MinMax1D( T* r, const T* e, int n, int L, T* g, T* h, Op op )
+   {
+      if ( L == 1 )
+      {
+         ::memcpy( r, e, n*sizeof( T ) );
+         return;
+      }
+
+      int m = n + L - 1;
+      for ( int i = 0; i < m; i += L )
+      {
+         int i1 = Min( i+L, m );
+         g[i] = e[i];
+         for ( int j = i+1; j < i1; ++j )
+            g[j] = op( g[j-1], e[j] );
+         h[i1-1] = e[i1-1];
+         for ( int j = i1-1; --j >= i; )
+            h[j] = op( h[j+1], e[j] );
+      }
+
+      for ( int i = 0; i < n; ++i )
+         r[i] = op( h[i], g[i+L-1] );
+   }
+
+   /*
+    * Vertical van Herk/Gil-Werman filter applied to a strip of w columns.
+    * Each element is a row of contiguous samples, so the inner loops can be
+    * vectorized by the compiler. The g and h work arrays must provide room
+    * for (n+L-1)*w samples.
+    */
+   template <typename T, class Op>
+   static void MinMax1DRows( T* const* r, const T* const* e, int n, int L, int w, T* g, T* h, Op op )
+   {
+      if ( L == 1 )
+      {
+         for ( int i = 0; i < n; ++i )
+            ::memcpy( r[i], e[i], w*sizeof( T ) );
+         return;
+      }
+
+      int m = n + L - 1;
+      for ( int i = 0; i < m; i += L )
+      {
+         int i1 = Min( i+L, m );
+         ::memcpy( g + size_type( i )*w, e[i], w*sizeof( T ) );
+         for ( int j = i+1; j < i1; ++j )
+         {
+            T* gj = g + size_type( j )*w;
+            const T* gj1 = gj - w;
+            const T* ej = e[j];
+            for ( int x = 0; x < w; ++x )
+               gj[x] = op( gj1[x], ej[x] );
+         }
+         ::memcpy( h + size_type( i1-1 )*w, e[i1-1], w*sizeof( T ) );
+         for ( int j = i1-1; --j >= i; )
+         {
+            T* hj = h + size_type( j )*w;
+            const T* hj1 = hj + w;
+            const T* ej = e[j];
+            for ( int x = 0; x < w; ++x )
+               hj[x] = op( hj1[x], ej[x] );
+         }
+      }
+
+      for ( int i = 0; i < n; ++i )
+      {
+         T* ri = r[i];
+         const T* hi = h + size_type( i )*w;
+         const T* gi = g + size_type( i+L-1 )*w;
+         for ( int x = 0; x < w; ++x )
+            ri[x] = op( hi[x], gi[x] );
+      }
+   }
+
+   /*
+    * Image row used for a structure row placed at row y (possibly outside
+    * the image), consistently with the general algorithm: rows above the
+    * image are mirrored with respect to the first selected row y0, and rows
+    * below the image replicate the last row.
+    */
+   static int MinMaxSourceRow( int y, int y0, int height )
+   {
+      if ( y < 0 )
+         y = 2*y0 - 1 - y;
+      return Range( y, 0, height-1 );
+   }
+
+   template <class P>
+   static void ApplyMinMaxFilter( GenericImage<P>& image, const MorphologicalTransformation& T, const MinMaxFilter& M )
+   {
+      if ( M.dilation )
+         ApplyMinMaxFilter( image, T, M, MaxOp<typename P::sample>() );
+      else
+         ApplyMinMaxFilter( image, T, M, MinOp<typename P::sample>() );
+   }
+
+   template <class P, class Op>
+   static void ApplyMinMaxFilter( GenericImage<P>& image, const MorphologicalTransformation& T, const MinMaxFilter& M, Op op )
+   {
+      typedef typename P::sample sample;
+
+      Rect r = image.SelectedRectangle();
+      int w = r.Width();
+      int h = r.Height();
+      int n = T.OverlappingDistance();
+      int n2 = n >> 1;
+      int maxThreads = T.IsParallelProcessingEnabled() ? T.MaxProcessors() : 1;
+
+      sample th0 = P::ToSample( T.LowThreshold() );
+      sample th1 = P::ToSample( T.HighThreshold() );
+      bool tz0 = 1 + th0 == 1;
+      bool tz1 = 1 + th1 == 1;
+      bool tz = tz0 && tz1;
+
+      /*
+       * Rows are processed by bands. The output of each band is written to
+       * the image once the source rows of the next band have been read.
+       */
+      int bandRows = Min( h, Max( n, 512 ) );
+      int lv = M.y1 - M.y0 + 1;
+      int sourceRows = bandRows + lv - 1;
+
+      GenericVector<sample> source( size_type( sourceRows )*w );
+      GenericVector<sample> line( M.cross ? size_type( bandRows )*w : size_type( 0 ) );
+      GenericVector<sample> output( size_type( bandRows )*w );
+
+      /*
+       * Horizontal pass: filters the image row used for structure row i at
+       * image row y, with horizontal window [x0,x1]. Columns outside the
+       * selection are mirrored with respect to the selection boundaries.
+       */
+      auto horizontalPass = [&]( sample* s, int y, int i, int x0, int x1, int c, sample* e, sample* g, sample* gh )
+      {
+         const sample* f = image.PixelAddress( r.x0, MinMaxSourceRow( y - n2 + i, r.y0, image.Height() ), c );
+         if ( x0 == n2 && x1 == n2 )
+         {
+            ::memcpy( s, f, w*sizeof( sample ) );
+            return;
+         }
+         ::memcpy( e + n2, f, w*sizeof( sample ) );
+         for ( int k = 1; k <= n2; ++k )
+         {
+            e[n2-k] = f[Min( k, w-1 )];
+            e[n2+w-1+k] = f[Max( w-1-k, 0 )];
+         }
+         MinMax1D( s, e + x0, w, x1-x0+1, g, gh, op );
+      };
+
+      for ( int c = image.FirstSelectedChannel(); c <= image.LastSelectedChannel(); ++c )
+      {
+         int pendingRow = -1, pendingRows = 0;
+
+         for ( int yb = r.y0; yb < r.y1; yb += bandRows )
+         {
+            int bh = Min( bandRows, r.y1 - yb );
+            int sh = bh + lv - 1;
+
+            ThreadPool::ParallelFor( sh, 16,
+               [&]( int begin, int end )
+               {
+                  GenericVector<sample> e( w + 2*n2 ), g( w + n ), gh( w + n );
+                  for ( int k = begin; k < end; ++k )
+                     if ( M.cross )
+                        horizontalPass( source.At( size_type( k )*w ), yb + k, M.y0, n2, n2, c, *e, *g, *gh );
+                     else
+                        horizontalPass( source.At( size_type( k )*w ), yb + k, M.y0, M.x0, M.x1, c, *e, *g, *gh );
+               }, maxThreads );
+
+            if ( M.cross )
+               ThreadPool::ParallelFor( bh, 16,
+                  [&]( int begin, int end )
+                  {
+                     GenericVector<sample> e( w + 2*n2 ), g( w + n ), gh( w + n );
+                     for ( int k = begin; k < end; ++k )
+                        horizontalPass( line.At( size_type( k )*w ), yb + k, M.row, M.x0, M.x1, c, *e, *g, *gh );
+                  }, maxThreads );
+
+            for ( int k = 0; k < pendingRows; ++k )
+               ::memcpy( image.PixelAddress( r.x0, pendingRow + k, c ), output.At( size_type( k )*w ), w*sizeof( sample ) );
+
+            /*
+             * Vertical pass by strips of columns.
+             */
+            const int stripWidth = 64;
+            int numberOfStrips = (w + stripWidth - 1)/stripWidth;
+            ThreadPool::ParallelFor( numberOfStrips, 1,
+               [&]( int begin, int end )
+               {
+                  GenericVector<sample> g( size_type( sh )*stripWidth ), gh( size_type( sh )*stripWidth );
+                  Array<const sample*> e( sh );
+                  Array<sample*> o( bh );
+                  for ( int strip = begin; strip < end; ++strip )
+                  {
+                     int sx = strip*stripWidth;
+                     int sw = Min( stripWidth, w - sx );
+                     for ( int k = 0; k < sh; ++k )
+                        e[k] = source.At( size_type( k )*w + sx );
+                     for ( int k = 0; k < bh; ++k )
+                        o[k] = output.At( size_type( k )*w + sx );
+                     MinMax1DRows( o.Begin(), e.Begin(), bh, lv, sw, *g, *gh, op );
+
+                     for ( int k = 0; k < bh; ++k )
+                     {
+                        sample* ok = o[k];
+                        if ( M.cross )
+                        {
+                           const sample* lk = line.At( size_type( k )*w + sx );
+                           for ( int x = 0; x < sw; ++x )
+                              ok[x] = op( ok[x], lk[x] );
+                        }
+
+                        if ( !tz )
+                        {
+                           const sample* f = image.PixelAddress( r.x0 + sx, yb + k, c );
+                           for ( int x = 0; x < sw; ++x )
+                           {
+                              double v = ok[x];
+                              if ( v < f[x] )
+                              {
+                                 if ( !tz0 )
+                                 {
+                                    double d = f[x] - v;
+                                    if ( d < th0 )
+                                    {
+                                       d /= th0;
+                                       v = d*v + (1 - d)*f[x];
+                                    }
+                                 }
+                              }
+                              else
+                              {
+                                 if ( !tz1 )
+                                 {
+                                    double d = v - f[x];
+                                    if ( d < th1 )
+                                    {
+                                       d /= th1;
+                                       v = d*v + (1 - d)*f[x];
+                                    }
+                                 }
+                              }
+                              ok[x] = P::FloatToSample( v );
+                           }
+                        }
+                     }
+                  }
+               }, maxThreads );
+
+            pendingRow = yb;
+            pendingRows = bh;
+
+            // Band completed: update the monitor, which may throw if the
+            // process has been aborted.
+            image.Status() += size_type( bh )*w;
+         }
+
+         for ( int k = 0; k < pendingRows; ++k )
+            ::memcpy( image.PixelAddress( r.x0, pendingRow + k, c ), output.At( size_type( k )*w ), w*sizeof( sample ) );
+      }
+   }
+
+   /*
+    * Histogram keys: 16-bit quantized sample values.
+    */
+   static int HistogramKey( float x )
+   {
+      return RoundInt( Range( x, 0.0F, 1.0F )*uint16_max );
+   }
+
+   static int HistogramKey( double x )
+   {
+      return RoundInt( Range( x, 0.0, 1.0 )*uint16_max );
+   }
+
+   static int HistogramKey( uint8 x )
+   {
+      return x;
+   }
+
+   static int HistogramKey( uint16 x )
+   {
+      return x;
+   }
+
+   template <typename T>
+   static int HistogramKey( const T& )
+   {
+      return 0; // unsupported
+   }
+
+   template <class P>
+   static double HistogramValue( int key, P* )
+   {
+      return P::IsFloatSample() ? double( key )/uint16_max : double( key );
+   }
+
+   /*
+    * A two-level histogram of 16-bit keys, with 256 coarse bins of 256 fine
+    * bins each. Order statistics are found with at most 512 bin visits.
+    * Bins are only allocated for an enabled histogram.
+    */
+   class SlidingHistogram
+   {
+   public:
+
+      SlidingHistogram( bool enabled ) : m_coarse( 0, enabled ? 256 : 0 ), m_fine( 0, enabled ? 65536 : 0 )
+      {
+      }
+
+      void Add( int key )
+      {
+         ++m_coarse[key >> 8];
+         ++m_fine[key];
+      }
+
+      void Remove( int key )
+      {
+         --m_coarse[key >> 8];
+         --m_fine[key];
+      }
+
+      /*
+       * Returns the key of the k-th order statistic (zero-based).
+       */
+      int Select( int k ) const
+      {
+         int c = 0;
+         for ( ; c < 255; ++c )
+         {
+            if ( k < m_coarse[c] )
+               break;
+            k -= m_coarse[c];
+         }
+         int i = c << 8;
+         for ( int i1 = i + 255; i < i1; ++i )
+         {
+            if ( k < m_fine[i] )
+               break;
+            k -= m_fine[i];
+         }
+         return i;
+      }
+
+   private:
+
+      IVector m_coarse;
+      IVector m_fine;
    };
 
    template <class P>
@@ -207,8 +818,19 @@ private:
 
          DVector W( m_data.transformation.Structure().NumberOfWays() );
 
-         raw_vector h( nh );
-         raw_vector h1( nh );
+         raw_vector h( m_data.useHistogram ? 0 : nh );
+         raw_vector h1( m_data.useHistogram ? 0 : nh );
+
+         SlidingHistogram H( m_data.useHistogram );
+         int k1 = 0, k2 = 0; // order statistics for the histogram filter
+         if ( m_data.useHistogram )
+            if ( m_data.median )
+            {
+               k2 = m_data.numberOfElements >> 1;
+               k1 = (m_data.numberOfElements & 1) ? k2 : k2-1;
+            }
+            else
+               k1 = k2 = RoundInt( m_data.selectionPoint*(m_data.numberOfElements - 1) );
 
          raw_data f0( P::MinSampleValue(), n, nf0 );
 
@@ -240,36 +862,59 @@ private:
 
             for ( int y = m_firstRow; ; )
             {
+               if ( m_data.useHistogram )
+                  for ( int i = 0; i < n; ++i )
+                     for ( int j = m_data.spanStart[i]; j <= m_data.spanEnd[i]; ++j )
+                        H.Add( HistogramKey( f0[i][j] ) );
+
                for ( int x = 0; x < w; ++x )
                {
-                  typename raw_vector::iterator hi = *h;
+                  double r = 0;
 
-                  for ( int i = 0; i < n; i += m_data.transformation.InterlacingDistance() )
+                  if ( m_data.useHistogram )
                   {
-                     typename raw_data::const_vector_iterator fi = f0[i].At( x );
-                     for ( int j = 0; j < n; j  += m_data.transformation.InterlacingDistance(),
-                                             fi += m_data.transformation.InterlacingDistance() )
-                        *hi++ = *fi;
+                     if ( x > 0 )
+                        for ( int i = 0; i < n; ++i )
+                           if ( m_data.spanStart[i] <= m_data.spanEnd[i] )
+                           {
+                              H.Remove( HistogramKey( f0[i][x-1 + m_data.spanStart[i]] ) );
+                              H.Add( HistogramKey( f0[i][x + m_data.spanEnd[i]] ) );
+                           }
+
+                     r = HistogramValue( H.Select( k1 ), (P*)0 );
+                     if ( k2 != k1 )
+                        r = P::FloatToSample( (r + HistogramValue( H.Select( k2 ), (P*)0 ))/2 );
                   }
+                  else
+                  {
+                     typename raw_vector::iterator hi = *h;
 
-                  for ( int k = 0; k < m_data.transformation.Structure().NumberOfWays(); ++k )
-                     if ( m_data.transformation.Structure().IsBox( k ) )
-                        W[k] = m_data.transformation.Operator()( *h, nh );
-                     else
+                     for ( int i = 0; i < n; i += m_data.transformation.InterlacingDistance() )
                      {
-                        int nh1;
-                        m_data.transformation.Structure().PeekElements( *h1, nh1, *h, k );
-                        if ( nh1 > 0 )
-                           W[k] = m_data.transformation.Operator()( *h1, nh1 );
-                        else
-                           W[k] = 0;
+                        typename raw_data::const_vector_iterator fi = f0[i].At( x );
+                        for ( int j = 0; j < n; j  += m_data.transformation.InterlacingDistance(),
+                                                fi += m_data.transformation.InterlacingDistance() )
+                           *hi++ = *fi;
                      }
 
-                  double r = 0;
-                  if ( m_data.transformation.Structure().NumberOfWays() > 1 )
-                     r = m_data.transformation.Operator()( *W, W.Length() );
-                  else
-                     r = W[0];
+                     for ( int k = 0; k < m_data.transformation.Structure().NumberOfWays(); ++k )
+                        if ( m_data.transformation.Structure().IsBox( k ) )
+                           W[k] = m_data.transformation.Operator()( *h, nh );
+                        else
+                        {
+                           int nh1;
+                           m_data.transformation.Structure().PeekElements( *h1, nh1, *h, k );
+                           if ( nh1 > 0 )
+                              W[k] = m_data.transformation.Operator()( *h1, nh1 );
+                           else
+                              W[k] = 0;
+                        }
+
+                     if ( m_data.transformation.Structure().NumberOfWays() > 1 )
+                        r = m_data.transformation.Operator()( *W, W.Length() );
+                     else
+                        r = W[0];
+                  }
 
                   if ( !tz )
                   {
@@ -309,6 +954,11 @@ private:
                   UPDATE_THREAD_MONITOR( 65536 )
                }
 
+               if ( m_data.useHistogram )
+                  for ( int i = 0; i < n; ++i )
+                     for ( int j = m_data.spanStart[i]; j <= m_data.spanEnd[i]; ++j )
+                        H.Remove( HistogramKey( f0[i][w-1 + j] ) );
+
                if ( ++y == m_endRow )
                   break;
 
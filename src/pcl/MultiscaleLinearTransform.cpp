@@ -54,6 +54,7 @@
 #include <pcl/FFTConvolution.h>
 #include <pcl/GaussianFilter.h>
 #include <pcl/MultiscaleLinearTransform.h>
+#include <pcl/RecursiveGaussianConvolution.h>
 #include <pcl/SeparableConvolution.h>
 
 namespace pcl
@@ -130,7 +131,13 @@ private:
    void LinearFilterLayer( GenericImage<P>& cj, int n, bool parallel, int maxProcessors )
    {
       GaussianFilter H( n );
-      if ( n >= PCL_FFT_CONVOLUTION_IS_FASTER_THAN_SEPARABLE_FILTER_SIZE || cj.Width() < n || cj.Height() < n  )
+      if ( H.Sigma() >= PCL_RECURSIVE_GAUSSIAN_IS_FASTER_THAN_SEPARABLE_FILTER_SIGMA )
+      {
+         RecursiveGaussianConvolution R( H );
+         R.EnableParallelProcessing( parallel, maxProcessors );
+         R >> cj;
+      }
+      else if ( n >= PCL_FFT_CONVOLUTION_IS_FASTER_THAN_SEPARABLE_FILTER_SIZE || cj.Width() < n || cj.Height() < n  )
       {
          FFTConvolution Z( H );
          Z.EnableParallelProcessing( parallel, maxProcessors );
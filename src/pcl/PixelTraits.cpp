@@ -0,0 +1,569 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/PixelTraits.cpp - Released 2016/02/21 20:22:19 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#include <pcl/InstructionSet.h>
+#include <pcl/PixelTraits.h>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __PCL_MACOSX )
+# define __PCL_BULK_CONVERSION_SSE2 1
+# include <emmintrin.h>
+# include <immintrin.h>
+# if defined( __PCL_HAVE_TARGET_ATTRIBUTES ) && !defined( __PCL_NO_AVX512_TARGET )
+#  define __PCL_BULK_CONVERSION_AVX512 1
+# endif
+#endif
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Scalar conversions, used for array tails and on non-x86 platforms. Integer
+ * to floating point conversions reproduce the ToSample() member functions of
+ * floating point pixel traits, without lookup tables.
+ */
+
+static inline float  ScalarToFloat( uint8 x )   { return float( x )/uint8_max; }
+static inline float  ScalarToFloat( uint16 x )  { return float( x )/uint16_max; }
+static inline float  ScalarToFloat( uint32 x )  { return float( double( x )/uint32_max ); }
+static inline double ScalarToDouble( uint8 x )  { return double( x )/uint8_max; }
+static inline double ScalarToDouble( uint16 x ) { return double( x )/uint16_max; }
+static inline double ScalarToDouble( uint32 x ) { return double( x )/uint32_max; }
+
+template <typename T, typename S> static inline
+void ScalarToFloat( T* f, const S* g, size_type n )
+{
+   for ( size_type i = 0; i < n; ++i )
+      f[i] = T( ScalarToDouble( g[i] ) );
+}
+
+template <typename S> static inline
+void ScalarToFloat( float* f, const S* g, size_type n )
+{
+   for ( size_type i = 0; i < n; ++i )
+      f[i] = ScalarToFloat( g[i] );
+}
+
+template <class P, typename T> static inline
+void ScalarToInteger( typename P::sample* f, const T* g, size_type n )
+{
+   for ( size_type i = 0; i < n; ++i )
+      f[i] = P::ToSampleConstrained( g[i] );
+}
+
+// ----------------------------------------------------------------------------
+
+#ifdef __PCL_BULK_CONVERSION_SSE2
+
+/*
+ * Conversion of four 32-bit unsigned integers to two pairs of doubles.
+ */
+static inline void UInt32ToDouble( __m128d& lo, __m128d& hi, __m128i v )
+{
+   const __m128i sgn = _mm_set1_epi32( int( 0x80000000 ) );
+   const __m128d off = _mm_set1_pd( 2147483648.0 );
+   v = _mm_xor_si128( v, sgn );
+   lo = _mm_add_pd( _mm_cvtepi32_pd( v ), off );
+   hi = _mm_add_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( v, 0xEE ) ), off );
+}
+
+/*
+ * Conversion of two pairs of doubles in the range [0,uint32_max] to four
+ * 32-bit unsigned integers, with round to nearest even.
+ */
+static inline __m128i DoubleToUInt32( __m128d lo, __m128d hi )
+{
+   const __m128i sgn = _mm_set1_epi32( int( 0x80000000 ) );
+   const __m128d off = _mm_set1_pd( 2147483648.0 );
+   __m128i ilo = _mm_cvtpd_epi32( _mm_sub_pd( lo, off ) );
+   __m128i ihi = _mm_cvtpd_epi32( _mm_sub_pd( hi, off ) );
+   return _mm_xor_si128( _mm_unpacklo_epi64( ilo, ihi ), sgn );
+}
+
+/*
+ * Packing of eight 32-bit integers in the range [0,uint16_max] to 16-bit
+ * unsigned integers (SSE2 lacks unsigned 32-bit saturation).
+ */
+static inline __m128i PackUInt16( __m128i a, __m128i b )
+{
+   const __m128i off32 = _mm_set1_epi32( 32768 );
+   const __m128i off16 = _mm_set1_epi16( short( 0x8000 ) );
+   return _mm_xor_si128( _mm_packs_epi32( _mm_sub_epi32( a, off32 ), _mm_sub_epi32( b, off32 ) ), off16 );
+}
+
+/*
+ * Clamped and scaled conversions of normalized reals to 32-bit integers.
+ */
+static inline __m128i ScaleToInt32( __m128 x, __m128 scale )
+{
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps( 1.0F );
+   return _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( x, zero ), one ), scale ) );
+}
+
+static inline __m128i ScaleToInt32( __m128d lo, __m128d hi, __m128d scale )
+{
+   const __m128d zero = _mm_setzero_pd();
+   const __m128d one = _mm_set1_pd( 1.0 );
+   __m128i ilo = _mm_cvtpd_epi32( _mm_mul_pd( _mm_min_pd( _mm_max_pd( lo, zero ), one ), scale ) );
+   __m128i ihi = _mm_cvtpd_epi32( _mm_mul_pd( _mm_min_pd( _mm_max_pd( hi, zero ), one ), scale ) );
+   return _mm_unpacklo_epi64( ilo, ihi );
+}
+
+static inline void ClampDouble( __m128d& lo, __m128d& hi, __m128d scale )
+{
+   const __m128d zero = _mm_setzero_pd();
+   const __m128d one = _mm_set1_pd( 1.0 );
+   lo = _mm_mul_pd( _mm_min_pd( _mm_max_pd( lo, zero ), one ), scale );
+   hi = _mm_mul_pd( _mm_min_pd( _mm_max_pd( hi, zero ), one ), scale );
+}
+
+// ----------------------------------------------------------------------------
+
+/*
+ * AVX2 kernels for the most frequent conversions.
+ */
+
+PCL_TARGET_AVX2
+static size_type AVX2_UInt16ToFloat( float* f, const uint16* g, size_type n )
+{
+   const __m256 k = _mm256_set1_ps( float( uint16_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+   {
+      __m256i v = _mm256_loadu_si256( (const __m256i*)(g+i) );
+      __m256 lo = _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( _mm256_castsi256_si128( v ) ) );
+      __m256 hi = _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( _mm256_extracti128_si256( v, 1 ) ) );
+      _mm256_storeu_ps( f+i, _mm256_div_ps( lo, k ) );
+      _mm256_storeu_ps( f+i+8, _mm256_div_ps( hi, k ) );
+   }
+   return i;
+}
+
+PCL_TARGET_AVX2
+static size_type AVX2_UInt8ToFloat( float* f, const uint8* g, size_type n )
+{
+   const __m256 k = _mm256_set1_ps( float( uint8_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+   {
+      __m128i v = _mm_loadu_si128( (const __m128i*)(g+i) );
+      __m256 lo = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( v ) );
+      __m256 hi = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_srli_si128( v, 8 ) ) );
+      _mm256_storeu_ps( f+i, _mm256_div_ps( lo, k ) );
+      _mm256_storeu_ps( f+i+8, _mm256_div_ps( hi, k ) );
+   }
+   return i;
+}
+
+PCL_TARGET_AVX2
+static inline __m256i AVX2_ScaleToInt32( __m256 x, __m256 scale )
+{
+   return _mm256_cvtps_epi32( _mm256_mul_ps( _mm256_min_ps( _mm256_max_ps( x, _mm256_setzero_ps() ),
+                                                            _mm256_set1_ps( 1.0F ) ), scale ) );
+}
+
+PCL_TARGET_AVX2
+static size_type AVX2_FloatToUInt16( uint16* f, const float* g, size_type n )
+{
+   const __m256 k = _mm256_set1_ps( float( uint16_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+   {
+      __m256i a = AVX2_ScaleToInt32( _mm256_loadu_ps( g+i ), k );
+      __m256i b = AVX2_ScaleToInt32( _mm256_loadu_ps( g+i+8 ), k );
+      __m256i v = _mm256_permute4x64_epi64( _mm256_packus_epi32( a, b ), 0xD8 );
+      _mm256_storeu_si256( (__m256i*)(f+i), v );
+   }
+   return i;
+}
+
+PCL_TARGET_AVX2
+static size_type AVX2_FloatToUInt8( uint8* f, const float* g, size_type n )
+{
+   const __m256 k = _mm256_set1_ps( float( uint8_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+   {
+      __m256i a = AVX2_ScaleToInt32( _mm256_loadu_ps( g+i ), k );
+      __m256i b = AVX2_ScaleToInt32( _mm256_loadu_ps( g+i+8 ), k );
+      __m256i v = _mm256_permute4x64_epi64( _mm256_packus_epi32( a, b ), 0xD8 );
+      _mm_storeu_si128( (__m128i*)(f+i), _mm_packus_epi16( _mm256_castsi256_si128( v ),
+                                                           _mm256_extracti128_si256( v, 1 ) ) );
+   }
+   return i;
+}
+
+// ----------------------------------------------------------------------------
+
+#ifdef __PCL_BULK_CONVERSION_AVX512
+
+/*
+ * AVX-512 kernels for the same conversions. Rounding and saturation are
+ * identical to the SSE2 and AVX2 kernels.
+ *
+ * The zero-masking forms of the intrinsics are used with a full mask. The
+ * unmasked forms are implemented by GCC with an undefined passthrough
+ * register, which triggers -Wmaybe-uninitialized warnings.
+ */
+
+#define AVX512_ALL_LANES __mmask16( 0xFFFF )
+
+PCL_TARGET_AVX512
+static size_type AVX512_UInt16ToFloat( float* f, const uint16* g, size_type n )
+{
+   const __m512 k = _mm512_set1_ps( float( uint16_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+   {
+      __m512i v = _mm512_maskz_cvtepu16_epi32( AVX512_ALL_LANES, _mm256_loadu_si256( (const __m256i*)(g+i) ) );
+      _mm512_storeu_ps( f+i, _mm512_div_ps( _mm512_maskz_cvtepi32_ps( AVX512_ALL_LANES, v ), k ) );
+   }
+   return i;
+}
+
+PCL_TARGET_AVX512
+static size_type AVX512_UInt8ToFloat( float* f, const uint8* g, size_type n )
+{
+   const __m512 k = _mm512_set1_ps( float( uint8_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+   {
+      __m512i v = _mm512_maskz_cvtepu8_epi32( AVX512_ALL_LANES, _mm_loadu_si128( (const __m128i*)(g+i) ) );
+      _mm512_storeu_ps( f+i, _mm512_div_ps( _mm512_maskz_cvtepi32_ps( AVX512_ALL_LANES, v ), k ) );
+   }
+   return i;
+}
+
+PCL_TARGET_AVX512
+static inline __m512i AVX512_ScaleToInt32( __m512 x, __m512 scale )
+{
+   __m512 y = _mm512_maskz_min_ps( AVX512_ALL_LANES,
+                                   _mm512_maskz_max_ps( AVX512_ALL_LANES, x, _mm512_setzero_ps() ), _mm512_set1_ps( 1.0F ) );
+   return _mm512_maskz_cvtps_epi32( AVX512_ALL_LANES, _mm512_mul_ps( y, scale ) );
+}
+
+PCL_TARGET_AVX512
+static size_type AVX512_FloatToUInt16( uint16* f, const float* g, size_type n )
+{
+   const __m512 k = _mm512_set1_ps( float( uint16_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+      _mm256_storeu_si256( (__m256i*)(f+i), _mm512_maskz_cvtusepi32_epi16( AVX512_ALL_LANES, AVX512_ScaleToInt32( _mm512_loadu_ps( g+i ), k ) ) );
+   return i;
+}
+
+PCL_TARGET_AVX512
+static size_type AVX512_FloatToUInt8( uint8* f, const float* g, size_type n )
+{
+   const __m512 k = _mm512_set1_ps( float( uint8_max ) );
+   size_type i = 0;
+   for ( ; i+16 <= n; i += 16 )
+      _mm_storeu_si128( (__m128i*)(f+i), _mm512_maskz_cvtusepi32_epi8( AVX512_ALL_LANES, AVX512_ScaleToInt32( _mm512_loadu_ps( g+i ), k ) ) );
+   return i;
+}
+
+#undef AVX512_ALL_LANES
+
+#endif   // __PCL_BULK_CONVERSION_AVX512
+
+#endif   // __PCL_BULK_CONVERSION_SSE2
+
+// ----------------------------------------------------------------------------
+
+void PixelTraitsConversion::Convert( float* f, const uint8* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   InstructionSet::value_type level = ActiveInstructionSet();
+#ifdef __PCL_BULK_CONVERSION_AVX512
+   if ( level >= InstructionSet::AVX512 )
+      i = AVX512_UInt8ToFloat( f, g, n );
+   else
+#endif
+   if ( level >= InstructionSet::AVX2 )
+      i = AVX2_UInt8ToFloat( f, g, n );
+   else
+   {
+      const __m128 k = _mm_set1_ps( float( uint8_max ) );
+      const __m128i zero = _mm_setzero_si128();
+      for ( ; i+16 <= n; i += 16 )
+      {
+         __m128i v = _mm_loadu_si128( (const __m128i*)(g+i) );
+         __m128i lo = _mm_unpacklo_epi8( v, zero );
+         __m128i hi = _mm_unpackhi_epi8( v, zero );
+         _mm_storeu_ps( f+i,    _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ), k ) );
+         _mm_storeu_ps( f+i+4,  _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ), k ) );
+         _mm_storeu_ps( f+i+8,  _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ), k ) );
+         _mm_storeu_ps( f+i+12, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ), k ) );
+      }
+   }
+#endif
+   ScalarToFloat( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( float* f, const uint16* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   InstructionSet::value_type level = ActiveInstructionSet();
+#ifdef __PCL_BULK_CONVERSION_AVX512
+   if ( level >= InstructionSet::AVX512 )
+      i = AVX512_UInt16ToFloat( f, g, n );
+   else
+#endif
+   if ( level >= InstructionSet::AVX2 )
+      i = AVX2_UInt16ToFloat( f, g, n );
+   else
+   {
+      const __m128 k = _mm_set1_ps( float( uint16_max ) );
+      const __m128i zero = _mm_setzero_si128();
+      for ( ; i+8 <= n; i += 8 )
+      {
+         __m128i v = _mm_loadu_si128( (const __m128i*)(g+i) );
+         _mm_storeu_ps( f+i,   _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( v, zero ) ), k ) );
+         _mm_storeu_ps( f+i+4, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( v, zero ) ), k ) );
+      }
+   }
+#endif
+   ScalarToFloat( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( float* f, const uint32* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint32_max ) );
+   for ( ; i+4 <= n; i += 4 )
+   {
+      __m128d lo, hi;
+      UInt32ToDouble( lo, hi, _mm_loadu_si128( (const __m128i*)(g+i) ) );
+      _mm_storeu_ps( f+i, _mm_movelh_ps( _mm_cvtpd_ps( _mm_div_pd( lo, k ) ),
+                                         _mm_cvtpd_ps( _mm_div_pd( hi, k ) ) ) );
+   }
+#endif
+   ScalarToFloat( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( double* f, const uint8* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint8_max ) );
+   const __m128i zero = _mm_setzero_si128();
+   for ( ; i+8 <= n; i += 8 )
+   {
+      __m128i v = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*)(g+i) ), zero );
+      __m128i lo = _mm_unpacklo_epi16( v, zero );
+      __m128i hi = _mm_unpackhi_epi16( v, zero );
+      _mm_storeu_pd( f+i,   _mm_div_pd( _mm_cvtepi32_pd( lo ), k ) );
+      _mm_storeu_pd( f+i+2, _mm_div_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( lo, 0xEE ) ), k ) );
+      _mm_storeu_pd( f+i+4, _mm_div_pd( _mm_cvtepi32_pd( hi ), k ) );
+      _mm_storeu_pd( f+i+6, _mm_div_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( hi, 0xEE ) ), k ) );
+   }
+#endif
+   ScalarToFloat( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( double* f, const uint16* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint16_max ) );
+   const __m128i zero = _mm_setzero_si128();
+   for ( ; i+8 <= n; i += 8 )
+   {
+      __m128i v = _mm_loadu_si128( (const __m128i*)(g+i) );
+      __m128i lo = _mm_unpacklo_epi16( v, zero );
+      __m128i hi = _mm_unpackhi_epi16( v, zero );
+      _mm_storeu_pd( f+i,   _mm_div_pd( _mm_cvtepi32_pd( lo ), k ) );
+      _mm_storeu_pd( f+i+2, _mm_div_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( lo, 0xEE ) ), k ) );
+      _mm_storeu_pd( f+i+4, _mm_div_pd( _mm_cvtepi32_pd( hi ), k ) );
+      _mm_storeu_pd( f+i+6, _mm_div_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( hi, 0xEE ) ), k ) );
+   }
+#endif
+   ScalarToFloat( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( double* f, const uint32* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint32_max ) );
+   for ( ; i+4 <= n; i += 4 )
+   {
+      __m128d lo, hi;
+      UInt32ToDouble( lo, hi, _mm_loadu_si128( (const __m128i*)(g+i) ) );
+      _mm_storeu_pd( f+i,   _mm_div_pd( lo, k ) );
+      _mm_storeu_pd( f+i+2, _mm_div_pd( hi, k ) );
+   }
+#endif
+   ScalarToFloat( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( uint8* f, const float* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   InstructionSet::value_type level = ActiveInstructionSet();
+#ifdef __PCL_BULK_CONVERSION_AVX512
+   if ( level >= InstructionSet::AVX512 )
+      i = AVX512_FloatToUInt8( f, g, n );
+   else
+#endif
+   if ( level >= InstructionSet::AVX2 )
+      i = AVX2_FloatToUInt8( f, g, n );
+   else
+   {
+      const __m128 k = _mm_set1_ps( float( uint8_max ) );
+      for ( ; i+16 <= n; i += 16 )
+      {
+         __m128i a = _mm_packs_epi32( ScaleToInt32( _mm_loadu_ps( g+i ), k ), ScaleToInt32( _mm_loadu_ps( g+i+4 ), k ) );
+         __m128i b = _mm_packs_epi32( ScaleToInt32( _mm_loadu_ps( g+i+8 ), k ), ScaleToInt32( _mm_loadu_ps( g+i+12 ), k ) );
+         _mm_storeu_si128( (__m128i*)(f+i), _mm_packus_epi16( a, b ) );
+      }
+   }
+#endif
+   ScalarToInteger<UInt8PixelTraits>( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( uint8* f, const double* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint8_max ) );
+   for ( ; i+16 <= n; i += 16 )
+   {
+      __m128i a = _mm_packs_epi32( ScaleToInt32( _mm_loadu_pd( g+i    ), _mm_loadu_pd( g+i+2  ), k ),
+                                   ScaleToInt32( _mm_loadu_pd( g+i+4  ), _mm_loadu_pd( g+i+6  ), k ) );
+      __m128i b = _mm_packs_epi32( ScaleToInt32( _mm_loadu_pd( g+i+8  ), _mm_loadu_pd( g+i+10 ), k ),
+                                   ScaleToInt32( _mm_loadu_pd( g+i+12 ), _mm_loadu_pd( g+i+14 ), k ) );
+      _mm_storeu_si128( (__m128i*)(f+i), _mm_packus_epi16( a, b ) );
+   }
+#endif
+   ScalarToInteger<UInt8PixelTraits>( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( uint16* f, const float* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   InstructionSet::value_type level = ActiveInstructionSet();
+#ifdef __PCL_BULK_CONVERSION_AVX512
+   if ( level >= InstructionSet::AVX512 )
+      i = AVX512_FloatToUInt16( f, g, n );
+   else
+#endif
+   if ( level >= InstructionSet::AVX2 )
+      i = AVX2_FloatToUInt16( f, g, n );
+   else
+   {
+      const __m128 k = _mm_set1_ps( float( uint16_max ) );
+      for ( ; i+8 <= n; i += 8 )
+         _mm_storeu_si128( (__m128i*)(f+i), PackUInt16( ScaleToInt32( _mm_loadu_ps( g+i ), k ),
+                                                        ScaleToInt32( _mm_loadu_ps( g+i+4 ), k ) ) );
+   }
+#endif
+   ScalarToInteger<UInt16PixelTraits>( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( uint16* f, const double* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint16_max ) );
+   for ( ; i+8 <= n; i += 8 )
+      _mm_storeu_si128( (__m128i*)(f+i), PackUInt16( ScaleToInt32( _mm_loadu_pd( g+i   ), _mm_loadu_pd( g+i+2 ), k ),
+                                                     ScaleToInt32( _mm_loadu_pd( g+i+4 ), _mm_loadu_pd( g+i+6 ), k ) ) );
+#endif
+   ScalarToInteger<UInt16PixelTraits>( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( uint32* f, const float* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint32_max ) );
+   for ( ; i+4 <= n; i += 4 )
+   {
+      __m128 x = _mm_loadu_ps( g+i );
+      __m128d lo = _mm_cvtps_pd( x );
+      __m128d hi = _mm_cvtps_pd( _mm_movehl_ps( x, x ) );
+      ClampDouble( lo, hi, k );
+      _mm_storeu_si128( (__m128i*)(f+i), DoubleToUInt32( lo, hi ) );
+   }
+#endif
+   ScalarToInteger<UInt32PixelTraits>( f+i, g+i, n-i );
+}
+
+void PixelTraitsConversion::Convert( uint32* f, const double* g, size_type n )
+{
+   size_type i = 0;
+#ifdef __PCL_BULK_CONVERSION_SSE2
+   const __m128d k = _mm_set1_pd( double( uint32_max ) );
+   for ( ; i+4 <= n; i += 4 )
+   {
+      __m128d lo = _mm_loadu_pd( g+i );
+      __m128d hi = _mm_loadu_pd( g+i+2 );
+      ClampDouble( lo, hi, k );
+      _mm_storeu_si128( (__m128i*)(f+i), DoubleToUInt32( lo, hi ) );
+   }
+#endif
+   ScalarToInteger<UInt32PixelTraits>( f+i, g+i, n-i );
+}
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+// ----------------------------------------------------------------------------
+// EOF pcl/PixelTraits.cpp - Released 2016/02/21 20:22:19 UTC
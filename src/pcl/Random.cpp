@@ -524,6 +524,192 @@ int RandomNumberGenerator::Poisson( double lambda )
    }
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+
+/*
+ * Number of Philox blocks computed simultaneously by batch generation
+ * functions. The rounds are computed in structure-of-arrays layout so that
+ * the compiler can vectorize the 32x32->64 bit multiplications.
+ */
+#define PHILOX_LANES 8
+
+static void PhiloxBlocks( uint32* out, uint64 block, uint64 stream, uint64 key )
+{
+   uint32 c0[ PHILOX_LANES ], c1[ PHILOX_LANES ], c2[ PHILOX_LANES ], c3[ PHILOX_LANES ];
+   for ( int i = 0; i < PHILOX_LANES; ++i )
+   {
+      uint64 b = block + i;
+      c0[i] = uint32( b );
+      c1[i] = uint32( b >> 32 );
+      c2[i] = uint32( stream );
+      c3[i] = uint32( stream >> 32 );
+   }
+
+   uint32 k0 = uint32( key ), k1 = uint32( key >> 32 );
+   for ( int r = 0; ; )
+   {
+      for ( int i = 0; i < PHILOX_LANES; ++i )
+      {
+         uint64 p0 = uint64( 0xD2511F53u ) * c0[i];
+         uint64 p1 = uint64( 0xCD9E8D57u ) * c2[i];
+         c0[i] = uint32( p1 >> 32 ) ^ c1[i] ^ k0;
+         c1[i] = uint32( p1 );
+         c2[i] = uint32( p0 >> 32 ) ^ c3[i] ^ k1;
+         c3[i] = uint32( p0 );
+      }
+      if ( ++r == 10 )
+         break;
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+   }
+
+   for ( int i = 0; i < PHILOX_LANES; ++i, out += 4 )
+   {
+      out[0] = c0[i];
+      out[1] = c1[i];
+      out[2] = c2[i];
+      out[3] = c3[i];
+   }
+}
+
+/*
+ * Box-Muller transform, basic form. Unlike the polar form used by
+ * RandomNumberGenerator, this form consumes a fixed number of random words per
+ * pair of normal deviates, so that generator positions remain predictable.
+ */
+static void BoxMuller( double u1, double u2, double& z0, double& z1 )
+{
+   double r = Sqrt( -2*Ln( 1 - u1 ) ); // 1 - u1 in (0,1]
+   double s, c;
+   SinCos( Const<double>::_2pi()*u2, s, c );
+   z0 = r*c;
+   z1 = r*s;
+}
+
+void Philox4x32::NormalPair( double& z0, double& z1 )
+{
+   double u1 = operator()();
+   double u2 = operator()();
+   BoxMuller( u1, u2, z0, z1 );
+}
+
+void Philox4x32::Uniform( double* x, size_type n )
+{
+   /*
+    * Each uniform deviate consumes two words. From an even position we can
+    * reach a block boundary and then generate whole blocks.
+    */
+   if ( (m_position & 1) == 0 )
+   {
+      for ( ; n > 0 && (m_position & 3) != 0; --n )
+         *x++ = operator()();
+
+      uint32 words[ 4*PHILOX_LANES ];
+      for ( ; n >= 2*PHILOX_LANES; n -= 2*PHILOX_LANES )
+      {
+         PhiloxBlocks( words, m_position >> 2, m_stream, m_key );
+         for ( int i = 0; i < 2*PHILOX_LANES; ++i )
+            *x++ = 1.1102230246251565404236e-16 * ((uint64( words[2*i] ) | (uint64( words[2*i+1] ) << 32)) >> 11);
+         m_position += 4*PHILOX_LANES;
+      }
+   }
+
+   for ( ; n > 0; --n )
+      *x++ = operator()();
+}
+
+void Philox4x32::Normal( double* x, size_type n, double mean, double sigma )
+{
+   if ( n == 0 )
+      return;
+
+   if ( m_normal )
+   {
+      m_normal = false;
+      *x++ = mean + m_vs*sigma;
+      --n;
+   }
+
+   double u[ 4*PHILOX_LANES ];
+   for ( ; n >= 2; )
+   {
+      size_type m = pcl::Min( n & ~size_type( 1 ), size_type( 4*PHILOX_LANES ) );
+      Uniform( u, m );
+      for ( size_type i = 0; i < m; i += 2, x += 2 )
+      {
+         double z0, z1;
+         BoxMuller( u[i], u[i+1], z0, z1 );
+         x[0] = mean + z0*sigma;
+         x[1] = mean + z1*sigma;
+      }
+      n -= m;
+   }
+
+   if ( n > 0 )
+      *x = Normal( mean, sigma );
+}
+
+int Philox4x32::Poisson( double lambda )
+{
+   if ( lambda < 12 )
+   {
+      /*
+       * Use Knuth's algorithm
+       */
+      if ( m_lambda[0] != lambda )
+      {
+         m_lambda[0] = lambda;
+         m_lambda[4] = Exp( -lambda );
+      }
+      int k = -1;
+      for ( double p = 1; ; ++k )
+         if ( (p *= operator()()) <= m_lambda[4] )
+            return k;
+   }
+
+   /*
+    * Use rejection sampling with a Lorentzian envelope
+    */
+
+   if ( m_lambda[0] != lambda )
+   {
+      m_lambda[0] = lambda;
+      m_lambda[1] = Sqrt( 2*lambda );
+      m_lambda[2] = Ln( lambda );
+      m_lambda[3] = lambda*m_lambda[2] - LnGamma( lambda+1 );
+   }
+
+   for ( ;; )
+   {
+      double y;
+      double k;
+      do
+      {
+         y = Tan( Const<double>::pi()*operator()() );
+         k = m_lambda[1]*y + lambda;
+      }
+      while ( k < 0 );
+
+      k = Floor( k );
+
+      if ( operator()() <= 0.9*(1 + y*y)*Exp( k*m_lambda[2] - LnGamma( k+1 ) - m_lambda[3] ) )
+         return int( k );
+   }
+}
+
+void Philox4x32::Poisson( int* k, size_type n, double lambda )
+{
+   for ( ; n > 0; --n )
+      *k++ = Poisson( lambda );
+}
+
+void Philox4x32::Poisson( int* k, const double* lambda, size_type n )
+{
+   for ( ; n > 0; --n )
+      *k++ = Poisson( *lambda++ );
+}
+
 // ----------------------------------------------------------------------------
 
 } // pcl
@@ -0,0 +1,452 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/RecursiveGaussianConvolution.cpp - Released 2016/02/21 20:22:19 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+
+#include <pcl/InstructionSet.h>
+#include <pcl/RecursiveGaussianConvolution.h>
+#include <pcl/Thread.h>
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Number of adjacent rows or columns filtered simultaneously.
+ */
+#define BLOCK_SIZE   16
+
+// ----------------------------------------------------------------------------
+
+class PCL_RecursiveGaussianConvolutionEngine
+{
+public:
+
+   template <class P> static
+   void Apply( GenericImage<P>& image, const RecursiveGaussianConvolution& convolution )
+   {
+      if ( P::BitsPerSample() < 32 )
+         ConvolveIntegerImage( image, convolution, reinterpret_cast<Image*>( 0 ) );
+      else
+         ConvolveIntegerImage( image, convolution, reinterpret_cast<DImage*>( 0 ) );
+   }
+
+   static void Apply( Image& image, const RecursiveGaussianConvolution& convolution )
+   {
+      DoApply( image, convolution );
+   }
+
+   static void Apply( DImage& image, const RecursiveGaussianConvolution& convolution )
+   {
+      DoApply( image, convolution );
+   }
+
+private:
+
+   /*
+    * Recursive filter coefficients.
+    *
+    * The causal recursion is:
+    *
+    *    w[n] = b*x[n] + a1*w[n-1] + a2*w[n-2] + a3*w[n-3]
+    *
+    * and the anticausal recursion has the same coefficients. The coefficients
+    * are computed from the poles of the Young-van Vliet filter, scaled for
+    * the required standard deviation (van Vliet, Young and Verbeek, 1998).
+    * M is the matrix of Triggs and Sdika (2006) for initialization of the
+    * anticausal recursion, premultiplied by b.
+    */
+   struct Coefficients
+   {
+      double b, a1, a2, a3;
+      double M[ 9 ];
+
+      Coefficients( double sigma )
+      {
+         const double m0 = 1.16680;
+         const double m1 = 1.10783;
+         const double m2 = 1.40586;
+         const double m1m1 = m1*m1;
+         const double m2m2 = m2*m2;
+
+         double q = (sigma < 3.556) ? -0.2568 + 0.5784*sigma + 0.0561*sigma*sigma :
+                                       2.5091 + 0.9804*(sigma - 3.556);
+         double q2 = q*q;
+         double scale = (m0 + q)*(m1m1 + m2m2 + 2*m1*q + q2);
+         a1 = q*(2*m0*m1 + m1m1 + m2m2 + (2*m0 + 4*m1)*q + 3*q2)/scale;
+         a2 = -q2*(m0 + 2*m1 + 3*q)/scale;
+         a3 = q2*q/scale;
+         b = 1 - (a1 + a2 + a3);
+
+         double k = b/((1 + a1 - a2 + a3)*(1 - a1 - a2 - a3)*(1 + a2 + (a1 - a3)*a3));
+         M[0] = k*(-a3*a1 + 1 - a3*a3 - a2);
+         M[1] = k*(a3 + a1)*(a2 + a3*a1);
+         M[2] = k*a3*(a1 + a3*a2);
+         M[3] = k*(a1 + a3*a2);
+         M[4] = -k*(a2 - 1)*(a2 + a3*a1);
+         M[5] = -k*a3*(a3*a1 + a3*a3 + a2 - 1);
+         M[6] = k*(a3*a1 + a2 + a1*a1 - a2*a2);
+         M[7] = k*(a1*a2 + a3*a2*a2 - a1*a3*a3 - a3*a3*a3 - a3*a2 + a3);
+         M[8] = k*a3*(a1 + a3*a2);
+      }
+   };
+
+   template <class P> static
+   void DoApply( GenericImage<P>& image, const RecursiveGaussianConvolution& convolution )
+   {
+      if ( image.IsEmptySelection() )
+         return;
+
+      if ( convolution.Sigma() < 0.5F )
+         throw Error( "Recursive Gaussian convolution requires a standard deviation >= 0.5 pixels." );
+
+      image.EnsureUnique();
+
+      size_type N = image.NumberOfSelectedSamples();
+      if ( image.Status().IsInitializationEnabled() )
+         image.Status().Initialize( "Convolution (recursive Gaussian)", N+N );
+
+      Coefficients K( convolution.Sigma() );
+
+      for ( int pass = 0; pass < 2; ++pass )
+      {
+         ThreadData<P> data( image, K, convolution.BoundaryDistance(), N );
+
+         // Distribute whole blocks of rows or columns among threads.
+         bool columns = pass > 0;
+         int numberOfLines = columns ? image.SelectedRectangle().Width() : image.SelectedRectangle().Height();
+         int numberOfBlocks = (numberOfLines + BLOCK_SIZE-1)/BLOCK_SIZE;
+         int numberOfThreads = convolution.IsParallelProcessingEnabled() ?
+                     Min( convolution.MaxProcessors(), Thread::NumberOfThreads( numberOfBlocks, 1 ) ) : 1;
+         int linesPerThread = (numberOfBlocks/numberOfThreads)*BLOCK_SIZE;
+         ReferenceArray<FilterThread<P> > threads;
+         for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+            threads.Add( new FilterThread<P>( data, columns,
+                                              i*linesPerThread,
+                                              (j < numberOfThreads) ? j*linesPerThread : numberOfLines ) );
+
+         AbstractImage::RunThreads( threads, data );
+
+         threads.Destroy();
+
+         image.Status() = data.status;
+      }
+   }
+
+   template <class P, class P1> static
+   void ConvolveIntegerImage( GenericImage<P>& image, const RecursiveGaussianConvolution& convolution, GenericImage<P1>* )
+   {
+      GenericImage<P1> tmp( image );
+      DoApply( tmp, convolution );
+
+      StatusMonitor monitor = tmp.Status();
+      image.SetStatusCallback( nullptr );
+
+      image.Mov( tmp, image.SelectedRectangle().LeftTop() );
+
+      image.Status() = monitor;
+   }
+
+   template <class P>
+   struct ThreadData : public AbstractImage::ThreadData
+   {
+      ThreadData( GenericImage<P>& a_image, const Coefficients& a_K, int a_boundary, size_type a_count ) :
+         AbstractImage::ThreadData( a_image, a_count ),
+         image( a_image ),
+         K( a_K ),
+         boundary( a_boundary )
+      {
+      }
+
+            GenericImage<P>& image;
+      const Coefficients&    K;
+            int              boundary;
+   };
+
+   /*
+    * Each thread filters a range of pixel rows or columns, relative to the
+    * selected rectangle, in blocks of BLOCK_SIZE adjacent lines. Each block
+    * is copied to a working tile, where each row of the tile stores one
+    * sample of every line in the block, in double precision. The recursions
+    * run along the rows of the tile, and all lines of the block are filtered
+    * in the innermost loops, which access consecutive memory locations and
+    * can be vectorized. This also hides the latency of the recursions, where
+    * each output sample depends on the three previous ones.
+    */
+   template <class P>
+   class FilterThread : public Thread
+   {
+   public:
+
+      FilterThread( ThreadData<P>& data, bool columns, int firstLine, int endLine ) :
+         Thread(),
+         m_data( data ), m_columns( columns ), m_firstLine( firstLine ), m_endLine( endLine )
+      {
+      }
+
+      virtual PCL_HOT_FUNCTION void Run()
+      {
+         INIT_THREAD_MONITOR()
+
+         Rect r = m_data.image.SelectedRectangle();
+         distance_type width = m_data.image.Width();
+
+         /*
+          * n:      Length of each line.
+          * dn, dl: Distance between adjacent samples of a line, and between
+          *         the first samples of adjacent lines.
+          * nb:     Length of mirrored boundaries.
+          */
+         int n, dx, dy;
+         distance_type dn, dl;
+         if ( m_columns )
+         {
+            n = r.Height();
+            dn = width;
+            dl = 1;
+            dx = 1;
+            dy = 0;
+         }
+         else
+         {
+            n = r.Width();
+            dn = 1;
+            dl = width;
+            dx = 0;
+            dy = 1;
+         }
+         int nb = Min( m_data.boundary, n );
+
+         DVector tv( (n + nb+nb)*BLOCK_SIZE );
+         double* t = tv.DataPtr();
+
+         // Monitoring increments, one for each filtered block or line.
+         size_type blockCount = size_type( n )*BLOCK_SIZE;
+         size_type lineCount = size_type( n );
+
+         for ( int c = m_data.image.FirstSelectedChannel(); c <= m_data.image.LastSelectedChannel(); ++c )
+         {
+            int i = m_firstLine;
+            for ( ; i+BLOCK_SIZE <= m_endLine; i += BLOCK_SIZE )
+            {
+               DispatchKernel<BlockFilter<BLOCK_SIZE> >( m_data.image.PixelAddress( r.x0 + i*dx, r.y0 + i*dy, c ), t,
+                                                         n, nb, dn, dl, m_data.K );
+               UPDATE_THREAD_MONITOR_CHUNK( blockCount, blockCount )
+            }
+            for ( ; i < m_endLine; ++i )
+            {
+               DispatchKernel<BlockFilter<1> >( m_data.image.PixelAddress( r.x0 + i*dx, r.y0 + i*dy, c ), t,
+                                                n, nb, dn, dl, m_data.K );
+               UPDATE_THREAD_MONITOR_CHUNK( lineCount, lineCount )
+            }
+         }
+      }
+
+   private:
+
+      ThreadData<P>& m_data;
+      bool           m_columns;
+      int            m_firstLine;
+      int            m_endLine;
+
+      /*
+       * Block filtering as a multi-versioned kernel - see DispatchKernel().
+       */
+      template <int B>
+      struct BlockFilter
+      {
+         static PCL_FORCE_INLINE
+         void Run( typename P::sample* f, double* t, int n, int nb, distance_type dn, distance_type dl,
+                   const Coefficients& K )
+         {
+            FilterBlock<B>( f, t, n, nb, dn, dl, K );
+         }
+      };
+
+      /*
+       * Filters B adjacent lines of n samples starting at f, where dn is the
+       * distance between adjacent samples of a line, and dl is the distance
+       * between the first samples of adjacent lines. t is the working tile,
+       * with room for at least (n + 2*nb)*B samples, where nb <= n is the
+       * length of mirrored boundaries.
+       */
+      template <int B> static PCL_FORCE_INLINE
+      void FilterBlock( typename P::sample* f, double* t, int n, int nb, distance_type dn, distance_type dl,
+                        const Coefficients& K )
+      {
+         /*
+          * Fill the working tile with mirrored boundaries. The boundary
+          * conditions are the same as in SeparableConvolution.
+          */
+         double* u = t + nb*B;
+         for ( int i = 0; i < n; ++i )
+         {
+            const typename P::sample* fi = f + i*dn;
+            for ( int j = 0; j < B; ++j )
+               u[i*B + j] = fi[j*dl];
+         }
+         for ( int i = 0; i < nb; ++i )
+            for ( int j = 0; j < B; ++j )
+            {
+               u[(-1-i)*B + j] = u[i*B + j];
+               u[(n+i)*B + j] = u[(n-1-i)*B + j];
+            }
+
+         Filter<B>( t, n + nb+nb, K );
+
+         for ( int i = 0; i < n; ++i )
+         {
+            typename P::sample* fi = f + i*dn;
+            for ( int j = 0; j < B; ++j )
+               fi[j*dl] = P::FloatToSample( u[i*B + j] );
+         }
+      }
+
+      /*
+       * Causal and anticausal recursions on B interleaved signals of m >= 3
+       * samples stored at w.
+       *
+       * The causal recursion is initialized for a constant continuation of
+       * the first sample. The anticausal recursion is initialized for a
+       * constant continuation of the last sample, as described by Triggs and
+       * Sdika, which is equivalent to running the causal and anticausal
+       * recursions over an infinite constant extension of the signal.
+       */
+      template <int B> static PCL_FORCE_INLINE
+      void Filter( double* w, int m, const Coefficients& K )
+      {
+         const double b = K.b, a1 = K.a1, a2 = K.a2, a3 = K.a3;
+
+         double xm[ B ], y1[ B ], y2[ B ];
+         for ( int j = 0; j < B; ++j )
+            xm[j] = w[(m-1)*B + j];
+
+         /*
+          * Causal recursion. With a constant initialization, the first output
+          * sample is equal to the first input sample.
+          */
+         for ( int j = 0; j < B; ++j )
+            w[B + j] = b*w[B + j] + (a1 + a2 + a3)*w[j];
+         for ( int j = 0; j < B; ++j )
+            w[2*B + j] = b*w[2*B + j] + a1*w[B + j] + (a2 + a3)*w[j];
+         for ( int i = 3; i < m; ++i )
+         {
+            double* wi = w + i*B;
+            for ( int j = 0; j < B; ++j )
+               wi[j] = b*wi[j] + a1*wi[j-B] + a2*wi[j-2*B] + a3*wi[j-3*B];
+         }
+
+         /*
+          * Anticausal recursion.
+          */
+         {
+            double* w0 = w + (m-1)*B;
+            double* w1 = w0 - B;
+            double* w2 = w1 - B;
+            for ( int j = 0; j < B; ++j )
+            {
+               double d0 = w0[j] - xm[j];
+               double d1 = w1[j] - xm[j];
+               double d2 = w2[j] - xm[j];
+               w0[j] = xm[j] + K.M[0]*d0 + K.M[1]*d1 + K.M[2]*d2;
+               y1[j] = xm[j] + K.M[3]*d0 + K.M[4]*d1 + K.M[5]*d2;
+               y2[j] = xm[j] + K.M[6]*d0 + K.M[7]*d1 + K.M[8]*d2;
+            }
+            for ( int j = 0; j < B; ++j )
+               w1[j] = b*w1[j] + a1*w0[j] + a2*y1[j] + a3*y2[j];
+            for ( int j = 0; j < B; ++j )
+               w2[j] = b*w2[j] + a1*w1[j] + a2*w0[j] + a3*y1[j];
+         }
+         for ( int i = m-4; i >= 0; --i )
+         {
+            double* wi = w + i*B;
+            for ( int j = 0; j < B; ++j )
+               wi[j] = b*wi[j] + a1*wi[j+B] + a2*wi[j+2*B] + a3*wi[j+3*B];
+         }
+      }
+   };
+};
+
+// ----------------------------------------------------------------------------
+
+void RecursiveGaussianConvolution::Apply( pcl::Image& image ) const
+{
+   PCL_RecursiveGaussianConvolutionEngine::Apply( image, *this );
+}
+
+void RecursiveGaussianConvolution::Apply( pcl::DImage& image ) const
+{
+   PCL_RecursiveGaussianConvolutionEngine::Apply( image, *this );
+}
+
+void RecursiveGaussianConvolution::Apply( pcl::UInt8Image& image ) const
+{
+   PCL_RecursiveGaussianConvolutionEngine::Apply( image, *this );
+}
+
+void RecursiveGaussianConvolution::Apply( pcl::UInt16Image& image ) const
+{
+   PCL_RecursiveGaussianConvolutionEngine::Apply( image, *this );
+}
+
+void RecursiveGaussianConvolution::Apply( pcl::UInt32Image& image ) const
+{
+   PCL_RecursiveGaussianConvolutionEngine::Apply( image, *this );
+}
+
+#undef BLOCK_SIZE
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+// ----------------------------------------------------------------------------
+// EOF pcl/RecursiveGaussianConvolution.cpp - Released 2016/02/21 20:22:19 UTC
@@ -50,7 +50,10 @@
 // ----------------------------------------------------------------------------
 
 #include <pcl/AutoPointer.h>
+#include <pcl/InstructionSet.h>
+#include <pcl/LanczosInterpolation.h>
 #include <pcl/Resample.h>
+#include <pcl/ThreadPool.h>
 
 namespace pcl
 {
@@ -147,6 +150,11 @@ void Resample::GetNewSizes( int& width, int& height ) const
 #pragma GCC optimize ("O2")
 #endif
 
+/*
+ * Number of output rows processed by a separable resampling task.
+ */
+#define RESAMPLE_BAND_ROWS    32
+
 class PCL_ResampleEngine
 {
 public:
@@ -187,6 +195,20 @@ public:
                Min( resample.MaxProcessors(), pcl::Thread::NumberOfThreads( height, 1 ) ) : 1;
       int rowsPerThread = height/numberOfThreads;
 
+      /*
+       * For the standard pixel interpolations, interpolation weights depend
+       * only on the output column (horizontal weights) or row (vertical
+       * weights), so they can be precomputed once for the whole image.
+       */
+      Kernel K;
+      bool separable = GetKernel( K, resample.Interpolation() );
+      AxisWeights H, V;
+      if ( separable )
+      {
+         GetAxisWeights( H, K, w0, width, false/*vertical*/ );
+         GetAxisWeights( V, K, h0, height, true/*vertical*/ );
+      }
+
       try
       {
          size_type N = size_type( width )*size_type( height );
@@ -197,24 +219,34 @@ public:
 
          for ( int c = 0; c < n; ++c )
          {
-            ThreadData<P> data( rx, ry, width, status, N );
-            data.f = f = image.Allocator().AllocatePixels( width, height );
+            f = image.Allocator().AllocatePixels( width, height );
 
-            ReferenceArray<Thread<P> > threads;
-            for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
-               threads.Add( new Thread<P>( data, resample.Interpolation().NewInterpolator<P>( f0[c], w0, h0 ),
-                                           i*rowsPerThread,
-                                           (j < numberOfThreads) ? j*rowsPerThread : height ) );
+            if ( separable )
+            {
+               ResampleSeparable<P>( f, width, height, f0[c], w0, K, H, V, numberOfThreads );
+               status += N;
+            }
+            else
+            {
+               ThreadData<P> data( rx, ry, width, status, N );
+               data.f = f;
+
+               ReferenceArray<Thread<P> > threads;
+               for ( int i = 0, j = 1; i < numberOfThreads; ++i, ++j )
+                  threads.Add( new Thread<P>( data, resample.Interpolation().NewInterpolator<P>( f0[c], w0, h0 ),
+                                              i*rowsPerThread,
+                                              (j < numberOfThreads) ? j*rowsPerThread : height ) );
+
+               AbstractImage::RunThreads( threads, data );
 
-            AbstractImage::RunThreads( threads, data );
+               threads.Destroy();
 
-            threads.Destroy();
+               status = data.status;
+            }
 
             image.Allocator().Deallocate( f0[c] );
             f0[c] = f;
             f = nullptr;
-
-            status = data.status;
          }
 
          image.ImportData( f0, width, height, n, cs0 ).Status() = status;
@@ -237,6 +269,689 @@ public:
 
 private:
 
+   /*
+    * Separable interpolation kernels.
+    */
+   enum { NearestNeighborKernel, BilinearKernel, CubicSplineKernel, CubicBSplineKernel, LanczosKernel };
+
+   /*
+    * Accumulation modes. Linear kernels are applied as plain convolutions.
+    * Clamped cubic spline and Lanczos kernels require separate accumulation
+    * of positive and negative filter terms.
+    */
+   enum { LinearMode, CubicClampMode, LanczosClampMode };
+
+   struct Kernel
+   {
+      int          type;
+      int          mode;
+      int          order;    // Lanczos filter order
+      const float* lut;      // Lanczos LUT, or nullptr
+      double       clampTh;  // clamping threshold
+      double       support;  // kernel half-width in source pixels
+
+      Kernel() : type( NearestNeighborKernel ), mode( LinearMode ), order( 0 ), lut( nullptr ), clampTh( 0 ), support( 0.5 )
+      {
+      }
+
+      int NumberOfPlanes() const
+      {
+         return (mode == LanczosClampMode) ? 4 : 1;
+      }
+   };
+
+   /*
+    * Interpolation weights for one axis: a fixed number of taps per output
+    * coordinate, with source indices already mirrored at the boundaries.
+    */
+   struct AxisWeights
+   {
+      int     taps;
+      IVector index;
+      DVector weight;
+      DVector sum;         // sum of weights
+      DVector positiveSum; // sum of positive weights
+
+      AxisWeights() : taps( 0 )
+      {
+      }
+   };
+
+   static bool GetKernel( Kernel& K, const PixelInterpolation& interpolation )
+   {
+      const PixelInterpolation* p = &interpolation;
+      if ( dynamic_cast<const NearestNeighborPixelInterpolation*>( p ) != nullptr )
+      {
+         K.type = NearestNeighborKernel;
+         K.support = 0.5;
+      }
+      else if ( dynamic_cast<const BilinearPixelInterpolation*>( p ) != nullptr )
+      {
+         K.type = BilinearKernel;
+         K.support = 1;
+      }
+      else if ( dynamic_cast<const BicubicSplinePixelInterpolation*>( p ) != nullptr )
+      {
+         K.type = CubicSplineKernel;
+         K.mode = CubicClampMode;
+         K.clampTh = Range( static_cast<const BicubicSplinePixelInterpolation*>( p )->ClampingThreshold(), 0.0F, 1.0F );
+         K.support = 2;
+      }
+      else if ( dynamic_cast<const BicubicBSplinePixelInterpolation*>( p ) != nullptr )
+      {
+         K.type = CubicBSplineKernel;
+         K.support = 2;
+      }
+      else
+      {
+         float clamp;
+         if ( dynamic_cast<const LanczosPixelInterpolation*>( p ) != nullptr )
+         {
+            const LanczosPixelInterpolation* L = static_cast<const LanczosPixelInterpolation*>( p );
+            K.order = Max( 1, L->FilterOrder() );
+            clamp = L->ClampingThreshold();
+         }
+         else if ( dynamic_cast<const Lanczos3LUTPixelInterpolation*>( p ) != nullptr )
+         {
+            PCL_InitializeLanczosLUT( PCL_Lanczos3_LUT, 3 );
+            K.order = 3;
+            K.lut = PCL_Lanczos3_LUT;
+            clamp = static_cast<const Lanczos3LUTPixelInterpolation*>( p )->ClampingThreshold();
+         }
+         else if ( dynamic_cast<const Lanczos4LUTPixelInterpolation*>( p ) != nullptr )
+         {
+            PCL_InitializeLanczosLUT( PCL_Lanczos4_LUT, 4 );
+            K.order = 4;
+            K.lut = PCL_Lanczos4_LUT;
+            clamp = static_cast<const Lanczos4LUTPixelInterpolation*>( p )->ClampingThreshold();
+         }
+         else if ( dynamic_cast<const Lanczos5LUTPixelInterpolation*>( p ) != nullptr )
+         {
+            PCL_InitializeLanczosLUT( PCL_Lanczos5_LUT, 5 );
+            K.order = 5;
+            K.lut = PCL_Lanczos5_LUT;
+            clamp = static_cast<const Lanczos5LUTPixelInterpolation*>( p )->ClampingThreshold();
+         }
+         else
+            return false; // BicubicFilterPixelInterpolation or a custom interpolation
+
+         K.type = LanczosKernel;
+         if ( clamp >= 0 )
+         {
+            K.mode = LanczosClampMode;
+            K.clampTh = Range( clamp, 0.0F, 1.0F );
+         }
+         K.support = K.order;
+      }
+
+      return true;
+   }
+
+   /*
+    * Cubic spline coefficients for a = -1/2, as in BicubicSplineInterpolation.
+    */
+   static void GetSplineCoefficients( double C[], double dx )
+   {
+      double dx2 = dx*dx;
+      double dx3 = dx2*dx;
+      double dx1_2 = dx/2;
+      double dx2_2 = dx2/2;
+      double dx3_2 = dx3/2;
+      double dx22 = dx2 + dx2;
+      double dx315 = dx3 + dx3_2;
+      C[0] =  dx2 - dx3_2 - dx1_2;
+      C[1] =  dx315 - dx22 - dx2_2 + 1;
+      C[2] =  dx22 - dx315 + dx1_2;
+      C[3] =  dx3_2 - dx2_2;
+   }
+
+   /*
+    * Cubic B-spline function, as in BicubicBSplineInterpolation, for -2 <= x <= 2.
+    */
+   static double BSpline( double x )
+   {
+      double fx = (x > 0) ? x*x*x : 0;
+      double fxp1 = x + 1;
+      fxp1 = (fxp1 > 0) ? fxp1*fxp1*fxp1 : 0;
+      double fxp2 = x + 2;
+      fxp2 = (fxp2 > 0) ? fxp2*fxp2*fxp2 : 0;
+      double fxm1 = x - 1;
+      fxm1 = (fxm1 > 0) ? fxm1*fxm1*fxm1 : 0;
+      return (fxp2 - 4*fxp1 + 6*fx - 4*fxm1)/6;
+   }
+
+   static double Lanczos( double x, int n )
+   {
+      if ( x < 0 )
+         x = -x;
+      if ( x >= n )
+         return 0;
+      double px = Const<double>::pi()*x;
+      double pxn = px/n;
+      return ((px > 1.0e-07) ? Sin( px )/px : 1.0) * ((pxn > 1.0e-07) ? Sin( pxn )/pxn : 1.0);
+   }
+
+   /*
+    * Continuous kernel function for prefiltered downsampling, at a distance x
+    * measured in output pixels.
+    */
+   static double Evaluate( const Kernel& K, double x )
+   {
+      x = Abs( x );
+      switch ( K.type )
+      {
+      case BilinearKernel:
+         return (x < 1) ? 1 - x : 0;
+      case CubicSplineKernel: // a = -1/2
+         if ( x <= 1 )
+            return (1.5*x - 2.5)*x*x + 1;
+         if ( x < 2 )
+            return ((-0.5*x + 2.5)*x - 4)*x + 2;
+         return 0;
+      case CubicBSplineKernel:
+         if ( x < 1 )
+            return (4 + (3*x - 6)*x*x)/6;
+         if ( x < 2 )
+         {
+            double d = 2 - x;
+            return d*d*d/6;
+         }
+         return 0;
+      case LanczosKernel:
+         return Lanczos( x, K.order );
+      default:
+         return 0;
+      }
+   }
+
+   /*
+    * Whole-sample symmetric boundary extension.
+    */
+   static int Mirror( int k, int n )
+   {
+      if ( k < 0 )
+         k = -k;
+      else if ( k >= n )
+         k = 2*n - 2 - k;
+      return Range( k, 0, n-1 );
+   }
+
+   /*
+    * Computes interpolation weights to resample an axis of n0 source pixels
+    * to n1 pixels.
+    *
+    * For magnification and unit ratios, each output coordinate j is
+    * interpolated at x = j*n0/n1 with exactly the same neighbor pixels,
+    * boundary rules and filter coefficients as the corresponding
+    * two-dimensional interpolation. For reductions, the kernel is widened by
+    * the reduction ratio and centered on the output pixel, which turns the
+    * interpolation into an area-averaging prefilter. Nearest neighbor
+    * reductions compute the exact box average of the covered source area.
+    */
+   static void GetAxisWeights( AxisWeights& W, const Kernel& K, int n0, int n1, bool vertical )
+   {
+      double r = double( n0 )/n1;
+
+      if ( r <= 1 )
+      {
+         switch ( K.type )
+         {
+         case NearestNeighborKernel: W.taps = 1; break;
+         case BilinearKernel:        W.taps = 2; break;
+         case CubicSplineKernel:
+         case CubicBSplineKernel:    W.taps = 4; break;
+         case LanczosKernel:         W.taps = 2*K.order; break;
+         }
+
+         W.index = IVector( n1*W.taps );
+         W.weight = DVector( n1*W.taps );
+
+         for ( int j = 0; j < n1; ++j )
+         {
+            double x = j*r;
+            int* k = W.index.At( j*W.taps );
+            double* w = W.weight.At( j*W.taps );
+
+            switch ( K.type )
+            {
+            case NearestNeighborKernel:
+               k[0] = Range( RoundIntArithmetic( x ), 0, n0-1 );
+               w[0] = 1;
+               break;
+
+            case BilinearKernel:
+               {
+                  int j0 = Range( TruncI( x ), 0, n0-1 );
+                  double dx = x - j0;
+                  k[0] = j0;
+                  k[1] = (j0+1 < n0) ? j0+1 : j0;
+                  w[0] = 1 - dx;
+                  w[1] = dx;
+               }
+               break;
+
+            case CubicSplineKernel:
+            case CubicBSplineKernel:
+               {
+                  // Neighbor pixels selected by BicubicInterpolationBase::InitXY()
+                  int j1 = Range( TruncI( x ), 0, n0-1 );
+                  double dx = x - j1;
+                  k[0] = (j1 > 0) ? j1-1 : j1;
+                  k[1] = j1;
+                  if ( vertical )
+                  {
+                     k[2] = (j1+1 < n0) ? j1+1 : j1;
+                     k[3] = (j1+2 < n0) ? j1+2 : k[2];
+                  }
+                  else if ( j1+1 < n0 )
+                  {
+                     k[2] = j1+1;
+                     k[3] = (j1+2 < n0) ? j1+2 : j1+1;
+                  }
+                  else
+                  {
+                     k[2] = j1;
+                     k[3] = Max( 0, j1-1 );
+                  }
+
+                  if ( K.type == CubicSplineKernel )
+                     GetSplineCoefficients( w, dx );
+                  else
+                  {
+                     w[0] = BSpline( -1 - dx );
+                     w[1] = BSpline(    - dx );
+                     w[2] = BSpline(  1 - dx );
+                     w[3] = BSpline(  2 - dx );
+                  }
+               }
+               break;
+
+            case LanczosKernel:
+               {
+                  int x0 = Range( TruncI( x ), 0, n0-1 );
+                  double dx = x - x0;
+                  int ldx = RoundI( dx*__PCL_LANCZOS_LUT_RESOLUTION );
+                  for ( int i = -K.order + 1, t = 0; i <= K.order; ++i, ++t )
+                  {
+                     k[t] = Mirror( x0 + i, n0 );
+                     w[t] = (K.lut != nullptr) ? double( K.lut[Abs( i*__PCL_LANCZOS_LUT_RESOLUTION - ldx )] ) : Lanczos( i - dx, K.order );
+                  }
+               }
+               break;
+            }
+         }
+      }
+      else
+      {
+         // Kernel half-width in source pixels.
+         double s = K.support*r;
+         int maxTaps = TruncInt( Ceil( 2*s ) ) + 2;
+         IVector first( n1 );
+         IVector count( n1 );
+         IVector index( n1*maxTaps );
+         DVector weight( n1*maxTaps );
+
+         W.taps = 0;
+         for ( int j = 0; j < n1; ++j )
+         {
+            // Center of the output pixel in source coordinates.
+            double c = (j + 0.5)*r - 0.5;
+            int kmin = TruncInt( Floor( c - s ) );
+            int* k = index.At( j*maxTaps );
+            double* w = weight.At( j*maxTaps );
+            int t0 = maxTaps, t1 = -1;
+            for ( int t = 0; t < maxTaps; ++t )
+            {
+               int i = kmin + t;
+               if ( K.type == NearestNeighborKernel )
+                  w[t] = Max( 0.0, Min( i + 0.5, c + 0.5*r ) - Max( i - 0.5, c - 0.5*r ) );
+               else
+                  w[t] = Evaluate( K, (i - c)/r );
+               k[t] = Mirror( i, n0 );
+               if ( w[t] != 0 )
+               {
+                  if ( t < t0 )
+                     t0 = t;
+                  t1 = t;
+               }
+            }
+            if ( t1 < 0 )
+               t0 = t1 = maxTaps >> 1;
+            first[j] = t0;
+            count[j] = t1 - t0 + 1;
+            W.taps = Max( W.taps, count[j] );
+         }
+
+         // Compact the tables, padding with zero weights.
+         W.index = IVector( n1*W.taps );
+         W.weight = DVector( n1*W.taps );
+         for ( int j = 0; j < n1; ++j )
+         {
+            const int* k = index.At( j*maxTaps + first[j] );
+            const double* w = weight.At( j*maxTaps + first[j] );
+            for ( int t = 0; t < W.taps; ++t )
+               if ( t < count[j] )
+               {
+                  W.index[j*W.taps + t] = k[t];
+                  W.weight[j*W.taps + t] = w[t];
+               }
+               else
+               {
+                  W.index[j*W.taps + t] = k[0];
+                  W.weight[j*W.taps + t] = 0;
+               }
+         }
+      }
+
+      /*
+       * Lanczos clamping is invariant to weight scaling, so Lanczos weights
+       * can be normalized as we do for prefiltering kernels. Interpolation
+       * weights of the remaining kernels already add up to one.
+       */
+      bool normalize = r > 1 || K.type == LanczosKernel;
+
+      W.sum = DVector( n1 );
+      W.positiveSum = DVector( n1 );
+      for ( int j = 0; j < n1; ++j )
+      {
+         double* w = W.weight.At( j*W.taps );
+         double sw = 0;
+         for ( int t = 0; t < W.taps; ++t )
+            sw += w[t];
+         if ( normalize && sw != 0 )
+         {
+            for ( int t = 0; t < W.taps; ++t )
+               w[t] /= sw;
+            sw = 1;
+         }
+         double sp = 0;
+         for ( int t = 0; t < W.taps; ++t )
+            if ( w[t] > 0 )
+               sp += w[t];
+         W.sum[j] = sw;
+         W.positiveSum[j] = sp;
+      }
+   }
+
+   /*
+    * Resamples a single channel by applying horizontal and vertical
+    * interpolation weights as two one-dimensional passes. Output rows are
+    * processed in bands; each band interpolates horizontally the source rows
+    * it needs into a working buffer, then interpolates output rows
+    * vertically from the buffer.
+    */
+   template <class P> static
+   void ResampleSeparable( typename P::sample* f, int width, int height,
+                           const typename P::sample* f0, int w0,
+                           const Kernel& K, const AxisWeights& H, const AxisWeights& V, int numberOfThreads )
+   {
+      int numberOfBands = (height + RESAMPLE_BAND_ROWS - 1)/RESAMPLE_BAND_ROWS;
+
+      auto process = [&]( int beginBand, int endBand )
+      {
+         int numberOfPlanes = K.NumberOfPlanes();
+         DVector buffer;
+         DVector acc( 4*width ); // up to four accumulators per output column
+
+         for ( int b = beginBand; b < endBand; ++b )
+         {
+            int i0 = b*RESAMPLE_BAND_ROWS;
+            int i1 = Min( height, i0 + RESAMPLE_BAND_ROWS );
+
+            // Range of source rows required by this band.
+            const int* ki = V.index.At( i0*V.taps );
+            int rmin = *ki, rmax = *ki;
+            for ( const int* k = ki, * kn = V.index.At( i1*V.taps ); k < kn; ++k )
+               if ( *k < rmin )
+                  rmin = *k;
+               else if ( *k > rmax )
+                  rmax = *k;
+
+            size_type planeSize = size_type( rmax - rmin + 1 )*width;
+            if ( buffer.Length() < int( numberOfPlanes*planeSize ) )
+               buffer = DVector( int( numberOfPlanes*planeSize ) );
+
+            for ( int r = rmin; r <= rmax; ++r )
+               DispatchKernel<RowInterpolation<P> >( buffer.At( size_type( r - rmin )*width ), planeSize,
+                                                     f0 + size_type( r )*w0, width, K, H );
+
+            for ( int i = i0; i < i1; ++i )
+               DispatchKernel<ColumnInterpolation<P> >( f + size_type( i )*width, acc.Begin(),
+                                                        buffer.Begin() - size_type( rmin )*width, planeSize,
+                                                        V.index.At( i*V.taps ), V.weight.At( i*V.taps ), V.taps,
+                                                        V.positiveSum[i], width, K, H );
+         }
+      };
+
+      if ( numberOfThreads > 1 )
+         ThreadPool::ParallelFor( numberOfBands, (numberOfBands + numberOfThreads - 1)/numberOfThreads, process );
+      else
+         process( 0, numberOfBands );
+   }
+
+   /*
+    * The horizontal and vertical passes are multi-versioned kernels,
+    * vectorized for the active instruction set - see DispatchKernel().
+    */
+   template <class P>
+   struct RowInterpolation
+   {
+      static PCL_FORCE_INLINE
+      void Run( double* h, size_type planeSize, const typename P::sample* f, int width,
+                const Kernel& K, const AxisWeights& H )
+      {
+         InterpolateRow<P>( h, planeSize, f, width, K, H );
+      }
+   };
+
+   template <class P>
+   struct ColumnInterpolation
+   {
+      static PCL_FORCE_INLINE
+      void Run( typename P::sample* f, double* acc, const double* h, size_type planeSize,
+                const int* k, const double* w, int taps, double positiveSum,
+                int width, const Kernel& K, const AxisWeights& H )
+      {
+         InterpolateColumns<P>( f, acc, h, planeSize, k, w, taps, positiveSum, width, K, H );
+      }
+   };
+
+   /*
+    * Horizontal pass: interpolates a source row at all output columns.
+    */
+   template <class P> static PCL_FORCE_INLINE
+   void InterpolateRow( double* h, size_type planeSize, const typename P::sample* f, int width,
+                        const Kernel& K, const AxisWeights& H )
+   {
+      const int* k = H.index.Begin();
+      const double* w = H.weight.Begin();
+      int taps = H.taps;
+
+      switch ( K.mode )
+      {
+      case LinearMode:
+         for ( int j = 0; j < width; ++j, k += taps, w += taps )
+         {
+            double s = 0;
+            for ( int t = 0; t < taps; ++t )
+               s += w[t]*f[k[t]];
+            h[j] = s;
+         }
+         break;
+
+      case CubicClampMode:
+         // Clamping rule of BicubicSplineInterpolation, with central and
+         // outer filter terms identified by the signs of their weights.
+         for ( int j = 0; j < width; ++j, k += taps, w += taps )
+         {
+            double sp = 0, sn = 0;
+            for ( int t = 0; t < taps; ++t )
+               if ( w[t] < 0 )
+                  sn += w[t]*f[k[t]];
+               else
+                  sp += w[t]*f[k[t]];
+            h[j] = (-sn < sp*K.clampTh) ? sp + sn : sp/H.positiveSum[j];
+         }
+         break;
+
+      case LanczosClampMode:
+         /*
+          * Lanczos clamping classifies filter terms by the sign of f*Lx*Ly.
+          * The horizontal pass accumulates separately the terms with positive
+          * and negative f*Lx products (planes 0 and 1), and the corresponding
+          * filter weights (planes 2 and 3).
+          */
+         {
+            double* ap = h;
+            double* an = ap + planeSize;
+            double* gp = an + planeSize;
+            double* gn = gp + planeSize;
+            for ( int j = 0; j < width; ++j, k += taps, w += taps )
+            {
+               double sp = 0, sn = 0, wp = 0, wn = 0;
+               for ( int t = 0; t < taps; ++t )
+               {
+                  double s = w[t]*f[k[t]];
+                  if ( s > 0 )
+                     sp += s, wp += w[t];
+                  else if ( s < 0 )
+                     sn += s, wn += w[t];
+               }
+               ap[j] = sp;
+               an[j] = sn;
+               gp[j] = wp;
+               gn[j] = wn;
+            }
+         }
+         break;
+      }
+   }
+
+   /*
+    * Vertical pass: interpolates an output row from horizontally interpolated
+    * source rows. Taps are iterated in the outer loop, so the inner loops run
+    * over contiguous rows and can be vectorized.
+    */
+   template <class P> static PCL_FORCE_INLINE
+   void InterpolateColumns( typename P::sample* f, double* acc, const double* h, size_type planeSize,
+                            const int* k, const double* w, int taps, double positiveSum,
+                            int width, const Kernel& K, const AxisWeights& H )
+   {
+      switch ( K.mode )
+      {
+      case LinearMode:
+         {
+            for ( int j = 0; j < width; ++j )
+               acc[j] = 0;
+            for ( int t = 0; t < taps; ++t )
+            {
+               const double* __restrict__ hk = h + size_type( k[t] )*width;
+               double* __restrict__ a = acc;
+               double wt = w[t];
+               for ( int j = 0; j < width; ++j )
+                  a[j] += wt*hk[j];
+            }
+            for ( int j = 0; j < width; ++j )
+               f[j] = ToSample<P>( acc[j] );
+         }
+         break;
+
+      case CubicClampMode:
+         {
+            double* ap = acc;
+            double* an = acc + width;
+            for ( int j = 0; j < width; ++j )
+               ap[j] = an[j] = 0;
+            for ( int t = 0; t < taps; ++t )
+            {
+               const double* __restrict__ hk = h + size_type( k[t] )*width;
+               double* __restrict__ a = (w[t] < 0) ? an : ap;
+               double wt = w[t];
+               for ( int j = 0; j < width; ++j )
+                  a[j] += wt*hk[j];
+            }
+            for ( int j = 0; j < width; ++j )
+               f[j] = ToSample<P>( (-an[j] < ap[j]*K.clampTh) ? ap[j] + an[j] : ap[j]/positiveSum );
+         }
+         break;
+
+      case LanczosClampMode:
+         {
+            double* sp = acc;
+            double* sn = sp + width;
+            double* wp = sn + width;
+            double* wn = wp + width;
+            for ( int j = 0; j < width; ++j )
+               sp[j] = sn[j] = wp[j] = wn[j] = 0;
+            for ( int t = 0; t < taps; ++t )
+            {
+               const double* ap = h + size_type( k[t] )*width;
+               const double* an = ap + planeSize;
+               const double* gp = an + planeSize;
+               const double* gn = gp + planeSize;
+               const double* sx = H.sum.Begin();
+               double wt = w[t];
+               if ( wt > 0 )
+                  for ( int j = 0; j < width; ++j )
+                  {
+                     sp[j] += wt*ap[j];
+                     sn[j] += wt*an[j];
+                     wp[j] += wt*(sx[j] - gn[j]);
+                     wn[j] += wt*gn[j];
+                  }
+               else if ( wt < 0 )
+                  for ( int j = 0; j < width; ++j )
+                  {
+                     sp[j] += wt*an[j];
+                     sn[j] += wt*ap[j];
+                     wp[j] += wt*(sx[j] - gp[j]);
+                     wn[j] += wt*gp[j];
+                  }
+            }
+
+            // Clamping and weighted convolution, as in LanczosInterpolation.
+            double th = K.clampTh;
+            double th1 = 1 - th;
+            for ( int j = 0; j < width; ++j )
+            {
+               double s1 = sp[j];
+               if ( s1 == 0 )
+               {
+                  f[j] = ToSample<P>( 0.0 );
+                  continue;
+               }
+               double s2 = -sn[j];
+               double w1 = wp[j];
+               double w2 = -wn[j];
+               double r = s2/s1;
+               if ( r >= 1 )
+               {
+                  f[j] = ToSample<P>( s1/w1 );
+                  continue;
+               }
+               if ( r > th )
+               {
+                  r = (r - th)/th1;
+                  double c = 1 - r*r;
+                  s2 *= c, w2 *= c;
+               }
+               f[j] = ToSample<P>( (s1 - s2)/(w1 - w2) );
+            }
+         }
+         break;
+      }
+   }
+
+   /*
+    * Conversion of interpolated values, as in PixelInterpolation::Interpolator.
+    */
+   template <class P> static PCL_FORCE_INLINE
+   typename P::sample ToSample( double r )
+   {
+      return (r < P::MinSampleValue()) ? P::MinSampleValue() :
+         ((r > P::MaxSampleValue()) ? P::MaxSampleValue() : P::FloatToSample( r ));
+   }
+
    template <class P>
    struct ThreadData : public AbstractImage::ThreadData
    {
@@ -296,6 +1011,8 @@ private:
 #pragma GCC pop_options
 #endif
 
+#undef RESAMPLE_BAND_ROWS
+
 // ----------------------------------------------------------------------------
 
 void Resample::Apply( pcl::Image& image ) const
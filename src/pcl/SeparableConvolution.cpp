@@ -49,6 +49,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 // ----------------------------------------------------------------------------
 
+#include <pcl/InstructionSet.h>
 #include <pcl/SeparableConvolution.h>
 #include <pcl/Thread.h>
 
@@ -57,6 +58,13 @@ namespace pcl
 
 // ----------------------------------------------------------------------------
 
+/*
+ * Number of adjacent columns convolved simultaneously by the column pass.
+ */
+#define COLUMN_BLOCK_SIZE  16
+
+// ----------------------------------------------------------------------------
+
 class PCL_SeparableConvolutionEngine
 {
 public:
@@ -139,10 +147,12 @@ private:
       {
          ThreadData<P> data( image, convolution, N2 );
 
+         // Distribute whole blocks of columns among threads.
          int numberOfCols = image.SelectedRectangle().Width();
+         int numberOfBlocks = (numberOfCols + COLUMN_BLOCK_SIZE-1)/COLUMN_BLOCK_SIZE;
          int numberOfThreads = convolution.IsParallelProcessingEnabled() ?
-                     Min( convolution.MaxProcessors(), Thread::NumberOfThreads( numberOfCols, 4 ) ) : 1;
-         int colsPerThread = numberOfCols/numberOfThreads;
+                     Min( convolution.MaxProcessors(), Thread::NumberOfThreads( numberOfBlocks, 1 ) ) : 1;
+         int colsPerThread = (numberOfBlocks/numberOfThreads)*COLUMN_BLOCK_SIZE;
          ReferenceArray<ColThread<P> > threads;
          for ( int i = 0, j = 1, x0 = image.SelectedRectangle().x0; i < numberOfThreads; ++i, ++j )
             threads.Add( new ColThread<P>( data,
@@ -204,12 +214,40 @@ private:
       const SeparableConvolution& convolution;
    };
 
+   /*
+    * Returns true iff the specified filter coefficients are symmetric with
+    * respect to the central element.
+    */
+   static bool IsSymmetricFilter( const coefficient* H, int n )
+   {
+      for ( int i = 0, j = n-1; i < j; ++i, --j )
+         if ( H[i] != H[j] )
+            return false;
+      return true;
+   }
+
+   /*
+    * One-dimensional convolution of N samples at f, using the working
+    * buffers t (N + 2*dn2 samples) and r (N accumulators).
+    *
+    * Convolution sums are accumulated for all samples in the r buffer,
+    * filter coefficient by filter coefficient. The innermost loops access
+    * consecutive memory locations and can be vectorized, while each sum is
+    * accumulated in the same order as a direct evaluation. The convolution
+    * is a multi-versioned kernel, vectorized for the active instruction set.
+    */
    template <class P>
    struct OneDimensionalConvolution
    {
-      static PCL_HOT_FUNCTION
-      void Convolve1D( typename P::sample* f, typename P::sample* t, int N, int d, int dn2,
-                       const SeparableFilter::coefficient* H, int n )
+      static void Convolve1D( typename P::sample* f, typename P::sample* t, double* r, int N, int d, int dn2,
+                              const SeparableFilter::coefficient* H, int n, bool symmetric )
+      {
+         DispatchKernel<OneDimensionalConvolution<P> >( f, t, r, N, d, dn2, H, n, symmetric );
+      }
+
+      static PCL_FORCE_INLINE
+      void Run( typename P::sample* f, typename P::sample* t, double* r, int N, int d, int dn2,
+                const SeparableFilter::coefficient* H, int n, bool symmetric )
       {
          // dn2 = (N + (N - 1)*(d - 1)) >> 1;
 
@@ -219,15 +257,43 @@ private:
          for ( int i = N+dn2+dn2, j = N-dn2; j < N; )
             t[--i] = f[j++];
 
-         const SeparableFilter::coefficient* Hn = H + n;
-         for ( const typename P::sample* fN = f + N; f < fN; ++f, ++t )
+         for ( int i = 0; i < N; ++i )
+            r[i] = 0;
+
+         if ( symmetric )
          {
-            double r = 0;
-            const typename P::sample* u = t;
-            for ( const SeparableFilter::coefficient* h = H; h < Hn; ++h, u += d )
-               r += *u * *h;
-            *f = P::FloatToSample( r );
+            // Symmetric filter: add pairs of samples at symmetric positions
+            // before multiplying, which halves the number of multiplications.
+            int n2 = n >> 1;
+            for ( int k = 0; k < n2; ++k )
+            {
+               const typename P::sample* u = t + k*d;
+               const typename P::sample* v = t + (n-1-k)*d;
+               double h = H[k];
+               for ( int i = 0; i < N; ++i )
+                  r[i] += (double( u[i] ) + v[i]) * h;
+            }
+            if ( n & 1 )
+            {
+               const typename P::sample* u = t + n2*d;
+               SeparableFilter::coefficient h = H[n2];
+               for ( int i = 0; i < N; ++i )
+                  r[i] += u[i] * h;
+            }
          }
+         else
+         {
+            for ( int k = 0; k < n; ++k )
+            {
+               const typename P::sample* u = t + k*d;
+               SeparableFilter::coefficient h = H[k];
+               for ( int i = 0; i < N; ++i )
+                  r[i] += u[i] * h;
+            }
+         }
+
+         for ( int i = 0; i < N; ++i )
+            f[i] = P::FloatToSample( r[i] );
       }
    };
 
@@ -254,19 +320,22 @@ private:
          int dn2 = dn >> 1;
 
          GenericVector<typename P::sample> tv( width + dn2+dn2 );
+         DVector rv( width );
 
          coefficient_vector hv = m_data.convolution.Filter( 0 );
 
          typename P::sample* t = tv.DataPtr();
+         double* rs = rv.DataPtr();
          const SeparableFilter::coefficient* h = hv.DataPtr();
          int n = hv.Length();
+         bool symmetric = IsSymmetricFilter( h, n );
 
          for ( int c = m_data.image.FirstSelectedChannel(); c <= m_data.image.LastSelectedChannel(); ++c )
          {
             typename P::sample* f = m_data.image.PixelAddress( r.x0, m_firstRow, c );
             for ( int i = m_firstRow; i < m_endRow; ++i, f += m_data.image.Width() )
             {
-               this->Convolve1D( f, t, width, d, dn2, h, n );
+               this->Convolve1D( f, t, rs, width, d, dn2, h, n, symmetric );
                UPDATE_THREAD_MONITOR_CHUNK( 65536, width )
             }
          }
@@ -279,8 +348,17 @@ private:
       int            m_endRow;
    };
 
+   /*
+    * The column pass convolves blocks of COLUMN_BLOCK_SIZE adjacent columns
+    * simultaneously. Each block is copied, row by row, to a working tile
+    * where each row of the tile stores one row of the block, extended with
+    * mirrored boundaries. Then all columns of the block are convolved in
+    * the innermost loop, which accesses consecutive memory locations and can
+    * be vectorized. This avoids accessing the image with a stride of one
+    * image row for each sample, which makes the column pass latency bound.
+    */
    template <class P>
-   class ColThread : public Thread, public OneDimensionalConvolution<P>
+   class ColThread : public Thread
    {
    public:
 
@@ -295,36 +373,35 @@ private:
          INIT_THREAD_MONITOR()
 
          Rect r = m_data.image.SelectedRectangle();
-         int width = r.Width();
+         int width = m_data.image.Width();
          int height = r.Height();
 
          int d = m_data.convolution.InterlacingDistance();
          int dn = m_data.convolution.OverlappingDistance();
          int dn2 = dn >> 1;
 
-         GenericVector<typename P::sample> gv( height );
-         GenericVector<typename P::sample> tv( height + dn2+dn2 );
+         GenericVector<typename P::sample> tv( (height + dn2+dn2)*COLUMN_BLOCK_SIZE );
 
          coefficient_vector hv = m_data.convolution.Filter( 1 );
 
-         typename P::sample* g = gv.DataPtr();
          typename P::sample* t = tv.DataPtr();
          const SeparableFilter::coefficient* h = hv.DataPtr();
          int n = hv.Length();
+         bool symmetric = IsSymmetricFilter( h, n );
 
          for ( int c = m_data.image.FirstSelectedChannel(); c <= m_data.image.LastSelectedChannel(); ++c )
          {
-            typename P::sample* f = m_data.image.PixelAddress( m_firstCol, r.y0, c );
-            for ( int i = m_firstCol; i < m_endCol; ++i, ++f )
+            int x = m_firstCol;
+            for ( ; x+COLUMN_BLOCK_SIZE <= m_endCol; x += COLUMN_BLOCK_SIZE )
             {
-               for ( int i = 0, j = 0; i < height; ++i, j += width )
-                  g[i] = f[j];
-
-               this->Convolve1D( g, t, height, d, dn2, h, n );
-
-               for ( int i = 0, j = 0; i < height; ++i, j += width )
-                  f[j] = g[i];
-
+               DispatchKernel<BlockConvolution<COLUMN_BLOCK_SIZE> >( m_data.image.PixelAddress( x, r.y0, c ), t,
+                                                                     width, height, d, dn2, h, n, symmetric );
+               UPDATE_THREAD_MONITOR_CHUNK( 65536, height*COLUMN_BLOCK_SIZE )
+            }
+            for ( ; x < m_endCol; ++x )
+            {
+               DispatchKernel<BlockConvolution<1> >( m_data.image.PixelAddress( x, r.y0, c ), t,
+                                                     width, height, d, dn2, h, n, symmetric );
                UPDATE_THREAD_MONITOR_CHUNK( 65536, height )
             }
          }
@@ -335,6 +412,75 @@ private:
       ThreadData<P>& m_data;
       int            m_firstCol;
       int            m_endCol;
+
+      /*
+       * Convolves B adjacent columns starting at f, where the distance
+       * between two vertically adjacent pixels is width samples. t is the
+       * working tile, with room for at least (height + 2*dn2)*B samples.
+       * This is a multi-versioned kernel - see DispatchKernel().
+       */
+      template <int B>
+      struct BlockConvolution
+      {
+         static PCL_FORCE_INLINE
+         void Run( typename P::sample* f, typename P::sample* t, int width, int height, int d, int dn2,
+                   const SeparableFilter::coefficient* H, int n, bool symmetric )
+         {
+            /*
+             * Fill the working tile with mirrored boundaries. The boundary
+             * conditions are the same as in OneDimensionalConvolution.
+             */
+            {
+               typename P::sample* u = t;
+               for ( int i = dn2; i > 0; u += B )
+                  ::memcpy( u, f + size_type( --i )*width, B*sizeof( *f ) );
+               for ( int i = 0; i < height; ++i, u += B )
+                  ::memcpy( u, f + size_type( i )*width, B*sizeof( *f ) );
+               for ( int i = height; i > height-dn2; u += B )
+                  ::memcpy( u, f + size_type( --i )*width, B*sizeof( *f ) );
+            }
+
+            int dB = d*B;
+            int n2 = n >> 1;
+            for ( int i = 0; i < height; ++i, f += width, t += B )
+            {
+               double r[ B ];
+               for ( int j = 0; j < B; ++j )
+                  r[j] = 0;
+
+               if ( symmetric )
+               {
+                  const typename P::sample* u = t;
+                  const typename P::sample* v = t + (n-1)*dB;
+                  for ( int k = 0; k < n2; ++k, u += dB, v -= dB )
+                  {
+                     double h = H[k];
+                     for ( int j = 0; j < B; ++j )
+                        r[j] += (double( u[j] ) + v[j]) * h;
+                  }
+                  if ( n & 1 )
+                  {
+                     SeparableFilter::coefficient h = H[n2];
+                     for ( int j = 0; j < B; ++j )
+                        r[j] += u[j] * h;
+                  }
+               }
+               else
+               {
+                  const typename P::sample* u = t;
+                  for ( int k = 0; k < n; ++k, u += dB )
+                  {
+                     SeparableFilter::coefficient h = H[k];
+                     for ( int j = 0; j < B; ++j )
+                        r[j] += u[j] * h;
+                  }
+               }
+
+               for ( int j = 0; j < B; ++j )
+                  f[j] = P::FloatToSample( r[j] );
+            }
+         }
+      };
    };
 };
 
@@ -375,6 +521,8 @@ void SeparableConvolution::Apply( pcl::UInt32Image& image ) const
    PCL_SeparableConvolutionEngine::Apply( image, *this );
 }
 
+#undef COLUMN_BLOCK_SIZE
+
 // ----------------------------------------------------------------------------
 
 void SeparableConvolution::ValidateFilter() const
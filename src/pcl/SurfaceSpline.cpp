@@ -49,52 +49,329 @@
 // POSSIBILITY OF SUCH DAMAGE.
 // ----------------------------------------------------------------------------
 
+#include <pcl/Matrix.h>
 #include <pcl/SurfaceSpline.h>
+#include <pcl/Thread.h>
+#include <pcl/ThreadPool.h>
 
-#include <pcl/api/APIException.h>
-#include <pcl/api/APIInterface.h>
+#include <float.h> // for DBL_EPSILON
 
 namespace pcl
 {
 
 // ----------------------------------------------------------------------------
 
+/*
+ * Number of nodes processed per block in surface spline evaluation loops.
+ */
+#define SPLINE_BLOCK_SIZE  256
+
+/*
+ * Minimum number of multiply-add operations to justify parallel execution of
+ * an elimination step in the linear system solver.
+ */
+#define SPLINE_PARALLEL_OPS   65536
+
+// ----------------------------------------------------------------------------
+
+class PCL_SurfaceSplineEngine
+{
+public:
+
+   template <typename T>
+   static void Generate( T* x, T* y, const T* z, int n, int m, float r, const float* w, T* spline,
+                         double& r0, double& x0, double& y0, bool parallel, int maxProcessors )
+   {
+      /*
+       * Normalize node coordinates to the unit circle centered at the mean
+       * node position. This improves the numerical condition of the system.
+       */
+      x0 = y0 = 0;
+      for ( int i = 0; i < n; ++i )
+      {
+         x0 += x[i];
+         y0 += y[i];
+      }
+      x0 /= n;
+      y0 /= n;
+
+      r0 = 0;
+      for ( int i = 0; i < n; ++i )
+      {
+         double dx = x[i] - x0;
+         double dy = y[i] - y0;
+         double r = Sqrt( dx*dx + dy*dy );
+         if ( r > r0 )
+            r0 = r;
+      }
+      if ( 1 + r0 == 1 )
+         throw Error( "SurfaceSpline: Insignificant node coordinate space." );
+      r0 = 1/r0;
+
+      for ( int i = 0; i < n; ++i )
+      {
+         x[i] = T( r0*(x[i] - x0) );
+         y[i] = T( r0*(y[i] - y0) );
+      }
+
+      /*
+       * Build the linear system:
+       *
+       * | K + s*W^-1   P | | c |   | z |
+       * |              | | |   | = |   |
+       * |     P^T      0 | | a |   | 0 |
+       *
+       * where K is the matrix of radial basis function values for all pairs of
+       * nodes, P is the matrix of polynomial terms evaluated at each node, W
+       * is the diagonal matrix of node weights, s is the smoothing factor, c
+       * is the vector of radial basis coefficients and a is the vector of
+       * polynomial coefficients.
+       */
+      int M = (m*(m + 1)) >> 1;
+      int N = n + M;
+      DMatrix A( 0.0, N, N );
+      DVector b( 0.0, N );
+      double* a = A.Begin();
+
+      int numberOfThreads = parallel ? pcl::Min( maxProcessors, Thread::NumberOfThreads( N, 1 ) ) : 1;
+
+      Run( n, numberOfThreads,
+         [=]( int begin, int end )
+         {
+            for ( int i = begin; i < end; ++i )
+            {
+               double* ai = a + size_type( i )*N;
+               for ( int j = 0; j < n; ++j )
+                  if ( j != i )
+                  {
+                     double dx = double( x[i] ) - double( x[j] );
+                     double dy = double( y[i] ) - double( y[j] );
+                     ai[j] = Kernel( dx*dx + dy*dy, m );
+                  }
+               if ( r > 0 )
+                  ai[i] = r/((w != nullptr && w[i] > 0) ? w[i] : 1.0F);
+               PolynomialTerms( ai + n, x[i], y[i], m );
+            }
+         } );
+
+      for ( int i = 0; i < n; ++i )
+      {
+         for ( int k = 0; k < M; ++k )
+            a[size_type( n + k )*N + i] = a[size_type( i )*N + n + k];
+         b[i] = z[i];
+      }
+
+      Solve( A, b, numberOfThreads );
+
+      for ( int i = 0; i < N; ++i )
+         spline[i] = T( b[i] );
+   }
+
+   template <typename T>
+   static void Interpolate( double* z, const double* x, const double* y, int count,
+                            const T* fx, const T* fy, int n, const T* cv, int m,
+                            double r0, double x0, double y0 )
+   {
+      double phi[ SPLINE_BLOCK_SIZE ];
+
+      for ( int p = 0; p < count; ++p )
+      {
+         double px = r0*(x[p] - x0);
+         double py = r0*(y[p] - y0);
+
+         /*
+          * Radial basis terms. Nodes are processed in blocks of contiguous
+          * coordinates and coefficients, so that each inner loop can be
+          * vectorized across nodes.
+          */
+         double s = 0;
+         for ( int i0 = 0; i0 < n; i0 += SPLINE_BLOCK_SIZE )
+         {
+            int nb = pcl::Min( SPLINE_BLOCK_SIZE, n - i0 );
+            const T* bx = fx + i0;
+            const T* by = fy + i0;
+            const T* bc = cv + i0;
+
+            for ( int i = 0; i < nb; ++i )
+            {
+               double dx = bx[i] - px;
+               double dy = by[i] - py;
+               phi[i] = dx*dx + dy*dy;
+            }
+
+            if ( m == 2 )
+            {
+               for ( int i = 0; i < nb; ++i )
+                  phi[i] = (phi[i] > 0) ? 0.5*phi[i]*Ln( phi[i] ) : 0.0;
+            }
+            else
+            {
+               for ( int i = 0; i < nb; ++i )
+                  phi[i] = Kernel( phi[i], m );
+            }
+
+            for ( int i = 0; i < nb; ++i )
+               s += bc[i]*phi[i];
+         }
+
+         z[p] = s + Polynomial( cv + n, px, py, m );
+      }
+   }
+
+private:
+
+   /*
+    * Radial basis function of a surface spline of order m, r^(2m-2)*ln(r), as
+    * a function of the squared distance r2. This is the scaling used by the
+    * PixInsight core implementation, which determines the meaning of the
+    * smoothing factor relative to the radial basis terms.
+    */
+   static double Kernel( double r2, int m )
+   {
+      return (r2 > 0) ? 0.5*PowI( r2, m-1 )*Ln( r2 ) : 0.0;
+   }
+
+   /*
+    * Polynomial terms of total degree < m, in order of increasing degree:
+    * 1, x, y, x^2, x*y, y^2, ...
+    */
+   static void PolynomialTerms( double* t, double x, double y, int m )
+   {
+      for ( int d = 0; d < m; ++d )
+         for ( int k = 0; k <= d; ++k )
+            *t++ = PowI( x, d-k )*PowI( y, k );
+   }
+
+   template <typename T>
+   static double Polynomial( const T* c, double x, double y, int m )
+   {
+      double z = 0;
+      for ( int d = 0; d < m; ++d )
+         for ( int k = 0; k <= d; ++k )
+            z += *c++ * PowI( x, d-k )*PowI( y, k );
+      return z;
+   }
+
+   /*
+    * In-place Gaussian elimination with partial pivoting. On output, b is the
+    * solution vector. A is destroyed.
+    */
+   static void Solve( DMatrix& A, DVector& b, int numberOfThreads )
+   {
+      int N = A.Rows();
+      double* a = A.Begin();
+      double* v = b.Begin();
+
+      double scale = 0;
+      for ( size_type i = 0, N2 = size_type( N )*N; i < N2; ++i )
+         if ( Abs( a[i] ) > scale )
+            scale = Abs( a[i] );
+      double eps = N*DBL_EPSILON*scale;
+
+      for ( int k = 0; k < N; ++k )
+      {
+         double* ak = a + size_type( k )*N;
+
+         int p = k;
+         double pmax = Abs( ak[k] );
+         for ( int i = k+1; i < N; ++i )
+         {
+            double f = Abs( a[size_type( i )*N + k] );
+            if ( f > pmax )
+            {
+               pmax = f;
+               p = i;
+            }
+         }
+         if ( pmax <= eps )
+            throw Error( "SurfaceSpline: Singular linear system. Surface spline nodes must be distinct." );
+
+         if ( p != k )
+         {
+            double* ap = a + size_type( p )*N;
+            for ( int j = k; j < N; ++j )
+               Swap( ak[j], ap[j] );
+            Swap( v[k], v[p] );
+         }
+
+         int rows = N - k - 1;
+         if ( rows > 0 )
+            Run( rows, (double( rows )*(N - k) >= SPLINE_PARALLEL_OPS) ? numberOfThreads : 1,
+               [=]( int begin, int end )
+               {
+                  for ( int i = k+1+begin, i1 = k+1+end; i < i1; ++i )
+                  {
+                     double* ai = a + size_type( i )*N;
+                     double f = ai[k]/ak[k];
+                     if ( f != 0 )
+                     {
+                        for ( int j = k+1; j < N; ++j )
+                           ai[j] -= f*ak[j];
+                        v[i] -= f*v[k];
+                     }
+                  }
+               } );
+      }
+
+      for ( int k = N; --k >= 0; )
+      {
+         const double* ak = a + size_type( k )*N;
+         double s = v[k];
+         for ( int j = k+1; j < N; ++j )
+            s -= ak[j]*v[j];
+         v[k] = s/ak[k];
+      }
+   }
+
+   /*
+    * Processes the range [0,count) with at most numberOfThreads concurrent
+    * thread pool tasks.
+    */
+   template <class F>
+   static void Run( int count, int numberOfThreads, F f )
+   {
+      if ( numberOfThreads > 1 )
+         ThreadPool::ParallelFor( count, (count + numberOfThreads - 1)/numberOfThreads, f );
+      else
+         f( 0, count );
+   }
+};
+
+// ----------------------------------------------------------------------------
+
 void SurfaceSplineBase::Generate( float* fx, float* fy, const float* fz, int n,
                                   int m, float r, const float* w, float* cv,
-                                  double& rm, double& xm, double& ym )
+                                  double& rm, double& xm, double& ym, bool parallel, int maxProcessors )
 {
-   if ( (*API->Numerical->SurfaceSplineGenerateF)( cv, &rm, &xm, &ym, fx, fy, fz, n, m, r, w ) == api_false )
-      throw APIFunctionError( "SurfaceSplineGenerateF" );
+   PCL_SurfaceSplineEngine::Generate( fx, fy, fz, n, m, r, w, cv, rm, xm, ym, parallel, maxProcessors );
 }
 
 void SurfaceSplineBase::Generate( double* fx, double* fy, const double* fz, int n,
                                   int m, float r, const float* w, double* cv,
-                                  double& rm, double& xm, double& ym )
+                                  double& rm, double& xm, double& ym, bool parallel, int maxProcessors )
 {
-   if ( (*API->Numerical->SurfaceSplineGenerateD)( cv, &rm, &xm, &ym, fx, fy, fz, n, m, r, w ) == api_false )
-      throw APIFunctionError( "SurfaceSplineGenerateD" );
+   PCL_SurfaceSplineEngine::Generate( fx, fy, fz, n, m, r, w, cv, rm, xm, ym, parallel, maxProcessors );
 }
 
-float SurfaceSplineBase::Interpolate( const float* fx, const float* fy, int n,
-                                      const float* cv, int m, double x, double y )
+void SurfaceSplineBase::Interpolate( double* z, const double* x, const double* y, int count,
+                                     const float* fx, const float* fy, int n, const float* cv, int m,
+                                     double rm, double xm, double ym )
 {
-   float z;
-   if ( (*API->Numerical->SurfaceSplineInterpolateF)( &z, fx, fy, cv, n, m, x, y ) == api_false )
-      throw APIFunctionError( "SurfaceSplineInterpolateF" );
-   return z;
+   PCL_SurfaceSplineEngine::Interpolate( z, x, y, count, fx, fy, n, cv, m, rm, xm, ym );
 }
 
-double SurfaceSplineBase::Interpolate( const double* fx, const double* fy, int n,
-                                       const double* cv, int m, double x, double y )
+void SurfaceSplineBase::Interpolate( double* z, const double* x, const double* y, int count,
+                                     const double* fx, const double* fy, int n, const double* cv, int m,
+                                     double rm, double xm, double ym )
 {
-   double z;
-   if ( (*API->Numerical->SurfaceSplineInterpolateD)( &z, fx, fy, cv, n, m, x, y ) == api_false )
-      throw APIFunctionError( "SurfaceSplineInterpolateD" );
-   return z;
+   PCL_SurfaceSplineEngine::Interpolate( z, x, y, count, fx, fy, n, cv, m, rm, xm, ym );
 }
 
 // ----------------------------------------------------------------------------
 
+#undef SPLINE_BLOCK_SIZE
+#undef SPLINE_PARALLEL_OPS
+
 } // pcl
 
 // ----------------------------------------------------------------------------
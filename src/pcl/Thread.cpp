@@ -131,7 +131,8 @@ public:
 Thread::Thread() :
    UIObject( (*API->Thread->CreateThread)( ModuleHandle(), this, 0/*flags*/ ) ),
    m_processorIndex( -1 ),
-   m_consoleOutputText()
+   m_consoleOutputText(),
+   m_abortRequested( 0 )
 {
    if ( IsNull() )
       throw APIFunctionError( "CreateThread" );
@@ -154,7 +155,8 @@ Thread::Thread() :
 Thread::Thread( void* h ) :
    UIObject( h ),
    m_processorIndex( -1 ),
-   m_consoleOutputText()
+   m_consoleOutputText(),
+   m_abortRequested( 0 )
 {
 }
 
@@ -171,6 +173,7 @@ Thread& Thread::Null()
 void Thread::Start( Thread::priority p, int processor )
 {
    m_processorIndex = Range( processor, -1, PCL_MAX_PROCESSORS );
+   m_abortRequested.Store( 0 );
    (*API->Thread->StartThread)( handle, p );
 }
 
@@ -0,0 +1,434 @@
+//     ____   ______ __
+//    / __ \ / ____// /
+//   / /_/ // /    / /
+//  / ____// /___ / /___   PixInsight Class Library
+// /_/     \____//_____/   PCL 02.01.01.0784
+// ----------------------------------------------------------------------------
+// pcl/ThreadPool.cpp - Released 2016/02/21 20:22:19 UTC
+// ----------------------------------------------------------------------------
+// This file is part of the PixInsight Class Library (PCL).
+// PCL is a multiplatform C++ framework for development of PixInsight modules.
+//
+// Copyright (c) 2003-2016 Pleiades Astrophoto S.L. All Rights Reserved.
+//
+// Redistribution and use in both source and binary forms, with or without
+// modification, is permitted provided that the following conditions are met:
+//
+// 1. All redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. All redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the names "PixInsight" and "Pleiades Astrophoto", nor the names
+//    of their contributors, may be used to endorse or promote products derived
+//    from this software without specific prior written permission. For written
+//    permission, please contact info@pixinsight.com.
+//
+// 4. All products derived from this software, in any form whatsoever, must
+//    reproduce the following acknowledgment in the end-user documentation
+//    and/or other materials provided with the product:
+//
+//    "This product is based on software from the PixInsight project, developed
+//    by Pleiades Astrophoto and its contributors (http://pixinsight.com/)."
+//
+//    Alternatively, if that is where third-party acknowledgments normally
+//    appear, this acknowledgment must be reproduced in the product itself.
+//
+// THIS SOFTWARE IS PROVIDED BY PLEIADES ASTROPHOTO AND ITS CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PLEIADES ASTROPHOTO OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, BUSINESS
+// INTERRUPTION; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; AND LOSS OF USE,
+// DATA OR PROFITS) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// ----------------------------------------------------------------------------
+
+#include <pcl/ReferenceArray.h>
+#include <pcl/ThreadPool.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pcl
+{
+
+// ----------------------------------------------------------------------------
+
+struct PoolTaskGroupData
+{
+   std::atomic<size_type>  pending;
+   std::mutex              mutex;
+   std::condition_variable completed;
+   std::exception_ptr      exception;
+
+   PoolTaskGroupData() : pending( 0 )
+   {
+   }
+};
+
+struct PoolEntry
+{
+   ThreadPool::Task*  task;
+   PoolTaskGroupData* group;
+};
+
+struct PoolQueue
+{
+   std::mutex            mutex;
+   std::deque<PoolEntry> entries;
+};
+
+// ----------------------------------------------------------------------------
+
+class PoolData
+{
+public:
+
+   PoolData( int numberOfWorkers ) :
+      m_queues( numberOfWorkers ), m_workerIds( numberOfWorkers ),
+      m_queued( 0 ), m_nextQueue( 0 ), m_registered( 0 ), m_terminate( false )
+   {
+      for ( int i = 0; i < numberOfWorkers; ++i )
+         m_queues[i] = new PoolQueue;
+
+      for ( int i = 0; i < numberOfWorkers; ++i )
+      {
+         m_workers.Add( new Worker( *this, i ) );
+         m_workers[i].Start( ThreadPriority::DefaultMax );
+      }
+
+      // Worker identifiers must be known before the pool can be used.
+      std::unique_lock<std::mutex> lock( m_sleepMutex );
+      m_registration.wait( lock, [this]{ return m_registered == int( m_queues.size() ); } );
+   }
+
+   ~PoolData()
+   {
+      {
+         std::lock_guard<std::mutex> lock( m_sleepMutex );
+         m_terminate = true;
+      }
+      m_wakeUp.notify_all();
+      for ( ReferenceArray<Worker>::iterator i = m_workers.Begin(); i != m_workers.End(); ++i )
+         i->Wait();
+      m_workers.Destroy();
+      for ( size_type i = 0; i < m_queues.size(); ++i )
+         delete m_queues[i];
+   }
+
+   int NumberOfWorkers() const
+   {
+      return int( m_queues.size() );
+   }
+
+   /*
+    * Returns the index of the calling worker thread, or -1 if the caller is
+    * not a worker of this pool.
+    */
+   int WorkerIndex() const
+   {
+      std::thread::id id = std::this_thread::get_id();
+      for ( size_type i = 0; i < m_workerIds.size(); ++i )
+         if ( m_workerIds[i] == id )
+            return int( i );
+      return -1;
+   }
+
+   void Submit( const PoolEntry& entry )
+   {
+      int self = WorkerIndex();
+      PoolQueue* q = m_queues[(self >= 0) ? self : m_nextQueue++ % m_queues.size()];
+      ++m_queued;
+      {
+         std::lock_guard<std::mutex> lock( q->mutex );
+         q->entries.push_back( entry );
+      }
+      {
+         std::lock_guard<std::mutex> lock( m_sleepMutex );
+      }
+      m_wakeUp.notify_one();
+   }
+
+   /*
+    * Takes the most recent entry of our own queue, or steals the oldest entry
+    * from another queue. Returns false if all queues are empty.
+    */
+   bool Acquire( PoolEntry& entry, int self )
+   {
+      if ( m_queued == 0 )
+         return false;
+
+      int n = int( m_queues.size() );
+      if ( self >= 0 )
+      {
+         PoolQueue* q = m_queues[self];
+         std::lock_guard<std::mutex> lock( q->mutex );
+         if ( !q->entries.empty() )
+         {
+            entry = q->entries.back();
+            q->entries.pop_back();
+            --m_queued;
+            return true;
+         }
+      }
+
+      for ( int i = 1, j = (self >= 0) ? self : 0; i <= n; ++i )
+      {
+         PoolQueue* q = m_queues[(j + i) % n];
+         std::lock_guard<std::mutex> lock( q->mutex );
+         if ( !q->entries.empty() )
+         {
+            entry = q->entries.front();
+            q->entries.pop_front();
+            --m_queued;
+            return true;
+         }
+      }
+
+      return false;
+   }
+
+   static void Execute( const PoolEntry& entry )
+   {
+      PoolTaskGroupData* group = entry.group;
+      try
+      {
+         entry.task->Execute();
+      }
+      catch ( ... )
+      {
+         std::lock_guard<std::mutex> lock( group->mutex );
+         if ( !group->exception )
+            group->exception = std::current_exception();
+      }
+
+      /*
+       * The group may be destroyed as soon as its last pending task has been
+       * completed, so the group mutex must be held until we are done with it.
+       */
+      std::lock_guard<std::mutex> lock( group->mutex );
+      if ( --group->pending == 0 )
+         group->completed.notify_all();
+   }
+
+private:
+
+   class Worker : public Thread
+   {
+   public:
+
+      Worker( PoolData& pool, int index ) : Thread(), m_pool( pool ), m_index( index )
+      {
+      }
+
+      virtual void Run()
+      {
+         m_pool.Register( m_index );
+         m_pool.Work( m_index );
+      }
+
+   private:
+
+      PoolData& m_pool;
+      int       m_index;
+   };
+
+   std::vector<PoolQueue*>      m_queues;
+   std::vector<std::thread::id> m_workerIds;
+   ReferenceArray<Worker>       m_workers;
+   std::atomic<int>             m_queued;
+   std::atomic<unsigned>        m_nextQueue;
+   std::mutex                   m_sleepMutex;
+   std::condition_variable      m_wakeUp;
+   std::condition_variable      m_registration;
+   int                          m_registered;
+   bool                         m_terminate;
+
+   void Register( int index )
+   {
+      std::lock_guard<std::mutex> lock( m_sleepMutex );
+      m_workerIds[index] = std::this_thread::get_id();
+      ++m_registered;
+      m_registration.notify_all();
+   }
+
+   void Work( int index )
+   {
+      for ( ;; )
+      {
+         PoolEntry entry;
+         if ( Acquire( entry, index ) )
+         {
+            Execute( entry );
+            continue;
+         }
+
+         std::unique_lock<std::mutex> lock( m_sleepMutex );
+         m_wakeUp.wait( lock, [this]{ return m_queued > 0 || m_terminate; } );
+         if ( m_terminate )
+            return;
+      }
+   }
+};
+
+// ----------------------------------------------------------------------------
+
+static std::atomic<PoolData*> s_pool( nullptr );
+static std::mutex             s_poolMutex;
+
+static PoolData& Pool()
+{
+   PoolData* pool = s_pool.load();
+   if ( pool == nullptr )
+   {
+      std::lock_guard<std::mutex> lock( s_poolMutex );
+      pool = s_pool.load();
+      if ( pool == nullptr )
+      {
+         pool = new PoolData( pcl::Max( 1, Thread::NumberOfThreads( PCL_MAX_PROCESSORS, 1 ) ) );
+         s_pool.store( pool );
+      }
+   }
+   return *pool;
+}
+
+int ThreadPool::NumberOfWorkers()
+{
+   return Pool().NumberOfWorkers();
+}
+
+void ThreadPool::Shutdown()
+{
+   std::lock_guard<std::mutex> lock( s_poolMutex );
+   delete s_pool.exchange( nullptr );
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::ThreadTask::Execute()
+{
+   if ( m_thread != nullptr )
+      try
+      {
+         if ( !m_thread->TryIsAborted() )
+            m_thread->Run();
+      }
+      catch ( ... )
+      {
+         /* ### Do _not_ propagate exceptions from a running thread */
+      }
+}
+
+// ----------------------------------------------------------------------------
+
+#define G   reinterpret_cast<PoolTaskGroupData*>( m_data )
+
+ThreadPool::TaskGroup::TaskGroup() : m_data( new PoolTaskGroupData )
+{
+}
+
+ThreadPool::TaskGroup::~TaskGroup()
+{
+   try
+   {
+      std::unique_lock<std::mutex> lock( G->mutex );
+      G->completed.wait( lock, [this]{ return G->pending == 0; } );
+   }
+   catch ( ... )
+   {
+   }
+   delete G;
+}
+
+void ThreadPool::TaskGroup::Run( Task& task )
+{
+   PoolData& pool = Pool();
+   ++G->pending;
+   PoolEntry entry = { &task, G };
+   pool.Submit( entry );
+}
+
+void ThreadPool::TaskGroup::Wait()
+{
+   PoolData& pool = Pool();
+   int self = pool.WorkerIndex();
+   while ( G->pending.load() != 0 )
+   {
+      PoolEntry entry;
+      if ( pool.Acquire( entry, self ) )
+         PoolData::Execute( entry );
+      else
+      {
+         std::unique_lock<std::mutex> lock( G->mutex );
+         G->completed.wait_for( lock, std::chrono::milliseconds( 1 ), [this]{ return G->pending == 0; } );
+      }
+   }
+
+   std::unique_lock<std::mutex> lock( G->mutex );
+   if ( G->exception )
+   {
+      std::exception_ptr e = G->exception;
+      G->exception = nullptr;
+      std::rethrow_exception( e );
+   }
+}
+
+bool ThreadPool::TaskGroup::Wait( unsigned ms )
+{
+   PoolData& pool = Pool();
+   int self = pool.WorkerIndex();
+   std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds( ms );
+   if ( self >= 0 )
+   {
+      // Pool workers contribute to execute pending tasks while waiting.
+      while ( G->pending.load() != 0 && std::chrono::steady_clock::now() < timeout )
+      {
+         PoolEntry entry;
+         if ( pool.Acquire( entry, self ) )
+            PoolData::Execute( entry );
+         else
+         {
+            std::unique_lock<std::mutex> lock( G->mutex );
+            G->completed.wait_for( lock, std::chrono::milliseconds( 1 ), [this]{ return G->pending == 0; } );
+         }
+      }
+   }
+
+   std::unique_lock<std::mutex> lock( G->mutex );
+   if ( !G->completed.wait_until( lock, timeout, [this]{ return G->pending == 0; } ) )
+      return false;
+
+   if ( G->exception )
+   {
+      std::exception_ptr e = G->exception;
+      G->exception = nullptr;
+      std::rethrow_exception( e );
+   }
+   return true;
+}
+
+bool ThreadPool::TaskGroup::IsComplete() const
+{
+   return G->pending == 0;
+}
+
+#undef G
+
+// ----------------------------------------------------------------------------
+
+} // pcl
+
+// ----------------------------------------------------------------------------
+// EOF pcl/ThreadPool.cpp - Released 2016/02/21 20:22:19 UTC